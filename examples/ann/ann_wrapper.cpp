@@ -119,6 +119,11 @@ bool iscc_ann_init_nn_search_object(void* const data_set,
 
 	scc_DataSet* const data_set_cast = static_cast<scc_DataSet*>(data_set);
 
+	// ANN reads points as packed rows with Euclidean distances, so column subsets,
+	// column-major data, column arrays, Gower data sets and binary data sets are not supported
+	if ((data_set_cast->columns != NULL) || (data_set_cast->column_arrays != NULL) || (data_set_cast->column_stride != 1) ||
+	        (data_set_cast->gower_weights != NULL) || (data_set_cast->binary_matrix != NULL)) return false;
+
 	ANNpoint* search_points;
 	try {
 		search_points = new ANNpoint[len_search_indices];
@@ -130,13 +135,13 @@ bool iscc_ann_init_nn_search_object(void* const data_set,
 	if (search_indices == NULL) {
 		assert(len_search_indices <= data_set_cast->num_data_points);
 		double* search_point = const_cast<double*>(data_set_cast->data_matrix);
-		for (size_t i = 0; i < len_search_indices; ++i, search_point += data_set_cast->num_dimensions) {
+		for (size_t i = 0; i < len_search_indices; ++i, search_point += data_set_cast->row_stride) {
 			search_points[i] = search_point;
 		}
 	} else if (search_indices != NULL) {
 		for (size_t i = 0; i < len_search_indices; ++i) {
 			assert(static_cast<size_t>(search_indices[i]) < data_set_cast->num_data_points);
-			search_points[i] = const_cast<double*>(data_set_cast->data_matrix) + search_indices[i] * data_set_cast->num_dimensions;
+			search_points[i] = const_cast<double*>(data_set_cast->data_matrix) + search_indices[i] * data_set_cast->row_stride;
 		}
 	}
 
@@ -223,7 +228,7 @@ bool iscc_ann_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 					if (query_indices != NULL) {
 						query = (size_t) query_indices[q];
 					}
-					const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->num_dimensions;
+					const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->row_stride;
 					search_tree->annkSearch(query_point,    // pointer to query point
 					                        k_int,          // number of neighbors
 					                        write_nnidx,    // pointer to start of index result
@@ -237,14 +242,16 @@ bool iscc_ann_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 				}
 			} else {
 				assert(radius_search);
-				const double radius_sq = radius * radius;
+				// Geo data sets are searched by chord distance on the unit sphere
+				const double embedded_radius = iscc_to_embedded_dist(data_set, radius);
+				const double radius_sq = embedded_radius * embedded_radius;
 				int* write_nnidx = out_nn_indices;
 				for (size_t q = 0; q < len_query_indices; ++q) {
 					size_t query = q;
 					if (query_indices != NULL) {
 						query = (size_t) query_indices[q];
 					}
-					const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->num_dimensions;
+					const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->row_stride;
 					const int num_found = search_tree->annkFRSearch(query_point,              // pointer to query point
 					                                                radius_sq,                // squared caliper
 					                                                k_int,                    // number of neighbors
@@ -291,7 +298,7 @@ bool iscc_ann_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 			if (query_indices != NULL) {
 				query = (size_t) query_indices[q];
 			}
-			const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->num_dimensions;
+			const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->row_stride;
 			search_tree->annkSearch(query_point,    // pointer to query point
 			                        k_int,          // number of neighbors
 			                        idx_scratch,    // pointer to start of index result
@@ -316,14 +323,16 @@ bool iscc_ann_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 
 	} else {
 		assert(radius_search);
-		const double radius_sq = radius * radius;
+		// Geo data sets are searched by chord distance on the unit sphere
+		const double embedded_radius = iscc_to_embedded_dist(data_set, radius);
+		const double radius_sq = embedded_radius * embedded_radius;
 		scc_PointIndex* write_nnidx = out_nn_indices;
 		for (size_t q = 0; q < len_query_indices; ++q) {
 			size_t query = q;
 			if (query_indices != NULL) {
 				query = (size_t) query_indices[q];
 			}
-			const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->num_dimensions;
+			const ANNpoint query_point = const_cast<double*>(data_set->data_matrix) + query * data_set->row_stride;
 			int num_found = search_tree->annkFRSearch(query_point,     // pointer to query point
 			                                          radius_sq,       // squared caliper
 			                                          k_int,           // number of neighbors
@@ -0,0 +1,161 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <scclust.h>
+#include "arrow_wrapper.h"
+
+#define NUM_DATA_POINTS 2000
+
+
+// The columns are owned by this program, so releasing only marks the structs as released
+static void release_schema(struct ArrowSchema* const schema)
+{
+	schema->release = NULL;
+}
+
+
+static void release_array(struct ArrowArray* const array)
+{
+	array->release = NULL;
+}
+
+
+int main(void) {
+
+	// Columns of a record batch: two covariates, a type label and a primary-point mask
+	static double x_values[NUM_DATA_POINTS];
+	static float y_values[NUM_DATA_POINTS];
+	static int8_t group_values[NUM_DATA_POINTS];
+	static uint8_t treated_bits[(NUM_DATA_POINTS + 7) / 8];
+	uint32_t state = 12345;
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		state = state * 1103515245u + 12345u;
+		x_values[i] = 100.0 * ((double) (state >> 8)) / 16777216.0;
+		state = state * 1103515245u + 12345u;
+		y_values[i] = (float) (100.0 * ((double) (state >> 8)) / 16777216.0);
+		group_values[i] = (int8_t) (i % 3 == 0);
+		if (group_values[i] == 1) treated_bits[i / 8] |= (uint8_t) (1u << (i % 8));
+	}
+
+	// Export the columns as a struct array, as a record batch would be exported
+	const char* const names[4] = { "x", "y", "group", "treated" };
+	const char* const formats[4] = { "g", "f", "c", "b" };
+	const void* const values[4] = { x_values, y_values, group_values, treated_bits };
+	const void* buffers[4][2];
+	struct ArrowSchema child_schemas[4];
+	struct ArrowArray child_arrays[4];
+	struct ArrowSchema* child_schema_ptrs[4];
+	struct ArrowArray* child_array_ptrs[4];
+	for (size_t c = 0; c < 4; ++c) {
+		buffers[c][0] = NULL;
+		buffers[c][1] = values[c];
+		child_schemas[c] = (struct ArrowSchema) {
+			.format = formats[c],
+			.name = names[c],
+			.flags = ARROW_FLAG_NULLABLE,
+			.release = release_schema,
+		};
+		child_arrays[c] = (struct ArrowArray) {
+			.length = NUM_DATA_POINTS,
+			.n_buffers = 2,
+			.buffers = buffers[c],
+			.release = release_array,
+		};
+		child_schema_ptrs[c] = &child_schemas[c];
+		child_array_ptrs[c] = &child_arrays[c];
+	}
+	const void* struct_buffers[1] = { NULL };
+	struct ArrowSchema schema = {
+		.format = "+s",
+		.name = "",
+		.n_children = 4,
+		.children = child_schema_ptrs,
+		.release = release_schema,
+	};
+	struct ArrowArray array = {
+		.length = NUM_DATA_POINTS,
+		.n_buffers = 1,
+		.n_children = 4,
+		.buffers = struct_buffers,
+		.children = child_array_ptrs,
+		.release = release_array,
+	};
+
+	// Data set reading "x" in place and a converted copy of "y"
+	const char* const covariates[2] = { "x", "y" };
+	scc_DataSet* arrow_data_set;
+	double* converted;
+	if (!scc_arrow_init_data_set(&schema, &array, 2, covariates, &arrow_data_set, &converted)) return 1;
+
+	static scc_TypeLabel type_labels[NUM_DATA_POINTS];
+	static scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+	size_t len_primary_data_points;
+	if (!scc_arrow_get_type_labels(&schema, &array, "group", type_labels)) return 1;
+	if (!scc_arrow_get_primary_data_points(&schema, &array, "treated", &len_primary_data_points, primary_data_points)) return 1;
+
+	// Reference data set built from a materialized row-major matrix
+	static double raw_data[2 * NUM_DATA_POINTS];
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		raw_data[2 * i] = x_values[i];
+		raw_data[2 * i + 1] = (double) y_values[i];
+	}
+	scc_DataSet* matrix_data_set;
+	if (scc_init_data_set(NUM_DATA_POINTS, 2, 2 * NUM_DATA_POINTS, raw_data, &matrix_data_set) != SCC_ER_OK) return 1;
+
+	// Clusters with one point of each group, formed around the treated points
+	const uint32_t type_constraints[2] = { 1, 1 };
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 2;
+	options.num_types = 2;
+	options.type_constraints = type_constraints;
+	options.len_type_labels = NUM_DATA_POINTS;
+	options.type_labels = type_labels;
+	options.len_primary_data_points = len_primary_data_points;
+	options.primary_data_points = primary_data_points;
+
+	static scc_Clabel arrow_labels[NUM_DATA_POINTS];
+	static scc_Clabel matrix_labels[NUM_DATA_POINTS];
+	scc_Clustering* clustering;
+	if (scc_init_empty_clustering(NUM_DATA_POINTS, arrow_labels, &clustering) != SCC_ER_OK) return 1;
+	if (scc_sc_clustering(arrow_data_set, &options, clustering) != SCC_ER_OK) return 1;
+	scc_free_clustering(&clustering);
+	if (scc_init_empty_clustering(NUM_DATA_POINTS, matrix_labels, &clustering) != SCC_ER_OK) return 1;
+	if (scc_sc_clustering(matrix_data_set, &options, clustering) != SCC_ER_OK) return 1;
+	scc_free_clustering(&clustering);
+
+	const bool same = (memcmp(arrow_labels, matrix_labels, sizeof(arrow_labels)) == 0);
+	printf("%zu treated points, clustering from Arrow columns %s the matrix clustering\n",
+	       len_primary_data_points, same ? "matches" : "differs from");
+
+	scc_free_data_set(&arrow_data_set);
+	scc_free_data_set(&matrix_data_set);
+	free(converted);
+	schema.release(&schema);
+	array.release(&array);
+
+	return same ? 0 : 1;
+}
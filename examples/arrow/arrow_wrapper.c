@@ -0,0 +1,335 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#include "arrow_wrapper.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <scclust.h>
+
+
+// =============================================================================
+// Internal structs
+// =============================================================================
+
+// A column of an Arrow array. `offset` is the position of the first row in
+// the column's buffers, including the offset of the parent struct array.
+typedef struct iscc_arrow_Column {
+	const struct ArrowSchema* schema;
+	const struct ArrowArray* array;
+	size_t offset;
+} iscc_arrow_Column;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static bool iscc_arrow_check_array(const struct ArrowSchema* schema,
+                                   const struct ArrowArray* array);
+
+
+static bool iscc_arrow_is_struct(const struct ArrowSchema* schema);
+
+
+static bool iscc_arrow_get_column(const struct ArrowSchema* schema,
+                                  const struct ArrowArray* array,
+                                  size_t column_index,
+                                  const char* column_name,
+                                  iscc_arrow_Column* out_column);
+
+
+static bool iscc_arrow_is_null(const iscc_arrow_Column* column,
+                               size_t row);
+
+
+static bool iscc_arrow_has_nulls(const iscc_arrow_Column* column,
+                                 size_t num_rows);
+
+
+static bool iscc_arrow_get_integer(const iscc_arrow_Column* column,
+                                   size_t row,
+                                   int64_t* out_value);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+bool scc_arrow_init_data_set(const struct ArrowSchema* const schema,
+                             const struct ArrowArray* const array,
+                             const size_t num_columns,
+                             const char* const column_names[const],
+                             scc_DataSet** const out_data_set,
+                             double** const out_converted)
+{
+	if ((out_data_set == NULL) || (out_converted == NULL)) return false;
+	*out_data_set = NULL;
+	*out_converted = NULL;
+	if (!iscc_arrow_check_array(schema, array)) return false;
+	if ((num_columns == 0) || (num_columns > UINT16_MAX)) return false;
+	if (!iscc_arrow_is_struct(schema) && ((num_columns != 1) || (column_names != NULL))) return false;
+
+	const size_t num_rows = (size_t) array->length;
+	iscc_arrow_Column* const columns = malloc(sizeof(iscc_arrow_Column[num_columns]));
+	const double** const column_arrays = malloc(sizeof(const double*[num_columns]));
+	if ((columns == NULL) || (column_arrays == NULL)) {
+		free(columns);
+		free(column_arrays);
+		return false;
+	}
+
+	// Float32 columns must be converted, so count them first
+	size_t num_converted = 0;
+	for (size_t c = 0; c < num_columns; ++c) {
+		const char* const column_name = (column_names == NULL) ? NULL : column_names[c];
+		if (!iscc_arrow_get_column(schema, array, c, column_name, &columns[c]) ||
+		        iscc_arrow_has_nulls(&columns[c], num_rows)) {
+			free(columns);
+			free(column_arrays);
+			return false;
+		}
+		const char* const format = columns[c].schema->format;
+		if (strcmp(format, "f") == 0) {
+			++num_converted;
+		} else if (strcmp(format, "g") != 0) {
+			free(columns);
+			free(column_arrays);
+			return false;
+		}
+	}
+
+	double* converted = NULL;
+	if (num_converted > 0) {
+		converted = malloc(sizeof(double[num_converted * num_rows]));
+		if (converted == NULL) {
+			free(columns);
+			free(column_arrays);
+			return false;
+		}
+	}
+
+	double* write_converted = converted;
+	for (size_t c = 0; c < num_columns; ++c) {
+		const void* const values = columns[c].array->buffers[1];
+		if (strcmp(columns[c].schema->format, "g") == 0) {
+			// Float64 columns are used in place
+			column_arrays[c] = ((const double*) values) + columns[c].offset;
+		} else {
+			const float* const float_values = ((const float*) values) + columns[c].offset;
+			for (size_t i = 0; i < num_rows; ++i) {
+				write_converted[i] = (double) float_values[i];
+			}
+			column_arrays[c] = write_converted;
+			write_converted += num_rows;
+		}
+	}
+
+	const scc_ErrorCode ec = scc_init_data_set_column_arrays((uint64_t) num_rows,
+	                                                         (uint32_t) num_columns,
+	                                                         column_arrays,
+	                                                         out_data_set);
+	free(columns);
+	free(column_arrays);
+	if (ec != SCC_ER_OK) {
+		free(converted);
+		return false;
+	}
+
+	*out_converted = converted;
+	return true;
+}
+
+
+bool scc_arrow_get_type_labels(const struct ArrowSchema* const schema,
+                               const struct ArrowArray* const array,
+                               const char* const column_name,
+                               scc_TypeLabel out_type_labels[const])
+{
+	if ((column_name == NULL) || (out_type_labels == NULL)) return false;
+	if (!iscc_arrow_check_array(schema, array) || !iscc_arrow_is_struct(schema)) return false;
+
+	const size_t num_rows = (size_t) array->length;
+	iscc_arrow_Column column;
+	if (!iscc_arrow_get_column(schema, array, 0, column_name, &column) ||
+	        iscc_arrow_has_nulls(&column, num_rows)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < num_rows; ++i) {
+		int64_t value;
+		if (!iscc_arrow_get_integer(&column, i, &value) || (value < 0)) return false;
+		out_type_labels[i] = (scc_TypeLabel) value;
+		if ((int64_t) out_type_labels[i] != value) return false;
+	}
+
+	return true;
+}
+
+
+bool scc_arrow_get_primary_data_points(const struct ArrowSchema* const schema,
+                                       const struct ArrowArray* const array,
+                                       const char* const column_name,
+                                       size_t* const out_len_primary_data_points,
+                                       scc_PointIndex out_primary_data_points[const])
+{
+	if ((column_name == NULL) || (out_len_primary_data_points == NULL) || (out_primary_data_points == NULL)) return false;
+	if (!iscc_arrow_check_array(schema, array) || !iscc_arrow_is_struct(schema)) return false;
+
+	const size_t num_rows = (size_t) array->length;
+	iscc_arrow_Column column;
+	if (!iscc_arrow_get_column(schema, array, 0, column_name, &column) ||
+	        (strcmp(column.schema->format, "b") != 0)) {
+		return false;
+	}
+
+	// Booleans are packed as bits, least significant bit first
+	const uint8_t* const bits = column.array->buffers[1];
+	size_t len_primary_data_points = 0;
+	for (size_t i = 0; i < num_rows; ++i) {
+		const size_t bit = column.offset + i;
+		if (!iscc_arrow_is_null(&column, i) && ((bits[bit / 8] >> (bit % 8)) & 1)) {
+			out_primary_data_points[len_primary_data_points] = (scc_PointIndex) i;
+			if ((size_t) out_primary_data_points[len_primary_data_points] != i) return false;
+			++len_primary_data_points;
+		}
+	}
+
+	*out_len_primary_data_points = len_primary_data_points;
+	return true;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static bool iscc_arrow_check_array(const struct ArrowSchema* const schema,
+                                   const struct ArrowArray* const array)
+{
+	if ((schema == NULL) || (array == NULL)) return false;
+	// Released structs may not be used
+	if ((schema->release == NULL) || (array->release == NULL)) return false;
+	if (schema->format == NULL) return false;
+	if ((array->length <= 0) || (array->offset < 0)) return false;
+	if ((uint64_t) array->length > (uint64_t) (SIZE_MAX / sizeof(double))) return false;
+	return true;
+}
+
+
+static bool iscc_arrow_is_struct(const struct ArrowSchema* const schema)
+{
+	return (strcmp(schema->format, "+s") == 0);
+}
+
+
+static bool iscc_arrow_get_column(const struct ArrowSchema* const schema,
+                                  const struct ArrowArray* const array,
+                                  const size_t column_index,
+                                  const char* const column_name,
+                                  iscc_arrow_Column* const out_column)
+{
+	if (!iscc_arrow_is_struct(schema)) {
+		if ((column_index != 0) || (column_name != NULL)) return false;
+		*out_column = (iscc_arrow_Column) {
+			.schema = schema,
+			.array = array,
+			.offset = (size_t) array->offset,
+		};
+	} else {
+		if (schema->n_children != array->n_children) return false;
+		// Null rows of the struct array itself are not supported
+		if ((array->n_buffers > 0) && (array->buffers[0] != NULL) && (array->null_count != 0)) return false;
+		int64_t child = (int64_t) column_index;
+		if (column_name != NULL) {
+			for (child = 0; child < schema->n_children; ++child) {
+				const char* const child_name = schema->children[child]->name;
+				if ((child_name != NULL) && (strcmp(child_name, column_name) == 0)) break;
+			}
+		}
+		if (child >= schema->n_children) return false;
+
+		// The rows of the struct array start at its offset in each child
+		const struct ArrowArray* const child_array = array->children[child];
+		if ((child_array->offset < 0) || (child_array->length < array->offset + array->length)) return false;
+		*out_column = (iscc_arrow_Column) {
+			.schema = schema->children[child],
+			.array = child_array,
+			.offset = (size_t) (child_array->offset + array->offset),
+		};
+	}
+
+	if ((out_column->schema->format == NULL) || (out_column->schema->dictionary != NULL)) return false;
+	if ((out_column->array->n_buffers < 2) || (out_column->array->buffers[1] == NULL)) return false;
+	return true;
+}
+
+
+static bool iscc_arrow_is_null(const iscc_arrow_Column* const column,
+                               const size_t row)
+{
+	const uint8_t* const validity = column->array->buffers[0];
+	if ((validity == NULL) || (column->array->null_count == 0)) return false;
+	const size_t bit = column->offset + row;
+	return ((validity[bit / 8] >> (bit % 8)) & 1) == 0;
+}
+
+
+static bool iscc_arrow_has_nulls(const iscc_arrow_Column* const column,
+                                 const size_t num_rows)
+{
+	if ((column->array->buffers[0] == NULL) || (column->array->null_count == 0)) return false;
+	for (size_t i = 0; i < num_rows; ++i) {
+		if (iscc_arrow_is_null(column, i)) return true;
+	}
+	return false;
+}
+
+
+static bool iscc_arrow_get_integer(const iscc_arrow_Column* const column,
+                                   const size_t row,
+                                   int64_t* const out_value)
+{
+	const void* const values = column->array->buffers[1];
+	const size_t pos = column->offset + row;
+	const char* const format = column->schema->format;
+	if (strcmp(format, "c") == 0) {
+		*out_value = ((const int8_t*) values)[pos];
+	} else if (strcmp(format, "C") == 0) {
+		*out_value = ((const uint8_t*) values)[pos];
+	} else if (strcmp(format, "s") == 0) {
+		*out_value = ((const int16_t*) values)[pos];
+	} else if (strcmp(format, "S") == 0) {
+		*out_value = ((const uint16_t*) values)[pos];
+	} else if (strcmp(format, "i") == 0) {
+		*out_value = ((const int32_t*) values)[pos];
+	} else if (strcmp(format, "I") == 0) {
+		*out_value = ((const uint32_t*) values)[pos];
+	} else if (strcmp(format, "l") == 0) {
+		*out_value = ((const int64_t*) values)[pos];
+	} else {
+		return false;
+	}
+	return true;
+}
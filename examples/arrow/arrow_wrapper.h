@@ -0,0 +1,106 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#ifndef SCC_ARROW_WRAPPER_HG
+#define SCC_ARROW_WRAPPER_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <scclust.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The Arrow C data interface, as given in the Arrow specification
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	const char* format;
+	const char* name;
+	const char* metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema** children;
+	struct ArrowSchema* dictionary;
+	void (*release)(struct ArrowSchema*);
+	void* private_data;
+};
+
+struct ArrowArray {
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void** buffers;
+	struct ArrowArray** children;
+	struct ArrowArray* dictionary;
+	void (*release)(struct ArrowArray*);
+	void* private_data;
+};
+
+#endif // ifndef ARROW_C_DATA_INTERFACE
+
+// Makes a data set from the columns named in `column_names` of a struct array, such as
+// an exported record batch. If `column_names` is NULL, all `num_columns` first columns
+// are used. An array that is not a struct is used as a data set with one column, in
+// which case `column_names` must be NULL and `num_columns` one. Columns must be float64
+// or float32 without nulls. Float64 columns are read in place, so the array must outlive
+// the data set. Float32 columns are converted to doubles, which are written to a buffer
+// returned in `out_converted` (NULL if there are none) that must be freed with `free`
+// after the data set.
+bool scc_arrow_init_data_set(const struct ArrowSchema* schema,
+                             const struct ArrowArray* array,
+                             size_t num_columns,
+                             const char* const column_names[],
+                             scc_DataSet** out_data_set,
+                             double** out_converted);
+
+// Reads the type labels of the data points from the integer column `column_name` of a
+// struct array. Labels must be non-negative and not null. `out_type_labels` must have
+// room for one label for each row of the array.
+bool scc_arrow_get_type_labels(const struct ArrowSchema* schema,
+                               const struct ArrowArray* array,
+                               const char* column_name,
+                               scc_TypeLabel out_type_labels[]);
+
+// Writes the indices of the rows of a struct array that are true in the boolean column
+// `column_name` to `out_primary_data_points`, and their number to `out_len_primary_data_points`.
+// Null values count as false. `out_primary_data_points` must have room for one index for
+// each row of the array.
+bool scc_arrow_get_primary_data_points(const struct ArrowSchema* schema,
+                                       const struct ArrowArray* array,
+                                       const char* column_name,
+                                       size_t* out_len_primary_data_points,
+                                       scc_PointIndex out_primary_data_points[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_ARROW_WRAPPER_HG
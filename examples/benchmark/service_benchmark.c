@@ -0,0 +1,376 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+// pthreads, `clock_gettime` and `getrusage` are POSIX
+#define _XOPEN_SOURCE 600
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <scclust.h>
+
+#define MAX_MIX_ENTRIES 16
+
+
+// One kind of job in the replayed mix
+typedef struct {
+	const char* spec;
+	uint64_t num_data_points;
+	uint32_t size_constraint;
+	bool hierarchical;
+	scc_SeedMethod seed_method;
+	scc_UnassignedMethod unassigned_method;
+	unsigned weight;
+	double* data_matrix;
+} MixEntry;
+
+
+// State shared by the client threads
+typedef struct {
+	uint32_t num_dimensions;
+	size_t num_mix_entries;
+	MixEntry* mix;
+	size_t num_jobs;
+	const size_t* job_mix;
+	double* job_latency;
+	bool* job_ok;
+	size_t next_job;
+	pthread_mutex_t next_job_lock;
+} ServiceState;
+
+
+static const char* const default_mix[] = {
+	"500:2:lexical:ignore:6",
+	"2000:3:inwards_updating:any_neighbor:3",
+	"10000:3:lexical:closest_assigned:1",
+	"5000:10:hierarchical:ignore:1",
+};
+
+
+static bool parse_mix_entry(const char* const spec,
+                            MixEntry* const out_entry)
+{
+	char method[32];
+	char unassigned[32];
+	unsigned long long num_data_points;
+	unsigned long size_constraint;
+	unsigned weight;
+	if (sscanf(spec, "%llu:%lu:%31[a-z_]:%31[a-z_]:%u",
+	           &num_data_points, &size_constraint, method, unassigned, &weight) != 5) {
+		return false;
+	}
+	if ((num_data_points < 2) || (size_constraint < 2) || (size_constraint > num_data_points) || (weight == 0)) {
+		return false;
+	}
+
+	*out_entry = (MixEntry) {
+		.spec = spec,
+		.num_data_points = (uint64_t) num_data_points,
+		.size_constraint = (uint32_t) size_constraint,
+		.hierarchical = false,
+		.seed_method = SCC_SM_LEXICAL,
+		.unassigned_method = SCC_UM_IGNORE,
+		.weight = weight,
+		.data_matrix = NULL,
+	};
+
+	if (strcmp(method, "hierarchical") == 0) out_entry->hierarchical = true;
+	else if (strcmp(method, "lexical") == 0) out_entry->seed_method = SCC_SM_LEXICAL;
+	else if (strcmp(method, "batches") == 0) out_entry->seed_method = SCC_SM_BATCHES;
+	else if (strcmp(method, "inwards_order") == 0) out_entry->seed_method = SCC_SM_INWARDS_ORDER;
+	else if (strcmp(method, "inwards_updating") == 0) out_entry->seed_method = SCC_SM_INWARDS_UPDATING;
+	else if (strcmp(method, "exclusion_order") == 0) out_entry->seed_method = SCC_SM_EXCLUSION_ORDER;
+	else if (strcmp(method, "exclusion_updating") == 0) out_entry->seed_method = SCC_SM_EXCLUSION_UPDATING;
+	else return false;
+
+	if (strcmp(unassigned, "ignore") == 0) out_entry->unassigned_method = SCC_UM_IGNORE;
+	else if (strcmp(unassigned, "any_neighbor") == 0) out_entry->unassigned_method = SCC_UM_ANY_NEIGHBOR;
+	else if (strcmp(unassigned, "closest_assigned") == 0) out_entry->unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+	else if (strcmp(unassigned, "closest_seed") == 0) out_entry->unassigned_method = SCC_UM_CLOSEST_SEED;
+	else return false;
+
+	// Batches cannot assign to the closest assigned or closest seed
+	if ((out_entry->seed_method == SCC_SM_BATCHES) &&
+	        (out_entry->unassigned_method != SCC_UM_IGNORE) &&
+	        (out_entry->unassigned_method != SCC_UM_ANY_NEIGHBOR)) {
+		return false;
+	}
+
+	return true;
+}
+
+
+static double seconds_since(const struct timespec* const start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((double) (now.tv_sec - start->tv_sec)) + 1e-9 * ((double) (now.tv_nsec - start->tv_nsec));
+}
+
+
+// A request: make the data set and clustering objects, cluster and free everything
+static bool run_job(const MixEntry* const entry,
+                    const uint32_t num_dimensions)
+{
+	scc_DataSet* data_set;
+	if (scc_init_data_set(entry->num_data_points,
+	                      num_dimensions,
+	                      (size_t) entry->num_data_points * num_dimensions,
+	                      entry->data_matrix,
+	                      &data_set) != SCC_ER_OK) {
+		return false;
+	}
+
+	scc_Clustering* clustering;
+	if (scc_init_empty_clustering(entry->num_data_points, NULL, &clustering) != SCC_ER_OK) {
+		scc_free_data_set(&data_set);
+		return false;
+	}
+
+	scc_ErrorCode ec;
+	if (entry->hierarchical) {
+		ec = scc_hierarchical_clustering(data_set, entry->size_constraint, false, clustering);
+	} else {
+		scc_ClusterOptions options = scc_get_default_options();
+		options.size_constraint = entry->size_constraint;
+		options.seed_method = entry->seed_method;
+		options.primary_unassigned_method = entry->unassigned_method;
+		ec = scc_sc_clustering(data_set, &options, clustering);
+	}
+
+	scc_free_clustering(&clustering);
+	scc_free_data_set(&data_set);
+
+	return (ec == SCC_ER_OK);
+}
+
+
+static void* client_thread(void* const arg)
+{
+	ServiceState* const state = arg;
+
+	while (true) {
+		pthread_mutex_lock(&state->next_job_lock);
+		const size_t job = state->next_job;
+		if (job < state->num_jobs) ++state->next_job;
+		pthread_mutex_unlock(&state->next_job_lock);
+		if (job >= state->num_jobs) break;
+
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		state->job_ok[job] = run_job(&state->mix[state->job_mix[job]], state->num_dimensions);
+		state->job_latency[job] = seconds_since(&start);
+	}
+
+	return NULL;
+}
+
+
+static int compare_double(const void* const a, const void* const b)
+{
+	const double da = *((const double*) a);
+	const double db = *((const double*) b);
+	return (da > db) - (da < db);
+}
+
+
+// Nearest-rank percentile of a sorted array
+static double percentile(const size_t len,
+                         const double sorted[const],
+                         const double p)
+{
+	size_t rank = (size_t) ceil(p * (double) len);
+	if (rank < 1) rank = 1;
+	return sorted[rank - 1];
+}
+
+
+static void print_latencies(const char* const label,
+                            const size_t len,
+                            double latencies[const])
+{
+	if (len == 0) {
+		printf("%-42s %6d\n", label, 0);
+		return;
+	}
+	qsort(latencies, len, sizeof(double), compare_double);
+	printf("%-42s %6zu %9.2f %9.2f %9.2f %9.2f\n",
+	       label,
+	       len,
+	       1000.0 * percentile(len, latencies, 0.50),
+	       1000.0 * percentile(len, latencies, 0.90),
+	       1000.0 * percentile(len, latencies, 0.99),
+	       1000.0 * latencies[len - 1]);
+}
+
+
+static void print_usage(const char* const program)
+{
+	fprintf(stderr,
+	        "Usage: %s [-t clients] [-n jobs] [-d dimensions] [-s seed] [mix entry ...]\n"
+	        "A mix entry is `points:size:method:unassigned:weight` where `method` is one of\n"
+	        "lexical, batches, inwards_order, inwards_updating, exclusion_order,\n"
+	        "exclusion_updating or hierarchical, and `unassigned` is one of ignore,\n"
+	        "any_neighbor, closest_assigned or closest_seed.\n",
+	        program);
+}
+
+
+int main(int argc, char* argv[]) {
+
+	size_t num_clients = 4;
+	size_t num_jobs = 200;
+	uint32_t num_dimensions = 2;
+	unsigned seed = 12345;
+
+	size_t num_mix_entries = 0;
+	MixEntry mix[MAX_MIX_ENTRIES];
+
+	for (int a = 1; a < argc; ++a) {
+		if ((strcmp(argv[a], "-t") == 0) && (a + 1 < argc)) {
+			num_clients = (size_t) strtoul(argv[++a], NULL, 10);
+		} else if ((strcmp(argv[a], "-n") == 0) && (a + 1 < argc)) {
+			num_jobs = (size_t) strtoul(argv[++a], NULL, 10);
+		} else if ((strcmp(argv[a], "-d") == 0) && (a + 1 < argc)) {
+			num_dimensions = (uint32_t) strtoul(argv[++a], NULL, 10);
+		} else if ((strcmp(argv[a], "-s") == 0) && (a + 1 < argc)) {
+			seed = (unsigned) strtoul(argv[++a], NULL, 10);
+		} else if ((num_mix_entries < MAX_MIX_ENTRIES) && parse_mix_entry(argv[a], &mix[num_mix_entries])) {
+			++num_mix_entries;
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((num_clients == 0) || (num_jobs == 0) || (num_dimensions == 0)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (num_mix_entries == 0) {
+		for (; num_mix_entries < sizeof(default_mix) / sizeof(default_mix[0]); ++num_mix_entries) {
+			if (!parse_mix_entry(default_mix[num_mix_entries], &mix[num_mix_entries])) return 1;
+		}
+	}
+
+	// Data and job schedule are made up front so that the clients only run the library
+	srand(seed);
+	unsigned total_weight = 0;
+	for (size_t m = 0; m < num_mix_entries; ++m) {
+		const size_t len_data_matrix = (size_t) mix[m].num_data_points * num_dimensions;
+		mix[m].data_matrix = malloc(sizeof(double[len_data_matrix]));
+		if (mix[m].data_matrix == NULL) return 1;
+		for (size_t i = 0; i < len_data_matrix; ++i) {
+			mix[m].data_matrix[i] = ((double) rand()) / ((double) RAND_MAX);
+		}
+		total_weight += mix[m].weight;
+	}
+
+	size_t* const job_mix = malloc(sizeof(size_t[num_jobs]));
+	double* const job_latency = malloc(sizeof(double[num_jobs]));
+	double* const sorted_latency = malloc(sizeof(double[num_jobs]));
+	bool* const job_ok = malloc(sizeof(bool[num_jobs]));
+	pthread_t* const clients = malloc(sizeof(pthread_t[num_clients]));
+	if ((job_mix == NULL) || (job_latency == NULL) || (sorted_latency == NULL) || (job_ok == NULL) || (clients == NULL)) return 1;
+
+	for (size_t j = 0; j < num_jobs; ++j) {
+		unsigned draw = (unsigned) rand() % total_weight;
+		size_t m = 0;
+		for (; draw >= mix[m].weight; ++m) draw -= mix[m].weight;
+		job_mix[j] = m;
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	const long rss_before = usage.ru_maxrss;
+
+	ServiceState state = {
+		.num_dimensions = num_dimensions,
+		.num_mix_entries = num_mix_entries,
+		.mix = mix,
+		.num_jobs = num_jobs,
+		.job_mix = job_mix,
+		.job_latency = job_latency,
+		.job_ok = job_ok,
+		.next_job = 0,
+	};
+	pthread_mutex_init(&state.next_job_lock, NULL);
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	size_t num_started = 0;
+	for (; num_started < num_clients; ++num_started) {
+		if (pthread_create(&clients[num_started], NULL, client_thread, &state) != 0) break;
+	}
+	for (size_t c = 0; c < num_started; ++c) {
+		pthread_join(clients[c], NULL);
+	}
+
+	const double wall_time = seconds_since(&start);
+	getrusage(RUSAGE_SELF, &usage);
+	pthread_mutex_destroy(&state.next_job_lock);
+
+	if (num_started == 0) return 1;
+
+	size_t num_failed = 0;
+	for (size_t j = 0; j < num_jobs; ++j) {
+		num_failed += !job_ok[j];
+	}
+
+	printf("Clients: %zu, jobs: %zu, dimensions: %u\n\n", num_started, num_jobs, num_dimensions);
+	printf("%-42s %6s %9s %9s %9s %9s\n", "Mix entry (latency in ms)", "jobs", "p50", "p90", "p99", "max");
+	for (size_t m = 0; m < num_mix_entries; ++m) {
+		size_t len = 0;
+		for (size_t j = 0; j < num_jobs; ++j) {
+			if (job_mix[j] == m) sorted_latency[len++] = job_latency[j];
+		}
+		print_latencies(mix[m].spec, len, sorted_latency);
+	}
+	memcpy(sorted_latency, job_latency, sizeof(double[num_jobs]));
+	print_latencies("All jobs", num_jobs, sorted_latency);
+
+	// `ru_maxrss` is in kilobytes on Linux and the BSDs
+	printf("\nWall time: %.3f s\n", wall_time);
+	printf("Throughput: %.2f jobs/s\n", ((double) num_jobs) / wall_time);
+	printf("Peak RSS: %.1f MiB (%.1f MiB before jobs)\n",
+	       ((double) usage.ru_maxrss) / 1024.0,
+	       ((double) rss_before) / 1024.0);
+	if (num_failed > 0) printf("Failed jobs: %zu\n", num_failed);
+
+	for (size_t m = 0; m < num_mix_entries; ++m) {
+		free(mix[m].data_matrix);
+	}
+	free(job_mix);
+	free(job_latency);
+	free(sorted_latency);
+	free(job_ok);
+	free(clients);
+
+	return (num_failed == 0) ? 0 : 1;
+}
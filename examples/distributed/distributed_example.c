@@ -0,0 +1,156 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+// `fork` is POSIX
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <scclust.h>
+#include "distributed_wrapper.h"
+
+#define NUM_DATA_POINTS 3000
+#define NUM_DIMENSIONS 2
+#define NUM_WORKERS 3
+
+
+// Clusters the data once with the built-in search and once with the workers
+static bool compare_clusterings(scc_DataSet* data_set,
+                                const scc_ClusterOptions* options,
+                                const char* worker_hosts[],
+                                const uint16_t worker_ports[])
+{
+	static scc_Clabel local_labels[NUM_DATA_POINTS];
+	static scc_Clabel distributed_labels[NUM_DATA_POINTS];
+	scc_Clustering* clustering;
+
+	if (scc_init_empty_clustering(NUM_DATA_POINTS, local_labels, &clustering) != SCC_ER_OK) return false;
+	scc_ErrorCode ec = scc_sc_clustering(data_set, options, clustering);
+	scc_free_clustering(&clustering);
+	if (ec != SCC_ER_OK) return false;
+
+	if (!scc_set_distributed_dist_search(NUM_WORKERS, worker_hosts, worker_ports)) return false;
+	if (scc_init_empty_clustering(NUM_DATA_POINTS, distributed_labels, &clustering) != SCC_ER_OK) return false;
+	ec = scc_sc_clustering(data_set, options, clustering);
+	scc_free_clustering(&clustering);
+	scc_close_distributed_dist_search();
+	if (ec != SCC_ER_OK) return false;
+
+	return (memcmp(local_labels, distributed_labels, sizeof(local_labels)) == 0);
+}
+
+
+int main(void) {
+
+	// Data: deterministic pseudo-random points
+	static double raw_data[NUM_DATA_POINTS * NUM_DIMENSIONS];
+	uint32_t state = 12345;
+	for (size_t i = 0; i < NUM_DATA_POINTS * NUM_DIMENSIONS; ++i) {
+		state = state * 1103515245u + 12345u;
+		raw_data[i] = ((double) (state >> 8)) / 16777216.0;
+	}
+
+	// Three clusterings are run, so start three workers per shard
+	const size_t num_runs = 3;
+	const char* worker_hosts[NUM_WORKERS];
+	uint16_t worker_ports[3][NUM_WORKERS];
+	pid_t worker_pids[3][NUM_WORKERS];
+
+	// Start workers on localhost, each holding a contiguous shard of the data matrix
+	for (size_t r = 0; r < num_runs; ++r) {
+		for (size_t w = 0; w < NUM_WORKERS; ++w) {
+			const size_t shard_begin = (w * NUM_DATA_POINTS) / NUM_WORKERS;
+			const size_t shard_end = ((w + 1) * NUM_DATA_POINTS) / NUM_WORKERS;
+
+			worker_hosts[w] = "127.0.0.1";
+			const int listen_fd = scc_distributed_listen("127.0.0.1", 0, &worker_ports[r][w]);
+			if (listen_fd < 0) return 1;
+
+			worker_pids[r][w] = fork();
+			if (worker_pids[r][w] < 0) return 1;
+			if (worker_pids[r][w] == 0) {
+				const bool served = scc_distributed_worker_serve(listen_fd,
+				                                                 shard_begin,
+				                                                 shard_end - shard_begin,
+				                                                 NUM_DIMENSIONS,
+				                                                 raw_data + shard_begin * NUM_DIMENSIONS);
+				close(listen_fd);
+				_exit(served ? 0 : 1);
+			}
+			close(listen_fd);
+		}
+	}
+
+	scc_DataSet* data_set;
+	if (scc_init_data_set(NUM_DATA_POINTS, NUM_DIMENSIONS, NUM_DATA_POINTS * NUM_DIMENSIONS, raw_data, &data_set) != SCC_ER_OK) return 1;
+
+	// Default options
+	scc_ClusterOptions options1 = scc_get_default_options();
+	options1.size_constraint = 3;
+
+	// Radius constraint and assignment of leftovers to closest assigned point
+	scc_ClusterOptions options2 = scc_get_default_options();
+	options2.size_constraint = 5;
+	options2.seed_method = SCC_SM_INWARDS_UPDATING;
+	options2.seed_radius = SCC_RM_USE_SUPPLIED;
+	options2.seed_supplied_radius = 0.05;
+	options2.primary_unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+
+	const bool same1 = compare_clusterings(data_set, &options1, worker_hosts, worker_ports[0]);
+	const bool same2 = compare_clusterings(data_set, &options2, worker_hosts, worker_ports[1]);
+
+	scc_free_data_set(&data_set);
+
+	// The same points stored as separate column arrays
+	static double columns[NUM_DIMENSIONS][NUM_DATA_POINTS];
+	const double* column_arrays[NUM_DIMENSIONS];
+	for (size_t d = 0; d < NUM_DIMENSIONS; ++d) {
+		for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+			columns[d][i] = raw_data[i * NUM_DIMENSIONS + d];
+		}
+		column_arrays[d] = columns[d];
+	}
+	if (scc_init_data_set_column_arrays(NUM_DATA_POINTS, NUM_DIMENSIONS, column_arrays, &data_set) != SCC_ER_OK) return 1;
+	const bool same3 = compare_clusterings(data_set, &options1, worker_hosts, worker_ports[2]);
+	scc_free_data_set(&data_set);
+
+	bool workers_ok = true;
+	for (size_t r = 0; r < num_runs; ++r) {
+		for (size_t w = 0; w < NUM_WORKERS; ++w) {
+			int status;
+			workers_ok = (waitpid(worker_pids[r][w], &status, 0) == worker_pids[r][w]) &&
+			             WIFEXITED(status) && (WEXITSTATUS(status) == 0) && workers_ok;
+		}
+	}
+
+	printf("Default options: %s\n", same1 ? "distributed and local clusterings agree" : "MISMATCH");
+	printf("Radius options:  %s\n", same2 ? "distributed and local clusterings agree" : "MISMATCH");
+	printf("Column arrays:   %s\n", same3 ? "distributed and local clusterings agree" : "MISMATCH");
+	printf("Workers: %s\n", workers_ok ? "shut down cleanly" : "FAILED");
+
+	return (same1 && same2 && same3 && workers_ok) ? 0 : 1;
+}
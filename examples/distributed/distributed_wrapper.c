@@ -0,0 +1,732 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+// Sockets are POSIX
+#define _POSIX_C_SOURCE 200112L
+
+#include "distributed_wrapper.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/data_set_struct.h>
+#include <src/dist_search_imp.h>
+
+
+// =============================================================================
+// Protocol
+// =============================================================================
+
+// All messages are sequences of `uint64_t` and `double` in host byte order, so
+// coordinator and workers must run on machines with the same representation.
+//
+// On connect, the worker sends: shard_begin, shard_len, num_dimensions.
+//
+// Requests from the coordinator start with an operation code:
+//   INIT:     search_id, has_indices, len_search_indices, [search indices]
+//             -> number of search points in the shard
+//   SEARCH:   search_id, num_queries, k, radius_search, radius (double),
+//             query coordinates (num_queries * num_dimensions doubles)
+//             -> num_queries * k indices, num_queries * k squared distances
+//   CLOSE:    search_id
+//             -> 0
+//   SHUTDOWN: (no reply)
+//
+// Each query's partial list is sorted nearest first and padded with
+// `ISCC_DD_NO_INDEX` when the shard has fewer than `k` candidates.
+
+static const uint64_t ISCC_DD_OP_INIT = 1;
+static const uint64_t ISCC_DD_OP_SEARCH = 2;
+static const uint64_t ISCC_DD_OP_CLOSE = 3;
+static const uint64_t ISCC_DD_OP_SHUTDOWN = 4;
+
+static const uint64_t ISCC_DD_NO_INDEX = UINT64_MAX;
+
+// Number of queries sent to the workers in each request
+static const size_t ISCC_DD_QUERY_BATCH = 1024;
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+typedef struct iscc_dd_WorkerSearch {
+	uint64_t search_id;
+	size_t shard_begin;
+	size_t len_rows;
+	size_t* rows;
+} iscc_dd_WorkerSearch;
+
+
+static const int32_t ISCC_DD_NN_SEARCH_STRUCT_VERSION = 291650001;
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	scc_DataSet* data_set;
+	uint64_t search_id;
+	size_t len_search_indices;
+};
+
+
+static size_t iscc_dd_num_workers = 0;
+static int* iscc_dd_worker_fds = NULL;
+static size_t iscc_dd_num_data_points = 0;
+static uint_fast16_t iscc_dd_num_dimensions = 0;
+static uint64_t iscc_dd_next_search_id = 0;
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static bool iscc_dd_send_all(int fd,
+                             const void* buffer,
+                             size_t length);
+
+
+static bool iscc_dd_recv_all(int fd,
+                             void* buffer,
+                             size_t length);
+
+
+static bool iscc_dd_send_u64(int fd,
+                             uint64_t value);
+
+
+static bool iscc_dd_recv_u64(int fd,
+                             uint64_t* out_value);
+
+
+static bool iscc_dd_worker_init_search(int fd,
+                                       size_t shard_begin,
+                                       size_t shard_len,
+                                       iscc_dd_WorkerSearch* out_search);
+
+
+static bool iscc_dd_worker_search(int fd,
+                                  uint_fast16_t num_dimensions,
+                                  const double shard_matrix[],
+                                  const iscc_dd_WorkerSearch* search);
+
+
+static bool iscc_dd_init_nn_search_object(void* data_set,
+                                          size_t len_search_indices,
+                                          const scc_PointIndex search_indices[],
+                                          iscc_NNSearchObject** out_nn_search_object);
+
+
+static bool iscc_dd_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
+                                            size_t len_query_indices,
+                                            const scc_PointIndex query_indices[],
+                                            uint32_t k,
+                                            bool radius_search,
+                                            double radius,
+                                            size_t* out_num_ok_queries,
+                                            scc_PointIndex out_query_indices[],
+                                            scc_PointIndex out_nn_indices[]);
+
+
+static bool iscc_dd_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+int scc_distributed_listen(const char* const host,
+                           const uint16_t port,
+                           uint16_t* const out_port)
+{
+	assert(host != NULL);
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &address.sin_addr) != 1) return -1;
+
+	const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd < 0) return -1;
+
+	const int reuse = 1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	if ((bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) != 0) ||
+	        (listen(listen_fd, 1) != 0)) {
+		close(listen_fd);
+		return -1;
+	}
+
+	if (out_port != NULL) {
+		socklen_t address_len = sizeof(address);
+		if (getsockname(listen_fd, (struct sockaddr*) &address, &address_len) != 0) {
+			close(listen_fd);
+			return -1;
+		}
+		*out_port = ntohs(address.sin_port);
+	}
+
+	return listen_fd;
+}
+
+
+bool scc_distributed_worker_serve(const int listen_fd,
+                                  const size_t shard_begin,
+                                  const size_t shard_len,
+                                  const uint_fast16_t num_dimensions,
+                                  const double shard_matrix[const])
+{
+	assert(listen_fd >= 0);
+	assert(num_dimensions > 0);
+	assert(shard_len == 0 || shard_matrix != NULL);
+
+	const int fd = accept(listen_fd, NULL, NULL);
+	if (fd < 0) return false;
+
+	if (!iscc_dd_send_u64(fd, (uint64_t) shard_begin) ||
+	        !iscc_dd_send_u64(fd, (uint64_t) shard_len) ||
+	        !iscc_dd_send_u64(fd, (uint64_t) num_dimensions)) {
+		close(fd);
+		return false;
+	}
+
+	size_t num_searches = 0;
+	iscc_dd_WorkerSearch* searches = NULL;
+
+	bool ok = true;
+	while (ok) {
+		uint64_t op;
+		if (!iscc_dd_recv_u64(fd, &op)) {
+			ok = false;
+		} else if (op == ISCC_DD_OP_INIT) {
+			iscc_dd_WorkerSearch* const tmp_searches = realloc(searches, sizeof(iscc_dd_WorkerSearch[num_searches + 1]));
+			if (tmp_searches == NULL) {
+				ok = false;
+			} else {
+				searches = tmp_searches;
+				ok = iscc_dd_worker_init_search(fd, shard_begin, shard_len, &searches[num_searches]);
+				if (ok) ++num_searches;
+			}
+		} else if (op == ISCC_DD_OP_SEARCH) {
+			uint64_t search_id;
+			ok = iscc_dd_recv_u64(fd, &search_id);
+			size_t s = 0;
+			for (; ok && (s < num_searches) && (searches[s].search_id != search_id); ++s);
+			ok = ok && (s < num_searches) && iscc_dd_worker_search(fd, num_dimensions, shard_matrix, &searches[s]);
+		} else if (op == ISCC_DD_OP_CLOSE) {
+			uint64_t search_id;
+			ok = iscc_dd_recv_u64(fd, &search_id);
+			size_t s = 0;
+			for (; ok && (s < num_searches) && (searches[s].search_id != search_id); ++s);
+			if (ok && (s < num_searches)) {
+				free(searches[s].rows);
+				searches[s] = searches[num_searches - 1];
+				--num_searches;
+			}
+			ok = ok && iscc_dd_send_u64(fd, 0);
+		} else if (op == ISCC_DD_OP_SHUTDOWN) {
+			break;
+		} else {
+			ok = false;
+		}
+	}
+
+	for (size_t s = 0; s < num_searches; ++s) {
+		free(searches[s].rows);
+	}
+	free(searches);
+	close(fd);
+
+	return ok;
+}
+
+
+bool scc_set_distributed_dist_search(const size_t num_workers,
+                                     const char* const worker_hosts[const],
+                                     const uint16_t worker_ports[const])
+{
+	if ((num_workers == 0) || (worker_hosts == NULL) || (worker_ports == NULL)) return false;
+	if (iscc_dd_worker_fds != NULL) return false;
+
+	iscc_dd_worker_fds = malloc(sizeof(int[num_workers]));
+	if (iscc_dd_worker_fds == NULL) return false;
+	iscc_dd_num_workers = 0;
+	iscc_dd_num_data_points = 0;
+	iscc_dd_num_dimensions = 0;
+
+	for (size_t w = 0; w < num_workers; ++w) {
+		struct sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(worker_ports[w]);
+		if (inet_pton(AF_INET, worker_hosts[w], &address.sin_addr) != 1) break;
+
+		const int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) break;
+		if (connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+			close(fd);
+			break;
+		}
+		iscc_dd_worker_fds[w] = fd;
+		++iscc_dd_num_workers;
+
+		// Shards must be listed in order and be contiguous
+		uint64_t shard_begin, shard_len, num_dimensions;
+		if (!iscc_dd_recv_u64(fd, &shard_begin) ||
+		        !iscc_dd_recv_u64(fd, &shard_len) ||
+		        !iscc_dd_recv_u64(fd, &num_dimensions)) break;
+		if (shard_begin != iscc_dd_num_data_points) break;
+		if ((w > 0) && (num_dimensions != iscc_dd_num_dimensions)) break;
+		iscc_dd_num_data_points += (size_t) shard_len;
+		iscc_dd_num_dimensions = (uint_fast16_t) num_dimensions;
+	}
+
+	if ((iscc_dd_num_workers != num_workers) ||
+	        (iscc_dd_num_data_points == 0) ||
+	        !scc_set_dist_functions(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	                                iscc_dd_init_nn_search_object,
+	                                iscc_dd_nearest_neighbor_search,
+	                                iscc_dd_close_nn_search_object)) {
+		scc_close_distributed_dist_search();
+		return false;
+	}
+
+	return true;
+}
+
+
+void scc_close_distributed_dist_search(void)
+{
+	for (size_t w = 0; w < iscc_dd_num_workers; ++w) {
+		iscc_dd_send_u64(iscc_dd_worker_fds[w], ISCC_DD_OP_SHUTDOWN);
+		close(iscc_dd_worker_fds[w]);
+	}
+	free(iscc_dd_worker_fds);
+	iscc_dd_worker_fds = NULL;
+	iscc_dd_num_workers = 0;
+	iscc_dd_num_data_points = 0;
+	iscc_dd_num_dimensions = 0;
+	scc_reset_dist_functions();
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static bool iscc_dd_send_all(const int fd,
+                             const void* const buffer,
+                             const size_t length)
+{
+	const char* write = buffer;
+	size_t remaining = length;
+	while (remaining > 0) {
+		const ssize_t sent = send(fd, write, remaining, 0);
+		if (sent < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		write += sent;
+		remaining -= (size_t) sent;
+	}
+	return true;
+}
+
+
+static bool iscc_dd_recv_all(const int fd,
+                             void* const buffer,
+                             const size_t length)
+{
+	char* read = buffer;
+	size_t remaining = length;
+	while (remaining > 0) {
+		const ssize_t received = recv(fd, read, remaining, 0);
+		if (received < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (received == 0) return false;
+		read += received;
+		remaining -= (size_t) received;
+	}
+	return true;
+}
+
+
+static bool iscc_dd_send_u64(const int fd,
+                             const uint64_t value)
+{
+	return iscc_dd_send_all(fd, &value, sizeof(uint64_t));
+}
+
+
+static bool iscc_dd_recv_u64(const int fd,
+                             uint64_t* const out_value)
+{
+	return iscc_dd_recv_all(fd, out_value, sizeof(uint64_t));
+}
+
+
+static bool iscc_dd_worker_init_search(const int fd,
+                                       const size_t shard_begin,
+                                       const size_t shard_len,
+                                       iscc_dd_WorkerSearch* const out_search)
+{
+	uint64_t search_id, has_indices, len_search_indices;
+	if (!iscc_dd_recv_u64(fd, &search_id) ||
+	        !iscc_dd_recv_u64(fd, &has_indices) ||
+	        !iscc_dd_recv_u64(fd, &len_search_indices)) return false;
+
+	*out_search = (iscc_dd_WorkerSearch) {
+		.search_id = search_id,
+		.shard_begin = shard_begin,
+		.len_rows = 0,
+		.rows = malloc(sizeof(size_t[shard_len + 1])),
+	};
+	if (out_search->rows == NULL) return false;
+
+	// Keep the search points in the shard, in the coordinator's order
+	if (has_indices == 0) {
+		for (size_t i = 0; (i < shard_len) && (shard_begin + i < len_search_indices); ++i) {
+			out_search->rows[out_search->len_rows] = i;
+			++(out_search->len_rows);
+		}
+	} else {
+		for (uint64_t i = 0; i < len_search_indices; ++i) {
+			uint64_t index;
+			if (!iscc_dd_recv_u64(fd, &index)) {
+				free(out_search->rows);
+				return false;
+			}
+			if ((index >= shard_begin) && (index < shard_begin + shard_len) && (out_search->len_rows < shard_len)) {
+				out_search->rows[out_search->len_rows] = (size_t) index - shard_begin;
+				++(out_search->len_rows);
+			}
+		}
+	}
+
+	if (!iscc_dd_send_u64(fd, (uint64_t) out_search->len_rows)) {
+		free(out_search->rows);
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool iscc_dd_worker_search(const int fd,
+                                  const uint_fast16_t num_dimensions,
+                                  const double shard_matrix[const],
+                                  const iscc_dd_WorkerSearch* const search)
+{
+	uint64_t num_queries, k, radius_search;
+	double radius;
+	if (!iscc_dd_recv_u64(fd, &num_queries) ||
+	        !iscc_dd_recv_u64(fd, &k) ||
+	        !iscc_dd_recv_u64(fd, &radius_search) ||
+	        !iscc_dd_recv_all(fd, &radius, sizeof(double))) return false;
+	if ((num_queries == 0) || (k == 0)) return false;
+
+	const size_t len_out = (size_t) (num_queries * k);
+	double* const queries = malloc(sizeof(double[(size_t) num_queries * num_dimensions]));
+	uint64_t* const out_indices = malloc(sizeof(uint64_t[len_out]));
+	double* const out_dists = malloc(sizeof(double[len_out]));
+	if ((queries == NULL) || (out_indices == NULL) || (out_dists == NULL)) {
+		free(queries);
+		free(out_indices);
+		free(out_dists);
+		return false;
+	}
+
+	if (!iscc_dd_recv_all(fd, queries, sizeof(double[(size_t) num_queries * num_dimensions]))) {
+		free(queries);
+		free(out_indices);
+		free(out_dists);
+		return false;
+	}
+
+	const double radius_sq = radius * radius;
+	for (size_t q = 0; q < num_queries; ++q) {
+		const double* const query = queries + q * num_dimensions;
+		uint64_t* const q_indices = out_indices + q * k;
+		double* const q_dists = out_dists + q * k;
+		size_t found = 0;
+
+		for (size_t s = 0; s < search->len_rows; ++s) {
+			const double* const point = shard_matrix + search->rows[s] * num_dimensions;
+			double sq_dist = 0.0;
+			for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+				const double value_diff = query[d] - point[d];
+				sq_dist += value_diff * value_diff;
+			}
+			if ((radius_search != 0) && (sq_dist > radius_sq)) continue;
+			if ((found == k) && (sq_dist >= q_dists[k - 1])) continue;
+
+			// Insert keeping earlier points first among equal distances
+			size_t pos = (found < k) ? found : (size_t) (k - 1);
+			for (; (pos > 0) && (sq_dist < q_dists[pos - 1]); --pos) {
+				q_dists[pos] = q_dists[pos - 1];
+				q_indices[pos] = q_indices[pos - 1];
+			}
+			q_dists[pos] = sq_dist;
+			q_indices[pos] = (uint64_t) (search->shard_begin + search->rows[s]);
+			if (found < k) ++found;
+		}
+
+		for (size_t i = found; i < k; ++i) {
+			q_indices[i] = ISCC_DD_NO_INDEX;
+			q_dists[i] = 0.0;
+		}
+	}
+
+	const bool sent = iscc_dd_send_all(fd, out_indices, sizeof(uint64_t[len_out])) &&
+	                  iscc_dd_send_all(fd, out_dists, sizeof(double[len_out]));
+
+	free(queries);
+	free(out_indices);
+	free(out_dists);
+
+	return sent;
+}
+
+
+static bool iscc_dd_init_nn_search_object(void* const data_set,
+                                          const size_t len_search_indices,
+                                          const scc_PointIndex search_indices[const],
+                                          iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_dd_worker_fds != NULL);
+	assert(iscc_imp_check_data_set(data_set));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	// The workers compute Euclidean distances on their own shards, so Gower, binary
+	// and geo data sets are not supported
+	scc_DataSet* const data_set_cast = (scc_DataSet*) data_set;
+	if ((data_set_cast->num_data_points != iscc_dd_num_data_points) ||
+	        (data_set_cast->num_dimensions != iscc_dd_num_dimensions) ||
+	        (data_set_cast->gower_weights != NULL) || (data_set_cast->binary_matrix != NULL) ||
+	        (data_set_cast->geo_matrix != NULL)) return false;
+
+	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	if (*out_nn_search_object == NULL) return false;
+
+	**out_nn_search_object = (iscc_NNSearchObject) {
+		.nn_search_version = ISCC_DD_NN_SEARCH_STRUCT_VERSION,
+		.data_set = data_set_cast,
+		.search_id = iscc_dd_next_search_id,
+		.len_search_indices = len_search_indices,
+	};
+	++iscc_dd_next_search_id;
+
+	uint64_t* search_indices_u64 = NULL;
+	if (search_indices != NULL) {
+		search_indices_u64 = malloc(sizeof(uint64_t[len_search_indices]));
+		if (search_indices_u64 == NULL) {
+			free(*out_nn_search_object);
+			*out_nn_search_object = NULL;
+			return false;
+		}
+		for (size_t i = 0; i < len_search_indices; ++i) {
+			search_indices_u64[i] = (uint64_t) search_indices[i];
+		}
+	}
+
+	bool ok = true;
+	for (size_t w = 0; ok && (w < iscc_dd_num_workers); ++w) {
+		const int fd = iscc_dd_worker_fds[w];
+		ok = iscc_dd_send_u64(fd, ISCC_DD_OP_INIT) &&
+		     iscc_dd_send_u64(fd, (*out_nn_search_object)->search_id) &&
+		     iscc_dd_send_u64(fd, (search_indices != NULL)) &&
+		     iscc_dd_send_u64(fd, (uint64_t) len_search_indices) &&
+		     ((search_indices_u64 == NULL) || iscc_dd_send_all(fd, search_indices_u64, sizeof(uint64_t[len_search_indices])));
+	}
+
+	uint64_t total_search_points = 0;
+	for (size_t w = 0; ok && (w < iscc_dd_num_workers); ++w) {
+		uint64_t worker_search_points;
+		ok = iscc_dd_recv_u64(iscc_dd_worker_fds[w], &worker_search_points);
+		total_search_points += worker_search_points;
+	}
+
+	free(search_indices_u64);
+
+	if (!ok || (total_search_points != len_search_indices)) {
+		free(*out_nn_search_object);
+		*out_nn_search_object = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool iscc_dd_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                            const size_t len_query_indices,
+                                            const scc_PointIndex query_indices[const],
+                                            const uint32_t k,
+                                            const bool radius_search,
+                                            const double radius,
+                                            size_t* const out_num_ok_queries,
+                                            scc_PointIndex out_query_indices[const],
+                                            scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_DD_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->len_search_indices);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+	const size_t batch_size = (len_query_indices < ISCC_DD_QUERY_BATCH) ? len_query_indices : ISCC_DD_QUERY_BATCH;
+	const size_t num_workers = iscc_dd_num_workers;
+
+	double* const queries = malloc(sizeof(double[batch_size * num_dimensions]));
+	uint64_t* const partial_indices = malloc(sizeof(uint64_t[num_workers * batch_size * k]));
+	double* const partial_dists = malloc(sizeof(double[num_workers * batch_size * k]));
+	size_t* const merge_pos = malloc(sizeof(size_t[num_workers]));
+	if ((queries == NULL) || (partial_indices == NULL) || (partial_dists == NULL) || (merge_pos == NULL)) {
+		free(queries);
+		free(partial_indices);
+		free(partial_dists);
+		free(merge_pos);
+		return false;
+	}
+
+	bool ok = true;
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t batch_start = 0; ok && (batch_start < len_query_indices); batch_start += batch_size) {
+		const size_t len_batch = ((len_query_indices - batch_start) < batch_size) ? (len_query_indices - batch_start) : batch_size;
+
+		for (size_t q = 0; q < len_batch; ++q) {
+			const size_t query = (query_indices == NULL) ? (batch_start + q) : (size_t) query_indices[batch_start + q];
+			if ((data_set->column_arrays == NULL) && (data_set->columns == NULL) && (data_set->column_stride == 1)) {
+				memcpy(queries + q * num_dimensions, data_set->data_matrix + query * data_set->row_stride, sizeof(double[num_dimensions]));
+			} else {
+				for (size_t d = 0; d < num_dimensions; ++d) {
+					queries[q * num_dimensions + d] = iscc_get_column_data(data_set, d)[query * data_set->row_stride];
+				}
+			}
+		}
+
+		// Scatter to all workers before gathering, so they search concurrently
+		for (size_t w = 0; ok && (w < num_workers); ++w) {
+			const int fd = iscc_dd_worker_fds[w];
+			ok = iscc_dd_send_u64(fd, ISCC_DD_OP_SEARCH) &&
+			     iscc_dd_send_u64(fd, nn_search_object->search_id) &&
+			     iscc_dd_send_u64(fd, (uint64_t) len_batch) &&
+			     iscc_dd_send_u64(fd, (uint64_t) k) &&
+			     iscc_dd_send_u64(fd, radius_search) &&
+			     iscc_dd_send_all(fd, &radius, sizeof(double)) &&
+			     iscc_dd_send_all(fd, queries, sizeof(double[len_batch * num_dimensions]));
+		}
+
+		for (size_t w = 0; ok && (w < num_workers); ++w) {
+			const int fd = iscc_dd_worker_fds[w];
+			ok = iscc_dd_recv_all(fd, partial_indices + w * len_batch * k, sizeof(uint64_t[len_batch * k])) &&
+			     iscc_dd_recv_all(fd, partial_dists + w * len_batch * k, sizeof(double[len_batch * k]));
+		}
+
+		// k-way merge of the partial lists. Shards are in index order,
+		// so taking the lower worker on ties keeps the earlier point first.
+		for (size_t q = 0; ok && (q < len_batch); ++q) {
+			for (size_t w = 0; w < num_workers; ++w) merge_pos[w] = 0;
+
+			uint32_t found = 0;
+			for (; found < k; ++found) {
+				size_t best_w = num_workers;
+				double best_dist = 0.0;
+				for (size_t w = 0; w < num_workers; ++w) {
+					if (merge_pos[w] == k) continue;
+					const size_t at = (w * len_batch + q) * k + merge_pos[w];
+					if (partial_indices[at] == ISCC_DD_NO_INDEX) continue;
+					if ((best_w == num_workers) || (partial_dists[at] < best_dist)) {
+						best_w = w;
+						best_dist = partial_dists[at];
+					}
+				}
+				if (best_w == num_workers) break;
+				index_write[found] = (scc_PointIndex) partial_indices[(best_w * len_batch + q) * k + merge_pos[best_w]];
+				++merge_pos[best_w];
+			}
+
+			if (found == k) {
+				if (out_query_indices != NULL) {
+					out_query_indices[num_ok_queries] = (query_indices == NULL) ? (scc_PointIndex) (batch_start + q) : query_indices[batch_start + q];
+				}
+				++num_ok_queries;
+				index_write += k;
+			} else if (!radius_search) {
+				ok = false;
+			}
+		}
+	}
+
+	free(queries);
+	free(partial_indices);
+	free(partial_dists);
+	free(merge_pos);
+
+	if (!ok) return false;
+
+	*out_num_ok_queries = num_ok_queries;
+
+	return true;
+}
+
+
+static bool iscc_dd_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	assert(nn_search_object != NULL);
+	assert(*nn_search_object != NULL);
+	assert((*nn_search_object)->nn_search_version == ISCC_DD_NN_SEARCH_STRUCT_VERSION);
+
+	bool ok = true;
+	for (size_t w = 0; w < iscc_dd_num_workers; ++w) {
+		ok = iscc_dd_send_u64(iscc_dd_worker_fds[w], ISCC_DD_OP_CLOSE) &&
+		     iscc_dd_send_u64(iscc_dd_worker_fds[w], (*nn_search_object)->search_id) && ok;
+	}
+	for (size_t w = 0; w < iscc_dd_num_workers; ++w) {
+		uint64_t ack;
+		ok = iscc_dd_recv_u64(iscc_dd_worker_fds[w], &ack) && ok;
+	}
+
+	free(*nn_search_object);
+	*nn_search_object = NULL;
+
+	return ok;
+}
@@ -0,0 +1,60 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DISTRIBUTED_WRAPPER_HG
+#define SCC_DISTRIBUTED_WRAPPER_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opens a listening socket on `host`. If `port` is zero, an ephemeral
+// port is chosen and written to `out_port`. Returns -1 on failure.
+int scc_distributed_listen(const char* host,
+                           uint16_t port,
+                           uint16_t* out_port);
+
+// Serves nearest neighbor requests for one coordinator connection on `listen_fd`.
+// The worker holds rows `shard_begin` to `shard_begin + shard_len - 1` of the
+// complete data matrix. Returns when the coordinator shuts the worker down.
+bool scc_distributed_worker_serve(int listen_fd,
+                                  size_t shard_begin,
+                                  size_t shard_len,
+                                  uint_fast16_t num_dimensions,
+                                  const double shard_matrix[]);
+
+// Connects to the workers and uses them for all nearest neighbor searches.
+// Together, the workers' shards must cover the data set without overlap.
+bool scc_set_distributed_dist_search(size_t num_workers,
+                                     const char* const worker_hosts[],
+                                     const uint16_t worker_ports[]);
+
+// Shuts down the workers and resets the distance functions.
+void scc_close_distributed_dist_search(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DISTRIBUTED_WRAPPER_HG
@@ -0,0 +1,187 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+// `pthread` and `clock_gettime` are POSIX
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <scclust.h>
+#include <scclust_spi.h>
+#include "ivf_wrapper.h"
+
+#define NUM_DATA_POINTS 20000
+#define NUM_DIMENSIONS 16
+#define NUM_THREADS 4
+
+
+// Runs the loop body on `NUM_THREADS` threads, each taking a contiguous part of the range
+typedef struct ThreadTask {
+	size_t begin;
+	size_t end;
+	scc_parallel_for_body body;
+	void* context;
+} ThreadTask;
+
+
+static void* run_task(void* const task_ptr)
+{
+	ThreadTask* const task = (ThreadTask*) task_ptr;
+	task->body(task->begin, task->end, task->context);
+	return NULL;
+}
+
+
+static void thread_parallel_for(const size_t begin,
+                                const size_t end,
+                                const size_t grain,
+                                const scc_parallel_for_body body,
+                                void* const context)
+{
+	pthread_t threads[NUM_THREADS];
+	ThreadTask tasks[NUM_THREADS];
+	bool started[NUM_THREADS];
+	size_t num_tasks = (end - begin + grain - 1) / grain;
+	if (num_tasks > NUM_THREADS) num_tasks = NUM_THREADS;
+
+	for (size_t t = 0; t < num_tasks; ++t) {
+		tasks[t] = (ThreadTask) {
+			.begin = begin + (t * (end - begin)) / num_tasks,
+			.end = begin + ((t + 1) * (end - begin)) / num_tasks,
+			.body = body,
+			.context = context,
+		};
+		started[t] = (t > 0) && (pthread_create(&threads[t], NULL, run_task, &tasks[t]) == 0);
+	}
+	// The first part, and parts whose thread could not be started, run on this thread
+	for (size_t t = 0; t < num_tasks; ++t) {
+		if (!started[t]) run_task(&tasks[t]);
+	}
+	for (size_t t = 1; t < num_tasks; ++t) {
+		if (started[t]) pthread_join(threads[t], NULL);
+	}
+}
+
+
+static double seconds_since(const struct timespec* const start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) (now.tv_sec - start->tv_sec) + ((double) (now.tv_nsec - start->tv_nsec)) / 1e9;
+}
+
+
+// Clusters the data set with the current distance functions and reports the time
+static bool run_clustering(scc_DataSet* const data_set,
+                           const scc_ClusterOptions* const options,
+                           scc_Clabel labels[const],
+                           const char* const name)
+{
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	scc_Clustering* clustering;
+	if (scc_init_empty_clustering(NUM_DATA_POINTS, labels, &clustering) != SCC_ER_OK) return false;
+	const scc_ErrorCode ec = scc_sc_clustering(data_set, options, clustering);
+	scc_free_clustering(&clustering);
+	printf("%-22s %6.2f s\n", name, seconds_since(&start));
+	return (ec == SCC_ER_OK);
+}
+
+
+int main(void) {
+
+	// Data: deterministic pseudo-random points around 50 centers
+	static double raw_data[NUM_DATA_POINTS * NUM_DIMENSIONS];
+	static double centers[50 * NUM_DIMENSIONS];
+	uint32_t state = 12345;
+	for (size_t i = 0; i < 50 * NUM_DIMENSIONS; ++i) {
+		state = state * 1103515245u + 12345u;
+		centers[i] = 10.0 * ((double) (state >> 8)) / 16777216.0;
+	}
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		for (size_t d = 0; d < NUM_DIMENSIONS; ++d) {
+			state = state * 1103515245u + 12345u;
+			raw_data[i * NUM_DIMENSIONS + d] = centers[(i % 50) * NUM_DIMENSIONS + d] + ((double) (state >> 8)) / 16777216.0;
+		}
+	}
+
+	scc_DataSet* data_set;
+	if (scc_init_data_set(NUM_DATA_POINTS, NUM_DIMENSIONS, NUM_DATA_POINTS * NUM_DIMENSIONS, raw_data, &data_set) != SCC_ER_OK) return 1;
+
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 4;
+
+	static scc_Clabel builtin_labels[NUM_DATA_POINTS];
+	static scc_Clabel exact_labels[NUM_DATA_POINTS];
+	static scc_Clabel approx_labels[NUM_DATA_POINTS];
+	static scc_Clabel column_labels[NUM_DATA_POINTS];
+
+	// The same points stored as separate column arrays
+	static double columns[NUM_DIMENSIONS][NUM_DATA_POINTS];
+	const double* column_arrays[NUM_DIMENSIONS];
+	for (size_t d = 0; d < NUM_DIMENSIONS; ++d) {
+		for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+			columns[d][i] = raw_data[i * NUM_DIMENSIONS + d];
+		}
+		column_arrays[d] = columns[d];
+	}
+	scc_DataSet* column_data_set;
+	if (scc_init_data_set_column_arrays(NUM_DATA_POINTS, NUM_DIMENSIONS, column_arrays, &column_data_set) != SCC_ER_OK) return 1;
+
+	scc_set_parallel_for(thread_parallel_for);
+
+	bool ok = run_clustering(data_set, &options, builtin_labels, "Built-in search:");
+
+	ok = ok && scc_set_ivf_dist_search(0, 1, true);
+	ok = ok && run_clustering(data_set, &options, exact_labels, "IVF, exact:");
+	ok = ok && run_clustering(column_data_set, &options, column_labels, "IVF, column arrays:");
+
+	ok = ok && scc_set_ivf_dist_search(0, 4, false);
+	ok = ok && run_clustering(data_set, &options, approx_labels, "IVF, nprobe = 4:");
+
+	scc_reset_dist_functions();
+	scc_reset_parallel_for();
+	scc_free_data_set(&data_set);
+	scc_free_data_set(&column_data_set);
+
+	if (!ok) {
+		printf("Clustering FAILED\n");
+		return 1;
+	}
+
+	size_t approx_same = 0;
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		approx_same += (approx_labels[i] == builtin_labels[i]);
+	}
+	const bool exact_same = (memcmp(builtin_labels, exact_labels, sizeof(builtin_labels)) == 0);
+	const bool column_same = (memcmp(builtin_labels, column_labels, sizeof(builtin_labels)) == 0);
+
+	printf("Exact IVF:   %s\n", exact_same ? "same clustering as the built-in search" : "MISMATCH");
+	printf("Columns:     %s\n", column_same ? "same clustering as the built-in search" : "MISMATCH");
+	printf("nprobe = 4:  %.1f%% of labels same as the built-in search\n", 100.0 * (double) approx_same / NUM_DATA_POINTS);
+
+	return (exact_same && column_same) ? 0 : 1;
+}
@@ -0,0 +1,503 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "ivf_wrapper.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/data_set_struct.h>
+#include <src/dist_search_imp.h>
+#include <src/parallel_for.h>
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+// Number of sampled search points per list used to train the centroids
+static const size_t ISCC_IVF_TRAIN_PER_LIST = 64;
+
+// Number of k-means iterations when training the centroids
+static const size_t ISCC_IVF_KMEANS_ITERATIONS = 10;
+
+// Number of points assigned to centroids in each parallel task
+static const size_t ISCC_IVF_ASSIGN_GRAIN = 1024;
+
+// Relative margin on list bounds, so rounding errors never skip a neighbor
+static const double ISCC_IVF_BOUND_SLACK = 1e-9;
+
+
+static const int32_t ISCC_IVF_NN_SEARCH_STRUCT_VERSION = 481730001;
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	const scc_DataSet* data_set;
+	size_t num_dimensions;
+	size_t num_lists;
+	double* centroids;
+	size_t* list_offsets;
+	scc_PointIndex* list_points;
+	double* list_data;
+};
+
+
+typedef struct iscc_ivf_AssignContext {
+	const double* points;
+	size_t point_step;
+	size_t num_dimensions;
+	const double* centroids;
+	size_t num_lists;
+	size_t* out_lists;
+} iscc_ivf_AssignContext;
+
+
+typedef struct iscc_ivf_ProbeOrder {
+	double sq_dist;
+	size_t list;
+} iscc_ivf_ProbeOrder;
+
+
+static size_t iscc_ivf_num_lists = 0;
+static size_t iscc_ivf_nprobe = 1;
+static bool iscc_ivf_exact = false;
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static bool iscc_ivf_init_nn_search_object(void* data_set,
+                                           size_t len_search_indices,
+                                           const scc_PointIndex search_indices[],
+                                           iscc_NNSearchObject** out_nn_search_object);
+
+
+static bool iscc_ivf_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
+                                             size_t len_query_indices,
+                                             const scc_PointIndex query_indices[],
+                                             uint32_t k,
+                                             bool radius_search,
+                                             double radius,
+                                             size_t* out_num_ok_queries,
+                                             scc_PointIndex out_query_indices[],
+                                             scc_PointIndex out_nn_indices[]);
+
+
+static bool iscc_ivf_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
+
+
+static void iscc_ivf_assign_body(size_t begin,
+                                 size_t end,
+                                 void* context);
+
+
+static int iscc_ivf_compare_probe_order(const void* a,
+                                        const void* b);
+
+
+static inline double iscc_ivf_sq_dist(const double* point1,
+                                      const double* point2,
+                                      size_t num_dimensions);
+
+
+static inline void iscc_ivf_add_dist_to_list(double add_dist,
+                                             scc_PointIndex add_index,
+                                             double* dist_list,
+                                             scc_PointIndex* index_list,
+                                             const double* dist_list_start);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool scc_set_ivf_dist_search(const size_t num_lists,
+                             const size_t nprobe,
+                             const bool exact)
+{
+	if (nprobe == 0) return false;
+
+	iscc_ivf_num_lists = num_lists;
+	iscc_ivf_nprobe = nprobe;
+	iscc_ivf_exact = exact;
+
+	return scc_set_dist_functions(NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              iscc_ivf_init_nn_search_object,
+	                              iscc_ivf_nearest_neighbor_search,
+	                              iscc_ivf_close_nn_search_object);
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static bool iscc_ivf_init_nn_search_object(void* const data_set,
+                                           const size_t len_search_indices,
+                                           const scc_PointIndex search_indices[const],
+                                           iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_imp_check_data_set(data_set));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	// Lists are built from Euclidean coordinates, so Gower and binary data sets are not supported
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	if ((data_set_cast->gower_weights != NULL) || (data_set_cast->binary_matrix != NULL)) return false;
+
+	const size_t num_dimensions = (size_t) data_set_cast->num_dimensions;
+	size_t num_lists = iscc_ivf_num_lists;
+	if (num_lists == 0) num_lists = (size_t) sqrt((double) len_search_indices);
+	if (num_lists == 0) num_lists = 1;
+	if (num_lists > len_search_indices) num_lists = len_search_indices;
+
+	double* const point_data = malloc(sizeof(double[len_search_indices * num_dimensions]));
+	size_t* const point_lists = malloc(sizeof(size_t[len_search_indices]));
+	double* const centroid_sums = malloc(sizeof(double[num_lists * num_dimensions]));
+	size_t* const centroid_counts = malloc(sizeof(size_t[num_lists]));
+	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	double* const centroids = malloc(sizeof(double[num_lists * num_dimensions]));
+	size_t* const list_offsets = malloc(sizeof(size_t[num_lists + 1]));
+	scc_PointIndex* const list_points = malloc(sizeof(scc_PointIndex[len_search_indices]));
+	double* const list_data = malloc(sizeof(double[len_search_indices * num_dimensions]));
+	if ((point_data == NULL) || (point_lists == NULL) || (centroid_sums == NULL) ||
+	        (centroid_counts == NULL) || (*out_nn_search_object == NULL) || (centroids == NULL) ||
+	        (list_offsets == NULL) || (list_points == NULL) || (list_data == NULL)) {
+		free(point_data);
+		free(point_lists);
+		free(centroid_sums);
+		free(centroid_counts);
+		free(*out_nn_search_object);
+		*out_nn_search_object = NULL;
+		free(centroids);
+		free(list_offsets);
+		free(list_points);
+		free(list_data);
+		return false;
+	}
+
+	// Gather the search points into a packed matrix
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		const size_t point = (search_indices == NULL) ? i : (size_t) search_indices[i];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			point_data[i * num_dimensions + d] = iscc_get_column_data(data_set_cast, d)[point * data_set_cast->row_stride];
+		}
+	}
+
+	// Train the centroids with k-means on an evenly spaced sample, starting from sampled points
+	const size_t init_step = len_search_indices / num_lists;
+	for (size_t l = 0; l < num_lists; ++l) {
+		memcpy(centroids + l * num_dimensions,
+		       point_data + l * init_step * num_dimensions,
+		       sizeof(double[num_dimensions]));
+	}
+
+	size_t len_train = num_lists * ISCC_IVF_TRAIN_PER_LIST;
+	if (len_train > len_search_indices) len_train = len_search_indices;
+	const size_t train_step = len_search_indices / len_train;
+
+	iscc_ivf_AssignContext train_context = {
+		.points = point_data,
+		.point_step = train_step,
+		.num_dimensions = num_dimensions,
+		.centroids = centroids,
+		.num_lists = num_lists,
+		.out_lists = point_lists,
+	};
+
+	for (size_t iter = 0; iter < ISCC_IVF_KMEANS_ITERATIONS; ++iter) {
+		iscc_parallel_for(0, len_train, ISCC_IVF_ASSIGN_GRAIN, iscc_ivf_assign_body, &train_context);
+
+		for (size_t i = 0; i < num_lists * num_dimensions; ++i) {
+			centroid_sums[i] = 0.0;
+		}
+		for (size_t l = 0; l < num_lists; ++l) {
+			centroid_counts[l] = 0;
+		}
+		for (size_t s = 0; s < len_train; ++s) {
+			const double* const point = point_data + s * train_step * num_dimensions;
+			double* const sum = centroid_sums + point_lists[s] * num_dimensions;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				sum[d] += point[d];
+			}
+			++centroid_counts[point_lists[s]];
+		}
+		// Empty clusters keep their previous centroid
+		for (size_t l = 0; l < num_lists; ++l) {
+			if (centroid_counts[l] == 0) continue;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				centroids[l * num_dimensions + d] = centroid_sums[l * num_dimensions + d] / (double) centroid_counts[l];
+			}
+		}
+	}
+
+	// Bucket all search points by their closest centroid. The bounds used
+	// by exact searches require that no point is closer to another centroid.
+	iscc_ivf_AssignContext bucket_context = {
+		.points = point_data,
+		.point_step = 1,
+		.num_dimensions = num_dimensions,
+		.centroids = centroids,
+		.num_lists = num_lists,
+		.out_lists = point_lists,
+	};
+	iscc_parallel_for(0, len_search_indices, ISCC_IVF_ASSIGN_GRAIN, iscc_ivf_assign_body, &bucket_context);
+
+	for (size_t l = 0; l <= num_lists; ++l) {
+		list_offsets[l] = 0;
+	}
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		++list_offsets[point_lists[i] + 1];
+	}
+	for (size_t l = 0; l < num_lists; ++l) {
+		list_offsets[l + 1] += list_offsets[l];
+	}
+	// `centroid_counts` is reused as write position of each list
+	for (size_t l = 0; l < num_lists; ++l) {
+		centroid_counts[l] = list_offsets[l];
+	}
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		const size_t write = centroid_counts[point_lists[i]]++;
+		list_points[write] = (search_indices == NULL) ? (scc_PointIndex) i : search_indices[i];
+		memcpy(list_data + write * num_dimensions,
+		       point_data + i * num_dimensions,
+		       sizeof(double[num_dimensions]));
+	}
+
+	free(point_data);
+	free(point_lists);
+	free(centroid_sums);
+	free(centroid_counts);
+
+	**out_nn_search_object = (iscc_NNSearchObject) {
+		.nn_search_version = ISCC_IVF_NN_SEARCH_STRUCT_VERSION,
+		.data_set = data_set_cast,
+		.num_dimensions = num_dimensions,
+		.num_lists = num_lists,
+		.centroids = centroids,
+		.list_offsets = list_offsets,
+		.list_points = list_points,
+		.list_data = list_data,
+	};
+
+	return true;
+}
+
+
+static bool iscc_ivf_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                             const size_t len_query_indices,
+                                             const scc_PointIndex query_indices[const],
+                                             const uint32_t k,
+                                             const bool radius_search,
+                                             const double radius,
+                                             size_t* const out_num_ok_queries,
+                                             scc_PointIndex out_query_indices[const],
+                                             scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_IVF_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->list_offsets[nn_search_object->num_lists]);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const size_t num_dimensions = nn_search_object->num_dimensions;
+	const size_t num_lists = nn_search_object->num_lists;
+	const double* const centroids = nn_search_object->centroids;
+	const size_t* const list_offsets = nn_search_object->list_offsets;
+	const size_t nprobe = iscc_ivf_nprobe;
+	const bool exact = iscc_ivf_exact;
+
+	// Geo data sets are searched by chord distance on the unit sphere
+	const double embedded_radius = iscc_to_embedded_dist(data_set, radius);
+	const double radius_sq = embedded_radius * embedded_radius;
+
+	// Scratch memory is local, so concurrent searches on the same object are safe
+	double* const query_point = malloc(sizeof(double[num_dimensions]));
+	iscc_ivf_ProbeOrder* const probe_order = malloc(sizeof(iscc_ivf_ProbeOrder[num_lists]));
+	double* const sort_scratch = malloc(sizeof(double[k]));
+	if ((query_point == NULL) || (probe_order == NULL) || (sort_scratch == NULL)) {
+		free(query_point);
+		free(probe_order);
+		free(sort_scratch);
+		return false;
+	}
+	double* const sort_scratch_end = sort_scratch + k - 1;
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			query_point[d] = iscc_get_column_data(data_set, d)[query * data_set->row_stride];
+		}
+
+		for (size_t l = 0; l < num_lists; ++l) {
+			probe_order[l].sq_dist = iscc_ivf_sq_dist(query_point, centroids + l * num_dimensions, num_dimensions);
+			probe_order[l].list = l;
+		}
+		qsort(probe_order, num_lists, sizeof(iscc_ivf_ProbeOrder), iscc_ivf_compare_probe_order);
+		const double* const closest_centroid = centroids + probe_order[0].list * num_dimensions;
+
+		uint32_t found = 0;
+		scc_PointIndex* const index_write_end = index_write + k - 1;
+
+		for (size_t r = 0; r < num_lists; ++r) {
+			if (!exact && (r >= nprobe) && (found == k)) break;
+
+			const size_t list = probe_order[r].list;
+			if (r > 0) {
+				// Points in the list are at least as close to its centroid as to the query's closest
+				// centroid, so they lie beyond the bisecting hyperplane of the two centroids
+				const double gap = sqrt(iscc_ivf_sq_dist(centroids + list * num_dimensions, closest_centroid, num_dimensions));
+				const double bound = (gap > 0.0) ? ((probe_order[r].sq_dist - probe_order[0].sq_dist) / (2.0 * gap)) : 0.0;
+				const double bound_sq = bound * bound * (1.0 - ISCC_IVF_BOUND_SLACK);
+				if ((found == k) && (bound_sq >= *sort_scratch_end)) continue;
+				if (radius_search && (bound_sq > radius_sq)) continue;
+			}
+
+			for (size_t i = list_offsets[list]; i < list_offsets[list + 1]; ++i) {
+				const double tmp_dist = iscc_ivf_sq_dist(query_point, nn_search_object->list_data + i * num_dimensions, num_dimensions);
+				const scc_PointIndex tmp_index = nn_search_object->list_points[i];
+				if (found < k) {
+					if (radius_search && (tmp_dist > radius_sq)) continue;
+					iscc_ivf_add_dist_to_list(tmp_dist, tmp_index, sort_scratch + found, index_write + found, sort_scratch);
+					++found;
+				} else {
+					if (tmp_dist >= *sort_scratch_end) continue;
+					iscc_ivf_add_dist_to_list(tmp_dist, tmp_index, sort_scratch_end, index_write_end, sort_scratch);
+				}
+			}
+		}
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	*out_num_ok_queries = num_ok_queries;
+
+	free(query_point);
+	free(probe_order);
+	free(sort_scratch);
+
+	return true;
+}
+
+
+static bool iscc_ivf_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	if ((nn_search_object != NULL) && (*nn_search_object != NULL)) {
+		assert((*nn_search_object)->nn_search_version == ISCC_IVF_NN_SEARCH_STRUCT_VERSION);
+		free((*nn_search_object)->centroids);
+		free((*nn_search_object)->list_offsets);
+		free((*nn_search_object)->list_points);
+		free((*nn_search_object)->list_data);
+		free(*nn_search_object);
+		*nn_search_object = NULL;
+	}
+	return true;
+}
+
+
+static void iscc_ivf_assign_body(const size_t begin,
+                                 const size_t end,
+                                 void* const context)
+{
+	const iscc_ivf_AssignContext* const assign = (const iscc_ivf_AssignContext*) context;
+	const size_t num_dimensions = assign->num_dimensions;
+
+	for (size_t i = begin; i < end; ++i) {
+		const double* const point = assign->points + i * assign->point_step * num_dimensions;
+		size_t closest = 0;
+		double closest_dist = iscc_ivf_sq_dist(point, assign->centroids, num_dimensions);
+		for (size_t l = 1; l < assign->num_lists; ++l) {
+			const double tmp_dist = iscc_ivf_sq_dist(point, assign->centroids + l * num_dimensions, num_dimensions);
+			if (tmp_dist < closest_dist) {
+				closest = l;
+				closest_dist = tmp_dist;
+			}
+		}
+		assign->out_lists[i] = closest;
+	}
+}
+
+
+static int iscc_ivf_compare_probe_order(const void* const a,
+                                        const void* const b)
+{
+	const double dist_a = ((const iscc_ivf_ProbeOrder*) a)->sq_dist;
+	const double dist_b = ((const iscc_ivf_ProbeOrder*) b)->sq_dist;
+	return (dist_a > dist_b) - (dist_a < dist_b);
+}
+
+
+static inline double iscc_ivf_sq_dist(const double* const point1,
+                                      const double* const point2,
+                                      const size_t num_dimensions)
+{
+	double tmp_dist = 0.0;
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		const double value_diff = point1[d] - point2[d];
+		tmp_dist += value_diff * value_diff;
+	}
+	return tmp_dist;
+}
+
+
+static inline void iscc_ivf_add_dist_to_list(const double add_dist,
+                                             const scc_PointIndex add_index,
+                                             double* dist_list,
+                                             scc_PointIndex* index_list,
+                                             const double* const dist_list_start)
+{
+	assert(dist_list != NULL);
+	assert(index_list != NULL);
+	assert(dist_list_start != NULL);
+
+	for (; (dist_list != dist_list_start) && (add_dist < dist_list[-1]); --dist_list, --index_list) {
+		dist_list[0] = dist_list[-1];
+		index_list[0] = index_list[-1];
+	}
+	dist_list[0] = add_dist;
+	index_list[0] = add_index;
+}
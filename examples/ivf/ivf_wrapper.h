@@ -0,0 +1,45 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_IVF_WRAPPER_HG
+#define SCC_IVF_WRAPPER_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Uses an inverted-file index for all nearest neighbor searches. The search points
+// are bucketed by their closest of `num_lists` k-means centroids, and each query scans
+// the lists of its `nprobe` closest centroids. If `num_lists` is zero, the square
+// root of the number of search points is used. If `exact` is true, queries continue
+// with the remaining lists until a bound shows that they cannot contain any of the
+// `k` nearest neighbors, so the search is exact.
+bool scc_set_ivf_dist_search(size_t num_lists,
+                             size_t nprobe,
+                             bool exact);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_IVF_WRAPPER_HG
@@ -92,6 +92,7 @@ typedef bool (*scc_init_nn_search_object) (void*,
                                            iscc_NNSearchObject**);
 
 
+// The library never passes output arrays that overlap the query indices.
 typedef bool (*scc_nearest_neighbor_search) (iscc_NNSearchObject*,
                                              size_t,
                                              const scc_PointIndex*,
@@ -106,6 +107,40 @@ typedef bool (*scc_nearest_neighbor_search) (iscc_NNSearchObject*,
 typedef bool (*scc_close_nn_search_object) (iscc_NNSearchObject**);
 
 
+// =============================================================================
+// Parallel loops
+// =============================================================================
+
+// Body of a loop over `[begin, end)`, called with the context given to the loop.
+typedef void (*scc_parallel_for_body) (size_t,
+                                       size_t,
+                                       void*);
+
+
+// Host-provided loop over `[begin, end)` with grain size `grain`. It must call the body
+// on disjoint subranges that together cover `[begin, end)`, and return when all calls
+// have returned. The bodies run on the host's worker threads, so while a loop is
+// registered, the distance functions may be called concurrently, also on the same search
+// object, and must be thread-safe. The library never starts a loop from within a body,
+// and it keeps no global state about running loops, so several host threads may run
+// clusterings at the same time with the same registered loop.
+typedef void (*scc_parallel_for) (size_t,
+                                  size_t,
+                                  size_t,
+                                  scc_parallel_for_body,
+                                  void*);
+
+
+// =============================================================================
+// Clock
+// =============================================================================
+
+// Host-provided monotonic wall clock. It writes the time in seconds, from any fixed
+// origin, to its argument, and returns false if the time is unavailable. It may be
+// called from several host threads at the same time.
+typedef bool (*scc_clock) (double*);
+
+
 // =============================================================================
 // SPI functions
 // =============================================================================
@@ -125,6 +160,27 @@ bool scc_set_dist_functions(scc_check_data_set,
                             scc_close_nn_search_object);
 
 
+// Optional variants of `scc_get_dist_rows` and `scc_get_max_dist` that output squared
+// distances. They are used where only the order of distances matters. A NULL argument
+// keeps the existing variant. When `scc_set_dist_functions` replaces `get_dist_rows` or
+// the max dist functions, the corresponding variant is cleared, and the squares of the
+// regular outputs are used until a new variant is set.
+bool scc_set_sq_dist_functions(scc_get_dist_rows,
+                               scc_get_max_dist);
+
+
+bool scc_reset_parallel_for(void);
+
+
+bool scc_set_parallel_for(scc_parallel_for);
+
+
+bool scc_reset_clock(void);
+
+
+bool scc_set_clock(scc_clock);
+
+
 #ifdef __cplusplus
 }
 #endif
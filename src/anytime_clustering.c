@@ -0,0 +1,352 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "../include/scclust.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clustering_struct.h"
+#include "dist_search.h"
+#include "error.h"
+#include "scclust_types.h"
+#include "utilities.h"
+#include "wall_clock.h"
+
+
+// =============================================================================
+// Internal structs & variables
+// =============================================================================
+
+// Keeps track of the time budget, in seconds of the host's wall clock. A step is started only if it
+// is expected to finish before the deadline, using the duration of the previous step as estimate.
+// `has_clock` is false when no wall clock is registered or it fails, and then no step is started.
+typedef struct iscc_at_Timer {
+	bool has_clock;
+	double start_time;
+	double time_budget;
+	double step_start;
+	double step_time;
+} iscc_at_Timer;
+
+
+// The best clustering found so far and its statistics.
+typedef struct iscc_at_Best {
+	scc_Clustering* clustering;
+	scc_ClusteringStats stats;
+	bool refined;
+} iscc_at_Best;
+
+
+// Seed methods tried after the first clustering, roughly in order of increasing cost.
+static const scc_SeedMethod ISCC_AT_SEED_METHODS[] = {
+	SCC_SM_LEXICAL,
+	SCC_SM_INWARDS_ORDER,
+	SCC_SM_INWARDS_UPDATING,
+	SCC_SM_EXCLUSION_ORDER,
+	SCC_SM_EXCLUSION_UPDATING,
+};
+
+// Number of seed methods in `ISCC_AT_SEED_METHODS`.
+static const size_t ISCC_AT_NUM_SEED_METHODS = sizeof(ISCC_AT_SEED_METHODS) / sizeof(ISCC_AT_SEED_METHODS[0]);
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static bool iscc_at_begin_step(iscc_at_Timer* timer);
+
+
+static void iscc_at_end_step(iscc_at_Timer* timer);
+
+
+static bool iscc_at_use_batches(const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_at_try_options(void* data_set,
+                                         const scc_ClusterOptions* options,
+                                         iscc_at_Best* best);
+
+
+static scc_ErrorCode iscc_at_try_refinement(void* data_set,
+                                            uint32_t size_constraint,
+                                            iscc_at_Best* best);
+
+
+static scc_ErrorCode iscc_at_keep_better(void* data_set,
+                                         scc_Clustering* candidate,
+                                         iscc_at_Best* best);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+scc_ErrorCode scc_anytime_clustering(void* const data_set,
+                                     const scc_ClusterOptions* const options,
+                                     const double time_budget,
+                                     scc_Clustering* const out_clustering)
+{
+	iscc_at_Timer timer = {
+		.has_clock = false,
+		.start_time = 0.0,
+		.time_budget = time_budget,
+		.step_start = 0.0,
+		.step_time = 0.0,
+	};
+	timer.has_clock = iscc_wall_clock_now(&timer.start_time);
+
+	if (!iscc_check_input_clustering(out_clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if (iscc_num_data_points(data_set) != out_clustering->num_data_points) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
+	}
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_cluster_options(options, out_clustering->num_data_points)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (!(time_budget >= 0.0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid time budget.");
+	}
+	if (out_clustering->num_clusters != 0) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+	}
+
+	iscc_at_Best best = {
+		.clustering = NULL,
+		.refined = false,
+	};
+
+	// The first clustering is always made, whatever the budget, so there is something to return
+	scc_ClusterOptions step_options = *options;
+	step_options.seed_method = iscc_at_use_batches(options) ? SCC_SM_BATCHES : SCC_SM_LEXICAL;
+	scc_Clustering* first_clustering;
+	if ((ec = scc_init_empty_clustering(out_clustering->num_data_points, NULL, &first_clustering)) != SCC_ER_OK) {
+		return ec;
+	}
+	if ((ec = scc_sc_clustering(data_set, &step_options, first_clustering)) != SCC_ER_OK) {
+		scc_free_clustering(&first_clustering);
+		return ec;
+	}
+	if ((ec = iscc_at_keep_better(data_set, first_clustering, &best)) != SCC_ER_OK) {
+		return ec;
+	}
+	timer.step_start = timer.start_time;
+	iscc_at_end_step(&timer);
+
+	// Hierarchical refinement only respects the overall size constraint
+	const bool use_refinement = (options->num_types < 2);
+	const scc_SeedMethod first_seed_method = step_options.seed_method;
+
+	bool time_left = true;
+	for (size_t m = 0; time_left && (m < ISCC_AT_NUM_SEED_METHODS); ++m) {
+		for (size_t closer = 0; time_left && (closer < 2); ++closer) {
+			if (use_refinement && !best.refined) {
+				if (!(time_left = iscc_at_begin_step(&timer))) break;
+				if ((ec = iscc_at_try_refinement(data_set, options->size_constraint, &best)) != SCC_ER_OK) {
+					scc_free_clustering(&best.clustering);
+					return ec;
+				}
+				iscc_at_end_step(&timer);
+			}
+
+			step_options = *options;
+			step_options.seed_method = ISCC_AT_SEED_METHODS[m];
+			if (closer == 1) {
+				// Leftover points are assigned to the closest assigned point rather than any neighbor
+				if (options->primary_unassigned_method != SCC_UM_ANY_NEIGHBOR) continue;
+				step_options.primary_unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+			} else if (step_options.seed_method == first_seed_method) {
+				continue;
+			}
+
+			if (!(time_left = iscc_at_begin_step(&timer))) break;
+			if ((ec = iscc_at_try_options(data_set, &step_options, &best)) != SCC_ER_OK) {
+				scc_free_clustering(&best.clustering);
+				return ec;
+			}
+			iscc_at_end_step(&timer);
+		}
+	}
+
+	if (time_left && use_refinement && !best.refined && iscc_at_begin_step(&timer)) {
+		if ((ec = iscc_at_try_refinement(data_set, options->size_constraint, &best)) != SCC_ER_OK) {
+			scc_free_clustering(&best.clustering);
+			return ec;
+		}
+	}
+
+	assert(best.clustering != NULL);
+	assert(best.clustering->num_data_points == out_clustering->num_data_points);
+	if (out_clustering->cluster_label == NULL) {
+		assert(!best.clustering->external_labels);
+		out_clustering->external_labels = false;
+		out_clustering->cluster_label = best.clustering->cluster_label;
+		best.clustering->cluster_label = NULL;
+	} else {
+		memcpy(out_clustering->cluster_label, best.clustering->cluster_label, out_clustering->num_data_points * sizeof(scc_Clabel));
+	}
+	out_clustering->num_clusters = best.clustering->num_clusters;
+
+	scc_free_clustering(&best.clustering);
+
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static bool iscc_at_begin_step(iscc_at_Timer* const timer)
+{
+	assert(timer != NULL);
+	double now;
+	if (!timer->has_clock || !iscc_wall_clock_now(&now)) return false;
+	// A step is not started unless it fits strictly within the budget, so a budget of zero
+	// gives the first clustering even when the clock has not ticked since the start
+	if ((now - timer->start_time) + timer->step_time >= timer->time_budget) return false;
+	timer->step_start = now;
+	return true;
+}
+
+
+static void iscc_at_end_step(iscc_at_Timer* const timer)
+{
+	assert(timer != NULL);
+	double now;
+	if (timer->has_clock && iscc_wall_clock_now(&now)) {
+		timer->step_time = now - timer->step_start;
+	} else {
+		timer->has_clock = false;
+	}
+}
+
+
+static bool iscc_at_use_batches(const scc_ClusterOptions* const options)
+{
+	assert(options != NULL);
+	return (options->num_types < 2) &&
+	       (options->secondary_unassigned_method == SCC_UM_IGNORE) &&
+	       (options->primary_radius == SCC_RM_USE_SEED_RADIUS) &&
+	       ((options->primary_unassigned_method == SCC_UM_IGNORE) ||
+	        (options->primary_unassigned_method == SCC_UM_ANY_NEIGHBOR));
+}
+
+
+static scc_ErrorCode iscc_at_try_options(void* const data_set,
+                                         const scc_ClusterOptions* const options,
+                                         iscc_at_Best* const best)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(options != NULL);
+	assert(best != NULL);
+
+	scc_ErrorCode ec;
+	scc_Clustering* candidate;
+	if ((ec = scc_init_empty_clustering(iscc_num_data_points(data_set), NULL, &candidate)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	ec = scc_sc_clustering(data_set, options, candidate);
+	if (ec == SCC_ER_NO_SOLUTION) {
+		// Other seed methods may still find a clustering
+		scc_free_clustering(&candidate);
+		return iscc_no_error();
+	}
+	if (ec != SCC_ER_OK) {
+		scc_free_clustering(&candidate);
+		return ec;
+	}
+
+	return iscc_at_keep_better(data_set, candidate, best);
+}
+
+
+static scc_ErrorCode iscc_at_try_refinement(void* const data_set,
+                                            const uint32_t size_constraint,
+                                            iscc_at_Best* const best)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(best != NULL);
+	assert(best->clustering != NULL);
+
+	best->refined = true;
+
+	scc_ErrorCode ec;
+	scc_Clustering* candidate;
+	if ((ec = scc_copy_clustering(best->clustering, &candidate)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	if ((ec = scc_hierarchical_clustering(data_set, size_constraint, false, candidate)) != SCC_ER_OK) {
+		scc_free_clustering(&candidate);
+		return ec;
+	}
+
+	if ((ec = iscc_at_keep_better(data_set, candidate, best)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	// A refined clustering cannot be refined further
+	best->refined = true;
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_at_keep_better(void* const data_set,
+                                         scc_Clustering* candidate,
+                                         iscc_at_Best* const best)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_check_input_clustering(candidate));
+	assert(best != NULL);
+
+	scc_ErrorCode ec;
+	scc_ClusteringStats stats;
+	if ((ec = scc_get_clustering_stats(data_set, candidate, &stats)) != SCC_ER_OK) {
+		scc_free_clustering(&candidate);
+		return ec;
+	}
+
+	// More assigned points is better, then smaller average distance within clusters
+	if ((best->clustering == NULL) ||
+	        (stats.num_assigned > best->stats.num_assigned) ||
+	        ((stats.num_assigned == best->stats.num_assigned) &&
+	         (stats.avg_dist_weighted < best->stats.avg_dist_weighted))) {
+		scc_free_clustering(&best->clustering);
+		best->clustering = candidate;
+		best->stats = stats;
+		best->refined = false;
+	} else {
+		scc_free_clustering(&candidate);
+	}
+
+	return iscc_no_error();
+}
@@ -21,6 +21,7 @@
 #include "../include/scclust.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -28,9 +29,46 @@
 #include <string.h>
 #include "error.h"
 #include "data_set_struct.h"
+#include "kd_tree.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// Maximum number of data points used to estimate principal components.
+static const size_t ISCC_PCA_MAX_SAMPLE = 4096;
+
+// Number of orthogonal iterations when estimating principal components.
+static const size_t ISCC_PCA_ITERATIONS = 20;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_check_num_data_points(uint64_t num_data_points);
+
+static inline double iscc_get_data_value(const scc_DataSet* data_set,
+                                         size_t point,
+                                         size_t dimension);
+
+static void iscc_orthonormalize_columns(size_t num_rows,
+                                        size_t num_columns,
+                                        double matrix[]);
+
+
+static scc_ErrorCode iscc_make_data_set(uint64_t num_data_points,
+                                        uint32_t num_dimensions,
+                                        size_t row_stride,
+                                        size_t column_stride,
+                                        const uint32_t columns[],
+                                        size_t len_data_matrix,
+                                        const double data_matrix[],
+                                        scc_DataSet** out_data_set);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -40,6 +78,77 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
                                 const size_t len_data_matrix,
                                 const double data_matrix[const],
                                 scc_DataSet** const out_data_set)
+{
+	return scc_init_data_set_columns(num_data_points,
+	                                 num_dimensions,
+	                                 (size_t) num_dimensions,
+	                                 NULL,
+	                                 len_data_matrix,
+	                                 data_matrix,
+	                                 out_data_set);
+}
+
+
+scc_ErrorCode scc_init_data_set_columns(const uint64_t num_data_points,
+                                        const uint32_t num_dimensions,
+                                        const size_t row_stride,
+                                        const uint32_t columns[const],
+                                        const size_t len_data_matrix,
+                                        const double data_matrix[const],
+                                        scc_DataSet** const out_data_set)
+{
+	if ((columns != NULL) && (num_dimensions <= UINT16_MAX)) {
+		for (uint32_t i = 0; i < num_dimensions; ++i) {
+			if (columns[i] >= row_stride) {
+				if (out_data_set != NULL) *out_data_set = NULL;
+				return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid column index.");
+			}
+		}
+	}
+	if ((columns == NULL) && (row_stride < num_dimensions)) {
+		if (out_data_set != NULL) *out_data_set = NULL;
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid row stride.");
+	}
+
+	return iscc_make_data_set(num_data_points,
+	                          num_dimensions,
+	                          row_stride,
+	                          1,
+	                          columns,
+	                          len_data_matrix,
+	                          data_matrix,
+	                          out_data_set);
+}
+
+
+scc_ErrorCode scc_init_data_set_column_major(const uint64_t num_data_points,
+                                             const uint32_t num_dimensions,
+                                             const size_t column_stride,
+                                             const uint32_t columns[const],
+                                             const size_t len_data_matrix,
+                                             const double data_matrix[const],
+                                             scc_DataSet** const out_data_set)
+{
+	if (column_stride < num_data_points) {
+		if (out_data_set != NULL) *out_data_set = NULL;
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid column stride.");
+	}
+
+	return iscc_make_data_set(num_data_points,
+	                          num_dimensions,
+	                          1,
+	                          column_stride,
+	                          columns,
+	                          len_data_matrix,
+	                          data_matrix,
+	                          out_data_set);
+}
+
+
+scc_ErrorCode scc_init_data_set_column_arrays(const uint64_t num_data_points,
+                                              const uint32_t num_dimensions,
+                                              const double* const column_arrays[const],
+                                              scc_DataSet** const out_data_set)
 {
 	if (out_data_set == NULL) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
@@ -48,6 +157,540 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 	// if user doesn't check for errors.
 	*out_data_set = NULL;
 
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_num_data_points(num_data_points)) != SCC_ER_OK) return ec;
+	if (num_dimensions == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of dimensions.");
+	}
+	if (num_dimensions > UINT16_MAX) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data dimensions.");
+	}
+	if (column_arrays == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid column arrays.");
+	}
+	for (uint32_t i = 0; i < num_dimensions; ++i) {
+		if (column_arrays[i] == NULL) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid column arrays.");
+		}
+	}
+
+	const double** const tmp_column_arrays = malloc(sizeof(const double*[num_dimensions]));
+	if (tmp_column_arrays == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	for (uint32_t i = 0; i < num_dimensions; ++i) {
+		tmp_column_arrays[i] = column_arrays[i];
+	}
+
+	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	if (tmp_dso == NULL) {
+		free(tmp_column_arrays);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Each column is read as a column-major matrix with one column
+	*tmp_dso = (scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = (size_t) num_data_points,
+		.num_dimensions = (uint_fast16_t) num_dimensions,
+		.row_stride = 1,
+		.column_stride = (size_t) num_data_points,
+		.columns = NULL,
+		.data_matrix = column_arrays[0],
+		.column_arrays = tmp_column_arrays,
+		.num_categorical = 0,
+		.categorical_matrix = NULL,
+		.gower_weights = NULL,
+		.binary_matrix = NULL,
+		.binary_distance = SCC_BD_HAMMING,
+		.geo_matrix = NULL,
+		.geo_radius = 0.0,
+		.num_components = 0,
+		.projection_matrix = NULL,
+		.search_index = NULL,
+	};
+
+	*out_data_set = tmp_dso;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_init_mixed_data_set(const uint64_t num_data_points,
+                                      const uint32_t num_numeric,
+                                      const size_t len_numeric_matrix,
+                                      const double numeric_matrix[const],
+                                      const double numeric_ranges[const],
+                                      const double numeric_weights[const],
+                                      const uint32_t num_categorical,
+                                      const size_t len_categorical_matrix,
+                                      const int32_t categorical_matrix[const],
+                                      const double categorical_weights[const],
+                                      scc_DataSet** const out_data_set)
+{
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_data_set = NULL;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_num_data_points(num_data_points)) != SCC_ER_OK) return ec;
+	if ((num_numeric == 0) && (num_categorical == 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of dimensions.");
+	}
+	if ((num_numeric > UINT16_MAX) || (num_categorical > UINT16_MAX)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data dimensions.");
+	}
+	if ((num_numeric > 0) && (num_data_points > SIZE_MAX / num_numeric)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too large data matrix.");
+	}
+	if ((num_categorical > 0) && (num_data_points > SIZE_MAX / num_categorical)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too large data matrix.");
+	}
+
+	const size_t num_points = (size_t) num_data_points;
+	if ((num_numeric > 0) && ((numeric_matrix == NULL) || (len_numeric_matrix < num_points * num_numeric))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
+	}
+	if ((num_categorical > 0) && ((categorical_matrix == NULL) || (len_categorical_matrix < num_points * num_categorical))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid categorical matrix.");
+	}
+	if (numeric_ranges != NULL) {
+		for (uint32_t d = 0; d < num_numeric; ++d) {
+			if (!(numeric_ranges[d] > 0.0)) {
+				return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid numeric ranges.");
+			}
+		}
+	}
+
+	// Unit weights unless supplied
+	double total_weight = 0.0;
+	for (uint32_t d = 0; d < num_numeric; ++d) {
+		const double weight = (numeric_weights == NULL) ? 1.0 : numeric_weights[d];
+		if (!(weight >= 0.0)) return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid Gower weights.");
+		total_weight += weight;
+	}
+	for (uint32_t c = 0; c < num_categorical; ++c) {
+		const double weight = (categorical_weights == NULL) ? 1.0 : categorical_weights[c];
+		if (!(weight >= 0.0)) return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid Gower weights.");
+		total_weight += weight;
+	}
+	if (!(total_weight > 0.0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid Gower weights.");
+	}
+
+	double* const tmp_weights = malloc(sizeof(double[num_numeric + num_categorical]));
+	if (tmp_weights == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	// The weight of a numeric column is divided by its range, so the distance kernel
+	// needs no divisions. Constant columns contribute nothing to the distances.
+	for (uint32_t d = 0; d < num_numeric; ++d) {
+		double range;
+		if (numeric_ranges != NULL) {
+			range = numeric_ranges[d];
+		} else {
+			double min_value = numeric_matrix[d];
+			double max_value = numeric_matrix[d];
+			for (size_t i = 1; i < num_points; ++i) {
+				const double value = numeric_matrix[i * num_numeric + d];
+				if (value < min_value) min_value = value;
+				if (value > max_value) max_value = value;
+			}
+			range = max_value - min_value;
+		}
+		const double weight = (numeric_weights == NULL) ? 1.0 : numeric_weights[d];
+		tmp_weights[d] = (range > 0.0) ? (weight / (range * total_weight)) : 0.0;
+	}
+	for (uint32_t c = 0; c < num_categorical; ++c) {
+		const double weight = (categorical_weights == NULL) ? 1.0 : categorical_weights[c];
+		tmp_weights[num_numeric + c] = weight / total_weight;
+	}
+
+	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	if (tmp_dso == NULL) {
+		free(tmp_weights);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	*tmp_dso = (scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = num_points,
+		.num_dimensions = (uint_fast16_t) num_numeric,
+		.row_stride = (num_numeric > 0) ? (size_t) num_numeric : 1,
+		.column_stride = 1,
+		.columns = NULL,
+		.data_matrix = (num_numeric > 0) ? numeric_matrix : NULL,
+		.column_arrays = NULL,
+		.num_categorical = (uint_fast16_t) num_categorical,
+		.categorical_matrix = (num_categorical > 0) ? categorical_matrix : NULL,
+		.gower_weights = tmp_weights,
+		.binary_matrix = NULL,
+		.binary_distance = SCC_BD_HAMMING,
+		.geo_matrix = NULL,
+		.geo_radius = 0.0,
+		.num_components = 0,
+		.projection_matrix = NULL,
+		.search_index = NULL,
+	};
+
+	*out_data_set = tmp_dso;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_init_binary_data_set(const uint64_t num_data_points,
+                                       const uint32_t num_features,
+                                       const scc_BinaryDistance distance,
+                                       const size_t len_data_matrix,
+                                       const uint64_t data_matrix[const],
+                                       scc_DataSet** const out_data_set)
+{
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_data_set = NULL;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_num_data_points(num_data_points)) != SCC_ER_OK) return ec;
+	if (num_features == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of dimensions.");
+	}
+	if (num_features > UINT16_MAX) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data dimensions.");
+	}
+	if ((distance != SCC_BD_HAMMING) && (distance != SCC_BD_JACCARD)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown binary distance.");
+	}
+
+	const size_t num_points = (size_t) num_data_points;
+	const size_t num_words = ((size_t) num_features + 63) / 64;
+	if (num_points > SIZE_MAX / num_words) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too large data matrix.");
+	}
+	if ((data_matrix == NULL) || (len_data_matrix < num_points * num_words)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
+	}
+
+	// The distance kernels count all bits in the words, so the padding must be zero
+	const uint_fast32_t used_bits = (uint_fast32_t) (num_features % 64);
+	if (used_bits > 0) {
+		const uint64_t padding_mask = ~((((uint64_t) 1) << used_bits) - 1);
+		for (size_t i = 0; i < num_points; ++i) {
+			if ((data_matrix[i * num_words + num_words - 1] & padding_mask) != 0) {
+				return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
+			}
+		}
+	}
+
+	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	if (tmp_dso == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	*tmp_dso = (scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = num_points,
+		.num_dimensions = (uint_fast16_t) num_features,
+		.row_stride = num_words,
+		.column_stride = 1,
+		.columns = NULL,
+		.data_matrix = NULL,
+		.column_arrays = NULL,
+		.num_categorical = 0,
+		.categorical_matrix = NULL,
+		.gower_weights = NULL,
+		.binary_matrix = data_matrix,
+		.binary_distance = distance,
+		.geo_matrix = NULL,
+		.geo_radius = 0.0,
+		.num_components = 0,
+		.projection_matrix = NULL,
+		.search_index = NULL,
+	};
+
+	*out_data_set = tmp_dso;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_init_geo_data_set(const uint64_t num_data_points,
+                                    const size_t len_coordinates,
+                                    const double coordinates[const],
+                                    const double sphere_radius,
+                                    scc_DataSet** const out_data_set)
+{
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_data_set = NULL;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_num_data_points(num_data_points)) != SCC_ER_OK) return ec;
+	if (num_data_points > SIZE_MAX / 3) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
+	}
+	const size_t num_points = (size_t) num_data_points;
+	if ((coordinates == NULL) || (len_coordinates < 2 * num_points)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid coordinates.");
+	}
+	if (!(sphere_radius > 0.0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid sphere radius.");
+	}
+	for (size_t i = 0; i < num_points; ++i) {
+		const double latitude = coordinates[2 * i];
+		const double longitude = coordinates[2 * i + 1];
+		if (!((latitude >= -90.0) && (latitude <= 90.0) && (longitude >= -360.0) && (longitude <= 360.0))) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid coordinates.");
+		}
+	}
+
+	double* const tmp_matrix = malloc(sizeof(double[3 * num_points]));
+	if (tmp_matrix == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	const double to_radians = ISCC_GEO_PI / 180.0;
+	for (size_t i = 0; i < num_points; ++i) {
+		const double latitude = coordinates[2 * i] * to_radians;
+		const double longitude = coordinates[2 * i + 1] * to_radians;
+		tmp_matrix[3 * i] = cos(latitude) * cos(longitude);
+		tmp_matrix[3 * i + 1] = cos(latitude) * sin(longitude);
+		tmp_matrix[3 * i + 2] = sin(latitude);
+	}
+
+	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	if (tmp_dso == NULL) {
+		free(tmp_matrix);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	*tmp_dso = (scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = num_points,
+		.num_dimensions = 3,
+		.row_stride = 3,
+		.column_stride = 1,
+		.columns = NULL,
+		.data_matrix = tmp_matrix,
+		.column_arrays = NULL,
+		.num_categorical = 0,
+		.categorical_matrix = NULL,
+		.gower_weights = NULL,
+		.binary_matrix = NULL,
+		.binary_distance = SCC_BD_HAMMING,
+		.geo_matrix = tmp_matrix,
+		.geo_radius = sphere_radius,
+		.num_components = 0,
+		.projection_matrix = NULL,
+		.search_index = NULL,
+	};
+
+	*out_data_set = tmp_dso;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_add_pca_projection(scc_DataSet* const data_set,
+                                     const uint32_t num_components)
+{
+	if (!scc_is_initialized_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if ((data_set->gower_weights != NULL) || (data_set->binary_matrix != NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Projections require a Euclidean data set.");
+	}
+	if ((num_components == 0) || (num_components >= data_set->num_dimensions)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid number of components.");
+	}
+
+	const size_t num_points = data_set->num_data_points;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const size_t num_comps = (size_t) num_components;
+	if (num_points > SIZE_MAX / num_comps) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
+	}
+
+	// Evenly spaced sample of data points
+	const size_t len_sample = (num_points < ISCC_PCA_MAX_SAMPLE) ? num_points : ISCC_PCA_MAX_SAMPLE;
+	const size_t sample_step = num_points / len_sample;
+
+	double* const mean = malloc(sizeof(double[num_dimensions]));
+	double* basis = malloc(sizeof(double[num_dimensions * num_comps]));
+	double* next_basis = malloc(sizeof(double[num_dimensions * num_comps]));
+	double* const sample_scores = malloc(sizeof(double[len_sample * num_comps]));
+	double* const tmp_projection = malloc(sizeof(double[num_points * num_comps]));
+	if ((mean == NULL) || (basis == NULL) || (next_basis == NULL) ||
+	        (sample_scores == NULL) || (tmp_projection == NULL)) {
+		free(mean);
+		free(basis);
+		free(next_basis);
+		free(sample_scores);
+		free(tmp_projection);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t j = 0; j < num_dimensions; ++j) {
+		mean[j] = 0.0;
+		for (size_t s = 0; s < len_sample; ++s) {
+			mean[j] += iscc_get_data_value(data_set, s * sample_step, j);
+		}
+		mean[j] /= (double) len_sample;
+	}
+
+	// Deterministic pseudo-random start, so projections are reproducible
+	uint64_t lcg_state = 722328007;
+	for (size_t i = 0; i < num_dimensions * num_comps; ++i) {
+		lcg_state = lcg_state * 6364136223846793005u + 1442695040888963407u;
+		basis[i] = ((double) (lcg_state >> 11)) / 9007199254740992.0 - 0.5;
+	}
+	iscc_orthonormalize_columns(num_dimensions, num_comps, basis);
+
+	// Orthogonal iteration on the sample covariance matrix, without forming it
+	for (size_t iter = 0; iter < ISCC_PCA_ITERATIONS; ++iter) {
+		for (size_t i = 0; i < num_dimensions * num_comps; ++i) {
+			next_basis[i] = 0.0;
+		}
+		for (size_t s = 0; s < len_sample; ++s) {
+			double* const scores = sample_scores + s * num_comps;
+			for (size_t c = 0; c < num_comps; ++c) {
+				scores[c] = 0.0;
+			}
+			for (size_t j = 0; j < num_dimensions; ++j) {
+				const double centered = iscc_get_data_value(data_set, s * sample_step, j) - mean[j];
+				for (size_t c = 0; c < num_comps; ++c) {
+					scores[c] += centered * basis[j * num_comps + c];
+				}
+			}
+			for (size_t j = 0; j < num_dimensions; ++j) {
+				const double centered = iscc_get_data_value(data_set, s * sample_step, j) - mean[j];
+				for (size_t c = 0; c < num_comps; ++c) {
+					next_basis[j * num_comps + c] += centered * scores[c];
+				}
+			}
+		}
+		double* const tmp_basis = basis;
+		basis = next_basis;
+		next_basis = tmp_basis;
+		iscc_orthonormalize_columns(num_dimensions, num_comps, basis);
+	}
+
+	// Centering is not needed, as it does not change distances between projected points
+	for (size_t i = 0; i < num_points; ++i) {
+		double* const projected = tmp_projection + i * num_comps;
+		for (size_t c = 0; c < num_comps; ++c) {
+			projected[c] = 0.0;
+		}
+		for (size_t j = 0; j < num_dimensions; ++j) {
+			const double value = iscc_get_data_value(data_set, i, j);
+			for (size_t c = 0; c < num_comps; ++c) {
+				projected[c] += value * basis[j * num_comps + c];
+			}
+		}
+	}
+
+	free(mean);
+	free(basis);
+	free(next_basis);
+	free(sample_scores);
+
+	free(data_set->projection_matrix);
+	data_set->num_components = (uint_fast16_t) num_components;
+	data_set->projection_matrix = tmp_projection;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_build_search_index(scc_DataSet* const data_set)
+{
+	if (!scc_is_initialized_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if ((data_set->gower_weights != NULL) || (data_set->binary_matrix != NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Search indices require a Euclidean data set.");
+	}
+
+	iscc_KDTree* tmp_index;
+	if (!iscc_init_kd_tree(data_set, data_set->num_data_points, NULL, &tmp_index)) {
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	iscc_free_kd_tree(&data_set->search_index);
+	data_set->search_index = tmp_index;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_save_search_index(const scc_DataSet* const data_set,
+                                    const char* const path)
+{
+	if (!scc_is_initialized_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if (data_set->search_index == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set has no search index.");
+	}
+	if (path == NULL) return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+
+	return iscc_save_kd_tree(data_set->search_index, data_set, path);
+}
+
+
+scc_ErrorCode scc_load_search_index(scc_DataSet* const data_set,
+                                    const char* const path)
+{
+	if (!scc_is_initialized_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if ((data_set->gower_weights != NULL) || (data_set->binary_matrix != NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Search indices require a Euclidean data set.");
+	}
+	if (path == NULL) return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+
+	iscc_KDTree* tmp_index;
+	scc_ErrorCode ec;
+	if ((ec = iscc_load_kd_tree(data_set, path, &tmp_index)) != SCC_ER_OK) return ec;
+
+	iscc_free_kd_tree(&data_set->search_index);
+	data_set->search_index = tmp_index;
+
+	return iscc_no_error();
+}
+
+
+void scc_free_data_set(scc_DataSet** const data_set)
+{
+	if ((data_set != NULL) && (*data_set != NULL)) {
+		free((*data_set)->columns);
+		free((*data_set)->column_arrays);
+		free((*data_set)->gower_weights);
+		free((*data_set)->geo_matrix);
+		free((*data_set)->projection_matrix);
+		iscc_free_kd_tree(&(*data_set)->search_index);
+		free(*data_set);
+		*data_set = NULL;
+	}
+}
+
+
+bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
+{
+	if (data_set == NULL) return false;
+	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
+	if (data_set->num_data_points == 0) return false;
+	if ((data_set->num_dimensions == 0) && (data_set->num_categorical == 0)) return false;
+	if ((data_set->row_stride == 0) || (data_set->column_stride == 0)) return false;
+	if ((data_set->num_dimensions > 0) && (data_set->data_matrix == NULL) && (data_set->binary_matrix == NULL)) return false;
+	if ((data_set->num_categorical > 0) && (data_set->categorical_matrix == NULL)) return false;
+	if ((data_set->num_categorical > 0) && (data_set->gower_weights == NULL)) return false;
+	return true;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_check_num_data_points(const uint64_t num_data_points)
+{
 	if (num_data_points == 0) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of data points.");
 	}
@@ -57,27 +700,96 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 	if (num_data_points > SIZE_MAX - 1) {
 		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
 	}
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_make_data_set(const uint64_t num_data_points,
+                                        const uint32_t num_dimensions,
+                                        const size_t row_stride,
+                                        const size_t column_stride,
+                                        const uint32_t columns[const],
+                                        const size_t len_data_matrix,
+                                        const double data_matrix[const],
+                                        scc_DataSet** const out_data_set)
+{
+	assert((row_stride == 1) || (column_stride == 1));
+
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	// Initialize to null, so subsequent functions detect invalid clustering
+	// if user doesn't check for errors.
+	*out_data_set = NULL;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_num_data_points(num_data_points)) != SCC_ER_OK) return ec;
 	if (num_dimensions == 0) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of dimensions.");
 	}
 	if (num_dimensions > UINT16_MAX) {
 		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data dimensions.");
 	}
-	if (len_data_matrix < num_data_points * num_dimensions) {
+
+	size_t max_column = (size_t) num_dimensions - 1;
+	bool leading_columns = true;
+	if (columns != NULL) {
+		max_column = 0;
+		for (uint32_t i = 0; i < num_dimensions; ++i) {
+			if (columns[i] > max_column) max_column = (size_t) columns[i];
+			leading_columns = leading_columns && (columns[i] == i);
+		}
+	}
+
+	// The last element used is at `(num_data_points - 1) * row_stride + max_column * column_stride`
+	const size_t last_point = (size_t) num_data_points - 1;
+	if ((max_column > 0) && (column_stride > (SIZE_MAX - 1) / max_column)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too large data matrix.");
+	}
+	const size_t last_column_offset = max_column * column_stride;
+	if ((last_point > 0) && (row_stride > (SIZE_MAX - 1 - last_column_offset) / last_point)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too large data matrix.");
+	}
+	if (len_data_matrix < last_point * row_stride + last_column_offset + 1) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
 	if (data_matrix == NULL) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
 
+	// When the used columns are the leading ones, the distance functions need no column list
+	uint32_t* tmp_columns = NULL;
+	if (!leading_columns) {
+		tmp_columns = malloc(sizeof(uint32_t[num_dimensions]));
+		if (tmp_columns == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		memcpy(tmp_columns, columns, sizeof(uint32_t[num_dimensions]));
+	}
+
 	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
-	if (tmp_dso == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	if (tmp_dso == NULL) {
+		free(tmp_columns);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
 
 	*tmp_dso = (scc_DataSet) {
 		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
 		.num_data_points = (size_t) num_data_points,
 		.num_dimensions = (uint_fast16_t) num_dimensions,
+		.row_stride = row_stride,
+		.column_stride = column_stride,
+		.columns = tmp_columns,
 		.data_matrix = data_matrix,
+		.column_arrays = NULL,
+		.num_categorical = 0,
+		.categorical_matrix = NULL,
+		.gower_weights = NULL,
+		.binary_matrix = NULL,
+		.binary_distance = SCC_BD_HAMMING,
+		.geo_matrix = NULL,
+		.geo_radius = 0.0,
+		.num_components = 0,
+		.projection_matrix = NULL,
+		.search_index = NULL,
 	};
 
 	*out_data_set = tmp_dso;
@@ -86,21 +798,58 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 }
 
 
-void scc_free_data_set(scc_DataSet** const data_set)
+static inline double iscc_get_data_value(const scc_DataSet* const data_set,
+                                         const size_t point,
+                                         const size_t dimension)
 {
-	if ((data_set != NULL) && (*data_set != NULL)) {
-		free(*data_set);
-		*data_set = NULL;
-	}
+	assert(point < data_set->num_data_points);
+	assert(dimension < data_set->num_dimensions);
+	return iscc_get_column_data(data_set, dimension)[point * data_set->row_stride];
 }
 
 
-bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
+// Gram-Schmidt on the columns of a row-major matrix, run twice so the columns are orthonormal
+// to working precision. Columns in the span of the previous columns are replaced by unit vectors.
+static void iscc_orthonormalize_columns(const size_t num_rows,
+                                        const size_t num_columns,
+                                        double matrix[const])
 {
-	if (data_set == NULL) return false;
-	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
-	if (data_set->num_data_points == 0) return false;
-	if (data_set->num_dimensions == 0) return false;
-	if (data_set->data_matrix == NULL) return false;
-	return true;
+	assert(num_columns < num_rows);
+
+	for (size_t c = 0; c < num_columns; ++c) {
+		size_t unit_row = 0;
+		while (true) {
+			double norm_before = 0.0;
+			for (size_t r = 0; r < num_rows; ++r) {
+				norm_before += matrix[r * num_columns + c] * matrix[r * num_columns + c];
+			}
+			for (size_t pass = 0; pass < 2; ++pass) {
+				for (size_t prev = 0; prev < c; ++prev) {
+					double dot = 0.0;
+					for (size_t r = 0; r < num_rows; ++r) {
+						dot += matrix[r * num_columns + c] * matrix[r * num_columns + prev];
+					}
+					for (size_t r = 0; r < num_rows; ++r) {
+						matrix[r * num_columns + c] -= dot * matrix[r * num_columns + prev];
+					}
+				}
+			}
+			double norm_after = 0.0;
+			for (size_t r = 0; r < num_rows; ++r) {
+				norm_after += matrix[r * num_columns + c] * matrix[r * num_columns + c];
+			}
+			if (norm_after > 1e-16 * norm_before) {
+				const double norm = sqrt(norm_after);
+				for (size_t r = 0; r < num_rows; ++r) {
+					matrix[r * num_columns + c] /= norm;
+				}
+				break;
+			}
+			assert(unit_row < num_rows);
+			for (size_t r = 0; r < num_rows; ++r) {
+				matrix[r * num_columns + c] = (r == unit_row) ? 1.0 : 0.0;
+			}
+			++unit_row;
+		}
+	}
 }
@@ -21,6 +21,7 @@
 #ifndef SCC_DATA_SET_STRUCT_HG
 #define SCC_DATA_SET_STRUCT_HG
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -39,11 +40,70 @@ struct scc_DataSet {
 	int32_t data_set_version;
 	size_t num_data_points;
 	uint_fast16_t num_dimensions;
+	size_t row_stride;
+	size_t column_stride;
+	uint32_t* columns;
 	const double* data_matrix;
+	const double** column_arrays;
+	uint_fast16_t num_categorical;
+	const int32_t* categorical_matrix;
+	double* gower_weights;
+	const uint64_t* binary_matrix;
+	scc_BinaryDistance binary_distance;
+	double* geo_matrix;
+	double geo_radius;
+	uint_fast16_t num_components;
+	double* projection_matrix;
+	struct iscc_KDTree* search_index;
 };
 
 
-static const int32_t ISCC_DATASET_STRUCT_VERSION = 722328001;
+static const int32_t ISCC_DATASET_STRUCT_VERSION = 722328007;
+
+
+static const double ISCC_GEO_PI = 3.14159265358979323846;
+
+
+// =============================================================================
+// Data access
+// =============================================================================
+
+// Returns the value of `dimension` for the first data point. The values of later
+// data points follow `row_stride` elements apart.
+static inline const double* iscc_get_column_data(const scc_DataSet* const data_set,
+                                                 const size_t dimension)
+{
+	if (data_set->column_arrays != NULL) return data_set->column_arrays[dimension];
+	const size_t column = (data_set->columns == NULL) ? dimension : (size_t) data_set->columns[dimension];
+	return data_set->data_matrix + column * data_set->column_stride;
+}
+
+
+// =============================================================================
+// Geo data set conversions
+// =============================================================================
+
+// Converts a great-circle distance in a geo data set to the chord length between the
+// points embedded on the unit sphere. Distances in other data sets are returned unchanged.
+static inline double iscc_to_embedded_dist(const scc_DataSet* const data_set,
+                                           const double dist)
+{
+	if (data_set->geo_matrix == NULL) return dist;
+	const double angle = dist / data_set->geo_radius;
+	// Beyond the antipode, so all points are within the distance
+	if (angle >= ISCC_GEO_PI) return 4.0;
+	return 2.0 * sin(angle / 2.0);
+}
+
+
+// Converts a chord length between embedded points to a great-circle distance.
+static inline double iscc_from_embedded_dist(const scc_DataSet* const data_set,
+                                             const double embedded_dist)
+{
+	if (data_set->geo_matrix == NULL) return embedded_dist;
+	const double half_chord = (embedded_dist < 2.0) ? (embedded_dist / 2.0) : 1.0;
+	return 2.0 * asin(half_chord) * data_set->geo_radius;
+}
 
 
 #ifdef __cplusplus
@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "../include/scclust_spi.h"
+#include "dist_search_imp.h"
 
 
 // =============================================================================
@@ -36,8 +37,10 @@ typedef struct iscc_dist_functions_struct {
 	scc_num_data_points num_data_points;
 	scc_get_dist_matrix get_dist_matrix;
 	scc_get_dist_rows get_dist_rows;
+	scc_get_dist_rows get_sq_dist_rows;
 	scc_init_max_dist_object init_max_dist_object;
 	scc_get_max_dist get_max_dist;
+	scc_get_max_dist get_sq_max_dist;
 	scc_close_max_dist_object close_max_dist_object;
 	scc_init_nn_search_object init_nn_search_object;
 	scc_nearest_neighbor_search nearest_neighbor_search;
@@ -92,6 +95,38 @@ static inline bool iscc_get_dist_rows(void* data_set,
 }
 
 
+static inline bool iscc_get_sq_dist_rows(void* data_set,
+                                         size_t len_query_indices,
+                                         const scc_PointIndex query_indices[],
+                                         size_t len_column_indices,
+                                         const scc_PointIndex column_indices[],
+                                         double output_dists[])
+{
+	if (iscc_dist_functions.get_sq_dist_rows != NULL) {
+		return iscc_dist_functions.get_sq_dist_rows(data_set,
+		                                            len_query_indices,
+		                                            query_indices,
+		                                            len_column_indices,
+		                                            column_indices,
+		                                            output_dists);
+	}
+
+	if (!iscc_dist_functions.get_dist_rows(data_set,
+	                                       len_query_indices,
+	                                       query_indices,
+	                                       len_column_indices,
+	                                       column_indices,
+	                                       output_dists)) {
+		return false;
+	}
+	const double* const output_dists_stop = output_dists + len_query_indices * len_column_indices;
+	for (double* dist = output_dists; dist != output_dists_stop; ++dist) {
+		*dist *= *dist;
+	}
+	return true;
+}
+
+
 // =============================================================================
 // Max dist functions
 // =============================================================================
@@ -122,6 +157,34 @@ static inline bool iscc_get_max_dist(iscc_MaxDistObject* max_dist_object,
 }
 
 
+static inline bool iscc_get_sq_max_dist(iscc_MaxDistObject* max_dist_object,
+                                        size_t len_query_indices,
+                                        const scc_PointIndex query_indices[],
+                                        scc_PointIndex out_max_indices[],
+                                        double out_max_dists[])
+{
+	if (iscc_dist_functions.get_sq_max_dist != NULL) {
+		return iscc_dist_functions.get_sq_max_dist(max_dist_object,
+		                                           len_query_indices,
+		                                           query_indices,
+		                                           out_max_indices,
+		                                           out_max_dists);
+	}
+
+	if (!iscc_dist_functions.get_max_dist(max_dist_object,
+	                                      len_query_indices,
+	                                      query_indices,
+	                                      out_max_indices,
+	                                      out_max_dists)) {
+		return false;
+	}
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		out_max_dists[q] *= out_max_dists[q];
+	}
+	return true;
+}
+
+
 static inline bool iscc_close_max_dist_object(iscc_MaxDistObject** max_dist_object)
 {
 	return iscc_dist_functions.close_max_dist_object(max_dist_object);
@@ -172,4 +235,27 @@ static inline bool iscc_close_nn_search_object(iscc_NNSearchObject** nn_search_o
 }
 
 
+// Tells the search object how many queries follow, so the built-in functions can decide whether
+// to build a search tree before the queries are split between the bodies of a parallel loop.
+static inline bool iscc_expect_nn_queries(iscc_NNSearchObject* nn_search_object,
+                                          size_t num_queries)
+{
+	if (iscc_dist_functions.init_nn_search_object == iscc_imp_init_nn_search_object) {
+		return iscc_imp_expect_nn_queries(nn_search_object, num_queries);
+	}
+	return true;
+}
+
+
+// Tells the search object that it is used in the body of a parallel loop. Only objects
+// of the built-in functions start loops of their own; others are left untouched.
+static inline void iscc_set_nn_search_in_parallel_loop(iscc_NNSearchObject* nn_search_object,
+                                                       bool in_parallel_loop)
+{
+	if (iscc_dist_functions.init_nn_search_object == iscc_imp_init_nn_search_object) {
+		iscc_imp_set_nn_search_in_parallel_loop(nn_search_object, in_parallel_loop);
+	}
+}
+
+
 #endif // ifndef SCC_DIST_SEARCH_HG
@@ -24,38 +24,344 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
 #include "data_set_struct.h"
+#include "kd_tree.h"
+#include "parallel_for.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// Number of points whose distances to a query are computed together.
+static const size_t ISCC_DIST_BLOCK_POINTS = 256;
+
+// Relative margin on projected distances, so rounding errors never prune a neighbor.
+static const double ISCC_PROJECTION_SLACK = 1e-9;
+
+// Smallest number of distances (queries times search points) computed in each slice of a split
+// search, so that each slice is worth a loop body (0.25-0.7 ms of scanning with 2-10 dimensions).
+static const size_t ISCC_SPLIT_SEARCH_SLICE_DISTS = 65536;
+
+// Smallest number of search points in each slice of a split search (a multiple of `ISCC_DIST_BLOCK_POINTS`).
+// Each slice keeps its own neighbor lists, which costs 2-5% over a serial scan at this length.
+static const size_t ISCC_SPLIT_SEARCH_SLICE_POINTS = 4096;
+
+// Largest number of slices in a split search.
+static const size_t ISCC_SPLIT_SEARCH_MAX_SLICES = 256;
+
+// Largest number of neighbors kept in the lists of all slices of a split search (12 MB of scratch).
+static const size_t ISCC_SPLIT_SEARCH_MAX_LIST_LEN = 1048576;
+
+// A kd-tree of the search set is built once the queries reach this fraction (1/32) of the search points...
+static const size_t ISCC_KD_TREE_QUERY_DIVISOR = 32;
+
+// ...or this many queries. Building costs about as much as scanning for 120-710 queries with 2-8 dimensions.
+static const size_t ISCC_KD_TREE_MAX_MIN_QUERIES = 512;
+
+
 // =============================================================================
 // Distance calculations
 // =============================================================================
 
-static inline double iscc_get_sq_dist(const scc_DataSet* const data_set,
-                                      const size_t index1,
-                                      const size_t index2)
+// How the terms of the distances are stored. The layout is looked up once per call or block,
+// so the loops over pairs of points do not branch on it.
+typedef enum {
+	// Euclidean, each point is a contiguous row of `data_matrix` (the common case)
+	ISCC_DL_ROWS,
+	// Euclidean, the dimensions are the `columns` of the rows of `data_matrix`
+	ISCC_DL_ROW_COLUMNS,
+	// Euclidean, each dimension is a contiguous column
+	ISCC_DL_COLUMNS,
+	ISCC_DL_GOWER,
+	ISCC_DL_BINARY,
+} iscc_DistLayout;
+
+
+static inline iscc_DistLayout iscc_get_dist_layout(const scc_DataSet* const data_set)
 {
-	assert(index1 < data_set->num_data_points);
-	assert(index2 < data_set->num_data_points);
+	if (data_set->binary_matrix != NULL) return ISCC_DL_BINARY;
+	if (data_set->gower_weights != NULL) return ISCC_DL_GOWER;
+	if ((data_set->column_arrays != NULL) || (data_set->column_stride != 1)) return ISCC_DL_COLUMNS;
+	if (data_set->columns != NULL) return ISCC_DL_ROW_COLUMNS;
+	return ISCC_DL_ROWS;
+}
 
-	const double* data1 = &data_set->data_matrix[index1 * data_set->num_dimensions];
-	const double* const data1_stop = data1 + data_set->num_dimensions;
-	const double* data2 = &data_set->data_matrix[index2 * data_set->num_dimensions];
 
+// Squared distance between two contiguous rows
+static inline double iscc_get_sq_dist(const double* const data1,
+                                      const double* const data2,
+                                      const uint_fast16_t num_dimensions)
+{
 	double tmp_dist = 0.0;
-	while (data1 != data1_stop) {
-		const double value_diff = (*data1 - *data2);
-		++data1;
-		++data2;
+	for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+		const double value_diff = (data1[d] - data2[d]);
 		tmp_dist += value_diff * value_diff;
 	}
 	return tmp_dist;
 }
 
 
+// Squared distance between two rows whose dimensions are the elements `columns` of the rows
+static inline double iscc_get_sq_dist_columns(const double* const data1,
+                                              const double* const data2,
+                                              const uint32_t columns[const],
+                                              const uint_fast16_t num_dimensions)
+{
+	double tmp_dist = 0.0;
+	for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+		const double value_diff = (data1[columns[d]] - data2[columns[d]]);
+		tmp_dist += value_diff * value_diff;
+	}
+	return tmp_dist;
+}
+
+
+static inline double iscc_get_gower_dist(const scc_DataSet* const data_set,
+                                         const size_t index1,
+                                         const size_t index2)
+{
+	assert(index1 < data_set->num_data_points);
+	assert(index2 < data_set->num_data_points);
+	assert(data_set->gower_weights != NULL);
+
+	// Branch-free loops over contiguous rows, so the compiler can vectorize them
+	double tmp_dist = 0.0;
+	const double* const numeric_weights = data_set->gower_weights;
+	const uint_fast16_t num_numeric = data_set->num_dimensions;
+	if (num_numeric > 0) {
+		const double* const data1 = &data_set->data_matrix[index1 * num_numeric];
+		const double* const data2 = &data_set->data_matrix[index2 * num_numeric];
+		for (uint_fast16_t d = 0; d < num_numeric; ++d) {
+			tmp_dist += numeric_weights[d] * fabs(data1[d] - data2[d]);
+		}
+	}
+
+	const double* const categorical_weights = data_set->gower_weights + num_numeric;
+	const uint_fast16_t num_categorical = data_set->num_categorical;
+	if (num_categorical > 0) {
+		const int32_t* const cat1 = &data_set->categorical_matrix[index1 * num_categorical];
+		const int32_t* const cat2 = &data_set->categorical_matrix[index2 * num_categorical];
+		for (uint_fast16_t c = 0; c < num_categorical; ++c) {
+			tmp_dist += categorical_weights[c] * (double) (cat1[c] != cat2[c]);
+		}
+	}
+
+	return tmp_dist;
+}
+
+
+static inline uint_fast32_t iscc_popcount64(const uint64_t word)
+{
+#if defined(__GNUC__)
+	// Compiles to POPCNT, or VPOPCNTQ in vectorized loops, when the target supports it
+	return (uint_fast32_t) __builtin_popcountll(word);
+#else
+	uint64_t tmp = word - ((word >> 1) & 0x5555555555555555u);
+	tmp = (tmp & 0x3333333333333333u) + ((tmp >> 2) & 0x3333333333333333u);
+	tmp = (tmp + (tmp >> 4)) & 0x0F0F0F0F0F0F0F0Fu;
+	return (uint_fast32_t) ((tmp * 0x0101010101010101u) >> 56);
+#endif
+}
+
+
+static inline double iscc_get_binary_dist(const scc_DataSet* const data_set,
+                                          const size_t index1,
+                                          const size_t index2)
+{
+	assert(index1 < data_set->num_data_points);
+	assert(index2 < data_set->num_data_points);
+	assert(data_set->binary_matrix != NULL);
+
+	const size_t num_words = data_set->row_stride;
+	const uint64_t* const bits1 = &data_set->binary_matrix[index1 * num_words];
+	const uint64_t* const bits2 = &data_set->binary_matrix[index2 * num_words];
+
+	if (data_set->binary_distance == SCC_BD_HAMMING) {
+		uint_fast32_t num_differ = 0;
+		for (size_t w = 0; w < num_words; ++w) {
+			num_differ += iscc_popcount64(bits1[w] ^ bits2[w]);
+		}
+		return (double) num_differ;
+	}
+
+	assert(data_set->binary_distance == SCC_BD_JACCARD);
+	uint_fast32_t num_differ = 0;
+	uint_fast32_t num_either = 0;
+	for (size_t w = 0; w < num_words; ++w) {
+		num_differ += iscc_popcount64(bits1[w] ^ bits2[w]);
+		num_either += iscc_popcount64(bits1[w] | bits2[w]);
+	}
+	return (num_either == 0) ? 0.0 : ((double) num_differ) / ((double) num_either);
+}
+
+
+// Gower and binary data sets have plain distances, Euclidean data sets have squared distances
+static inline bool iscc_euclidean_data_set(const scc_DataSet* const data_set)
+{
+	return (data_set->gower_weights == NULL) && (data_set->binary_matrix == NULL);
+}
+
+
+// Distances from `query` to `point_indices[0], ..., point_indices[len_points - 1]`, or, if
+// `point_indices` is NULL, to `first_point, ..., first_point + len_points - 1`. The distances are
+// squared for Euclidean data sets and plain for other data sets (see `iscc_finish_dist`). With
+// column-major data, the distances are accumulated one column at a time over the whole block of
+// points. The terms are summed in the same order as in `iscc_get_sq_dist`, so the results are identical.
+static inline void iscc_get_block_dists(const scc_DataSet* const data_set,
+                                        const iscc_DistLayout layout,
+                                        const size_t query,
+                                        const size_t len_points,
+                                        const scc_PointIndex point_indices[const],
+                                        const size_t first_point,
+                                        double out_dists[const])
+{
+	assert(query < data_set->num_data_points);
+	assert((point_indices != NULL) || (first_point + len_points <= data_set->num_data_points));
+	assert(layout == iscc_get_dist_layout(data_set));
+
+	if ((layout == ISCC_DL_ROWS) || (layout == ISCC_DL_ROW_COLUMNS)) {
+		const double* const data_matrix = data_set->data_matrix;
+		const size_t row_stride = data_set->row_stride;
+		const uint_fast16_t num_dimensions = data_set->num_dimensions;
+		const double* const query_row = data_matrix + query * row_stride;
+		if (layout == ISCC_DL_ROWS) {
+			if (point_indices == NULL) {
+				const double* point_row = data_matrix + first_point * row_stride;
+				for (size_t p = 0; p < len_points; ++p, point_row += row_stride) {
+					out_dists[p] = iscc_get_sq_dist(query_row, point_row, num_dimensions);
+				}
+			} else {
+				for (size_t p = 0; p < len_points; ++p) {
+					out_dists[p] = iscc_get_sq_dist(query_row, data_matrix + ((size_t) point_indices[p]) * row_stride, num_dimensions);
+				}
+			}
+		} else {
+			const uint32_t* const columns = data_set->columns;
+			for (size_t p = 0; p < len_points; ++p) {
+				const size_t point = (point_indices == NULL) ? (first_point + p) : (size_t) point_indices[p];
+				out_dists[p] = iscc_get_sq_dist_columns(query_row, data_matrix + point * row_stride, columns, num_dimensions);
+			}
+		}
+		return;
+	}
+
+	if (layout == ISCC_DL_BINARY) {
+		if (point_indices == NULL) {
+			for (size_t p = 0; p < len_points; ++p) {
+				out_dists[p] = iscc_get_binary_dist(data_set, query, first_point + p);
+			}
+		} else {
+			for (size_t p = 0; p < len_points; ++p) {
+				out_dists[p] = iscc_get_binary_dist(data_set, query, (size_t) point_indices[p]);
+			}
+		}
+		return;
+	}
+
+	if (layout == ISCC_DL_GOWER) {
+		if (point_indices == NULL) {
+			for (size_t p = 0; p < len_points; ++p) {
+				out_dists[p] = iscc_get_gower_dist(data_set, query, first_point + p);
+			}
+		} else {
+			for (size_t p = 0; p < len_points; ++p) {
+				out_dists[p] = iscc_get_gower_dist(data_set, query, (size_t) point_indices[p]);
+			}
+		}
+		return;
+	}
+
+	assert(layout == ISCC_DL_COLUMNS);
+	assert(data_set->row_stride == 1);
+	for (size_t p = 0; p < len_points; ++p) {
+		out_dists[p] = 0.0;
+	}
+	for (uint_fast16_t d = 0; d < data_set->num_dimensions; ++d) {
+		const double* const column_data = iscc_get_column_data(data_set, d);
+		const double query_value = column_data[query];
+		if (point_indices == NULL) {
+			const double* const block_data = column_data + first_point;
+			for (size_t p = 0; p < len_points; ++p) {
+				const double value_diff = (query_value - block_data[p]);
+				out_dists[p] += value_diff * value_diff;
+			}
+		} else {
+			for (size_t p = 0; p < len_points; ++p) {
+				const double value_diff = (query_value - column_data[point_indices[p]]);
+				out_dists[p] += value_diff * value_diff;
+			}
+		}
+	}
+}
+
+
+// Squared distances between the projections of `query` and the points, as in `iscc_get_block_dists`.
+// These are lower bounds of the squared distances between the points.
+static inline void iscc_get_projected_sq_dists(const scc_DataSet* const data_set,
+                                               const size_t query,
+                                               const size_t len_points,
+                                               const scc_PointIndex point_indices[const],
+                                               const size_t first_point,
+                                               double out_sq_dists[const])
+{
+	assert(data_set->projection_matrix != NULL);
+	const size_t num_components = (size_t) data_set->num_components;
+	const double* const query_proj = data_set->projection_matrix + query * num_components;
+	for (size_t p = 0; p < len_points; ++p) {
+		const size_t point = (point_indices == NULL) ? (first_point + p) : (size_t) point_indices[p];
+		const double* const point_proj = data_set->projection_matrix + point * num_components;
+		double tmp_dist = 0.0;
+		for (size_t c = 0; c < num_components; ++c) {
+			const double value_diff = (query_proj[c] - point_proj[c]);
+			tmp_dist += value_diff * value_diff;
+		}
+		out_sq_dists[p] = tmp_dist;
+	}
+}
+
+
+// Converts the output of `iscc_get_block_dists` to distances or squared distances.
+// `squared` is a constant at every call site, so the branch is resolved at compile time
+static inline double iscc_finish_dist(const scc_DataSet* const data_set,
+                                      const double block_dist,
+                                      const bool squared)
+{
+	if (!iscc_euclidean_data_set(data_set)) {
+		return squared ? (block_dist * block_dist) : block_dist;
+	}
+	if (data_set->geo_matrix != NULL) {
+		const double dist = iscc_from_embedded_dist(data_set, sqrt(block_dist));
+		return squared ? (dist * dist) : dist;
+	}
+	return squared ? block_dist : sqrt(block_dist);
+}
+
+
+// Applies `iscc_finish_dist` to a block of distances, with the data set type looked up once
+static inline void iscc_finish_block_dists(const scc_DataSet* const data_set,
+                                           const size_t len_dists,
+                                           double dists[const],
+                                           const bool squared)
+{
+	if (iscc_euclidean_data_set(data_set) && (data_set->geo_matrix == NULL)) {
+		if (!squared) {
+			for (size_t i = 0; i < len_dists; ++i) {
+				dists[i] = sqrt(dists[i]);
+			}
+		}
+		return;
+	}
+	for (size_t i = 0; i < len_dists; ++i) {
+		dists[i] = iscc_finish_dist(data_set, dists[i], squared);
+	}
+}
+
+
 // =============================================================================
 // Miscellaneous functions implementations
 // =============================================================================
@@ -87,72 +393,78 @@ bool iscc_imp_get_dist_matrix(void* const data_set,
 	assert(len_point_indices > 1);
 	assert(output_dists != NULL);
 
-	if (point_indices == NULL) {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, p1, p2));
-				++output_dists;
-			}
-		}
-	} else {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) point_indices[p1], (size_t) point_indices[p2]));
-				++output_dists;
-			}
+	const iscc_DistLayout layout = iscc_get_dist_layout(data_set);
+	for (size_t p1 = 0; p1 < len_point_indices - 1; ++p1) {
+		const size_t len_row = len_point_indices - p1 - 1;
+		if (point_indices == NULL) {
+			iscc_get_block_dists(data_set, layout, p1, len_row, NULL, p1 + 1, output_dists);
+		} else {
+			iscc_get_block_dists(data_set, layout, (size_t) point_indices[p1], len_row, point_indices + p1 + 1, 0, output_dists);
 		}
+		iscc_finish_block_dists(data_set, len_row, output_dists, false);
+		output_dists += len_row;
 	}
 
 	return true;
 }
 
 
-bool iscc_imp_get_dist_rows(void* const data_set,
-                            const size_t len_query_indices,
-                            const scc_PointIndex query_indices[const],
-                            const size_t len_column_indices,
-                            const scc_PointIndex column_indices[const],
-                            double output_dists[])
+static inline bool iscc_get_dist_rows_imp(void* const data_set,
+                                          const size_t len_query_indices,
+                                          const scc_PointIndex query_indices[const],
+                                          const size_t len_column_indices,
+                                          const scc_PointIndex column_indices[const],
+                                          const bool squared,
+                                          double output_dists[])
 {
 	assert(iscc_imp_check_data_set(data_set));
 	assert(len_query_indices > 0);
 	assert(len_column_indices > 0);
 	assert(output_dists != NULL);
 
-	if ((query_indices != NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
+	const iscc_DistLayout layout = iscc_get_dist_layout(data_set);
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+		iscc_get_block_dists(data_set, layout, query, len_column_indices, column_indices, 0, output_dists);
+		iscc_finish_block_dists(data_set, len_column_indices, output_dists, squared);
+		output_dists += len_column_indices;
+	}
 
-	} else if ((query_indices == NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
+	return true;
+}
 
-	} else if ((query_indices != NULL) && (column_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], c));
-				++output_dists;
-			}
-		}
 
-	} else if ((query_indices == NULL) && (column_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, c));
-				++output_dists;
-			}
-		}
-	}
+bool iscc_imp_get_dist_rows(void* const data_set,
+                            const size_t len_query_indices,
+                            const scc_PointIndex query_indices[const],
+                            const size_t len_column_indices,
+                            const scc_PointIndex column_indices[const],
+                            double output_dists[])
+{
+	return iscc_get_dist_rows_imp(data_set,
+	                              len_query_indices,
+	                              query_indices,
+	                              len_column_indices,
+	                              column_indices,
+	                              false,
+	                              output_dists);
+}
 
-	return true;
+
+bool iscc_imp_get_sq_dist_rows(void* const data_set,
+                               const size_t len_query_indices,
+                               const scc_PointIndex query_indices[const],
+                               const size_t len_column_indices,
+                               const scc_PointIndex column_indices[const],
+                               double output_dists[])
+{
+	return iscc_get_dist_rows_imp(data_set,
+	                              len_query_indices,
+	                              query_indices,
+	                              len_column_indices,
+	                              column_indices,
+	                              true,
+	                              output_dists);
 }
 
 
@@ -194,11 +506,12 @@ bool iscc_imp_init_max_dist_object(void* const data_set,
 }
 
 
-bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
-                           const size_t len_query_indices,
-                           const scc_PointIndex query_indices[const],
-                           scc_PointIndex out_max_indices[const],
-                           double out_max_dists[const])
+static inline bool iscc_get_max_dist_imp(iscc_MaxDistObject* const max_dist_object,
+                                         const size_t len_query_indices,
+                                         const scc_PointIndex query_indices[const],
+                                         const bool squared,
+                                         scc_PointIndex out_max_indices[const],
+                                         double out_max_dists[const])
 {
 	assert(max_dist_object != NULL);
 	assert(max_dist_object->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
@@ -212,66 +525,89 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 	assert(out_max_indices != NULL);
 	assert(out_max_dists != NULL);
 
-	double tmp_dist;
-	double max_dist;
-
-	if ((query_indices != NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) search_indices[s]);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = search_indices[s];
-				}
-			}
-			out_max_dists[q] = sqrt(max_dist);
-		}
-
-	} else if ((query_indices == NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, (size_t) search_indices[s]);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = search_indices[s];
+	const iscc_DistLayout layout = iscc_get_dist_layout(data_set);
+	double block_dists[ISCC_DIST_BLOCK_POINTS];
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+		double max_dist = -1.0;
+		if (layout == ISCC_DL_ROWS) {
+			// The maximum is tracked while the distances are computed, without a block buffer
+			const double* const data_matrix = data_set->data_matrix;
+			const size_t row_stride = data_set->row_stride;
+			const uint_fast16_t num_dimensions = data_set->num_dimensions;
+			const double* const query_row = data_matrix + query * row_stride;
+			size_t max_pos = 0;
+			if (search_indices == NULL) {
+				const double* point_row = data_matrix;
+				for (size_t s = 0; s < len_search_indices; ++s, point_row += row_stride) {
+					const double tmp_dist = iscc_get_sq_dist(query_row, point_row, num_dimensions);
+					if (max_dist < tmp_dist) {
+						max_dist = tmp_dist;
+						max_pos = s;
+					}
 				}
-			}
-			out_max_dists[q] = sqrt(max_dist);
-		}
-
-	} else if ((query_indices != NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], s);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = (scc_PointIndex) s;
+				out_max_indices[q] = (scc_PointIndex) max_pos;
+			} else {
+				for (size_t s = 0; s < len_search_indices; ++s) {
+					const double tmp_dist = iscc_get_sq_dist(query_row, data_matrix + ((size_t) search_indices[s]) * row_stride, num_dimensions);
+					if (max_dist < tmp_dist) {
+						max_dist = tmp_dist;
+						max_pos = s;
+					}
 				}
+				out_max_indices[q] = search_indices[max_pos];
 			}
-			out_max_dists[q] = sqrt(max_dist);
+			out_max_dists[q] = iscc_finish_dist(data_set, max_dist, squared);
+			continue;
 		}
-
-	} else if ((query_indices == NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, s);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = (scc_PointIndex) s;
+		for (size_t block_start = 0; block_start < len_search_indices; block_start += ISCC_DIST_BLOCK_POINTS) {
+			const size_t len_block = ((len_search_indices - block_start) < ISCC_DIST_BLOCK_POINTS) ? (len_search_indices - block_start) : ISCC_DIST_BLOCK_POINTS;
+			const scc_PointIndex* const block_indices = (search_indices == NULL) ? NULL : (search_indices + block_start);
+			iscc_get_block_dists(data_set, layout, query, len_block, block_indices, block_start, block_dists);
+			for (size_t s = 0; s < len_block; ++s) {
+				if (max_dist < block_dists[s]) {
+					max_dist = block_dists[s];
+					out_max_indices[q] = (block_indices == NULL) ? ((scc_PointIndex) (block_start + s)) : block_indices[s];
 				}
 			}
-			out_max_dists[q] = sqrt(max_dist);
 		}
+		out_max_dists[q] = iscc_finish_dist(data_set, max_dist, squared);
 	}
 
 	return true;
 }
 
 
+bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
+                           const size_t len_query_indices,
+                           const scc_PointIndex query_indices[const],
+                           scc_PointIndex out_max_indices[const],
+                           double out_max_dists[const])
+{
+	return iscc_get_max_dist_imp(max_dist_object,
+	                             len_query_indices,
+	                             query_indices,
+	                             false,
+	                             out_max_indices,
+	                             out_max_dists);
+}
+
+
+bool iscc_imp_get_sq_max_dist(iscc_MaxDistObject* const max_dist_object,
+                              const size_t len_query_indices,
+                              const scc_PointIndex query_indices[const],
+                              scc_PointIndex out_max_indices[const],
+                              double out_max_dists[const])
+{
+	return iscc_get_max_dist_imp(max_dist_object,
+	                             len_query_indices,
+	                             query_indices,
+	                             true,
+	                             out_max_indices,
+	                             out_max_dists);
+}
+
+
 bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 {
 	if (max_dist_object != NULL && *max_dist_object != NULL) {
@@ -292,12 +628,35 @@ struct iscc_NNSearchObject {
 	scc_DataSet* data_set;
 	size_t len_search_indices;
 	const scc_PointIndex* search_indices;
+	iscc_KDTree* kd_tree;
+	bool owns_kd_tree;
+	bool kd_tree_pending;
+	size_t num_queries;
+	bool in_parallel_loop;
 };
 
 
 static const int32_t ISCC_NN_SEARCH_STRUCT_VERSION = 722294001;
 
 
+// Each slice of the search set is scanned separately for every query, and writes the
+// `k` nearest points it found to its own part of `slice_dists` and `slice_indices`.
+typedef struct iscc_SplitSearch {
+	scc_DataSet* data_set;
+	const scc_PointIndex* search_indices;
+	size_t len_search_indices;
+	size_t slice_len;
+	size_t len_query_indices;
+	const scc_PointIndex* query_indices;
+	uint32_t k;
+	bool radius_search;
+	double block_radius;
+	double* slice_dists;
+	scc_PointIndex* slice_indices;
+	uint32_t* slice_found;
+} iscc_SplitSearch;
+
+
 static inline void iscc_add_dist_to_list(const double add_dist,
                                          const scc_PointIndex add_index,
                                          double* dist_list,
@@ -334,7 +693,263 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 		.data_set = data_set,
 		.len_search_indices = len_search_indices,
 		.search_indices = search_indices,
+		.kd_tree = NULL,
+		.owns_kd_tree = false,
+		.kd_tree_pending = false,
+		.num_queries = 0,
+		.in_parallel_loop = false,
+	};
+
+	// Low-dimensional Euclidean data sets are searched with a dual-tree traversal. A search
+	// index attached to the data set is used when all points are searched. Otherwise, a tree
+	// is built when enough queries have been made (see `iscc_imp_expect_nn_queries`), as
+	// short-lived objects with few queries are faster to scan.
+	if ((search_indices == NULL) && (((scc_DataSet*) data_set)->search_index != NULL) &&
+	        (len_search_indices == ((scc_DataSet*) data_set)->num_data_points)) {
+		(*out_nn_search_object)->kd_tree = ((scc_DataSet*) data_set)->search_index;
+	} else {
+		(*out_nn_search_object)->kd_tree_pending = iscc_kd_tree_applicable(data_set, len_search_indices);
+	}
+
+	return true;
+}
+
+
+bool iscc_imp_expect_nn_queries(iscc_NNSearchObject* const nn_search_object,
+                                const size_t num_queries)
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
+	assert(!nn_search_object->in_parallel_loop);
+
+	if (!nn_search_object->kd_tree_pending) return true;
+
+	size_t min_queries = nn_search_object->len_search_indices / ISCC_KD_TREE_QUERY_DIVISOR;
+	if (min_queries > ISCC_KD_TREE_MAX_MIN_QUERIES) min_queries = ISCC_KD_TREE_MAX_MIN_QUERIES;
+	if (nn_search_object->num_queries + num_queries < min_queries) return true;
+
+	nn_search_object->kd_tree_pending = false;
+	if (!iscc_init_kd_tree(nn_search_object->data_set,
+	                       nn_search_object->len_search_indices,
+	                       nn_search_object->search_indices,
+	                       &nn_search_object->kd_tree)) {
+		return false;
+	}
+	nn_search_object->owns_kd_tree = true;
+
+	return true;
+}
+
+
+// Finds the (at most) `k` nearest points to `query` among positions `[range_begin, range_end)`
+// of the search set, sorted by distance. Ties are kept in search set order.
+static uint32_t iscc_scan_search_range(scc_DataSet* const data_set,
+                                       const size_t query,
+                                       const scc_PointIndex* const search_indices,
+                                       const size_t range_begin,
+                                       const size_t range_end,
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double block_radius,
+                                       double* const out_dists,
+                                       scc_PointIndex* const out_indices)
+{
+	assert(range_begin < range_end);
+	assert(k > 0);
+	assert(out_dists != NULL);
+	assert(out_indices != NULL);
+
+	const iscc_DistLayout layout = iscc_get_dist_layout(data_set);
+	uint32_t found = 0;
+	double* const out_dists_end = out_dists + k - 1;
+	scc_PointIndex* const out_indices_end = out_indices + k - 1;
+	double block_dists[ISCC_DIST_BLOCK_POINTS];
+	double block_bounds[ISCC_DIST_BLOCK_POINTS];
+	scc_PointIndex block_survivors[ISCC_DIST_BLOCK_POINTS];
+
+	for (size_t block_start = range_begin; block_start < range_end; block_start += ISCC_DIST_BLOCK_POINTS) {
+		const size_t len_block = ((range_end - block_start) < ISCC_DIST_BLOCK_POINTS) ? (range_end - block_start) : ISCC_DIST_BLOCK_POINTS;
+		const scc_PointIndex* block_indices = (search_indices == NULL) ? NULL : (search_indices + block_start);
+		size_t len_compute = len_block;
+
+		// Points whose projected distance already exceeds the radius, or the distance of the
+		// current k-th neighbor, would be skipped below, so their distances are not computed
+		if ((data_set->projection_matrix != NULL) && ((found == k) || radius_search)) {
+			const double bound = (found == k) ? *out_dists_end : block_radius;
+			iscc_get_projected_sq_dists(data_set, query, len_block, block_indices, block_start, block_bounds);
+			len_compute = 0;
+			for (size_t s = 0; s < len_block; ++s) {
+				block_survivors[len_compute] = (block_indices == NULL) ? ((scc_PointIndex) (block_start + s)) : block_indices[s];
+				len_compute += (block_bounds[s] * (1.0 - ISCC_PROJECTION_SLACK) <= bound);
+			}
+			block_indices = block_survivors;
+		}
+		iscc_get_block_dists(data_set, layout, query, len_compute, block_indices, block_start, block_dists);
+
+		for (size_t s = 0; s < len_compute; ++s) {
+			const double tmp_dist = block_dists[s];
+			const scc_PointIndex tmp_index = (block_indices == NULL) ? ((scc_PointIndex) (block_start + s)) : block_indices[s];
+			if (found < k) {
+				// Fill the list with the first points (within the radius)
+				if (radius_search && (tmp_dist > block_radius)) continue;
+				iscc_add_dist_to_list(tmp_dist, tmp_index, out_dists + found, out_indices + found, out_dists);
+				++found;
+			} else {
+				if (tmp_dist >= *out_dists_end) continue;
+				iscc_add_dist_to_list(tmp_dist, tmp_index, out_dists_end, out_indices_end, out_dists);
+			}
+		}
+	}
+
+	return found;
+}
+
+
+static void iscc_search_slices(const size_t begin,
+                               const size_t end,
+                               void* const context)
+{
+	const iscc_SplitSearch* const split_search = context;
+	assert(split_search != NULL);
+	assert(begin <= end);
+
+	const size_t len_query_indices = split_search->len_query_indices;
+	const uint32_t k = split_search->k;
+	for (size_t slice = begin; slice < end; ++slice) {
+		const size_t range_begin = slice * split_search->slice_len;
+		assert(range_begin < split_search->len_search_indices);
+		const size_t range_end = (split_search->len_search_indices - range_begin < split_search->slice_len) ?
+		                         split_search->len_search_indices : (range_begin + split_search->slice_len);
+		for (size_t q = 0; q < len_query_indices; ++q) {
+			const size_t query = (split_search->query_indices == NULL) ? q : (size_t) split_search->query_indices[q];
+			const size_t list_start = (slice * len_query_indices + q) * k;
+			split_search->slice_found[slice * len_query_indices + q] = iscc_scan_search_range(split_search->data_set,
+			                                                                                 query,
+			                                                                                 split_search->search_indices,
+			                                                                                 range_begin,
+			                                                                                 range_end,
+			                                                                                 k,
+			                                                                                 split_search->radius_search,
+			                                                                                 split_search->block_radius,
+			                                                                                 split_search->slice_dists + list_start,
+			                                                                                 split_search->slice_indices + list_start);
+		}
+	}
+}
+
+
+// Number of slices that a search is split into. Each slice computes at least `ISCC_SPLIT_SEARCH_SLICE_DISTS`
+// distances, so the slices are sized by the total work rather than by the number of queries alone.
+// Below two, the search is not split.
+static size_t iscc_get_num_search_slices(const size_t len_search_indices,
+                                         const size_t len_query_indices,
+                                         const uint32_t k)
+{
+	assert(len_query_indices > 0);
+	assert(k > 0);
+
+	size_t min_slice_len = (ISCC_SPLIT_SEARCH_SLICE_DISTS + len_query_indices - 1) / len_query_indices;
+	if (min_slice_len < ISCC_SPLIT_SEARCH_SLICE_POINTS) min_slice_len = ISCC_SPLIT_SEARCH_SLICE_POINTS;
+	size_t num_slices = len_search_indices / min_slice_len;
+	if (num_slices > ISCC_SPLIT_SEARCH_MAX_SLICES) num_slices = ISCC_SPLIT_SEARCH_MAX_SLICES;
+	const size_t max_list_slices = ISCC_SPLIT_SEARCH_MAX_LIST_LEN / len_query_indices / k;
+	if (num_slices > max_list_slices) num_slices = max_list_slices;
+	return num_slices;
+}
+
+
+static bool iscc_split_nn_search(scc_DataSet* const data_set,
+                                 const scc_PointIndex* const search_indices,
+                                 const size_t len_search_indices,
+                                 size_t num_slices,
+                                 const size_t len_query_indices,
+                                 const scc_PointIndex* const query_indices,
+                                 const uint32_t k,
+                                 const bool radius_search,
+                                 const double block_radius,
+                                 size_t* const out_num_ok_queries,
+                                 scc_PointIndex* const out_query_indices,
+                                 scc_PointIndex* const out_nn_indices)
+{
+	assert(num_slices >= 2);
+	assert(len_search_indices >= num_slices * ISCC_SPLIT_SEARCH_SLICE_POINTS);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+
+	// Slices are whole blocks, so the blocks are the same as in a serial scan
+	const size_t slice_blocks = ((len_search_indices + ISCC_DIST_BLOCK_POINTS - 1) / ISCC_DIST_BLOCK_POINTS + num_slices - 1) / num_slices;
+	const size_t slice_len = slice_blocks * ISCC_DIST_BLOCK_POINTS;
+	num_slices = (len_search_indices + slice_len - 1) / slice_len;
+
+	const size_t len_slice_lists = num_slices * len_query_indices * k;
+	iscc_SplitSearch split_search = {
+		.data_set = data_set,
+		.search_indices = search_indices,
+		.len_search_indices = len_search_indices,
+		.slice_len = slice_len,
+		.len_query_indices = len_query_indices,
+		.query_indices = query_indices,
+		.k = k,
+		.radius_search = radius_search,
+		.block_radius = block_radius,
+		.slice_dists = malloc(sizeof(double[len_slice_lists])),
+		.slice_indices = malloc(sizeof(scc_PointIndex[len_slice_lists])),
+		.slice_found = malloc(sizeof(uint32_t[num_slices * len_query_indices])),
 	};
+	double* const sort_scratch = malloc(sizeof(double[k]));
+	if ((split_search.slice_dists == NULL) ||
+	        (split_search.slice_indices == NULL) ||
+	        (split_search.slice_found == NULL) ||
+	        (sort_scratch == NULL)) {
+		free(split_search.slice_dists);
+		free(split_search.slice_indices);
+		free(split_search.slice_found);
+		free(sort_scratch);
+		return false;
+	}
+
+	iscc_parallel_for(0, num_slices, 1, iscc_search_slices, &split_search);
+
+	// Merging the slices in order gives the same neighbors, in the same order, as a serial scan
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+	double* const sort_scratch_end = sort_scratch + k - 1;
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		uint32_t found = 0;
+		scc_PointIndex* const index_write_end = index_write + k - 1;
+		for (size_t slice = 0; slice < num_slices; ++slice) {
+			const size_t list_start = (slice * len_query_indices + q) * k;
+			const double* const list_dists = split_search.slice_dists + list_start;
+			const scc_PointIndex* const list_indices = split_search.slice_indices + list_start;
+			const uint32_t list_found = split_search.slice_found[slice * len_query_indices + q];
+			for (uint32_t i = 0; i < list_found; ++i) {
+				if (found < k) {
+					iscc_add_dist_to_list(list_dists[i], list_indices[i], sort_scratch + found, index_write + found, sort_scratch);
+					++found;
+				} else {
+					// The lists are sorted, so the rest of this list is not closer either
+					if (list_dists[i] >= *sort_scratch_end) break;
+					iscc_add_dist_to_list(list_dists[i], list_indices[i], sort_scratch_end, index_write_end, sort_scratch);
+				}
+			}
+		}
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (query_indices == NULL) ? ((scc_PointIndex) q) : query_indices[q];
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	*out_num_ok_queries = num_ok_queries;
+
+	free(split_search.slice_dists);
+	free(split_search.slice_indices);
+	free(split_search.slice_found);
+	free(sort_scratch);
 
 	return true;
 }
@@ -365,98 +980,74 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 	assert(out_num_ok_queries != NULL);
 	assert(out_nn_indices != NULL);
 
-	double tmp_dist;
+	// Searches in the body of a loop were announced before it, and may not change the object
+	if (!nn_search_object->in_parallel_loop) {
+		if (!iscc_imp_expect_nn_queries(nn_search_object, len_query_indices)) return false;
+		nn_search_object->num_queries += len_query_indices;
+	}
+
+	// Radius on the scale of `iscc_get_block_dists`
+	const double embedded_radius = iscc_to_embedded_dist(data_set, radius);
+	const double block_radius = iscc_euclidean_data_set(data_set) ? (embedded_radius * embedded_radius) : radius;
+
+	if (nn_search_object->kd_tree != NULL) {
+		return iscc_kd_tree_nearest_neighbor_search(nn_search_object->kd_tree,
+		                                            data_set,
+		                                            search_indices,
+		                                            len_query_indices,
+		                                            query_indices,
+		                                            k,
+		                                            radius_search,
+		                                            block_radius,
+		                                            out_num_ok_queries,
+		                                            out_query_indices,
+		                                            out_nn_indices);
+	}
+
+	// A search outside the body of a loop would otherwise be serial, so the search set is split
+	// between the bodies of a loop of its own when there is enough work for several slices
+	const size_t num_slices = (iscc_parallel_for_is_set() && !nn_search_object->in_parallel_loop) ?
+	                          iscc_get_num_search_slices(len_search_indices, len_query_indices, k) : 0;
+	if (num_slices >= 2) {
+		return iscc_split_nn_search(data_set,
+		                            search_indices,
+		                            len_search_indices,
+		                            num_slices,
+		                            len_query_indices,
+		                            query_indices,
+		                            k,
+		                            radius_search,
+		                            block_radius,
+		                            out_num_ok_queries,
+		                            out_query_indices,
+		                            out_nn_indices);
+	}
+
 	size_t num_ok_queries = 0;
 	scc_PointIndex* index_write = out_nn_indices;
 	double* const sort_scratch = malloc(sizeof(double[k]));
 	if (sort_scratch == NULL) return false;
-	double* const sort_scratch_end = sort_scratch + k - 1;
-	const double radius_sq = radius * radius;
-
-	if (search_indices == NULL) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
-			if (query_indices != NULL) {
-				query = (size_t) query_indices[q];
-			}
-			size_t s = 0;
-			uint32_t found;
-			scc_PointIndex* const index_write_end = index_write + k - 1;
-
-			if (radius_search) {
-				found = 0;
-				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
-					if (tmp_dist > radius_sq) continue;
-					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + found, index_write + found, sort_scratch);
-					++found;
-				}
-			} else {
-				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
-					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + s, index_write + s, sort_scratch);
-				}
-				found = k;
-			}
-
-			for (; s < len_search_indices; ++s) {
-				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, s);
-				if (tmp_dist >= *sort_scratch_end) continue;
-				iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch_end, index_write_end, sort_scratch);
-			}
-
-			assert(found == k || out_query_indices != NULL);
-			if (found == k) {
-				if (out_query_indices != NULL) {
-					out_query_indices[num_ok_queries] = (scc_PointIndex) query;
-				}
-				++num_ok_queries;
-				index_write += k;
-			}
-		}
-	} else {
-		assert(search_indices != NULL);
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
-			if (query_indices != NULL) {
-				query = (size_t) query_indices[q];
-			}
-			size_t s = 0;
-			uint32_t found;
-			scc_PointIndex* const index_write_end = index_write + k - 1;
-
-			if (radius_search) {
-				found = 0;
-				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-					if (tmp_dist > radius_sq) continue;
-					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + found, index_write + found, sort_scratch);
-					++found;
-				}
-			} else {
-				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + s, index_write + s, sort_scratch);
-				}
-				found = k;
-			}
-
-			for (; s < len_search_indices; ++s) {
-				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-				if (tmp_dist >= *sort_scratch_end) continue;
-				iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch_end, index_write_end, sort_scratch);
-			}
 
-			assert(found == k || out_query_indices != NULL);
-			if (found == k) {
-				if (out_query_indices != NULL) {
-					out_query_indices[num_ok_queries] = (scc_PointIndex) query;
-				}
-				++num_ok_queries;
-				index_write += k;
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+		const uint32_t found = iscc_scan_search_range(data_set,
+		                                              query,
+		                                              search_indices,
+		                                              0,
+		                                              len_search_indices,
+		                                              k,
+		                                              radius_search,
+		                                              block_radius,
+		                                              sort_scratch,
+		                                              index_write);
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
 			}
+			++num_ok_queries;
+			index_write += k;
 		}
 	}
 
@@ -472,8 +1063,20 @@ bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** const nn_search_objec
 {
 	if (nn_search_object != NULL && *nn_search_object != NULL) {
 		assert((*nn_search_object)->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
+		if ((*nn_search_object)->owns_kd_tree) {
+			iscc_free_kd_tree(&(*nn_search_object)->kd_tree);
+		}
 		free(*nn_search_object);
 		*nn_search_object = NULL;
 	}
 	return true;
 }
+
+
+void iscc_imp_set_nn_search_in_parallel_loop(iscc_NNSearchObject* const nn_search_object,
+                                             const bool in_parallel_loop)
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
+	nn_search_object->in_parallel_loop = in_parallel_loop;
+}
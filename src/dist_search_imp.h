@@ -58,6 +58,15 @@ bool iscc_imp_get_dist_rows(void* data_set,
                             double output_dists[]);
 
 
+// As `iscc_imp_get_dist_rows` but outputs squared distances
+bool iscc_imp_get_sq_dist_rows(void* data_set,
+                               size_t len_query_indices,
+                               const scc_PointIndex query_indices[],
+                               size_t len_column_indices,
+                               const scc_PointIndex column_indices[],
+                               double output_dists[]);
+
+
 // =============================================================================
 // Max dist functions
 // =============================================================================
@@ -76,6 +85,14 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* max_dist_object,
                            double out_max_dists[]);
 
 
+// As `iscc_imp_get_max_dist` but outputs squared distances
+bool iscc_imp_get_sq_max_dist(iscc_MaxDistObject* max_dist_object,
+                              size_t len_query_indices,
+                              const scc_PointIndex query_indices[],
+                              scc_PointIndex out_max_indices[],
+                              double out_max_dists[]);
+
+
 bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** max_dist_object);
 
 
@@ -104,6 +121,18 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
 bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
 
 
+// Tells `nn_search_object` that `num_queries` queries follow, possibly from the bodies of a
+// parallel loop, and builds its kd-tree if they justify it. Must not be called in a loop body.
+bool iscc_imp_expect_nn_queries(iscc_NNSearchObject* nn_search_object,
+                                size_t num_queries);
+
+
+// Marks whether searches on `nn_search_object` are called from the body of a parallel
+// loop, in which case they do not start loops of their own
+void iscc_imp_set_nn_search_in_parallel_loop(iscc_NNSearchObject* nn_search_object,
+                                             bool in_parallel_loop);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,7 +44,7 @@ scc_ErrorCode iscc_make_error__(const scc_ErrorCode ec,
                                 const char* const file,
                                 const int line)
 {
-	assert((ec > SCC_ER_OK) && (ec <= SCC_ER_NOT_IMPLEMENTED));
+	assert((ec > SCC_ER_OK) && (ec <= SCC_ER_IO_ERROR));
 
 	iscc_error_code = ec;
 	iscc_error_msg = msg;
@@ -102,6 +102,9 @@ bool scc_get_latest_error(const size_t len_error_message_buffer,
 			case SCC_ER_NOT_IMPLEMENTED:
 				error_message = "Functionality not yet implemented.";
 				break;
+			case SCC_ER_IO_ERROR:
+				error_message = "Failed to read or write a file.";
+				break;
 			default:
 				error_message = "Unknown error code.";
 				break;
@@ -26,14 +26,23 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "dist_search.h"
 #include "clustering_struct.h"
 #include "error.h"
+#include "parallel_for.h"
 #include "scclust_types.h"
 
 // Maximum number of data points to check when finding centers.
 static const uint_fast16_t ISCC_HI_NUM_TO_CHECK = 100;
 
+// Clusters with at least twice this many points are split using the parallel loop function,
+// with at least this many members in each slice handled by a loop body.
+static const size_t ISCC_HI_SLICE_POINTS = 4096;
+
+// Largest number of slices of a cluster that is split using the parallel loop function.
+static const size_t ISCC_HI_MAX_SLICES = 256;
+
 
 // =============================================================================
 // Internal structs
@@ -62,6 +71,37 @@ typedef struct iscc_hi_ClusterStack {
 } iscc_hi_ClusterStack;
 
 
+// A node in the split tree covers the points `points[begin]` to `points[begin + size - 1]`.
+// `first` and `second` are the nodes it was split into, or zero if it was not split.
+typedef struct iscc_hi_SplitNode {
+	size_t begin;
+	size_t size;
+	size_t first;
+	size_t second;
+} iscc_hi_SplitNode;
+
+
+struct scc_SplitTree {
+	size_t num_data_points;
+	uint32_t size_constraint;
+	bool batch_assign;
+	size_t num_nodes;
+	iscc_hi_SplitNode* nodes;
+	scc_PointIndex* points;
+};
+
+
+// Records the splits made while clustering. `stack_nodes[i]` is the
+// node of the cluster at position `i` in the cluster stack.
+typedef struct iscc_hi_SplitRecorder {
+	size_t num_nodes;
+	size_t node_capacity;
+	iscc_hi_SplitNode* nodes;
+	size_t stack_capacity;
+	size_t* stack_nodes;
+} iscc_hi_SplitRecorder;
+
+
 typedef struct iscc_hi_WorkArea {
 	scc_PointIndex* const pointindex_array1;
 	scc_PointIndex* const pointindex_array2;
@@ -72,6 +112,44 @@ typedef struct iscc_hi_WorkArea {
 } iscc_hi_WorkArea;
 
 
+// Finds the members of a cluster farthest from query points. Large clusters are
+// divided into slices, each with its own max distance object, which are searched
+// in the bodies of a parallel loop. Slice `s` writes its result for the query at
+// position `q` to position `s * ISCC_HI_NUM_TO_CHECK + q` in `slice_max_indices`
+// and `slice_max_dists`.
+typedef struct iscc_hi_MaxDistProbe {
+	iscc_MaxDistObject* max_dist_object;
+	const iscc_hi_ClusterItem* cl;
+	size_t slice_len;
+	size_t num_slices;
+	iscc_MaxDistObject** slice_objects;
+	size_t num_to_check;
+	const scc_PointIndex* to_check;
+	scc_PointIndex* slice_max_indices;
+	double* slice_max_dists;
+	bool* slice_ok;
+} iscc_hi_MaxDistProbe;
+
+
+// State of the parallel loops that populate the edge lists of a large cluster. List `l`
+// is read from `from_edges[l]` and written to `to_edges[l]`, which are swapped after
+// each round of merging. Edges are sorted in runs of `run_len` edges that start at
+// position one.
+typedef struct iscc_hi_EdgeSlices {
+	void* data_set;
+	const iscc_hi_ClusterItem* cl;
+	size_t slice_len;
+	scc_PointIndex centers[2];
+	size_t center_positions[2];
+	double* row_dists;
+	size_t run_len;
+	size_t num_runs;
+	iscc_hi_DistanceEdge* from_edges[2];
+	iscc_hi_DistanceEdge* to_edges[2];
+	bool* slice_ok;
+} iscc_hi_EdgeSlices;
+
+
 // =============================================================================
 // Static function prototypes
 // =============================================================================
@@ -85,12 +163,30 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* in_cl,
                                            size_t* out_size_largest_cluster);
 
 
+static scc_ErrorCode iscc_hi_cluster_stack(iscc_hi_ClusterStack* cl_stack,
+                                           size_t num_data_points,
+                                           size_t size_largest_cluster,
+                                           scc_Clustering* cl,
+                                           void* data_set,
+                                           uint32_t size_constraint,
+                                           bool batch_assign,
+                                           iscc_hi_SplitRecorder* recorder);
+
+
 static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* cl_stack,
                                                          scc_Clustering* cl,
                                                          void* data_set,
                                                          iscc_hi_WorkArea* work_area,
                                                          uint32_t size_constraint,
-                                                         bool batch_assign);
+                                                         bool batch_assign,
+                                                         iscc_hi_SplitRecorder* recorder);
+
+
+static scc_ErrorCode iscc_hi_record_split(iscc_hi_ClusterStack* cl_stack,
+                                          iscc_hi_SplitRecorder* recorder);
+
+
+static bool iscc_hi_check_split_tree(const scc_SplitTree* split_tree);
 
 
 static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* cl_stack);
@@ -170,10 +266,62 @@ static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* cl,
                                           iscc_hi_DistanceEdge edge_store[static cl->size]);
 
 
+static inline void iscc_hi_link_edge_list(size_t cluster_size,
+                                          iscc_hi_DistanceEdge edge_store[static cluster_size]);
+
+
 static int iscc_hi_compare_dist_edges(const void* a,
                                       const void* b);
 
 
+static inline bool iscc_hi_split_in_parallel(const iscc_hi_ClusterItem* cl);
+
+
+static inline size_t iscc_hi_get_slice_len(size_t cluster_size);
+
+
+static scc_ErrorCode iscc_hi_init_max_dist_probe(void* data_set,
+                                                 const iscc_hi_ClusterItem* cl,
+                                                 iscc_hi_MaxDistProbe* out_probe);
+
+
+static bool iscc_hi_get_sq_max_dist(iscc_hi_MaxDistProbe* probe,
+                                    size_t num_to_check,
+                                    const scc_PointIndex to_check[],
+                                    scc_PointIndex out_max_indices[],
+                                    double out_max_dists[]);
+
+
+static bool iscc_hi_close_max_dist_probe(iscc_hi_MaxDistProbe* probe);
+
+
+static void iscc_hi_probe_slices(size_t begin,
+                                 size_t end,
+                                 void* context);
+
+
+static scc_ErrorCode iscc_hi_parallel_populate_edge_lists(const iscc_hi_ClusterItem* cl,
+                                                          void* data_set,
+                                                          scc_PointIndex center1,
+                                                          scc_PointIndex center2,
+                                                          iscc_hi_WorkArea* work_area);
+
+
+static void iscc_hi_fill_edge_slices(size_t begin,
+                                     size_t end,
+                                     void* context);
+
+
+static void iscc_hi_sort_edge_runs(size_t begin,
+                                   size_t end,
+                                   void* context);
+
+
+static void iscc_hi_merge_edge_runs(size_t begin,
+                                    size_t end,
+                                    void* context);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -219,42 +367,245 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 		}
 	}
 
-	assert(cl_stack.items > 0);
-	assert(cl_stack.clusters != NULL);
-	assert(cl_stack.pointindex_store != NULL);
+	ec = iscc_hi_cluster_stack(&cl_stack,
+	                           out_clustering->num_data_points,
+	                           size_largest_cluster,
+	                           out_clustering,
+	                           data_set,
+	                           size_constraint,
+	                           batch_assign,
+	                           NULL);
 
-	const size_t size_pointindex_array = (size_constraint > ISCC_HI_NUM_TO_CHECK) ? size_constraint : ISCC_HI_NUM_TO_CHECK;
-	const size_t size_dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK;
-	iscc_hi_WorkArea work_area = {
-		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.dist_array = malloc(sizeof(double[size_dist_array])),
-		.vertex_markers = calloc(out_clustering->num_data_points, sizeof(uint_fast16_t)),
-		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+	free(cl_stack.clusters);
+	free(cl_stack.pointindex_store);
+
+	return ec;
+}
+
+
+scc_ErrorCode scc_build_split_tree(void* const data_set,
+                                   const uint32_t size_constraint,
+                                   const bool batch_assign,
+                                   scc_SplitTree** const out_split_tree)
+{
+	if (out_split_tree == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	// Initialize to null, so subsequent calls to `scc_free_split_tree` are safe
+	*out_split_tree = NULL;
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if (size_constraint < 2) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be 2 or greater.");
+	}
+	const size_t num_data_points = iscc_num_data_points(data_set);
+	if (num_data_points < size_constraint) {
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
+	}
+
+	scc_ErrorCode ec;
+	iscc_hi_ClusterStack cl_stack;
+	if ((ec = iscc_hi_empty_cl_stack(num_data_points, &cl_stack)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	// Each split adds two nodes, and the number of splits is bounded by the number of clusters
+	const size_t tmp_node_capacity = 1 + 2 * (num_data_points / size_constraint);
+	iscc_hi_SplitRecorder recorder = {
+		.num_nodes = 1,
+		.node_capacity = tmp_node_capacity,
+		.nodes = malloc(sizeof(iscc_hi_SplitNode[tmp_node_capacity])),
+		.stack_capacity = cl_stack.capacity,
+		.stack_nodes = malloc(sizeof(size_t[cl_stack.capacity])),
 	};
+	scc_SplitTree* const tmp_split_tree = malloc(sizeof(scc_SplitTree));
 
-	if ((work_area.pointindex_array1 == NULL) || (work_area.pointindex_array2 == NULL) ||
-	        (work_area.dist_array == NULL) || (work_area.vertex_markers == NULL) ||
-	        (work_area.edge_store1 == NULL) || (work_area.edge_store2 == NULL)) {
+	if ((recorder.nodes == NULL) || (recorder.stack_nodes == NULL) || (tmp_split_tree == NULL)) {
 		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	} else {
+		recorder.nodes[0] = (iscc_hi_SplitNode) {
+			.begin = 0,
+			.size = num_data_points,
+			.first = 0,
+			.second = 0,
+		};
+		recorder.stack_nodes[0] = 0;
+
+		ec = iscc_hi_cluster_stack(&cl_stack,
+		                           num_data_points,
+		                           num_data_points,
+		                           NULL,
+		                           data_set,
+		                           size_constraint,
+		                           batch_assign,
+		                           &recorder);
+	}
+
+	free(cl_stack.clusters);
+	free(recorder.stack_nodes);
+
+	if (ec != SCC_ER_OK) {
+		free(cl_stack.pointindex_store);
+		free(recorder.nodes);
+		free(tmp_split_tree);
+		return ec;
+	}
+
+	// Splits never move points out of their clusters, so the final order of
+	// the point store is consistent with all nodes in the tree
+	*tmp_split_tree = (scc_SplitTree) {
+		.num_data_points = num_data_points,
+		.size_constraint = size_constraint,
+		.batch_assign = batch_assign,
+		.num_nodes = recorder.num_nodes,
+		.nodes = recorder.nodes,
+		.points = cl_stack.pointindex_store,
+	};
+
+	*out_split_tree = tmp_split_tree;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_cut_split_tree(const scc_SplitTree* const split_tree,
+                                 void* const data_set,
+                                 const uint32_t size_constraint,
+                                 scc_Clustering* const out_clustering)
+{
+	if (!iscc_hi_check_split_tree(split_tree)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid split tree object.");
+	}
+	if (!iscc_check_input_clustering(out_clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if ((iscc_num_data_points(data_set) != out_clustering->num_data_points) ||
+	        (split_tree->num_data_points != out_clustering->num_data_points)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object or split tree.");
+	}
+	if (size_constraint < split_tree->size_constraint) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be at least the size constraint of the split tree.");
+	}
+	if (out_clustering->num_data_points < size_constraint) {
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
+	}
+	if (out_clustering->num_clusters != 0) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+	}
+
+	if (out_clustering->cluster_label == NULL) {
+		out_clustering->external_labels = false;
+		out_clustering->cluster_label = malloc(sizeof(scc_Clabel[out_clustering->num_data_points]));
+		if (out_clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	size_t* const node_stack = malloc(sizeof(size_t[split_tree->num_nodes]));
+	size_t* const resplit_nodes = malloc(sizeof(size_t[split_tree->num_nodes]));
+	if ((node_stack == NULL) || (resplit_nodes == NULL)) {
+		free(node_stack);
+		free(resplit_nodes);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Walk the tree in the order `iscc_hi_run_hierarchical_clustering` splits clusters, so
+	// that cutting at the size constraint of the tree gives the labels of the original run.
+	// A node is a cluster when it is too small to split. It is re-split if the recorded
+	// split made a cluster smaller than the size constraint.
+	const iscc_hi_SplitNode* const nodes = split_tree->nodes;
+	scc_Clabel* const cluster_label = out_clustering->cluster_label;
+	scc_Clabel current_label = 0;
+	size_t num_resplit_nodes = 0;
+	size_t num_resplit_points = 0;
+	size_t size_largest_resplit = 0;
+	size_t stack_items = 1;
+	node_stack[0] = 0;
+	while (stack_items > 0) {
+		const iscc_hi_SplitNode* const node = &nodes[node_stack[--stack_items]];
+		if (node->size < (2 * (size_t) size_constraint)) {
+			if (current_label == SCC_CLABEL_MAX) {
+				free(node_stack);
+				free(resplit_nodes);
+				return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+			}
+			for (size_t i = node->begin; i < node->begin + node->size; ++i) {
+				cluster_label[split_tree->points[i]] = current_label;
+			}
+			++current_label;
+		} else if ((node->first != 0) &&
+		               (nodes[node->first].size >= size_constraint) &&
+		               (nodes[node->second].size >= size_constraint)) {
+			node_stack[stack_items++] = node->first;
+			node_stack[stack_items++] = node->second;
+		} else {
+			resplit_nodes[num_resplit_nodes++] = (size_t) (node - nodes);
+			num_resplit_points += node->size;
+			size_largest_resplit = (node->size > size_largest_resplit) ? node->size : size_largest_resplit;
+		}
+	}
+	free(node_stack);
+
+	if (num_resplit_nodes == 0) {
+		free(resplit_nodes);
+		out_clustering->num_clusters = (size_t) current_label;
+		return iscc_no_error();
+	}
+
+	// All nodes that must be re-split are put on one stack and clustered in one run
+	const uint64_t tmp_capacity = num_resplit_nodes + 1 + ((uint64_t) (10 * log2((double) num_resplit_points)));
+	if (tmp_capacity > SIZE_MAX) {
+		free(resplit_nodes);
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters.");
+	}
+	iscc_hi_ClusterStack cl_stack = {
+		.capacity = (size_t) tmp_capacity,
+		.items = num_resplit_nodes,
+		.clusters = malloc(sizeof(iscc_hi_ClusterItem[(size_t) tmp_capacity])),
+		.pointindex_store = malloc(sizeof(scc_PointIndex[num_resplit_points])),
+	};
+	if ((cl_stack.clusters == NULL) || (cl_stack.pointindex_store == NULL)) {
+		free(resplit_nodes);
+		free(cl_stack.clusters);
+		free(cl_stack.pointindex_store);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
+	scc_PointIndex* members = cl_stack.pointindex_store;
+	for (size_t r = 0; r < num_resplit_nodes; ++r) {
+		const iscc_hi_SplitNode* const node = &nodes[resplit_nodes[r]];
+		memcpy(members, split_tree->points + node->begin, sizeof(scc_PointIndex[node->size]));
+		cl_stack.clusters[r] = (iscc_hi_ClusterItem) {
+			.size = node->size,
+			.marker = 0,
+			.members = members,
+		};
+		members += node->size;
+	}
+	free(resplit_nodes);
+
+	scc_ErrorCode ec = iscc_hi_cluster_stack(&cl_stack,
+	                                         out_clustering->num_data_points,
+	                                         size_largest_resplit,
+	                                         out_clustering,
+	                                         data_set,
+	                                         size_constraint,
+	                                         split_tree->batch_assign,
+	                                         NULL);
+
+	// The re-split clusters are labeled from zero, and follow the clusters in the tree
+	if ((ec == SCC_ER_OK) && (out_clustering->num_clusters > (size_t) (SCC_CLABEL_MAX - current_label))) {
+		ec = iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+	}
 	if (ec == SCC_ER_OK) {
-		ec = iscc_hi_run_hierarchical_clustering(&cl_stack,
-		                                         out_clustering,
-		                                         data_set,
-		                                         &work_area,
-		                                         size_constraint,
-		                                         batch_assign);
+		for (size_t i = 0; i < num_resplit_points; ++i) {
+			cluster_label[cl_stack.pointindex_store[i]] += current_label;
+		}
+		out_clustering->num_clusters += (size_t) current_label;
 	}
 
-	free(work_area.pointindex_array1);
-	free(work_area.pointindex_array2);
-	free(work_area.dist_array);
-	free(work_area.vertex_markers);
-	free(work_area.edge_store1);
-	free(work_area.edge_store2);
 	free(cl_stack.clusters);
 	free(cl_stack.pointindex_store);
 
@@ -262,6 +613,17 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 }
 
 
+void scc_free_split_tree(scc_SplitTree** const split_tree)
+{
+	if ((split_tree != NULL) && (*split_tree != NULL)) {
+		free((*split_tree)->nodes);
+		free((*split_tree)->points);
+		free(*split_tree);
+		*split_tree = NULL;
+	}
+}
+
+
 // =============================================================================
 // Static function implementations
 // =============================================================================
@@ -356,21 +718,77 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 }
 
 
+static scc_ErrorCode iscc_hi_cluster_stack(iscc_hi_ClusterStack* const cl_stack,
+                                           const size_t num_data_points,
+                                           const size_t size_largest_cluster,
+                                           scc_Clustering* const cl,
+                                           void* const data_set,
+                                           const uint32_t size_constraint,
+                                           const bool batch_assign,
+                                           iscc_hi_SplitRecorder* const recorder)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items > 0);
+	assert(cl_stack->clusters != NULL);
+	assert(cl_stack->pointindex_store != NULL);
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(size_largest_cluster <= num_data_points);
+
+	const size_t size_pointindex_array = (size_constraint > ISCC_HI_NUM_TO_CHECK) ? size_constraint : ISCC_HI_NUM_TO_CHECK;
+	const size_t size_dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK;
+	iscc_hi_WorkArea work_area = {
+		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.dist_array = malloc(sizeof(double[size_dist_array])),
+		.vertex_markers = calloc(num_data_points, sizeof(uint_fast16_t)),
+		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+	};
+
+	scc_ErrorCode ec;
+	if ((work_area.pointindex_array1 == NULL) || (work_area.pointindex_array2 == NULL) ||
+	        (work_area.dist_array == NULL) || (work_area.vertex_markers == NULL) ||
+	        (work_area.edge_store1 == NULL) || (work_area.edge_store2 == NULL)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	} else {
+		ec = iscc_hi_run_hierarchical_clustering(cl_stack,
+		                                         cl,
+		                                         data_set,
+		                                         &work_area,
+		                                         size_constraint,
+		                                         batch_assign,
+		                                         recorder);
+	}
+
+	free(work_area.pointindex_array1);
+	free(work_area.pointindex_array2);
+	free(work_area.dist_array);
+	free(work_area.vertex_markers);
+	free(work_area.edge_store1);
+	free(work_area.edge_store2);
+
+	return ec;
+}
+
+
+// `cl` may be NULL when only the splits are recorded, and `recorder` is NULL when they are not
 static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* const cl_stack,
                                                          scc_Clustering* const cl,
                                                          void* const data_set,
                                                          iscc_hi_WorkArea* const work_area,
                                                          const uint32_t size_constraint,
-                                                         const bool batch_assign)
+                                                         const bool batch_assign,
+                                                         iscc_hi_SplitRecorder* const recorder)
 {
 	assert(cl_stack != NULL);
 	assert(cl_stack->items > 0);
 	assert(cl_stack->items <= cl_stack->capacity);
 	assert(cl_stack->clusters != NULL);
 	assert(cl_stack->pointindex_store != NULL);
-	assert(iscc_check_input_clustering(cl));
+	assert((cl == NULL) || iscc_check_input_clustering(cl));
 	assert(iscc_check_data_set(data_set));
-	assert(iscc_num_data_points(data_set) == cl->num_data_points);
+	assert((cl == NULL) || (iscc_num_data_points(data_set) == cl->num_data_points));
+	assert((cl != NULL) || (recorder != NULL));
 	assert(work_area != NULL);
 	assert(size_constraint >= 2);
 
@@ -385,7 +803,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 		iscc_hi_ClusterItem* current_cluster = &cl_stack->clusters[cl_stack->items - 1];
 
 		if (current_cluster->size < (2 * size_constraint)) {
-			if (current_cluster->size > 0) {
+			if ((current_cluster->size > 0) && (cl != NULL)) {
 				if (current_label == SCC_CLABEL_MAX) {
 					return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
 				}
@@ -406,10 +824,13 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 			                                         new_cluster)) != SCC_ER_OK) {
 				return ec;
 			}
+			if ((recorder != NULL) && ((ec = iscc_hi_record_split(cl_stack, recorder)) != SCC_ER_OK)) {
+				return ec;
+			}
 		}
 	}
 
-	cl->num_clusters = (size_t) current_label;
+	if (cl != NULL) cl->num_clusters = (size_t) current_label;
 
 	assert(cl_stack->items == 0);
 
@@ -417,6 +838,76 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 }
 
 
+// Records the split of the second to last cluster on the stack into itself and the last cluster
+static scc_ErrorCode iscc_hi_record_split(iscc_hi_ClusterStack* const cl_stack,
+                                          iscc_hi_SplitRecorder* const recorder)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items >= 2);
+	assert(recorder != NULL);
+	assert(recorder->num_nodes > 0);
+	assert(recorder->stack_nodes != NULL);
+
+	if (recorder->stack_capacity < cl_stack->capacity) {
+		size_t* const stack_nodes_tmp = realloc(recorder->stack_nodes, sizeof(size_t[cl_stack->capacity]));
+		if (stack_nodes_tmp == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		recorder->stack_nodes = stack_nodes_tmp;
+		recorder->stack_capacity = cl_stack->capacity;
+	}
+
+	if (recorder->num_nodes + 2 > recorder->node_capacity) {
+		const uintmax_t capacity_tmp = recorder->node_capacity + 16 + (recorder->node_capacity >> 4);
+		if ((capacity_tmp > SIZE_MAX) || (capacity_tmp < recorder->node_capacity)) {
+			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters.");
+		}
+		iscc_hi_SplitNode* const nodes_tmp = realloc(recorder->nodes, sizeof(iscc_hi_SplitNode[(size_t) capacity_tmp]));
+		if (nodes_tmp == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		recorder->nodes = nodes_tmp;
+		recorder->node_capacity = (size_t) capacity_tmp;
+	}
+
+	const size_t parent_item = cl_stack->items - 2;
+	const size_t parent = recorder->stack_nodes[parent_item];
+	const iscc_hi_ClusterItem* const first_cluster = &cl_stack->clusters[parent_item];
+	const iscc_hi_ClusterItem* const second_cluster = &cl_stack->clusters[parent_item + 1];
+
+	const size_t first = recorder->num_nodes;
+	const size_t second = first + 1;
+	recorder->nodes[first] = (iscc_hi_SplitNode) {
+		.begin = (size_t) (first_cluster->members - cl_stack->pointindex_store),
+		.size = first_cluster->size,
+		.first = 0,
+		.second = 0,
+	};
+	recorder->nodes[second] = (iscc_hi_SplitNode) {
+		.begin = (size_t) (second_cluster->members - cl_stack->pointindex_store),
+		.size = second_cluster->size,
+		.first = 0,
+		.second = 0,
+	};
+	recorder->nodes[parent].first = first;
+	recorder->nodes[parent].second = second;
+	recorder->num_nodes += 2;
+
+	recorder->stack_nodes[parent_item] = first;
+	recorder->stack_nodes[parent_item + 1] = second;
+
+	return iscc_no_error();
+}
+
+
+static bool iscc_hi_check_split_tree(const scc_SplitTree* const split_tree)
+{
+	if (split_tree == NULL) return false;
+	if (split_tree->num_data_points < 2) return false;
+	if (split_tree->size_constraint < 2) return false;
+	if (split_tree->num_nodes == 0) return false;
+	if (split_tree->nodes == NULL) return false;
+	if (split_tree->points == NULL) return false;
+	return true;
+}
+
+
 static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* const cl_stack)
 {
 	assert(cl_stack != NULL);
@@ -762,15 +1253,17 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 		vertex_markers[to_check[i]] = curr_marker;
 	}
 
-	iscc_MaxDistObject* max_dist_object;
-	if (!iscc_init_max_dist_object(data_set, cl->size, cl->members, &max_dist_object)) {
-		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	scc_ErrorCode ec;
+	iscc_hi_MaxDistProbe probe;
+	if ((ec = iscc_hi_init_max_dist_probe(data_set, cl, &probe)) != SCC_ER_OK) {
+		return ec;
 	}
 
+	// Only the order matters, so compare squared distances
 	double max_dist = -1.0;
 	while (num_to_check > 0) {
-		if (!iscc_get_max_dist(max_dist_object, num_to_check, to_check, max_indices, max_dists)) {
-			iscc_close_max_dist_object(&max_dist_object);
+		if (!iscc_hi_get_sq_max_dist(&probe, num_to_check, to_check, max_indices, max_dists)) {
+			iscc_hi_close_max_dist_probe(&probe);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
@@ -792,7 +1285,7 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 		num_to_check = write_in_to_check;
 	}
 
-	if (!iscc_close_max_dist_object(&max_dist_object)) {
+	if (!iscc_hi_close_max_dist_probe(&probe)) {
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
@@ -816,15 +1309,20 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 	assert(work_area->edge_store1 != NULL);
 	assert(work_area->edge_store2 != NULL);
 
+	if (iscc_hi_split_in_parallel(cl)) {
+		return iscc_hi_parallel_populate_edge_lists(cl, data_set, center1, center2, work_area);
+	}
+
 	double* const row_dists = work_area->dist_array;
 	const scc_PointIndex query_indices[2] = { center1, center2 };
 
-	if (!iscc_get_dist_rows(data_set,
-	                        2,
-	                        query_indices,
-	                        cl->size,
-	                        cl->members,
-	                        row_dists)) {
+	// Edges are only sorted, so squared distances suffice
+	if (!iscc_get_sq_dist_rows(data_set,
+	                           2,
+	                           query_indices,
+	                           cl->size,
+	                           cl->members,
+	                           row_dists)) {
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
@@ -858,7 +1356,17 @@ static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
 
 	qsort(edge_store + 1, cl->size - 1, sizeof(iscc_hi_DistanceEdge), iscc_hi_compare_dist_edges);
 
-	iscc_hi_DistanceEdge* const edge_stop = edge_store + cl->size - 1;
+	iscc_hi_link_edge_list(cl->size, edge_store);
+}
+
+
+static inline void iscc_hi_link_edge_list(const size_t cluster_size,
+                                          iscc_hi_DistanceEdge edge_store[const static cluster_size])
+{
+	assert(cluster_size >= 2);
+	assert(edge_store != NULL);
+
+	iscc_hi_DistanceEdge* const edge_stop = edge_store + cluster_size - 1;
 	for (iscc_hi_DistanceEdge* edge = edge_store; edge != edge_stop; ++edge) {
 		edge->next_dist = edge + 1;
 	}
@@ -876,3 +1384,352 @@ static int iscc_hi_compare_dist_edges(const void* const a,
 	if (dist_a > dist_b) return 1;
 	return 0;
 }
+
+
+static inline bool iscc_hi_split_in_parallel(const iscc_hi_ClusterItem* const cl)
+{
+	assert(cl != NULL);
+	return iscc_parallel_for_is_set() && (cl->size >= 2 * ISCC_HI_SLICE_POINTS);
+}
+
+
+static inline size_t iscc_hi_get_slice_len(const size_t cluster_size)
+{
+	const size_t slice_len = (cluster_size + ISCC_HI_MAX_SLICES - 1) / ISCC_HI_MAX_SLICES;
+	return (slice_len < ISCC_HI_SLICE_POINTS) ? ISCC_HI_SLICE_POINTS : slice_len;
+}
+
+
+static scc_ErrorCode iscc_hi_init_max_dist_probe(void* const data_set,
+                                                 const iscc_hi_ClusterItem* const cl,
+                                                 iscc_hi_MaxDistProbe* const out_probe)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(cl != NULL);
+	assert(cl->members != NULL);
+	assert(out_probe != NULL);
+
+	*out_probe = (iscc_hi_MaxDistProbe) {
+		.max_dist_object = NULL,
+		.cl = cl,
+		.slice_len = 0,
+		.num_slices = 0,
+		.slice_objects = NULL,
+		.num_to_check = 0,
+		.to_check = NULL,
+		.slice_max_indices = NULL,
+		.slice_max_dists = NULL,
+		.slice_ok = NULL,
+	};
+
+	if (!iscc_hi_split_in_parallel(cl)) {
+		if (!iscc_init_max_dist_object(data_set, cl->size, cl->members, &out_probe->max_dist_object)) {
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+		return iscc_no_error();
+	}
+
+	out_probe->slice_len = iscc_hi_get_slice_len(cl->size);
+	out_probe->num_slices = (cl->size + out_probe->slice_len - 1) / out_probe->slice_len;
+	const size_t num_slices = out_probe->num_slices;
+	out_probe->slice_objects = calloc(num_slices, sizeof(iscc_MaxDistObject*));
+	out_probe->slice_max_indices = malloc(sizeof(scc_PointIndex[num_slices * ISCC_HI_NUM_TO_CHECK]));
+	out_probe->slice_max_dists = malloc(sizeof(double[num_slices * ISCC_HI_NUM_TO_CHECK]));
+	out_probe->slice_ok = malloc(sizeof(bool[num_slices]));
+	if ((out_probe->slice_objects == NULL) || (out_probe->slice_max_indices == NULL) ||
+	        (out_probe->slice_max_dists == NULL) || (out_probe->slice_ok == NULL)) {
+		iscc_hi_close_max_dist_probe(out_probe);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t s = 0; s < num_slices; ++s) {
+		const size_t slice_begin = s * out_probe->slice_len;
+		const size_t slice_end = (slice_begin + out_probe->slice_len < cl->size) ? (slice_begin + out_probe->slice_len) : cl->size;
+		if (!iscc_init_max_dist_object(data_set, slice_end - slice_begin, cl->members + slice_begin, &out_probe->slice_objects[s])) {
+			iscc_hi_close_max_dist_probe(out_probe);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+static bool iscc_hi_get_sq_max_dist(iscc_hi_MaxDistProbe* const probe,
+                                    const size_t num_to_check,
+                                    const scc_PointIndex to_check[const],
+                                    scc_PointIndex out_max_indices[const],
+                                    double out_max_dists[const])
+{
+	assert(probe != NULL);
+	assert(num_to_check > 0);
+	assert(num_to_check <= ISCC_HI_NUM_TO_CHECK);
+	assert(to_check != NULL);
+	assert(out_max_indices != NULL);
+	assert(out_max_dists != NULL);
+
+	if (probe->max_dist_object != NULL) {
+		return iscc_get_sq_max_dist(probe->max_dist_object, num_to_check, to_check, out_max_indices, out_max_dists);
+	}
+
+	probe->num_to_check = num_to_check;
+	probe->to_check = to_check;
+	iscc_parallel_for(0, probe->num_slices, 1, iscc_hi_probe_slices, probe);
+
+	for (size_t s = 0; s < probe->num_slices; ++s) {
+		if (!probe->slice_ok[s]) return false;
+	}
+
+	// Slices are merged in order, so ties go to the first member as in a single search
+	for (size_t q = 0; q < num_to_check; ++q) {
+		out_max_indices[q] = probe->slice_max_indices[q];
+		out_max_dists[q] = probe->slice_max_dists[q];
+		for (size_t s = 1; s < probe->num_slices; ++s) {
+			const size_t pos = s * ISCC_HI_NUM_TO_CHECK + q;
+			if (out_max_dists[q] < probe->slice_max_dists[pos]) {
+				out_max_indices[q] = probe->slice_max_indices[pos];
+				out_max_dists[q] = probe->slice_max_dists[pos];
+			}
+		}
+	}
+
+	return true;
+}
+
+
+static bool iscc_hi_close_max_dist_probe(iscc_hi_MaxDistProbe* const probe)
+{
+	assert(probe != NULL);
+
+	bool close_ok = true;
+	if (probe->max_dist_object != NULL) {
+		close_ok = iscc_close_max_dist_object(&probe->max_dist_object);
+	}
+	if (probe->slice_objects != NULL) {
+		for (size_t s = 0; s < probe->num_slices; ++s) {
+			if (probe->slice_objects[s] != NULL) {
+				close_ok = iscc_close_max_dist_object(&probe->slice_objects[s]) && close_ok;
+			}
+		}
+	}
+
+	free(probe->slice_objects);
+	free(probe->slice_max_indices);
+	free(probe->slice_max_dists);
+	free(probe->slice_ok);
+	probe->slice_objects = NULL;
+	probe->slice_max_indices = NULL;
+	probe->slice_max_dists = NULL;
+	probe->slice_ok = NULL;
+
+	return close_ok;
+}
+
+
+static void iscc_hi_probe_slices(const size_t begin,
+                                 const size_t end,
+                                 void* const context)
+{
+	iscc_hi_MaxDistProbe* const probe = context;
+	assert(probe != NULL);
+	assert(end <= probe->num_slices);
+
+	for (size_t s = begin; s < end; ++s) {
+		probe->slice_ok[s] = iscc_get_sq_max_dist(probe->slice_objects[s],
+		                                          probe->num_to_check,
+		                                          probe->to_check,
+		                                          probe->slice_max_indices + s * ISCC_HI_NUM_TO_CHECK,
+		                                          probe->slice_max_dists + s * ISCC_HI_NUM_TO_CHECK);
+	}
+}
+
+
+static scc_ErrorCode iscc_hi_parallel_populate_edge_lists(const iscc_hi_ClusterItem* const cl,
+                                                          void* const data_set,
+                                                          const scc_PointIndex center1,
+                                                          const scc_PointIndex center2,
+                                                          iscc_hi_WorkArea* const work_area)
+{
+	assert(cl != NULL);
+	assert(cl->size >= 2 * ISCC_HI_SLICE_POINTS);
+	assert(cl->members != NULL);
+	assert(center1 != center2);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+
+	const size_t num_edges = cl->size - 1;
+	const size_t slice_len = iscc_hi_get_slice_len(cl->size);
+	const size_t num_slices = (cl->size + slice_len - 1) / slice_len;
+
+	bool* const slice_ok = malloc(sizeof(bool[num_slices]));
+	iscc_hi_DistanceEdge* const edge_scratch = malloc(sizeof(iscc_hi_DistanceEdge[2 * cl->size]));
+	if ((slice_ok == NULL) || (edge_scratch == NULL)) {
+		free(slice_ok);
+		free(edge_scratch);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	iscc_hi_EdgeSlices edges = {
+		.data_set = data_set,
+		.cl = cl,
+		.slice_len = slice_len,
+		.centers = { center1, center2 },
+		.center_positions = { cl->size, cl->size },
+		.row_dists = work_area->dist_array,
+		.run_len = slice_len,
+		.num_runs = (num_edges + slice_len - 1) / slice_len,
+		.from_edges = { work_area->edge_store1, work_area->edge_store2 },
+		.to_edges = { edge_scratch, edge_scratch + cl->size },
+		.slice_ok = slice_ok,
+	};
+
+	for (size_t i = 0; i < cl->size; ++i) {
+		if (cl->members[i] == center1) edges.center_positions[0] = i;
+		if (cl->members[i] == center2) edges.center_positions[1] = i;
+	}
+	assert(edges.center_positions[0] < cl->size);
+	assert(edges.center_positions[1] < cl->size);
+
+	iscc_parallel_for(0, num_slices, 1, iscc_hi_fill_edge_slices, &edges);
+	for (size_t s = 0; s < num_slices; ++s) {
+		if (!slice_ok[s]) {
+			free(slice_ok);
+			free(edge_scratch);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+	}
+
+	// Runs of both lists are sorted in one loop, and then merged pairwise until each list is one run
+	iscc_parallel_for(0, 2 * edges.num_runs, 1, iscc_hi_sort_edge_runs, &edges);
+	while (edges.num_runs > 1) {
+		const size_t num_merged_runs = (edges.num_runs + 1) / 2;
+		iscc_parallel_for(0, 2 * num_merged_runs, 1, iscc_hi_merge_edge_runs, &edges);
+		for (size_t l = 0; l < 2; ++l) {
+			iscc_hi_DistanceEdge* const tmp_edges = edges.from_edges[l];
+			edges.from_edges[l] = edges.to_edges[l];
+			edges.to_edges[l] = tmp_edges;
+		}
+		edges.run_len *= 2;
+		edges.num_runs = num_merged_runs;
+	}
+
+	if (edges.from_edges[0] != work_area->edge_store1) {
+		memcpy(work_area->edge_store1 + 1, edges.from_edges[0] + 1, num_edges * sizeof(iscc_hi_DistanceEdge));
+		memcpy(work_area->edge_store2 + 1, edges.from_edges[1] + 1, num_edges * sizeof(iscc_hi_DistanceEdge));
+	}
+
+	free(slice_ok);
+	free(edge_scratch);
+
+	iscc_hi_link_edge_list(cl->size, work_area->edge_store1);
+	iscc_hi_link_edge_list(cl->size, work_area->edge_store2);
+
+	return iscc_no_error();
+}
+
+
+static void iscc_hi_fill_edge_slices(const size_t begin,
+                                     const size_t end,
+                                     void* const context)
+{
+	const iscc_hi_EdgeSlices* const edges = context;
+	assert(edges != NULL);
+	const iscc_hi_ClusterItem* const cl = edges->cl;
+
+	for (size_t s = begin; s < end; ++s) {
+		const size_t slice_begin = s * edges->slice_len;
+		const size_t slice_end = (slice_begin + edges->slice_len < cl->size) ? (slice_begin + edges->slice_len) : cl->size;
+		assert(slice_begin < slice_end);
+
+		edges->slice_ok[s] = true;
+		for (size_t l = 0; l < 2; ++l) {
+			double* const row_dists = edges->row_dists + l * cl->size;
+			if (!iscc_get_sq_dist_rows(edges->data_set,
+			                           1,
+			                           &edges->centers[l],
+			                           slice_end - slice_begin,
+			                           cl->members + slice_begin,
+			                           row_dists + slice_begin)) {
+				edges->slice_ok[s] = false;
+				break;
+			}
+
+			// Edges are stored from position one, skipping the center
+			const size_t center_position = edges->center_positions[l];
+			iscc_hi_DistanceEdge* const edge_store = edges->from_edges[l];
+			for (size_t i = slice_begin; i < slice_end; ++i) {
+				if (i == center_position) continue;
+				iscc_hi_DistanceEdge* const edge = edge_store + ((i < center_position) ? (i + 1) : i);
+				edge->head = cl->members[i];
+				edge->distance = row_dists[i];
+			}
+		}
+	}
+}
+
+
+static void iscc_hi_sort_edge_runs(const size_t begin,
+                                   const size_t end,
+                                   void* const context)
+{
+	const iscc_hi_EdgeSlices* const edges = context;
+	assert(edges != NULL);
+	assert(end <= 2 * edges->num_runs);
+	const size_t cluster_size = edges->cl->size;
+
+	for (size_t r = begin; r < end; ++r) {
+		const size_t run_begin = 1 + (r % edges->num_runs) * edges->run_len;
+		const size_t run_end = (run_begin + edges->run_len < cluster_size) ? (run_begin + edges->run_len) : cluster_size;
+		qsort(edges->from_edges[r / edges->num_runs] + run_begin,
+		      run_end - run_begin,
+		      sizeof(iscc_hi_DistanceEdge),
+		      iscc_hi_compare_dist_edges);
+	}
+}
+
+
+static void iscc_hi_merge_edge_runs(const size_t begin,
+                                    const size_t end,
+                                    void* const context)
+{
+	const iscc_hi_EdgeSlices* const edges = context;
+	assert(edges != NULL);
+	const size_t cluster_size = edges->cl->size;
+	const size_t num_merged_runs = (edges->num_runs + 1) / 2;
+	assert(end <= 2 * num_merged_runs);
+
+	for (size_t r = begin; r < end; ++r) {
+		const size_t list = r / num_merged_runs;
+		const size_t run_begin = 1 + (r % num_merged_runs) * 2 * edges->run_len;
+		const size_t run_mid = (run_begin + edges->run_len < cluster_size) ? (run_begin + edges->run_len) : cluster_size;
+		const size_t run_end = (run_mid + edges->run_len < cluster_size) ? (run_mid + edges->run_len) : cluster_size;
+
+		const iscc_hi_DistanceEdge* left = edges->from_edges[list] + run_begin;
+		const iscc_hi_DistanceEdge* const left_stop = edges->from_edges[list] + run_mid;
+		const iscc_hi_DistanceEdge* right = left_stop;
+		const iscc_hi_DistanceEdge* const right_stop = edges->from_edges[list] + run_end;
+		iscc_hi_DistanceEdge* write_edge = edges->to_edges[list] + run_begin;
+
+		// Ties are taken from the left run so that the merge is stable
+		while ((left != left_stop) && (right != right_stop)) {
+			if (right->distance < left->distance) {
+				*write_edge = *right;
+				++right;
+			} else {
+				*write_edge = *left;
+				++left;
+			}
+			++write_edge;
+		}
+		while (left != left_stop) {
+			*write_edge = *left;
+			++left;
+			++write_edge;
+		}
+		while (right != right_stop) {
+			*write_edge = *right;
+			++right;
+			++write_edge;
+		}
+	}
+}
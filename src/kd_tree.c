@@ -0,0 +1,901 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "kd_tree.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "data_set_struct.h"
+#include "error.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+// Nodes with `left == 0` are leaves (the root, node 0, is never a child).
+typedef struct iscc_KDNode {
+	size_t begin;
+	size_t end;
+	size_t left;
+	size_t right;
+} iscc_KDNode;
+
+
+struct iscc_KDTree {
+	size_t num_points;
+	size_t num_dimensions;
+	size_t num_nodes;
+	size_t* positions;
+	double* points;
+	iscc_KDNode* nodes;
+	double* bounds;
+};
+
+
+typedef struct iscc_DualTreeSearch {
+	const iscc_KDTree* query_tree;
+	const iscc_KDTree* search_tree;
+	uint32_t k;
+	double empty_bound;
+	uint32_t* num_found;
+	double* nn_dists;
+	size_t* nn_positions;
+	double* node_bounds;
+} iscc_DualTreeSearch;
+
+
+// Maximum number of points in a leaf.
+static const size_t ISCC_KD_LEAF_POINTS = 16;
+
+// Trees are only built for data sets with at most this many dimensions.
+static const uint_fast16_t ISCC_KD_MAX_DIMENSIONS = 8;
+
+// Trees are only built for search sets with at least this many points.
+static const size_t ISCC_KD_MIN_POINTS = 256;
+
+// Number of queries searched together with one query tree.
+static const size_t ISCC_KD_QUERY_CHUNK = 8192;
+
+// Identifies files written by `iscc_save_kd_tree`, including the format version.
+static const char ISCC_KD_FILE_MAGIC[8] = { 'S', 'C', 'C', 'K', 'D', 'T', '0', '1' };
+
+// Written in native byte order, so files from machines with another byte order are rejected.
+static const uint32_t ISCC_KD_FILE_BYTE_ORDER = 0x01020304;
+
+// Maximum number of points whose coordinates enter the data set fingerprint.
+static const size_t ISCC_KD_FINGERPRINT_POINTS = 4096;
+
+// Number of values written or read with each call to `fwrite` or `fread`.
+static const size_t ISCC_KD_FILE_BUFFER = 4096;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static bool iscc_build_kd_tree(const scc_DataSet* data_set,
+                               size_t len_points,
+                               const scc_PointIndex point_indices[],
+                               size_t first_point,
+                               iscc_KDTree* out_kd_tree);
+
+static void iscc_free_kd_tree_arrays(iscc_KDTree* kd_tree);
+
+static inline double iscc_kd_data_value(const scc_DataSet* data_set,
+                                        size_t point,
+                                        size_t dim);
+
+static void iscc_gather_kd_points(const scc_DataSet* data_set,
+                                  iscc_KDTree* kd_tree);
+
+static bool iscc_check_kd_tree(const iscc_KDTree* kd_tree);
+
+static size_t iscc_count_kd_nodes(size_t len_points);
+
+static size_t iscc_build_kd_node(iscc_KDTree* kd_tree,
+                                 double coordinates[],
+                                 size_t begin,
+                                 size_t end,
+                                 size_t* next_node);
+
+static void iscc_kd_select(size_t positions[],
+                           const double coordinates[],
+                           size_t num_dimensions,
+                           size_t split_dim,
+                           size_t begin,
+                           size_t end,
+                           size_t nth);
+
+static inline double iscc_kd_node_sq_dist(const iscc_KDTree* kd_tree1,
+                                          size_t node1,
+                                          const iscc_KDTree* kd_tree2,
+                                          size_t node2);
+
+static inline bool iscc_kd_precedes(double dist1,
+                                    size_t position1,
+                                    double dist2,
+                                    size_t position2);
+
+static void iscc_dual_tree_recurse(iscc_DualTreeSearch* dt_search,
+                                   size_t query_node,
+                                   size_t search_node,
+                                   double node_sq_dist);
+
+static void iscc_dual_tree_base_case(iscc_DualTreeSearch* dt_search,
+                                     size_t query_node,
+                                     size_t search_node);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_kd_tree_applicable(const scc_DataSet* const data_set,
+                             const size_t len_search_indices)
+{
+	assert(data_set != NULL);
+	return (data_set->gower_weights == NULL) &&
+	       (data_set->binary_matrix == NULL) &&
+	       (data_set->projection_matrix == NULL) &&
+	       (data_set->num_dimensions > 0) &&
+	       (data_set->num_dimensions <= ISCC_KD_MAX_DIMENSIONS) &&
+	       (len_search_indices >= ISCC_KD_MIN_POINTS);
+}
+
+
+bool iscc_init_kd_tree(const scc_DataSet* const data_set,
+                       const size_t len_search_indices,
+                       const scc_PointIndex search_indices[const],
+                       iscc_KDTree** const out_kd_tree)
+{
+	assert(data_set != NULL);
+	assert((data_set->gower_weights == NULL) && (data_set->binary_matrix == NULL));
+	assert(len_search_indices > 0);
+	assert(out_kd_tree != NULL);
+
+	*out_kd_tree = malloc(sizeof(iscc_KDTree));
+	if (*out_kd_tree == NULL) return false;
+
+	if (!iscc_build_kd_tree(data_set, len_search_indices, search_indices, 0, *out_kd_tree)) {
+		free(*out_kd_tree);
+		*out_kd_tree = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+void iscc_free_kd_tree(iscc_KDTree** const kd_tree)
+{
+	if (kd_tree != NULL && *kd_tree != NULL) {
+		iscc_free_kd_tree_arrays(*kd_tree);
+		free(*kd_tree);
+		*kd_tree = NULL;
+	}
+}
+
+
+// FNV-1a hash of the size of the data set and the coordinates of evenly spaced points
+uint64_t iscc_kd_fingerprint(const scc_DataSet* const data_set)
+{
+	const size_t num_points = data_set->num_data_points;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const size_t step = (num_points > ISCC_KD_FINGERPRINT_POINTS) ? (num_points / ISCC_KD_FINGERPRINT_POINTS) : 1;
+
+	uint64_t hash = 14695981039346656037u;
+	uint64_t values[2] = { (uint64_t) num_points, (uint64_t) num_dimensions };
+	for (size_t v = 0; v < 2; ++v) {
+		hash = (hash ^ values[v]) * 1099511628211u;
+	}
+	for (size_t p = 0; p < num_points; p += step) {
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			const double value = iscc_kd_data_value(data_set, p, d);
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(uint64_t));
+			hash = (hash ^ bits) * 1099511628211u;
+		}
+	}
+	return hash;
+}
+
+
+scc_ErrorCode iscc_save_kd_tree(const iscc_KDTree* const kd_tree,
+                                const scc_DataSet* const data_set,
+                                const char* const path)
+{
+	assert(kd_tree != NULL);
+	assert(data_set != NULL);
+	assert(kd_tree->num_points == data_set->num_data_points);
+	assert(path != NULL);
+
+	uint64_t* const buffer = malloc(sizeof(uint64_t[ISCC_KD_FILE_BUFFER]));
+	if (buffer == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	FILE* const file = fopen(path, "wb");
+	if (file == NULL) {
+		free(buffer);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot open search index file for writing.");
+	}
+
+	const uint32_t num_dimensions = (uint32_t) kd_tree->num_dimensions;
+	const uint64_t header[3] = {
+		(uint64_t) kd_tree->num_points,
+		(uint64_t) kd_tree->num_nodes,
+		iscc_kd_fingerprint(data_set),
+	};
+	bool write_ok = (fwrite(ISCC_KD_FILE_MAGIC, 1, 8, file) == 8) &&
+	                (fwrite(&ISCC_KD_FILE_BYTE_ORDER, sizeof(uint32_t), 1, file) == 1) &&
+	                (fwrite(&num_dimensions, sizeof(uint32_t), 1, file) == 1) &&
+	                (fwrite(header, sizeof(uint64_t), 3, file) == 3);
+
+	for (size_t start = 0; write_ok && (start < kd_tree->num_points); start += ISCC_KD_FILE_BUFFER) {
+		const size_t len = ((kd_tree->num_points - start) < ISCC_KD_FILE_BUFFER) ? (kd_tree->num_points - start) : ISCC_KD_FILE_BUFFER;
+		for (size_t i = 0; i < len; ++i) {
+			buffer[i] = (uint64_t) kd_tree->positions[start + i];
+		}
+		write_ok = (fwrite(buffer, sizeof(uint64_t), len, file) == len);
+	}
+
+	for (size_t n = 0; write_ok && (n < kd_tree->num_nodes); ++n) {
+		const uint64_t node[4] = {
+			(uint64_t) kd_tree->nodes[n].begin,
+			(uint64_t) kd_tree->nodes[n].end,
+			(uint64_t) kd_tree->nodes[n].left,
+			(uint64_t) kd_tree->nodes[n].right,
+		};
+		write_ok = (fwrite(node, sizeof(uint64_t), 4, file) == 4);
+	}
+
+	const size_t len_bounds = 2 * kd_tree->num_nodes * kd_tree->num_dimensions;
+	write_ok = write_ok && (fwrite(kd_tree->bounds, sizeof(double), len_bounds, file) == len_bounds);
+
+	free(buffer);
+	if ((fclose(file) != 0) || !write_ok) {
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write search index file.");
+	}
+
+	return iscc_no_error();
+}
+
+
+// The point coordinates are not stored in the file, but gathered from the data set
+scc_ErrorCode iscc_load_kd_tree(const scc_DataSet* const data_set,
+                                const char* const path,
+                                iscc_KDTree** const out_kd_tree)
+{
+	assert(data_set != NULL);
+	assert(path != NULL);
+	assert(out_kd_tree != NULL);
+
+	FILE* const file = fopen(path, "rb");
+	if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot open search index file for reading.");
+
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t num_dimensions;
+	uint64_t header[3];
+	if ((fread(magic, 1, 8, file) != 8) ||
+	        (fread(&byte_order, sizeof(uint32_t), 1, file) != 1) ||
+	        (fread(&num_dimensions, sizeof(uint32_t), 1, file) != 1) ||
+	        (fread(header, sizeof(uint64_t), 3, file) != 3)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot read search index file.");
+	}
+
+	if ((memcmp(magic, ISCC_KD_FILE_MAGIC, 8) != 0) || (byte_order != ISCC_KD_FILE_BYTE_ORDER)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Not a search index file, or written with another version or byte order.");
+	}
+
+	const size_t num_points = data_set->num_data_points;
+	if ((num_dimensions != (uint32_t) data_set->num_dimensions) ||
+	        (header[0] != (uint64_t) num_points) ||
+	        (header[1] == 0) || (header[1] > 2 * (uint64_t) num_points) ||
+	        (header[2] != iscc_kd_fingerprint(data_set))) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Search index does not match the data set.");
+	}
+	const size_t num_nodes = (size_t) header[1];
+
+	iscc_KDTree* const kd_tree = malloc(sizeof(iscc_KDTree));
+	uint64_t* const buffer = malloc(sizeof(uint64_t[ISCC_KD_FILE_BUFFER]));
+	if ((kd_tree == NULL) || (buffer == NULL)) {
+		free(kd_tree);
+		free(buffer);
+		fclose(file);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	*kd_tree = (iscc_KDTree) {
+		.num_points = num_points,
+		.num_dimensions = (size_t) num_dimensions,
+		.num_nodes = num_nodes,
+		.positions = malloc(sizeof(size_t[num_points])),
+		.points = malloc(sizeof(double[num_points * num_dimensions])),
+		.nodes = malloc(sizeof(iscc_KDNode[num_nodes])),
+		.bounds = malloc(sizeof(double[2 * num_nodes * num_dimensions])),
+	};
+	if ((kd_tree->positions == NULL) || (kd_tree->points == NULL) ||
+	        (kd_tree->nodes == NULL) || (kd_tree->bounds == NULL)) {
+		iscc_free_kd_tree_arrays(kd_tree);
+		free(kd_tree);
+		free(buffer);
+		fclose(file);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	bool read_ok = true;
+	for (size_t start = 0; read_ok && (start < num_points); start += ISCC_KD_FILE_BUFFER) {
+		const size_t len = ((num_points - start) < ISCC_KD_FILE_BUFFER) ? (num_points - start) : ISCC_KD_FILE_BUFFER;
+		read_ok = (fread(buffer, sizeof(uint64_t), len, file) == len);
+		for (size_t i = 0; read_ok && (i < len); ++i) {
+			read_ok = (buffer[i] < (uint64_t) num_points);
+			kd_tree->positions[start + i] = (size_t) buffer[i];
+		}
+	}
+
+	for (size_t n = 0; read_ok && (n < num_nodes); ++n) {
+		uint64_t node[4];
+		read_ok = (fread(node, sizeof(uint64_t), 4, file) == 4) &&
+		          (node[0] < node[1]) && (node[1] <= (uint64_t) num_points) &&
+		          (node[2] < (uint64_t) num_nodes) && (node[3] < (uint64_t) num_nodes);
+		kd_tree->nodes[n] = (iscc_KDNode) {
+			.begin = (size_t) node[0],
+			.end = (size_t) node[1],
+			.left = (size_t) node[2],
+			.right = (size_t) node[3],
+		};
+	}
+
+	const size_t len_bounds = 2 * num_nodes * (size_t) num_dimensions;
+	read_ok = read_ok && (fread(kd_tree->bounds, sizeof(double), len_bounds, file) == len_bounds);
+
+	free(buffer);
+	fclose(file);
+
+	if (read_ok) {
+		iscc_gather_kd_points(data_set, kd_tree);
+		read_ok = iscc_check_kd_tree(kd_tree);
+	}
+	if (!read_ok) {
+		iscc_free_kd_tree_arrays(kd_tree);
+		free(kd_tree);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Search index file is corrupt or does not match the data set.");
+	}
+
+	*out_kd_tree = kd_tree;
+
+	return iscc_no_error();
+}
+
+
+// The queries are searched in chunks. Each chunk is indexed by a kd-tree of its own, and the
+// query tree and search tree are traversed together, so queries in the same region of the
+// data share the bounds used to prune the search tree. Ties are broken by the position in
+// the search set, so the neighbors are the same as those found by a linear scan.
+bool iscc_kd_tree_nearest_neighbor_search(const iscc_KDTree* const kd_tree,
+                                          const scc_DataSet* const data_set,
+                                          const scc_PointIndex search_indices[const],
+                                          const size_t len_query_indices,
+                                          const scc_PointIndex query_indices[const],
+                                          const uint32_t k,
+                                          const bool radius_search,
+                                          const double sq_radius,
+                                          size_t* const out_num_ok_queries,
+                                          scc_PointIndex out_query_indices[const],
+                                          scc_PointIndex out_nn_indices[const])
+{
+	assert(kd_tree != NULL);
+	assert(data_set != NULL);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= kd_tree->num_points);
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	const size_t max_chunk = (len_query_indices < ISCC_KD_QUERY_CHUNK) ? len_query_indices : ISCC_KD_QUERY_CHUNK;
+
+	iscc_DualTreeSearch dt_search = {
+		.query_tree = NULL,
+		.search_tree = kd_tree,
+		.k = k,
+		.empty_bound = radius_search ? sq_radius : INFINITY,
+		.num_found = malloc(sizeof(uint32_t[max_chunk])),
+		.nn_dists = malloc(sizeof(double[max_chunk * k])),
+		.nn_positions = malloc(sizeof(size_t[max_chunk * k])),
+		.node_bounds = malloc(sizeof(double[iscc_count_kd_nodes(max_chunk)])),
+	};
+	if ((dt_search.num_found == NULL) || (dt_search.nn_dists == NULL) ||
+	        (dt_search.nn_positions == NULL) || (dt_search.node_bounds == NULL)) {
+		free(dt_search.num_found);
+		free(dt_search.nn_dists);
+		free(dt_search.nn_positions);
+		free(dt_search.node_bounds);
+		return false;
+	}
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t chunk_start = 0; chunk_start < len_query_indices; chunk_start += max_chunk) {
+		const size_t len_chunk = ((len_query_indices - chunk_start) < max_chunk) ? (len_query_indices - chunk_start) : max_chunk;
+		const scc_PointIndex* const chunk_indices = (query_indices == NULL) ? NULL : (query_indices + chunk_start);
+
+		iscc_KDTree query_tree;
+		if (!iscc_build_kd_tree(data_set, len_chunk, chunk_indices, chunk_start, &query_tree)) {
+			free(dt_search.num_found);
+			free(dt_search.nn_dists);
+			free(dt_search.nn_positions);
+			free(dt_search.node_bounds);
+			return false;
+		}
+		dt_search.query_tree = &query_tree;
+
+		for (size_t q = 0; q < len_chunk; ++q) {
+			dt_search.num_found[q] = 0;
+		}
+		for (size_t n = 0; n < query_tree.num_nodes; ++n) {
+			dt_search.node_bounds[n] = dt_search.empty_bound;
+		}
+
+		iscc_dual_tree_recurse(&dt_search, 0, 0, iscc_kd_node_sq_dist(&query_tree, 0, kd_tree, 0));
+
+		for (size_t q = 0; q < len_chunk; ++q) {
+			assert(dt_search.num_found[q] == k || out_query_indices != NULL);
+			if (dt_search.num_found[q] == k) {
+				const size_t* const nn_positions = dt_search.nn_positions + q * k;
+				for (uint32_t i = 0; i < k; ++i) {
+					index_write[i] = (search_indices == NULL) ? ((scc_PointIndex) nn_positions[i]) : search_indices[nn_positions[i]];
+				}
+				if (out_query_indices != NULL) {
+					out_query_indices[num_ok_queries] = (chunk_indices == NULL) ? ((scc_PointIndex) (chunk_start + q)) : chunk_indices[q];
+				}
+				++num_ok_queries;
+				index_write += k;
+			}
+		}
+
+		iscc_free_kd_tree_arrays(&query_tree);
+	}
+
+	*out_num_ok_queries = num_ok_queries;
+
+	free(dt_search.num_found);
+	free(dt_search.nn_dists);
+	free(dt_search.nn_positions);
+	free(dt_search.node_bounds);
+
+	return true;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+// Indexes `point_indices[0], ..., point_indices[len_points - 1]`, or, if `point_indices`
+// is NULL, `first_point, ..., first_point + len_points - 1`. `positions` refer to the
+// order of the points in this list.
+static bool iscc_build_kd_tree(const scc_DataSet* const data_set,
+                               const size_t len_points,
+                               const scc_PointIndex point_indices[const],
+                               const size_t first_point,
+                               iscc_KDTree* const out_kd_tree)
+{
+	assert(data_set != NULL);
+	assert(len_points > 0);
+	assert(out_kd_tree != NULL);
+
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const size_t num_nodes = iscc_count_kd_nodes(len_points);
+
+	*out_kd_tree = (iscc_KDTree) {
+		.num_points = len_points,
+		.num_dimensions = num_dimensions,
+		.num_nodes = num_nodes,
+		.positions = malloc(sizeof(size_t[len_points])),
+		.points = malloc(sizeof(double[len_points * num_dimensions])),
+		.nodes = malloc(sizeof(iscc_KDNode[num_nodes])),
+		.bounds = malloc(sizeof(double[2 * num_nodes * num_dimensions])),
+	};
+	double* const coordinates = malloc(sizeof(double[len_points * num_dimensions]));
+	if ((out_kd_tree->positions == NULL) || (out_kd_tree->points == NULL) ||
+	        (out_kd_tree->nodes == NULL) || (out_kd_tree->bounds == NULL) || (coordinates == NULL)) {
+		iscc_free_kd_tree_arrays(out_kd_tree);
+		free(coordinates);
+		return false;
+	}
+
+	for (size_t p = 0; p < len_points; ++p) {
+		const size_t point = (point_indices == NULL) ? (first_point + p) : (size_t) point_indices[p];
+		assert(point < data_set->num_data_points);
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			coordinates[p * num_dimensions + d] = iscc_kd_data_value(data_set, point, d);
+		}
+		out_kd_tree->positions[p] = p;
+	}
+
+	size_t next_node = 0;
+	iscc_build_kd_node(out_kd_tree, coordinates, 0, len_points, &next_node);
+	assert(next_node == num_nodes);
+
+	// Store the coordinates in tree order, so leaves are contiguous
+	for (size_t i = 0; i < len_points; ++i) {
+		const double* const from = coordinates + out_kd_tree->positions[i] * num_dimensions;
+		double* const to = out_kd_tree->points + i * num_dimensions;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			to[d] = from[d];
+		}
+	}
+
+	free(coordinates);
+
+	return true;
+}
+
+
+static void iscc_free_kd_tree_arrays(iscc_KDTree* const kd_tree)
+{
+	assert(kd_tree != NULL);
+	free(kd_tree->positions);
+	free(kd_tree->points);
+	free(kd_tree->nodes);
+	free(kd_tree->bounds);
+}
+
+
+static inline double iscc_kd_data_value(const scc_DataSet* const data_set,
+                                        const size_t point,
+                                        const size_t dim)
+{
+	assert(point < data_set->num_data_points);
+	assert(dim < data_set->num_dimensions);
+	return iscc_get_column_data(data_set, dim)[point * data_set->row_stride];
+}
+
+
+// Copies the coordinates of the points, in tree order, for a tree indexing all points in the data set
+static void iscc_gather_kd_points(const scc_DataSet* const data_set,
+                                  iscc_KDTree* const kd_tree)
+{
+	assert(kd_tree->num_points == data_set->num_data_points);
+	const size_t num_dimensions = kd_tree->num_dimensions;
+	for (size_t i = 0; i < kd_tree->num_points; ++i) {
+		double* const to = kd_tree->points + i * num_dimensions;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			to[d] = iscc_kd_data_value(data_set, kd_tree->positions[i], d);
+		}
+	}
+}
+
+
+// Checks that the nodes form a tree over all points, and that the box of each node contains
+// the points and child boxes of the node. Searches with such a tree are exact, whatever the
+// file it was read from. Comparisons are written so that NaN bounds fail.
+static bool iscc_check_kd_tree(const iscc_KDTree* const kd_tree)
+{
+	const size_t num_points = kd_tree->num_points;
+	const size_t num_dimensions = kd_tree->num_dimensions;
+
+	bool* const seen = calloc(num_points, sizeof(bool));
+	if (seen == NULL) return false;
+	bool tree_ok = true;
+	for (size_t i = 0; tree_ok && (i < num_points); ++i) {
+		tree_ok = !seen[kd_tree->positions[i]];
+		seen[kd_tree->positions[i]] = true;
+	}
+	free(seen);
+
+	tree_ok = tree_ok && (kd_tree->nodes[0].begin == 0) && (kd_tree->nodes[0].end == num_points);
+
+	for (size_t n = 0; tree_ok && (n < kd_tree->num_nodes); ++n) {
+		const iscc_KDNode* const node = &kd_tree->nodes[n];
+		const double* const lower = kd_tree->bounds + 2 * n * num_dimensions;
+		const double* const upper = lower + num_dimensions;
+		if (node->left == 0) {
+			tree_ok = (node->right == 0);
+			for (size_t i = node->begin; tree_ok && (i < node->end); ++i) {
+				const double* const point = kd_tree->points + i * num_dimensions;
+				for (size_t d = 0; d < num_dimensions; ++d) {
+					tree_ok = tree_ok && (lower[d] <= point[d]) && (point[d] <= upper[d]);
+				}
+			}
+		} else {
+			const iscc_KDNode* const left = &kd_tree->nodes[node->left];
+			const iscc_KDNode* const right = &kd_tree->nodes[node->right];
+			// Children come after their parent, so the nodes cannot form cycles
+			tree_ok = (node->left > n) && (node->right > n) &&
+			          (left->begin == node->begin) && (left->end == right->begin) && (right->end == node->end);
+			for (size_t c = 0; tree_ok && (c < 2); ++c) {
+				const double* const child_lower = kd_tree->bounds + 2 * ((c == 0) ? node->left : node->right) * num_dimensions;
+				const double* const child_upper = child_lower + num_dimensions;
+				for (size_t d = 0; d < num_dimensions; ++d) {
+					tree_ok = tree_ok && (lower[d] <= child_lower[d]) && (child_upper[d] <= upper[d]);
+				}
+			}
+		}
+	}
+
+	return tree_ok;
+}
+
+
+static size_t iscc_count_kd_nodes(const size_t len_points)
+{
+	if (len_points <= ISCC_KD_LEAF_POINTS) return 1;
+	return 1 + iscc_count_kd_nodes(len_points / 2) + iscc_count_kd_nodes(len_points - len_points / 2);
+}
+
+
+// Nodes are split at the median of the dimension with the widest spread
+static size_t iscc_build_kd_node(iscc_KDTree* const kd_tree,
+                                 double coordinates[const],
+                                 const size_t begin,
+                                 const size_t end,
+                                 size_t* const next_node)
+{
+	assert(begin < end);
+	const size_t num_dimensions = kd_tree->num_dimensions;
+	const size_t node = (*next_node)++;
+	assert(node < kd_tree->num_nodes);
+
+	double* const lower = kd_tree->bounds + 2 * node * num_dimensions;
+	double* const upper = lower + num_dimensions;
+	const double* const first = coordinates + kd_tree->positions[begin] * num_dimensions;
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		lower[d] = upper[d] = first[d];
+	}
+	for (size_t i = begin + 1; i < end; ++i) {
+		const double* const point = coordinates + kd_tree->positions[i] * num_dimensions;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			if (point[d] < lower[d]) lower[d] = point[d];
+			if (point[d] > upper[d]) upper[d] = point[d];
+		}
+	}
+
+	kd_tree->nodes[node] = (iscc_KDNode) {
+		.begin = begin,
+		.end = end,
+		.left = 0,
+		.right = 0,
+	};
+
+	if (end - begin <= ISCC_KD_LEAF_POINTS) return node;
+
+	size_t split_dim = 0;
+	for (size_t d = 1; d < num_dimensions; ++d) {
+		if (upper[d] - lower[d] > upper[split_dim] - lower[split_dim]) split_dim = d;
+	}
+
+	const size_t mid = begin + (end - begin) / 2;
+	iscc_kd_select(kd_tree->positions, coordinates, num_dimensions, split_dim, begin, end, mid);
+	const size_t left = iscc_build_kd_node(kd_tree, coordinates, begin, mid, next_node);
+	const size_t right = iscc_build_kd_node(kd_tree, coordinates, mid, end, next_node);
+	kd_tree->nodes[node].left = left;
+	kd_tree->nodes[node].right = right;
+
+	return node;
+}
+
+
+// Hoare selection: afterwards, no point in `[begin, nth)` lies above, and no point in
+// `[nth, end)` below, the point at `nth` in `split_dim`
+static void iscc_kd_select(size_t positions[const],
+                           const double coordinates[const],
+                           const size_t num_dimensions,
+                           const size_t split_dim,
+                           size_t begin,
+                           size_t end,
+                           const size_t nth)
+{
+	assert(begin <= nth);
+	assert(nth < end);
+
+	while (end - begin > 1) {
+		const double pivot = coordinates[positions[begin + (end - begin) / 2] * num_dimensions + split_dim];
+		size_t i = begin;
+		size_t j = end - 1;
+		while (true) {
+			while (coordinates[positions[i] * num_dimensions + split_dim] < pivot) ++i;
+			while (coordinates[positions[j] * num_dimensions + split_dim] > pivot) --j;
+			if (i >= j) break;
+			const size_t tmp = positions[i];
+			positions[i] = positions[j];
+			positions[j] = tmp;
+			++i;
+			--j;
+		}
+
+		if (i == j) {
+			// `positions[i]` equals the pivot and is in its final place
+			if (nth == i) return;
+			if (nth < i) {
+				end = i;
+			} else {
+				begin = i + 1;
+			}
+		} else if (nth <= j) {
+			end = j + 1;
+		} else {
+			begin = j + 1;
+		}
+	}
+}
+
+
+// Lower bound of the squared distances between the points in the two nodes. Each term is
+// at most the corresponding term in the distance calculation (rounding is monotone), so
+// the bound never exceeds a computed distance.
+static inline double iscc_kd_node_sq_dist(const iscc_KDTree* const kd_tree1,
+                                          const size_t node1,
+                                          const iscc_KDTree* const kd_tree2,
+                                          const size_t node2)
+{
+	assert(kd_tree1->num_dimensions == kd_tree2->num_dimensions);
+	const size_t num_dimensions = kd_tree1->num_dimensions;
+	const double* const lower1 = kd_tree1->bounds + 2 * node1 * num_dimensions;
+	const double* const upper1 = lower1 + num_dimensions;
+	const double* const lower2 = kd_tree2->bounds + 2 * node2 * num_dimensions;
+	const double* const upper2 = lower2 + num_dimensions;
+
+	double tmp_dist = 0.0;
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		double gap = 0.0;
+		if (lower2[d] > upper1[d]) {
+			gap = lower2[d] - upper1[d];
+		} else if (lower1[d] > upper2[d]) {
+			gap = lower1[d] - upper2[d];
+		}
+		tmp_dist += gap * gap;
+	}
+	return tmp_dist;
+}
+
+
+// Whether (dist1, position1) comes before (dist2, position2) in lexical order
+static inline bool iscc_kd_precedes(const double dist1,
+                                    const size_t position1,
+                                    const double dist2,
+                                    const size_t position2)
+{
+	return (dist1 < dist2) || (!(dist2 < dist1) && (position1 < position2));
+}
+
+
+static void iscc_dual_tree_recurse(iscc_DualTreeSearch* const dt_search,
+                                   const size_t query_node,
+                                   const size_t search_node,
+                                   const double node_sq_dist)
+{
+	// No query in the node would accept any point in the search node
+	if (node_sq_dist > dt_search->node_bounds[query_node]) return;
+
+	const iscc_KDTree* const query_tree = dt_search->query_tree;
+	const iscc_KDTree* const search_tree = dt_search->search_tree;
+	const iscc_KDNode* const q_node = &query_tree->nodes[query_node];
+	const iscc_KDNode* const s_node = &search_tree->nodes[search_node];
+	const bool query_leaf = (q_node->left == 0);
+	const bool search_leaf = (s_node->left == 0);
+
+	if (query_leaf && search_leaf) {
+		iscc_dual_tree_base_case(dt_search, query_node, search_node);
+
+	} else if (query_leaf || (!search_leaf && (s_node->end - s_node->begin >= q_node->end - q_node->begin))) {
+		// Split the search node, and visit the closer child first
+		const double left_sq_dist = iscc_kd_node_sq_dist(query_tree, query_node, search_tree, s_node->left);
+		const double right_sq_dist = iscc_kd_node_sq_dist(query_tree, query_node, search_tree, s_node->right);
+		if (left_sq_dist <= right_sq_dist) {
+			iscc_dual_tree_recurse(dt_search, query_node, s_node->left, left_sq_dist);
+			iscc_dual_tree_recurse(dt_search, query_node, s_node->right, right_sq_dist);
+		} else {
+			iscc_dual_tree_recurse(dt_search, query_node, s_node->right, right_sq_dist);
+			iscc_dual_tree_recurse(dt_search, query_node, s_node->left, left_sq_dist);
+		}
+
+	} else {
+		// Split the query node, and tighten its bound with the children's bounds
+		iscc_dual_tree_recurse(dt_search, q_node->left, search_node,
+		                       iscc_kd_node_sq_dist(query_tree, q_node->left, search_tree, search_node));
+		iscc_dual_tree_recurse(dt_search, q_node->right, search_node,
+		                       iscc_kd_node_sq_dist(query_tree, q_node->right, search_tree, search_node));
+		const double left_bound = dt_search->node_bounds[q_node->left];
+		const double right_bound = dt_search->node_bounds[q_node->right];
+		dt_search->node_bounds[query_node] = (left_bound > right_bound) ? left_bound : right_bound;
+	}
+}
+
+
+// Distances are summed in the same order as in `iscc_get_sq_dist`, so they are identical
+static void iscc_dual_tree_base_case(iscc_DualTreeSearch* const dt_search,
+                                     const size_t query_node,
+                                     const size_t search_node)
+{
+	const iscc_KDTree* const query_tree = dt_search->query_tree;
+	const iscc_KDTree* const search_tree = dt_search->search_tree;
+	const size_t num_dimensions = query_tree->num_dimensions;
+	const iscc_KDNode* const q_node = &query_tree->nodes[query_node];
+	const iscc_KDNode* const s_node = &search_tree->nodes[search_node];
+	const double* const s_lower = search_tree->bounds + 2 * search_node * num_dimensions;
+	const double* const s_upper = s_lower + num_dimensions;
+	const uint32_t k = dt_search->k;
+
+	double node_bound = 0.0;
+	for (size_t qi = q_node->begin; qi < q_node->end; ++qi) {
+		const size_t q = query_tree->positions[qi];
+		const double* const query_point = query_tree->points + qi * num_dimensions;
+		uint32_t* const found = &dt_search->num_found[q];
+		double* const nn_dists = dt_search->nn_dists + q * k;
+		size_t* const nn_positions = dt_search->nn_positions + q * k;
+		double bound = (*found == k) ? nn_dists[k - 1] : dt_search->empty_bound;
+
+		// Distance from the query to the box of the search node
+		double box_sq_dist = 0.0;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			double gap = 0.0;
+			if (s_lower[d] > query_point[d]) {
+				gap = s_lower[d] - query_point[d];
+			} else if (query_point[d] > s_upper[d]) {
+				gap = query_point[d] - s_upper[d];
+			}
+			box_sq_dist += gap * gap;
+		}
+
+		if (box_sq_dist <= bound) {
+			for (size_t si = s_node->begin; si < s_node->end; ++si) {
+				const double* const search_point = search_tree->points + si * num_dimensions;
+				double tmp_dist = 0.0;
+				for (size_t d = 0; d < num_dimensions; ++d) {
+					const double value_diff = (query_point[d] - search_point[d]);
+					tmp_dist += value_diff * value_diff;
+				}
+				if (tmp_dist > bound) continue;
+
+				const size_t position = search_tree->positions[si];
+				size_t slot;
+				if (*found < k) {
+					slot = (*found)++;
+				} else {
+					if (!iscc_kd_precedes(tmp_dist, position, nn_dists[k - 1], nn_positions[k - 1])) continue;
+					slot = k - 1;
+				}
+				for (; (slot > 0) && iscc_kd_precedes(tmp_dist, position, nn_dists[slot - 1], nn_positions[slot - 1]); --slot) {
+					nn_dists[slot] = nn_dists[slot - 1];
+					nn_positions[slot] = nn_positions[slot - 1];
+				}
+				nn_dists[slot] = tmp_dist;
+				nn_positions[slot] = position;
+				if (*found == k) bound = nn_dists[k - 1];
+			}
+		}
+
+		if (bound > node_bound) node_bound = bound;
+	}
+
+	dt_search->node_bounds[query_node] = node_bound;
+}
@@ -0,0 +1,84 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_KD_TREE_HG
+#define SCC_KD_TREE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Structs
+// =============================================================================
+
+typedef struct iscc_KDTree iscc_KDTree;
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+bool iscc_kd_tree_applicable(const scc_DataSet* data_set,
+                             size_t len_search_indices);
+
+
+bool iscc_init_kd_tree(const scc_DataSet* data_set,
+                       size_t len_search_indices,
+                       const scc_PointIndex search_indices[],
+                       iscc_KDTree** out_kd_tree);
+
+
+void iscc_free_kd_tree(iscc_KDTree** kd_tree);
+
+
+// Hash of sampled coordinates, identifying the data of saved trees and checkpoints
+uint64_t iscc_kd_fingerprint(const scc_DataSet* data_set);
+
+
+// Writes a tree indexing all points in `data_set`, so it can be loaded with `iscc_load_kd_tree`
+scc_ErrorCode iscc_save_kd_tree(const iscc_KDTree* kd_tree,
+                                const scc_DataSet* data_set,
+                                const char* path);
+
+
+// The loaded tree is checked against `data_set`: every point must lie in the boxes of its nodes
+scc_ErrorCode iscc_load_kd_tree(const scc_DataSet* data_set,
+                                const char* path,
+                                iscc_KDTree** out_kd_tree);
+
+
+// `sq_radius` is the squared radius on the scale of the data matrix (see `iscc_to_embedded_dist`)
+bool iscc_kd_tree_nearest_neighbor_search(const iscc_KDTree* kd_tree,
+                                          const scc_DataSet* data_set,
+                                          const scc_PointIndex search_indices[],
+                                          size_t len_query_indices,
+                                          const scc_PointIndex query_indices[],
+                                          uint32_t k,
+                                          bool radius_search,
+                                          double sq_radius,
+                                          size_t* out_num_ok_queries,
+                                          scc_PointIndex out_query_indices[],
+                                          scc_PointIndex out_nn_indices[]);
+
+
+#endif // ifndef SCC_KD_TREE_HG
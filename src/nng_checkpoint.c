@@ -0,0 +1,585 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "nng_checkpoint.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "clustering_struct.h"
+#include "digraph_core.h"
+#include "dist_search.h"
+#include "error.h"
+#include "kd_tree.h"
+#include "nng_core.h"
+#include "nng_findseeds.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// Identifies checkpoint files, including the format version.
+static const char ISCC_CHECKPOINT_MAGIC[8] = { 'S', 'C', 'C', 'C', 'H', 'K', '0', '2' };
+
+// Written in native byte order, so files from machines with another byte order are rejected.
+static const uint32_t ISCC_CHECKPOINT_BYTE_ORDER = 0x01020304;
+
+// Phases, written in the file headers.
+static const uint32_t ISCC_CHECKPOINT_NNG = 1;
+static const uint32_t ISCC_CHECKPOINT_SEEDS = 2;
+static const uint32_t ISCC_CHECKPOINT_ASSIGN = 3;
+
+// File names in the checkpoint directory.
+static const char* const ISCC_CHECKPOINT_FILES[4] = { NULL, "nng.scc", "seeds.scc", "assign.scc" };
+
+// Number of evenly spaced points whose distances enter the data fingerprint.
+static const size_t ISCC_CHECKPOINT_PROBE_QUERIES = 4;
+
+// Number of evenly spaced points the distances of the probe queries are calculated to.
+static const size_t ISCC_CHECKPOINT_PROBE_COLUMNS = 64;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static char* iscc_checkpoint_path(const iscc_Checkpoint* checkpoint,
+                                  uint32_t phase,
+                                  bool temporary);
+
+static FILE* iscc_begin_checkpoint(const iscc_Checkpoint* checkpoint,
+                                   uint32_t phase);
+
+static scc_ErrorCode iscc_finish_checkpoint(const iscc_Checkpoint* checkpoint,
+                                            uint32_t phase,
+                                            FILE* file,
+                                            bool write_ok);
+
+static scc_ErrorCode iscc_open_checkpoint(const iscc_Checkpoint* checkpoint,
+                                          uint32_t phase,
+                                          FILE** out_file);
+
+static inline bool iscc_write_value(FILE* file,
+                                    uint64_t value);
+
+static inline bool iscc_read_value(FILE* file,
+                                   uint64_t* out_value);
+
+static inline uint64_t iscc_hash_value(uint64_t hash,
+                                       uint64_t value);
+
+static inline uint64_t iscc_hash_double(uint64_t hash,
+                                        double value);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+// FNV-1a hash of the options that affect the clustering, including the contents of arrays
+uint64_t iscc_checkpoint_key(const scc_ClusterOptions* const options,
+                             const size_t num_data_points)
+{
+	assert(options != NULL);
+
+	uint64_t hash = 14695981039346656037u;
+	hash = iscc_hash_value(hash, (uint64_t) num_data_points);
+	hash = iscc_hash_value(hash, (uint64_t) options->size_constraint);
+	hash = iscc_hash_value(hash, (uint64_t) options->num_types);
+	for (size_t i = 0; (options->type_constraints != NULL) && (i < options->num_types); ++i) {
+		hash = iscc_hash_value(hash, (uint64_t) options->type_constraints[i]);
+	}
+	hash = iscc_hash_value(hash, (uint64_t) options->len_type_labels);
+	for (size_t i = 0; (options->type_labels != NULL) && (i < options->len_type_labels); ++i) {
+		hash = iscc_hash_value(hash, (uint64_t) options->type_labels[i]);
+	}
+	hash = iscc_hash_value(hash, (uint64_t) options->seed_method);
+	hash = iscc_hash_value(hash, (uint64_t) options->len_primary_data_points);
+	for (size_t i = 0; (options->primary_data_points != NULL) && (i < options->len_primary_data_points); ++i) {
+		hash = iscc_hash_value(hash, (uint64_t) options->primary_data_points[i]);
+	}
+	hash = iscc_hash_value(hash, (uint64_t) options->primary_unassigned_method);
+	hash = iscc_hash_value(hash, (uint64_t) options->secondary_unassigned_method);
+	hash = iscc_hash_value(hash, (uint64_t) options->seed_radius);
+	hash = iscc_hash_double(hash, options->seed_supplied_radius);
+	hash = iscc_hash_value(hash, (uint64_t) options->primary_radius);
+	hash = iscc_hash_double(hash, options->primary_supplied_radius);
+	hash = iscc_hash_value(hash, (uint64_t) options->secondary_radius);
+	hash = iscc_hash_double(hash, options->secondary_supplied_radius);
+	return hash;
+}
+
+
+// Distances are used for all data sets, so that data behind the SPI is covered. They
+// depend only on the data, as the same points are used whatever the options.
+scc_ErrorCode iscc_checkpoint_fingerprint(void* const data_set,
+                                          const size_t num_data_points,
+                                          uint64_t* const out_fingerprint)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(num_data_points > 0);
+	assert(out_fingerprint != NULL);
+
+	const size_t num_queries = (num_data_points < ISCC_CHECKPOINT_PROBE_QUERIES) ? num_data_points : ISCC_CHECKPOINT_PROBE_QUERIES;
+	const size_t num_columns = (num_data_points < ISCC_CHECKPOINT_PROBE_COLUMNS) ? num_data_points : ISCC_CHECKPOINT_PROBE_COLUMNS;
+	scc_PointIndex* const probe_points = malloc(sizeof(scc_PointIndex[num_queries + num_columns]));
+	double* const probe_dists = malloc(sizeof(double[num_queries * num_columns]));
+	if ((probe_points == NULL) || (probe_dists == NULL)) {
+		free(probe_points);
+		free(probe_dists);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_PointIndex* const query_indices = probe_points;
+	scc_PointIndex* const column_indices = probe_points + num_queries;
+	for (size_t q = 0; q < num_queries; ++q) {
+		query_indices[q] = (scc_PointIndex) ((q * num_data_points) / num_queries);
+	}
+	for (size_t c = 0; c < num_columns; ++c) {
+		column_indices[c] = (scc_PointIndex) ((c * num_data_points) / num_columns);
+	}
+
+	if (!iscc_get_dist_rows(data_set, num_queries, query_indices, num_columns, column_indices, probe_dists)) {
+		free(probe_points);
+		free(probe_dists);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	// Data sets of the built-in distance functions are `scc_DataSet`
+	uint64_t hash = 14695981039346656037u;
+	if (iscc_dist_functions.check_data_set == iscc_imp_check_data_set) {
+		hash = iscc_hash_value(hash, iscc_kd_fingerprint(data_set));
+	}
+	hash = iscc_hash_value(hash, (uint64_t) num_data_points);
+	for (size_t i = 0; i < num_queries * num_columns; ++i) {
+		hash = iscc_hash_double(hash, probe_dists[i]);
+	}
+
+	free(probe_points);
+	free(probe_dists);
+
+	*out_fingerprint = hash;
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_save_nng_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                       const iscc_Digraph* const nng)
+{
+	assert(checkpoint != NULL);
+	assert(iscc_digraph_is_valid(nng));
+	assert(nng->vertices == checkpoint->num_data_points);
+
+	FILE* const file = iscc_begin_checkpoint(checkpoint, ISCC_CHECKPOINT_NNG);
+	if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write checkpoint.");
+
+	const size_t num_arcs = nng->tail_ptr[nng->vertices];
+	bool write_ok = iscc_write_value(file, (uint64_t) num_arcs);
+	for (size_t v = 0; write_ok && (v <= nng->vertices); ++v) {
+		write_ok = iscc_write_value(file, (uint64_t) nng->tail_ptr[v]);
+	}
+	for (size_t a = 0; write_ok && (a < num_arcs); ++a) {
+		write_ok = iscc_write_value(file, (uint64_t) nng->head[a]);
+	}
+
+	return iscc_finish_checkpoint(checkpoint, ISCC_CHECKPOINT_NNG, file, write_ok);
+}
+
+
+scc_ErrorCode iscc_load_nng_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                       bool* const out_found,
+                                       iscc_Digraph* const out_nng)
+{
+	assert(checkpoint != NULL);
+	assert(out_found != NULL);
+	assert(out_nng != NULL);
+
+	*out_found = false;
+	FILE* file;
+	scc_ErrorCode ec;
+	if ((ec = iscc_open_checkpoint(checkpoint, ISCC_CHECKPOINT_NNG, &file)) != SCC_ER_OK) return ec;
+	if (file == NULL) return iscc_no_error();
+
+	uint64_t num_arcs;
+	if (!iscc_read_value(file, &num_arcs) || (num_arcs > ISCC_ARCINDEX_MAX)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	if ((ec = iscc_init_digraph(checkpoint->num_data_points, num_arcs, out_nng)) != SCC_ER_OK) {
+		fclose(file);
+		return ec;
+	}
+
+	uint64_t value = 0;
+	bool read_ok = true;
+	for (size_t v = 0; read_ok && (v <= checkpoint->num_data_points); ++v) {
+		const uint64_t prev_value = value;
+		read_ok = iscc_read_value(file, &value) &&
+		          (value <= num_arcs) && (value >= prev_value) && ((v > 0) || (value == 0));
+		out_nng->tail_ptr[v] = (iscc_ArcIndex) value;
+	}
+	read_ok = read_ok && (value == num_arcs);
+	for (size_t a = 0; read_ok && (a < num_arcs); ++a) {
+		read_ok = iscc_read_value(file, &value) && (value < (uint64_t) checkpoint->num_data_points);
+		out_nng->head[a] = (scc_PointIndex) value;
+	}
+	fclose(file);
+
+	if (!read_ok) {
+		iscc_free_digraph(out_nng);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	*out_found = true;
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_save_seeds_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                         const iscc_SeedResult* const seed_result)
+{
+	assert(checkpoint != NULL);
+	assert(seed_result != NULL);
+	assert(seed_result->count > 0);
+
+	FILE* const file = iscc_begin_checkpoint(checkpoint, ISCC_CHECKPOINT_SEEDS);
+	if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write checkpoint.");
+
+	bool write_ok = iscc_write_value(file, (uint64_t) seed_result->count);
+	for (size_t s = 0; write_ok && (s < seed_result->count); ++s) {
+		write_ok = iscc_write_value(file, (uint64_t) seed_result->seeds[s]);
+	}
+
+	return iscc_finish_checkpoint(checkpoint, ISCC_CHECKPOINT_SEEDS, file, write_ok);
+}
+
+
+scc_ErrorCode iscc_load_seeds_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                         bool* const out_found,
+                                         iscc_SeedResult* const out_seed_result)
+{
+	assert(checkpoint != NULL);
+	assert(out_found != NULL);
+	assert(out_seed_result != NULL);
+
+	*out_found = false;
+	FILE* file;
+	scc_ErrorCode ec;
+	if ((ec = iscc_open_checkpoint(checkpoint, ISCC_CHECKPOINT_SEEDS, &file)) != SCC_ER_OK) return ec;
+	if (file == NULL) return iscc_no_error();
+
+	uint64_t count;
+	if (!iscc_read_value(file, &count) || (count == 0) || (count > (uint64_t) checkpoint->num_data_points)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	scc_PointIndex* const seeds = malloc(sizeof(scc_PointIndex[count]));
+	if (seeds == NULL) {
+		fclose(file);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	bool read_ok = true;
+	for (size_t s = 0; read_ok && (s < count); ++s) {
+		uint64_t value;
+		read_ok = iscc_read_value(file, &value) && (value < (uint64_t) checkpoint->num_data_points);
+		seeds[s] = (scc_PointIndex) value;
+	}
+	fclose(file);
+
+	if (!read_ok) {
+		free(seeds);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	*out_seed_result = (iscc_SeedResult) {
+		.capacity = (size_t) count,
+		.count = (size_t) count,
+		.seeds = seeds,
+	};
+	*out_found = true;
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_save_assign_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                          const scc_Clustering* const clustering,
+                                          const iscc_NNGAssignState* const assign_state,
+                                          const bool secondary_radius_constraint,
+                                          const double secondary_radius)
+{
+	assert(checkpoint != NULL);
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_data_points == checkpoint->num_data_points);
+	assert(assign_state != NULL);
+
+	FILE* const file = iscc_begin_checkpoint(checkpoint, ISCC_CHECKPOINT_ASSIGN);
+	if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write checkpoint.");
+
+	uint64_t radius_bits;
+	memcpy(&radius_bits, &secondary_radius, sizeof(uint64_t));
+	bool write_ok = iscc_write_value(file, (uint64_t) clustering->num_clusters) &&
+	                iscc_write_value(file, (uint64_t) secondary_radius_constraint) &&
+	                iscc_write_value(file, radius_bits);
+	for (size_t i = 0; write_ok && (i < clustering->num_data_points); ++i) {
+		const scc_Clabel label = clustering->cluster_label[i];
+		write_ok = iscc_write_value(file, (label == SCC_CLABEL_NA) ? UINT64_MAX : (uint64_t) label);
+	}
+	write_ok = write_ok && iscc_write_value(file, (uint64_t) assign_state->num_seed_or_neighbor);
+	for (size_t i = 0; write_ok && (i < assign_state->num_seed_or_neighbor); ++i) {
+		write_ok = iscc_write_value(file, (uint64_t) assign_state->seed_or_neighbor[i]);
+	}
+
+	return iscc_finish_checkpoint(checkpoint, ISCC_CHECKPOINT_ASSIGN, file, write_ok);
+}
+
+
+scc_ErrorCode iscc_load_assign_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                          bool* const out_found,
+                                          scc_Clustering* const clustering,
+                                          iscc_NNGAssignState* const out_assign_state,
+                                          bool* const out_secondary_radius_constraint,
+                                          double* const out_secondary_radius)
+{
+	assert(checkpoint != NULL);
+	assert(out_found != NULL);
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->cluster_label != NULL);
+	assert(clustering->num_data_points == checkpoint->num_data_points);
+	assert(out_assign_state != NULL);
+	assert(out_secondary_radius_constraint != NULL);
+	assert(out_secondary_radius != NULL);
+
+	*out_found = false;
+	FILE* file;
+	scc_ErrorCode ec;
+	if ((ec = iscc_open_checkpoint(checkpoint, ISCC_CHECKPOINT_ASSIGN, &file)) != SCC_ER_OK) return ec;
+	if (file == NULL) return iscc_no_error();
+
+	uint64_t num_clusters;
+	uint64_t radius_constraint;
+	uint64_t radius_bits;
+	bool read_ok = iscc_read_value(file, &num_clusters) &&
+	               iscc_read_value(file, &radius_constraint) &&
+	               iscc_read_value(file, &radius_bits) &&
+	               (num_clusters > 0) && (num_clusters <= (uint64_t) SCC_CLABEL_MAX) && (radius_constraint <= 1);
+	for (size_t i = 0; read_ok && (i < clustering->num_data_points); ++i) {
+		uint64_t value;
+		read_ok = iscc_read_value(file, &value) && ((value == UINT64_MAX) || (value < num_clusters));
+		clustering->cluster_label[i] = (value == UINT64_MAX) ? SCC_CLABEL_NA : (scc_Clabel) value;
+	}
+
+	uint64_t num_seed_or_neighbor = 0;
+	read_ok = read_ok && iscc_read_value(file, &num_seed_or_neighbor) &&
+	          (num_seed_or_neighbor <= (uint64_t) clustering->num_data_points);
+	scc_PointIndex* seed_or_neighbor = NULL;
+	if (read_ok && (num_seed_or_neighbor > 0)) {
+		seed_or_neighbor = malloc(sizeof(scc_PointIndex[num_seed_or_neighbor]));
+		if (seed_or_neighbor == NULL) {
+			fclose(file);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+	}
+	for (size_t i = 0; read_ok && (i < num_seed_or_neighbor); ++i) {
+		uint64_t value;
+		read_ok = iscc_read_value(file, &value) && (value < (uint64_t) clustering->num_data_points);
+		seed_or_neighbor[i] = (scc_PointIndex) value;
+	}
+	fclose(file);
+
+	if (!read_ok) {
+		free(seed_or_neighbor);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	clustering->num_clusters = (size_t) num_clusters;
+	*out_assign_state = (iscc_NNGAssignState) {
+		.num_seed_or_neighbor = (size_t) num_seed_or_neighbor,
+		.seed_or_neighbor = seed_or_neighbor,
+		.nn_assigned_search_object = NULL,
+		.nn_seed_search_object = NULL,
+	};
+	*out_secondary_radius_constraint = (radius_constraint == 1);
+	memcpy(out_secondary_radius, &radius_bits, sizeof(double));
+	*out_found = true;
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static char* iscc_checkpoint_path(const iscc_Checkpoint* const checkpoint,
+                                  const uint32_t phase,
+                                  const bool temporary)
+{
+	const char* const file_name = ISCC_CHECKPOINT_FILES[phase];
+	const size_t len_path = strlen(checkpoint->dir) + strlen(file_name) + 6;
+	char* const path = malloc(sizeof(char[len_path]));
+	if (path == NULL) return NULL;
+	snprintf(path, len_path, "%s/%s%s", checkpoint->dir, file_name, temporary ? ".tmp" : "");
+	return path;
+}
+
+
+// Checkpoints are written to a temporary file, which replaces the previous checkpoint
+// when it is complete, so an interrupted write never leaves a partial checkpoint
+static FILE* iscc_begin_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                   const uint32_t phase)
+{
+	char* const tmp_path = iscc_checkpoint_path(checkpoint, phase, true);
+	if (tmp_path == NULL) return NULL;
+	FILE* const file = fopen(tmp_path, "wb");
+	free(tmp_path);
+	if (file == NULL) return NULL;
+
+	const bool write_ok = (fwrite(ISCC_CHECKPOINT_MAGIC, 1, 8, file) == 8) &&
+	                      (fwrite(&ISCC_CHECKPOINT_BYTE_ORDER, sizeof(uint32_t), 1, file) == 1) &&
+	                      (fwrite(&phase, sizeof(uint32_t), 1, file) == 1) &&
+	                      iscc_write_value(file, checkpoint->key) &&
+	                      iscc_write_value(file, checkpoint->fingerprint) &&
+	                      iscc_write_value(file, (uint64_t) checkpoint->num_data_points);
+	if (!write_ok) {
+		fclose(file);
+		return NULL;
+	}
+	return file;
+}
+
+
+static scc_ErrorCode iscc_finish_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                            const uint32_t phase,
+                                            FILE* const file,
+                                            bool write_ok)
+{
+	write_ok = (fclose(file) == 0) && write_ok;
+
+	char* const tmp_path = iscc_checkpoint_path(checkpoint, phase, true);
+	char* const path = iscc_checkpoint_path(checkpoint, phase, false);
+	if ((tmp_path == NULL) || (path == NULL)) {
+		free(tmp_path);
+		free(path);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (write_ok && (rename(tmp_path, path) != 0)) {
+		// `rename` replaces the old checkpoint atomically on POSIX. Where it does not replace
+		// existing files, the old checkpoint is removed first, and a crash in between loses it.
+		remove(path);
+		write_ok = (rename(tmp_path, path) == 0);
+	}
+	if (!write_ok) remove(tmp_path);
+
+	free(tmp_path);
+	free(path);
+
+	if (!write_ok) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write checkpoint.");
+	return iscc_no_error();
+}
+
+
+// Writes NULL to `out_file`, without error, if the checkpoint does not exist
+static scc_ErrorCode iscc_open_checkpoint(const iscc_Checkpoint* const checkpoint,
+                                          const uint32_t phase,
+                                          FILE** const out_file)
+{
+	*out_file = NULL;
+	char* const path = iscc_checkpoint_path(checkpoint, phase, false);
+	if (path == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	FILE* const file = fopen(path, "rb");
+	free(path);
+	if (file == NULL) return iscc_no_error();
+
+	char magic[8];
+	uint32_t byte_order;
+	uint32_t file_phase;
+	uint64_t key;
+	uint64_t fingerprint;
+	uint64_t num_data_points;
+	if ((fread(magic, 1, 8, file) != 8) ||
+	        (fread(&byte_order, sizeof(uint32_t), 1, file) != 1) ||
+	        (fread(&file_phase, sizeof(uint32_t), 1, file) != 1) ||
+	        !iscc_read_value(file, &key) ||
+	        !iscc_read_value(file, &fingerprint) ||
+	        !iscc_read_value(file, &num_data_points)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Corrupt checkpoint.");
+	}
+
+	if ((memcmp(magic, ISCC_CHECKPOINT_MAGIC, 8) != 0) ||
+	        (byte_order != ISCC_CHECKPOINT_BYTE_ORDER) ||
+	        (file_phase != phase)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Not a checkpoint, or written with another version or byte order.");
+	}
+
+	if ((key != checkpoint->key) || (num_data_points != (uint64_t) checkpoint->num_data_points)) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Checkpoint was made for another clustering problem.");
+	}
+
+	if (fingerprint != checkpoint->fingerprint) {
+		fclose(file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Checkpoint was made for other data.");
+	}
+
+	*out_file = file;
+	return iscc_no_error();
+}
+
+
+static inline bool iscc_write_value(FILE* const file,
+                                    const uint64_t value)
+{
+	return (fwrite(&value, sizeof(uint64_t), 1, file) == 1);
+}
+
+
+static inline bool iscc_read_value(FILE* const file,
+                                   uint64_t* const out_value)
+{
+	return (fread(out_value, sizeof(uint64_t), 1, file) == 1);
+}
+
+
+static inline uint64_t iscc_hash_value(const uint64_t hash,
+                                       const uint64_t value)
+{
+	return (hash ^ value) * 1099511628211u;
+}
+
+
+static inline uint64_t iscc_hash_double(const uint64_t hash,
+                                        const double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(uint64_t));
+	return iscc_hash_value(hash, bits);
+}
@@ -0,0 +1,98 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_NNG_CHECKPOINT_HG
+#define SCC_NNG_CHECKPOINT_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "digraph_core.h"
+#include "nng_core.h"
+#include "nng_findseeds.h"
+
+
+// =============================================================================
+// Structs
+// =============================================================================
+
+// Checkpoints are written to files in `dir`. `key` identifies the clustering
+// problem and `fingerprint` the data, and checkpoints made with another key or
+// fingerprint are rejected.
+typedef struct iscc_Checkpoint {
+	const char* dir;
+	uint64_t key;
+	uint64_t fingerprint;
+	size_t num_data_points;
+} iscc_Checkpoint;
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+uint64_t iscc_checkpoint_key(const scc_ClusterOptions* options,
+                             size_t num_data_points);
+
+
+// Hashes distances between fixed points, and for `scc_DataSet` also sampled coordinates
+scc_ErrorCode iscc_checkpoint_fingerprint(void* data_set,
+                                          size_t num_data_points,
+                                          uint64_t* out_fingerprint);
+
+
+scc_ErrorCode iscc_save_nng_checkpoint(const iscc_Checkpoint* checkpoint,
+                                       const iscc_Digraph* nng);
+
+
+// `out_found` is set to false, and no error is returned, if there is no checkpoint
+scc_ErrorCode iscc_load_nng_checkpoint(const iscc_Checkpoint* checkpoint,
+                                       bool* out_found,
+                                       iscc_Digraph* out_nng);
+
+
+scc_ErrorCode iscc_save_seeds_checkpoint(const iscc_Checkpoint* checkpoint,
+                                         const iscc_SeedResult* seed_result);
+
+
+scc_ErrorCode iscc_load_seeds_checkpoint(const iscc_Checkpoint* checkpoint,
+                                         bool* out_found,
+                                         iscc_SeedResult* out_seed_result);
+
+
+// Saves the labels after the primary assignment, and what the secondary assignment needs
+scc_ErrorCode iscc_save_assign_checkpoint(const iscc_Checkpoint* checkpoint,
+                                          const scc_Clustering* clustering,
+                                          const iscc_NNGAssignState* assign_state,
+                                          bool secondary_radius_constraint,
+                                          double secondary_radius);
+
+
+// `clustering` must have allocated labels. The search objects in `out_assign_state` are NULL.
+scc_ErrorCode iscc_load_assign_checkpoint(const iscc_Checkpoint* checkpoint,
+                                          bool* out_found,
+                                          scc_Clustering* clustering,
+                                          iscc_NNGAssignState* out_assign_state,
+                                          bool* out_secondary_radius_constraint,
+                                          double* out_secondary_radius);
+
+
+#endif // ifndef SCC_NNG_CHECKPOINT_HG
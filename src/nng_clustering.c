@@ -30,8 +30,10 @@
 #include "dist_search.h"
 #include "error.h"
 #include "nng_batch_clustering.h"
+#include "nng_checkpoint.h"
 #include "nng_core.h"
 #include "nng_findseeds.h"
+#include "nng_pair_clustering.h"
 #include "utilities.h"
 
 
@@ -39,12 +41,36 @@
 // Static function prototypes
 // =============================================================================
 
+static scc_ErrorCode iscc_sc_clustering(void* data_set,
+                                        const scc_ClusterOptions* options,
+                                        const char* checkpoint_dir,
+                                        scc_Clustering* out_clustering);
+
+
+static scc_ErrorCode iscc_init_cluster_labels(scc_Clustering* clustering);
+
+
+static scc_ErrorCode iscc_resume_secondary_assignment(scc_Clustering* clustering,
+                                                      void* data_set,
+                                                      const scc_ClusterOptions* options,
+                                                      const iscc_Checkpoint* checkpoint,
+                                                      bool* out_found);
+
+
 static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* clustering,
                                                    void* data_set,
                                                    iscc_Digraph* nng,
                                                    const scc_ClusterOptions* options);
 
 
+static scc_ErrorCode iscc_make_clustering_from_nng_and_seeds(scc_Clustering* clustering,
+                                                             void* data_set,
+                                                             iscc_Digraph* nng,
+                                                             iscc_SeedResult* seed_result,
+                                                             const scc_ClusterOptions* options,
+                                                             const iscc_Checkpoint* checkpoint);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -52,6 +78,31 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* clustering,
 scc_ErrorCode scc_sc_clustering(void* const data_set,
                                 const scc_ClusterOptions* const options,
                                 scc_Clustering* const out_clustering)
+{
+	return iscc_sc_clustering(data_set, options, NULL, out_clustering);
+}
+
+
+scc_ErrorCode scc_sc_clustering_with_checkpoints(void* const data_set,
+                                                 const scc_ClusterOptions* const options,
+                                                 const char* const checkpoint_dir,
+                                                 scc_Clustering* const out_clustering)
+{
+	if (checkpoint_dir == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid checkpoint directory.");
+	}
+	return iscc_sc_clustering(data_set, options, checkpoint_dir, out_clustering);
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_sc_clustering(void* const data_set,
+                                        const scc_ClusterOptions* const options,
+                                        const char* const checkpoint_dir,
+                                        scc_Clustering* const out_clustering)
 {
 	if (!iscc_check_input_clustering(out_clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
@@ -82,41 +133,163 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 		                                  options->batch_size);
 	}
 
-	iscc_Digraph nng;
-	if (options->num_types < 2) {
-		if ((ec = iscc_get_nng_with_size_constraint(data_set,
-		                                            out_clustering->num_data_points,
-		                                            options->size_constraint,
-		                                            options->len_primary_data_points,
-		                                            options->primary_data_points,
-		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
-		                                            options->seed_supplied_radius,
-		                                            &nng)) != SCC_ER_OK) {
+	if (iscc_use_pair_clustering(options)) {
+		return iscc_nng_clustering_pairs(out_clustering,
+		                                 data_set,
+		                                 options->primary_unassigned_method,
+		                                 (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                 options->seed_supplied_radius,
+		                                 options->len_primary_data_points,
+		                                 options->primary_data_points);
+	}
+
+	// Checkpoints are written after each phase, and the latest one is resumed from
+	iscc_Checkpoint checkpoint_data;
+	const iscc_Checkpoint* checkpoint = NULL;
+	if (checkpoint_dir != NULL) {
+		checkpoint_data = (iscc_Checkpoint) {
+			.dir = checkpoint_dir,
+			.key = iscc_checkpoint_key(options, out_clustering->num_data_points),
+			.fingerprint = 0,
+			.num_data_points = out_clustering->num_data_points,
+		};
+		if ((ec = iscc_checkpoint_fingerprint(data_set,
+		                                      out_clustering->num_data_points,
+		                                      &checkpoint_data.fingerprint)) != SCC_ER_OK) {
 			return ec;
 		}
-	} else {
-		assert(options->num_types <= UINT16_MAX);
-		if ((ec = iscc_get_nng_with_type_constraint(data_set,
-		                                            out_clustering->num_data_points,
-		                                            options->size_constraint,
-		                                            (uint_fast16_t) options->num_types,
-		                                            options->type_constraints,
-		                                            options->type_labels,
-		                                            options->len_primary_data_points,
-		                                            options->primary_data_points,
-		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
-		                                            options->seed_supplied_radius,
-		                                            &nng)) != SCC_ER_OK) {
+		checkpoint = &checkpoint_data;
+
+		bool assign_found;
+		if ((ec = iscc_resume_secondary_assignment(out_clustering,
+		                                           data_set,
+		                                           options,
+		                                           checkpoint,
+		                                           &assign_found)) != SCC_ER_OK) {
+			return ec;
+		}
+		if (assign_found) return iscc_no_error();
+	}
+
+	// Lexical seeds only need the rows up to the current vertex, so they are found
+	// while the NNG is constructed. Non-seed rows are needed only when unassigned
+	// points are assigned using the NNG.
+	const bool lexical_seeds = (options->num_types < 2) && (options->seed_method == SCC_SM_LEXICAL);
+
+	iscc_Digraph nng = ISCC_NULL_DIGRAPH;
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (out_clustering->num_data_points / options->size_constraint),
+		.count = 0,
+		.seeds = NULL,
+	};
+	bool nng_found = false;
+	bool seeds_found = false;
+
+	if (checkpoint != NULL) {
+		if ((ec = iscc_load_nng_checkpoint(checkpoint, &nng_found, &nng)) != SCC_ER_OK) {
+			return ec;
+		}
+		if (nng_found) {
+			if ((ec = iscc_load_seeds_checkpoint(checkpoint, &seeds_found, &seed_result)) != SCC_ER_OK) {
+				iscc_free_digraph(&nng);
+				return ec;
+			}
+			// Lexical seeds cannot be found from the saved NNG, so it is constructed again
+			if (lexical_seeds && !seeds_found) {
+				iscc_free_digraph(&nng);
+				nng_found = false;
+			}
+		}
+	}
+
+	if (!nng_found) {
+		if (lexical_seeds) {
+			const bool seed_rows_only = (options->primary_unassigned_method != SCC_UM_ANY_NEIGHBOR) &&
+			                            (options->primary_unassigned_method != SCC_UM_CLOSEST_ASSIGNED);
+			if ((ec = iscc_get_nng_with_lexical_seeds(data_set,
+			                                          out_clustering->num_data_points,
+			                                          options->size_constraint,
+			                                          options->len_primary_data_points,
+			                                          options->primary_data_points,
+			                                          (options->seed_radius == SCC_RM_USE_SUPPLIED),
+			                                          options->seed_supplied_radius,
+			                                          seed_rows_only,
+			                                          &seed_result,
+			                                          &nng)) != SCC_ER_OK) {
+				return ec;
+			}
+			seeds_found = true;
+			// The seeds are saved first, so a saved NNG always has its seeds
+			if ((checkpoint != NULL) &&
+			        ((ec = iscc_save_seeds_checkpoint(checkpoint, &seed_result)) != SCC_ER_OK)) {
+				free(seed_result.seeds);
+				iscc_free_digraph(&nng);
+				return ec;
+			}
+		} else if (options->num_types < 2) {
+			if ((ec = iscc_get_nng_with_size_constraint(data_set,
+			                                            out_clustering->num_data_points,
+			                                            options->size_constraint,
+			                                            options->len_primary_data_points,
+			                                            options->primary_data_points,
+			                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
+			                                            options->seed_supplied_radius,
+			                                            &nng)) != SCC_ER_OK) {
+				return ec;
+			}
+		} else {
+			assert(options->num_types <= UINT16_MAX);
+			if ((ec = iscc_get_nng_with_type_constraint(data_set,
+			                                            out_clustering->num_data_points,
+			                                            options->size_constraint,
+			                                            (uint_fast16_t) options->num_types,
+			                                            options->type_constraints,
+			                                            options->type_labels,
+			                                            options->len_primary_data_points,
+			                                            options->primary_data_points,
+			                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
+			                                            options->seed_supplied_radius,
+			                                            &nng)) != SCC_ER_OK) {
+				return ec;
+			}
+		}
+
+		if ((checkpoint != NULL) &&
+		        ((ec = iscc_save_nng_checkpoint(checkpoint, &nng)) != SCC_ER_OK)) {
+			free(seed_result.seeds);
+			iscc_free_digraph(&nng);
 			return ec;
 		}
 	}
 
 	assert(!iscc_digraph_is_empty(&nng));
 
-	ec = iscc_make_clustering_from_nng(out_clustering,
-	                                   data_set,
-	                                   &nng,
-	                                   options);
+	if (seeds_found) {
+		ec = iscc_make_clustering_from_nng_and_seeds(out_clustering,
+		                                             data_set,
+		                                             &nng,
+		                                             &seed_result,
+		                                             options,
+		                                             checkpoint);
+	} else if (checkpoint == NULL) {
+		ec = iscc_make_clustering_from_nng(out_clustering,
+		                                   data_set,
+		                                   &nng,
+		                                   options);
+	} else {
+		if ((ec = iscc_find_seeds(&nng, options->seed_method, &seed_result)) == SCC_ER_OK) {
+			if ((ec = iscc_save_seeds_checkpoint(checkpoint, &seed_result)) == SCC_ER_OK) {
+				ec = iscc_make_clustering_from_nng_and_seeds(out_clustering,
+				                                             data_set,
+				                                             &nng,
+				                                             &seed_result,
+				                                             options,
+				                                             checkpoint);
+			} else {
+				free(seed_result.seeds);
+			}
+		}
+	}
 
 	iscc_free_digraph(&nng);
 
@@ -124,9 +297,67 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 }
 
 
-// =============================================================================
-// Static function implementations
-// =============================================================================
+static scc_ErrorCode iscc_init_cluster_labels(scc_Clustering* const clustering)
+{
+	if (clustering->cluster_label == NULL) {
+		clustering->external_labels = false;
+		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		if (clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_resume_secondary_assignment(scc_Clustering* const clustering,
+                                                      void* const data_set,
+                                                      const scc_ClusterOptions* const options,
+                                                      const iscc_Checkpoint* const checkpoint,
+                                                      bool* const out_found)
+{
+	assert(checkpoint != NULL);
+	assert(out_found != NULL);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_init_cluster_labels(clustering)) != SCC_ER_OK) return ec;
+
+	iscc_NNGAssignState assign_state;
+	bool secondary_radius_constraint;
+	double secondary_radius;
+	if ((ec = iscc_load_assign_checkpoint(checkpoint,
+	                                      out_found,
+	                                      clustering,
+	                                      &assign_state,
+	                                      &secondary_radius_constraint,
+	                                      &secondary_radius)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (!*out_found) return iscc_no_error();
+
+	iscc_SeedResult seed_result;
+	bool seeds_found;
+	if ((ec = iscc_load_seeds_checkpoint(checkpoint, &seeds_found, &seed_result)) != SCC_ER_OK) {
+		iscc_free_nng_assign_state(&assign_state);
+		return ec;
+	}
+	if (!seeds_found) {
+		iscc_free_nng_assign_state(&assign_state);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Incomplete checkpoint.");
+	}
+
+	ec = iscc_assign_secondary_from_seeds(clustering,
+	                                      data_set,
+	                                      &seed_result,
+	                                      options->secondary_unassigned_method,
+	                                      secondary_radius_constraint,
+	                                      secondary_radius,
+	                                      &assign_state);
+
+	iscc_free_nng_assign_state(&assign_state);
+	free(seed_result.seeds);
+
+	return ec;
+}
+
 
 static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const clustering,
                                                    void* const data_set,
@@ -150,6 +381,32 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 		return ec;
 	}
 
+	return iscc_make_clustering_from_nng_and_seeds(clustering,
+	                                               data_set,
+	                                               nng,
+	                                               &seed_result,
+	                                               options,
+	                                               NULL);
+}
+
+
+static scc_ErrorCode iscc_make_clustering_from_nng_and_seeds(scc_Clustering* const clustering,
+                                                             void* const data_set,
+                                                             iscc_Digraph* const nng,
+                                                             iscc_SeedResult* const seed_result,
+                                                             const scc_ClusterOptions* options,
+                                                             const iscc_Checkpoint* const checkpoint)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(seed_result->count > 0);
+	assert(seed_result->seeds != NULL);
+
+	scc_ErrorCode ec;
+
 	scc_RadiusMethod primary_radius = options->primary_radius;
 	double primary_supplied_radius = options->primary_supplied_radius;
 	scc_RadiusMethod secondary_radius = options->secondary_radius;
@@ -180,11 +437,11 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	        (secondary_radius == SCC_RM_USE_ESTIMATED)) {
 		double avg_seed_dist;
 		if ((ec = iscc_estimate_avg_seed_dist(data_set,
-		                                      &seed_result,
+		                                      seed_result,
 		                                      nng,
 		                                      options->size_constraint,
 		                                      &avg_seed_dist)) != SCC_ER_OK) {
-			free(seed_result.seeds);
+			free(seed_result->seeds);
 			return ec;
 		}
 
@@ -193,7 +450,7 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				primary_radius = SCC_RM_USE_SUPPLIED;
 				primary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
+				free(seed_result->seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -203,7 +460,7 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				secondary_radius = SCC_RM_USE_SUPPLIED;
 				secondary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
+				free(seed_result->seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -213,29 +470,44 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	assert((secondary_radius == SCC_RM_NO_RADIUS) || (secondary_radius == SCC_RM_USE_SUPPLIED));
 
 	// Initialize cluster labels
-	if (clustering->cluster_label == NULL) {
-		clustering->external_labels = false;
-		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
-		if (clustering->cluster_label == NULL) {
-			free(seed_result.seeds);
-			return iscc_make_error(SCC_ER_NO_MEMORY);
-		}
+	if ((ec = iscc_init_cluster_labels(clustering)) != SCC_ER_OK) {
+		free(seed_result->seeds);
+		return ec;
 	}
 
-	ec = iscc_make_nng_clusters_from_seeds(clustering,
-	                                       data_set,
-	                                       &seed_result,
-	                                       nng,
-	                                       (options->num_types < 2),
-	                                       options->primary_unassigned_method,
-	                                       (primary_radius == SCC_RM_USE_SUPPLIED),
-	                                       primary_supplied_radius,
-	                                       options->len_primary_data_points,
-	                                       options->primary_data_points,
-	                                       options->secondary_unassigned_method,
-	                                       (secondary_radius == SCC_RM_USE_SUPPLIED),
-	                                       secondary_supplied_radius);
+	iscc_NNGAssignState assign_state;
+	ec = iscc_assign_primary_from_seeds(clustering,
+	                                    data_set,
+	                                    seed_result,
+	                                    nng,
+	                                    (options->num_types < 2),
+	                                    options->primary_unassigned_method,
+	                                    (primary_radius == SCC_RM_USE_SUPPLIED),
+	                                    primary_supplied_radius,
+	                                    options->len_primary_data_points,
+	                                    options->primary_data_points,
+	                                    options->secondary_unassigned_method,
+	                                    &assign_state);
 
-	free(seed_result.seeds);
+	if ((ec == SCC_ER_OK) && (checkpoint != NULL)) {
+		ec = iscc_save_assign_checkpoint(checkpoint,
+		                                 clustering,
+		                                 &assign_state,
+		                                 (secondary_radius == SCC_RM_USE_SUPPLIED),
+		                                 secondary_supplied_radius);
+	}
+
+	if (ec == SCC_ER_OK) {
+		ec = iscc_assign_secondary_from_seeds(clustering,
+		                                      data_set,
+		                                      seed_result,
+		                                      options->secondary_unassigned_method,
+		                                      (secondary_radius == SCC_RM_USE_SUPPLIED),
+		                                      secondary_supplied_radius,
+		                                      &assign_state);
+	}
+
+	iscc_free_nng_assign_state(&assign_state);
+	free(seed_result->seeds);
 	return ec;
 }
@@ -33,6 +33,7 @@
 #include "dist_search.h"
 #include "error.h"
 #include "nng_findseeds.h"
+#include "parallel_for.h"
 #include "scclust_types.h"
 
 
@@ -48,8 +49,57 @@ typedef struct iscc_TypeCount {
 } iscc_TypeCount;
 
 
+// Searches a round of query blocks for `iscc_make_nng_from_search_object` and
+// `iscc_make_loopless_nng`. Each block has its own slots in the scratch arrays,
+// so the blocks of a round can be searched concurrently.
+typedef struct iscc_NNGBlockSearch {
+	iscc_NNSearchObject* nn_search_object;
+	size_t len_query_indices;
+	const scc_PointIndex* query_indices;
+	uint32_t k;
+	bool radius_search;
+	double radius;
+	bool finalize_loopless;
+	size_t block_size;
+	size_t num_blocks;
+	size_t blocks_per_round;
+	size_t round_first_block;
+	scc_PointIndex* block_queries;
+	scc_PointIndex* block_ok_queries;
+	scc_PointIndex* block_nn_indices;
+	size_t* block_num_ok;
+	bool* block_search_ok;
+} iscc_NNGBlockSearch;
+
+
+// Searches blocks of `iscc_assign_by_nn_search`. Each block writes to its own range.
+typedef struct iscc_AssignSearch {
+	iscc_NNSearchObject* nn_search_object;
+	size_t num_to_assign;
+	const scc_PointIndex* to_assign;
+	bool radius_constraint;
+	double radius;
+	scc_PointIndex* ok_queries;
+	scc_PointIndex* nn_indices;
+	size_t* block_num_ok;
+	bool* block_search_ok;
+} iscc_AssignSearch;
+
+
 static const size_t ISCC_ESTIMATE_AVG_MAX_SAMPLE = 1000;
 
+// Number of arcs to search for in each block when constructing NNGs.
+static const size_t ISCC_NNG_BLOCK_ARCS = 4096;
+
+// Number of queries to sample when estimating how many queries satisfy a radius constraint.
+static const size_t ISCC_RADIUS_PROBE_SAMPLE = 64;
+
+// Number of blocks searched in each round when a parallel loop is registered.
+static const size_t ISCC_NNG_PARALLEL_BLOCKS = 32;
+
+// Number of queries per call to the search function when assigning by nearest neighbor search.
+static const size_t ISCC_ASSIGN_BLOCK_QUERIES = 4096;
+
 
 // =============================================================================
 // Static function prototypes
@@ -81,6 +131,93 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* nn_se
                                                       iscc_Digraph* out_nng);
 
 
+static scc_ErrorCode iscc_estimate_radius_ok_queries(iscc_NNSearchObject* nn_search_object,
+                                                     size_t len_query_indices,
+                                                     const scc_PointIndex query_indices[],
+                                                     uint32_t k,
+                                                     double radius,
+                                                     size_t* out_estimate);
+
+
+static inline scc_ErrorCode iscc_reserve_nng_arcs(iscc_Digraph* nng,
+                                                  size_t arcs_written,
+                                                  size_t min_arcs,
+                                                  size_t max_arcs);
+
+
+static scc_ErrorCode iscc_init_nng_block_search(iscc_NNSearchObject* nn_search_object,
+                                                size_t len_query_indices,
+                                                const scc_PointIndex query_indices[],
+                                                uint32_t k,
+                                                bool radius_search,
+                                                double radius,
+                                                bool finalize_loopless,
+                                                iscc_NNGBlockSearch* out_block_search);
+
+
+static void iscc_free_nng_block_search(iscc_NNGBlockSearch* block_search);
+
+
+static scc_ErrorCode iscc_search_nng_round(iscc_NNGBlockSearch* block_search,
+                                           size_t round_first_block,
+                                           size_t* out_len_round);
+
+
+static void iscc_search_nng_blocks(size_t begin,
+                                   size_t end,
+                                   void* context);
+
+
+static inline size_t iscc_nng_block_len(const iscc_NNGBlockSearch* block_search,
+                                        size_t round_block);
+
+
+static inline const scc_PointIndex* iscc_nng_block_ok_queries(const iscc_NNGBlockSearch* block_search,
+                                                              size_t round_block);
+
+
+static inline const scc_PointIndex* iscc_nng_block_nn_indices(const iscc_NNGBlockSearch* block_search,
+                                                              size_t round_block);
+
+
+static scc_ErrorCode iscc_make_loopless_nng(void* data_set,
+                                            size_t num_data_points,
+                                            size_t len_query_indices,
+                                            const scc_PointIndex query_indices[],
+                                            uint32_t k,
+                                            bool radius_search,
+                                            double radius,
+                                            iscc_SeedResult* out_lexical_seeds,
+                                            bool seed_rows_only,
+                                            iscc_Digraph* out_nng);
+
+
+static scc_ErrorCode iscc_search_nearest_neighbors(iscc_NNSearchObject* nn_search_object,
+                                                   size_t len_query_indices,
+                                                   const scc_PointIndex query_indices[],
+                                                   bool loopless,
+                                                   bool radius_search,
+                                                   double radius,
+                                                   scc_PointIndex out_nn[]);
+
+
+static scc_ErrorCode iscc_make_bipartite_nng(void* data_set,
+                                             size_t num_data_points,
+                                             uint32_t size_constraint,
+                                             const scc_TypeLabel type_labels[],
+                                             size_t len_query_indices,
+                                             const scc_PointIndex query_indices[],
+                                             bool radius_constraint,
+                                             double radius,
+                                             iscc_Digraph* out_nng);
+
+
+static inline void iscc_finalize_loopless_rows(size_t num_rows,
+                                               const scc_PointIndex row_queries[],
+                                               uint32_t k,
+                                               scc_PointIndex* in_out_head);
+
+
 static inline void iscc_ensure_self_match(iscc_Digraph* nng,
                                           size_t len_search_indices,
                                           const scc_PointIndex search_indices[]);
@@ -106,13 +243,21 @@ static size_t iscc_assign_by_nng(scc_Clustering* clustering,
 static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* clustering,
                                               iscc_NNSearchObject* nn_search_object,
                                               size_t num_to_assign,
-                                              scc_PointIndex to_assign[restrict static num_to_assign],
+                                              const scc_PointIndex to_assign[restrict static num_to_assign],
                                               bool radius_constraint,
                                               double radius);
 
 
+static void iscc_assign_search_blocks(size_t begin,
+                                      size_t end,
+                                      void* context);
+
+
 #ifdef SCC_STABLE_NNG
 
+static int iscc_compare_PointIndex(const void* a, const void* b);
+
+
 static void iscc_sort_nng(iscc_Digraph* nng);
 
 #endif // ifdef SCC_STABLE_NNG
@@ -147,18 +292,16 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 	}
 
 	scc_ErrorCode ec;
-	if ((ec = iscc_make_nng(data_set,
-	                        num_data_points,
-	                        num_data_points,
-	                        NULL,
-	                        num_queries,
-	                        primary_data_points,
-	                        size_constraint,
-	                        radius_constraint,
-	                        radius,
-	                        NULL,
-	                        NULL,
-	                        out_nng)) != SCC_ER_OK) {
+	if ((ec = iscc_make_loopless_nng(data_set,
+	                                 num_data_points,
+	                                 num_queries,
+	                                 primary_data_points,
+	                                 size_constraint,
+	                                 radius_constraint,
+	                                 radius,
+	                                 NULL,
+	                                 false,
+	                                 out_nng)) != SCC_ER_OK) {
 		return ec;
 	}
 
@@ -167,21 +310,115 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 	}
 
-	iscc_ensure_self_match(out_nng, num_data_points, NULL);
+	return iscc_no_error();
+}
+
 
-	if ((ec = iscc_delete_loops(out_nng)) != SCC_ER_OK) {
-		iscc_free_digraph(out_nng);
+scc_ErrorCode iscc_get_nng_with_lexical_seeds(void* const data_set,
+                                              const size_t num_data_points,
+                                              const uint32_t size_constraint,
+                                              const size_t len_primary_data_points,
+                                              const scc_PointIndex primary_data_points[const],
+                                              const bool radius_constraint,
+                                              const double radius,
+                                              const bool seed_rows_only,
+                                              iscc_SeedResult* const out_seeds,
+                                              iscc_Digraph* const out_nng)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(num_data_points >= 2);
+	assert(size_constraint <= num_data_points);
+	assert(size_constraint >= 2);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(out_seeds != NULL);
+	assert(out_seeds->capacity > 0);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+	assert(out_nng != NULL);
+
+	size_t num_queries;
+	if (primary_data_points == NULL) {
+		num_queries = num_data_points;
+	} else {
+		num_queries = len_primary_data_points;
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_make_loopless_nng(data_set,
+	                                 num_data_points,
+	                                 num_queries,
+	                                 primary_data_points,
+	                                 size_constraint,
+	                                 radius_constraint,
+	                                 radius,
+	                                 out_seeds,
+	                                 seed_rows_only,
+	                                 out_nng)) != SCC_ER_OK) {
 		return ec;
 	}
 
-	#ifdef SCC_STABLE_NNG
-		iscc_sort_nng(out_nng);
-	#endif // ifdef SCC_STABLE_NNG
+	// The first non-empty row is always a seed
+	if (out_seeds->count == 0) {
+		assert(iscc_digraph_is_empty(out_nng));
+		free(out_seeds->seeds);
+		out_seeds->seeds = NULL;
+		iscc_free_digraph(out_nng);
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	iscc_shrink_seed_result(out_seeds);
 
 	return iscc_no_error();
 }
 
 
+scc_ErrorCode iscc_get_nearest_neighbors(void* const data_set,
+                                         const size_t num_data_points,
+                                         const size_t len_query_indices,
+                                         const scc_PointIndex query_indices[const],
+                                         const bool radius_constraint,
+                                         const double radius,
+                                         scc_PointIndex out_nn[const])
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(num_data_points >= 2);
+	assert(len_query_indices > 0);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(out_nn != NULL);
+
+	// Non-queries and queries without neighbor within the radius point to themselves
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed.
+	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+		out_nn[i] = i;
+	}
+
+	iscc_NNSearchObject* nn_search_object;
+	if (!iscc_init_nn_search_object(data_set,
+	                                num_data_points,
+	                                NULL,
+	                                &nn_search_object)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	scc_ErrorCode ec = iscc_search_nearest_neighbors(nn_search_object,
+	                                                 len_query_indices,
+	                                                 query_indices,
+	                                                 true,
+	                                                 radius_constraint,
+	                                                 radius,
+	                                                 out_nn);
+
+	if (!iscc_close_nn_search_object(&nn_search_object) && (ec == SCC_ER_OK)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	return ec;
+}
+
+
 scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
                                                 const size_t num_data_points,
                                                 const uint32_t size_constraint,
@@ -213,6 +450,27 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		num_queries = len_primary_data_points;
 	}
 
+	scc_ErrorCode ec;
+	if ((num_types == 2) && (type_constraints[0] == 1) && (type_constraints[1] == 1)) {
+		if ((ec = iscc_make_bipartite_nng(data_set,
+		                                  num_data_points,
+		                                  size_constraint,
+		                                  type_labels,
+		                                  num_queries,
+		                                  primary_data_points,
+		                                  radius_constraint,
+		                                  radius,
+		                                  out_nng)) != SCC_ER_OK) {
+			return ec;
+		}
+
+		#ifdef SCC_STABLE_NNG
+			iscc_sort_nng(out_nng);
+		#endif // ifdef SCC_STABLE_NNG
+
+		return iscc_no_error();
+	}
+
 	scc_PointIndex* seedable;
 	const scc_PointIndex* seedable_const;
 	if (radius_constraint) {
@@ -237,7 +495,6 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	scc_ErrorCode ec;
 	iscc_TypeCount tc;
 	if ((ec = iscc_type_count(num_data_points,
 	                          size_constraint,
@@ -423,14 +680,58 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
                                                 const iscc_SeedResult* const seed_result,
                                                 iscc_Digraph* const nng,
                                                 const bool nng_is_ordered,
-                                                scc_UnassignedMethod unassigned_method,
+                                                const scc_UnassignedMethod unassigned_method,
                                                 const bool radius_constraint,
                                                 const double radius,
-                                                size_t len_primary_data_points,
-                                                const scc_PointIndex primary_data_points[],
-                                                scc_UnassignedMethod secondary_unassigned_method,
+                                                const size_t len_primary_data_points,
+                                                const scc_PointIndex primary_data_points[const],
+                                                const scc_UnassignedMethod secondary_unassigned_method,
                                                 const bool secondary_radius_constraint,
                                                 const double secondary_radius)
+{
+	iscc_NNGAssignState assign_state;
+	scc_ErrorCode ec;
+	if ((ec = iscc_assign_primary_from_seeds(clustering,
+	                                         data_set,
+	                                         seed_result,
+	                                         nng,
+	                                         nng_is_ordered,
+	                                         unassigned_method,
+	                                         radius_constraint,
+	                                         radius,
+	                                         len_primary_data_points,
+	                                         primary_data_points,
+	                                         secondary_unassigned_method,
+	                                         &assign_state)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	ec = iscc_assign_secondary_from_seeds(clustering,
+	                                      data_set,
+	                                      seed_result,
+	                                      secondary_unassigned_method,
+	                                      secondary_radius_constraint,
+	                                      secondary_radius,
+	                                      &assign_state);
+
+	iscc_free_nng_assign_state(&assign_state);
+
+	return ec;
+}
+
+
+scc_ErrorCode iscc_assign_primary_from_seeds(scc_Clustering* const clustering,
+                                             void* const data_set,
+                                             const iscc_SeedResult* const seed_result,
+                                             iscc_Digraph* const nng,
+                                             const bool nng_is_ordered,
+                                             scc_UnassignedMethod unassigned_method,
+                                             const bool radius_constraint,
+                                             const double radius,
+                                             const size_t len_primary_data_points,
+                                             const scc_PointIndex primary_data_points[const],
+                                             const scc_UnassignedMethod secondary_unassigned_method,
+                                             iscc_NNGAssignState* const out_assign_state)
 {
 	assert(iscc_check_input_clustering(clustering));
 	assert(iscc_check_data_set(data_set));
@@ -447,7 +748,14 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	assert((secondary_unassigned_method == SCC_UM_IGNORE) ||
 	       (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
 	       (secondary_unassigned_method == SCC_UM_CLOSEST_SEED));
-	assert(!secondary_radius_constraint || (secondary_radius > 0.0));
+	assert(out_assign_state != NULL);
+
+	*out_assign_state = (iscc_NNGAssignState) {
+		.num_seed_or_neighbor = 0,
+		.seed_or_neighbor = NULL,
+		.nn_assigned_search_object = NULL,
+		.nn_seed_search_object = NULL,
+	};
 
 	// Assign seeds and their neighbors
 	const size_t num_assigned_as_seed_or_neighbor = iscc_assign_seeds_and_neighbors(clustering, seed_result, nng);
@@ -476,6 +784,8 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 			}
 		}
 		assert(((size_t) (write_seed_or_neighbor - seed_or_neighbor)) == num_assigned_as_seed_or_neighbor);
+		out_assign_state->num_seed_or_neighbor = num_assigned_as_seed_or_neighbor;
+		out_assign_state->seed_or_neighbor = seed_or_neighbor;
 	}
 
 	// Run assignment by nng. When nng is ordered, we can use it for `SCC_UM_CLOSEST_ASSIGNED` as well.
@@ -492,7 +802,6 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		// Are we done?
 		if ((total_assigned == clustering->num_data_points) ||
 		        ((unassigned_method == SCC_UM_IGNORE) && (secondary_unassigned_method == SCC_UM_IGNORE))) {
-			free(seed_or_neighbor);
 			return iscc_no_error();
 		}
 	}
@@ -500,54 +809,35 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	// No need for nng any more
 	iscc_free_digraph(nng);
 
-	scc_ErrorCode ec = SCC_ER_OK;
-	iscc_NNSearchObject* nn_assigned_search_object = NULL;
-	iscc_NNSearchObject* nn_seed_search_object = NULL;
+	if (unassigned_method == SCC_UM_IGNORE) return iscc_no_error();
 
-	if ((unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
-	        (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED)) {
+	iscc_NNSearchObject* nn_search_object;
+	if (unassigned_method == SCC_UM_CLOSEST_ASSIGNED) {
 		assert(seed_or_neighbor != NULL);
 		if (!iscc_init_nn_search_object(data_set,
 		                                num_assigned_as_seed_or_neighbor,
 		                                seed_or_neighbor,
-		                                &nn_assigned_search_object)) {
-			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		                                &out_assign_state->nn_assigned_search_object)) {
+			iscc_free_nng_assign_state(out_assign_state);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
-	}
-
-	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
-		return ec;
-	}
-
-	if ((unassigned_method == SCC_UM_CLOSEST_SEED) ||
-	        (secondary_unassigned_method == SCC_UM_CLOSEST_SEED)) {
+		nn_search_object = out_assign_state->nn_assigned_search_object;
+	} else {
+		assert(unassigned_method == SCC_UM_CLOSEST_SEED);
 		if (!iscc_init_nn_search_object(data_set,
 		                                seed_result->count,
 		                                seed_result->seeds,
-		                                &nn_seed_search_object)) {
-			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
-		}
-	}
-
-	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
-		if (nn_assigned_search_object != NULL) {
-			iscc_close_nn_search_object(&nn_assigned_search_object);
+		                                &out_assign_state->nn_seed_search_object)) {
+			iscc_free_nng_assign_state(out_assign_state);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
-		return ec;
+		nn_search_object = out_assign_state->nn_seed_search_object;
 	}
 
 	size_t num_to_assign = 0;
 	scc_PointIndex* const to_assign = malloc(sizeof(scc_PointIndex[clustering->num_data_points - total_assigned + 1]));
 	if (to_assign == NULL) {
-		free(seed_or_neighbor);
-		if (nn_assigned_search_object != NULL) {
-			iscc_close_nn_search_object(&nn_assigned_search_object);
-		}
-		if (nn_seed_search_object != NULL) {
-			iscc_close_nn_search_object(&nn_seed_search_object);
-		}
+		iscc_free_nng_assign_state(out_assign_state);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -564,73 +854,118 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		}
 	}
 
+	scc_ErrorCode ec = SCC_ER_OK;
 	if (num_to_assign > 0) {
-		if (unassigned_method == SCC_UM_CLOSEST_ASSIGNED) {
-			ec = iscc_assign_by_nn_search(clustering,
-			                              nn_assigned_search_object,
-			                              num_to_assign,
-			                              to_assign,
-			                              radius_constraint,
-			                              radius);
-		} else if (unassigned_method == SCC_UM_CLOSEST_SEED) {
-			ec = iscc_assign_by_nn_search(clustering,
-			                              nn_seed_search_object,
-			                              num_to_assign,
-			                              to_assign,
-			                              radius_constraint,
-			                              radius);
-		}
+		ec = iscc_assign_by_nn_search(clustering,
+		                              nn_search_object,
+		                              num_to_assign,
+		                              to_assign,
+		                              radius_constraint,
+		                              radius);
 	}
 
+	free(to_assign);
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
+		iscc_free_nng_assign_state(out_assign_state);
+	}
+
+	return ec;
+}
+
+
+scc_ErrorCode iscc_assign_secondary_from_seeds(scc_Clustering* const clustering,
+                                               void* const data_set,
+                                               const iscc_SeedResult* const seed_result,
+                                               const scc_UnassignedMethod secondary_unassigned_method,
+                                               const bool secondary_radius_constraint,
+                                               const double secondary_radius,
+                                               iscc_NNGAssignState* const assign_state)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(seed_result->count > 0);
+	assert(seed_result->seeds != NULL);
+	assert((secondary_unassigned_method == SCC_UM_IGNORE) ||
+	       (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	       (secondary_unassigned_method == SCC_UM_CLOSEST_SEED));
+	assert(!secondary_radius_constraint || (secondary_radius > 0.0));
+	assert(assign_state != NULL);
+
+	if (secondary_unassigned_method == SCC_UM_IGNORE) return iscc_no_error();
+
+	size_t num_to_assign = 0;
+	scc_PointIndex* const to_assign = malloc(sizeof(scc_PointIndex[clustering->num_data_points]));
+	if (to_assign == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) clustering->num_data_points;
+	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+		to_assign[num_to_assign] = i;
+		num_to_assign += (clustering->cluster_label[i] == SCC_CLABEL_NA);
+	}
+
+	if (num_to_assign == 0) {
 		free(to_assign);
-		if (nn_assigned_search_object != NULL) {
-			iscc_close_nn_search_object(&nn_assigned_search_object);
-		}
-		if (nn_seed_search_object != NULL) {
-			iscc_close_nn_search_object(&nn_seed_search_object);
-		}
-		return ec;
+		return iscc_no_error();
 	}
 
-	if (secondary_unassigned_method != SCC_UM_IGNORE) {
-		size_t num_to_assign = 0;
-		const scc_PointIndex num_data_points_pi = (scc_PointIndex) clustering->num_data_points;
-		for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
-			to_assign[num_to_assign] = i;
-			num_to_assign += (clustering->cluster_label[i] == SCC_CLABEL_NA);
+	// Search objects made for the primary assignment are reused
+	iscc_NNSearchObject** nn_search_object;
+	bool search_ok = true;
+	if (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) {
+		assert(assign_state->seed_or_neighbor != NULL);
+		nn_search_object = &assign_state->nn_assigned_search_object;
+		if (*nn_search_object == NULL) {
+			search_ok = iscc_init_nn_search_object(data_set,
+			                                       assign_state->num_seed_or_neighbor,
+			                                       assign_state->seed_or_neighbor,
+			                                       nn_search_object);
 		}
-
-		if (num_to_assign > 0) {
-			if (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) {
-				ec = iscc_assign_by_nn_search(clustering,
-				                              nn_assigned_search_object,
-				                              num_to_assign,
-				                              to_assign,
-				                              secondary_radius_constraint,
-				                              secondary_radius);
-			} else if (secondary_unassigned_method == SCC_UM_CLOSEST_SEED) {
-				ec = iscc_assign_by_nn_search(clustering,
-				                              nn_seed_search_object,
-				                              num_to_assign,
-				                              to_assign,
-				                              secondary_radius_constraint,
-				                              secondary_radius);
-			}
+	} else {
+		nn_search_object = &assign_state->nn_seed_search_object;
+		if (*nn_search_object == NULL) {
+			search_ok = iscc_init_nn_search_object(data_set,
+			                                       seed_result->count,
+			                                       seed_result->seeds,
+			                                       nn_search_object);
 		}
 	}
+	if (!search_ok) {
+		*nn_search_object = NULL;
+		free(to_assign);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	const scc_ErrorCode ec = iscc_assign_by_nn_search(clustering,
+	                                                  *nn_search_object,
+	                                                  num_to_assign,
+	                                                  to_assign,
+	                                                  secondary_radius_constraint,
+	                                                  secondary_radius);
 
-	free(seed_or_neighbor);
 	free(to_assign);
-	if (nn_assigned_search_object != NULL) {
-		iscc_close_nn_search_object(&nn_assigned_search_object);
-	}
-	if (nn_seed_search_object != NULL) {
-		iscc_close_nn_search_object(&nn_seed_search_object);
-	}
 
-	return iscc_no_error();
+	return ec;
+}
+
+
+void iscc_free_nng_assign_state(iscc_NNGAssignState* const assign_state)
+{
+	if (assign_state != NULL) {
+		free(assign_state->seed_or_neighbor);
+		if (assign_state->nn_assigned_search_object != NULL) {
+			iscc_close_nn_search_object(&assign_state->nn_assigned_search_object);
+		}
+		if (assign_state->nn_seed_search_object != NULL) {
+			iscc_close_nn_search_object(&assign_state->nn_seed_search_object);
+		}
+		*assign_state = (iscc_NNGAssignState) {
+			.num_seed_or_neighbor = 0,
+			.seed_or_neighbor = NULL,
+			.nn_assigned_search_object = NULL,
+			.nn_seed_search_object = NULL,
+		};
+	}
 }
 
 
@@ -708,94 +1043,104 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	assert(!radius_search || (radius > 0.0));
 	assert(out_nng != NULL);
 
-	scc_PointIndex* internal_out_query_indices = NULL;
-	scc_PointIndex* dist_out_query_indices = NULL;
+	scc_ErrorCode ec;
+	iscc_NNGBlockSearch block_search;
+	if ((ec = iscc_init_nng_block_search(nn_search_object,
+	                                     len_query_indices,
+	                                     query_indices,
+	                                     k,
+	                                     radius_search,
+	                                     radius,
+	                                     false,
+	                                     &block_search)) != SCC_ER_OK) {
+		return ec;
+	}
 
+	// With a radius constraint, the number of ok queries is not known before the search.
+	// Start from a sampled estimate and grow the arc storage if it turns out too small.
+	size_t max_rows_initial = len_query_indices;
 	if (radius_search) {
-		if (out_query_indices != NULL) {
-			dist_out_query_indices = out_query_indices;
-		} else {
-			internal_out_query_indices = malloc(sizeof(scc_PointIndex[len_query_indices]));
-			if (internal_out_query_indices == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
-			dist_out_query_indices = internal_out_query_indices;
+		size_t estimated_ok_queries;
+		if ((ec = iscc_estimate_radius_ok_queries(nn_search_object,
+		                                          len_query_indices,
+		                                          query_indices,
+		                                          k,
+		                                          radius,
+		                                          &estimated_ok_queries)) != SCC_ER_OK) {
+			iscc_free_nng_block_search(&block_search);
+			return ec;
 		}
+		estimated_ok_queries += (estimated_ok_queries >> 3) + block_search.block_size;
+		if (estimated_ok_queries < max_rows_initial) max_rows_initial = estimated_ok_queries;
 	}
 
-	scc_ErrorCode ec;
 	if ((ec = iscc_init_digraph(num_data_points,
-	                            len_query_indices * k,
+	                            max_rows_initial * k,
 	                            out_nng)) != SCC_ER_OK) {
-		free(internal_out_query_indices);
+		iscc_free_nng_block_search(&block_search);
 		return ec;
 	}
 
 	size_t num_ok_queries = 0;
-	if (!iscc_nearest_neighbor_search(nn_search_object,
-	                                  len_query_indices,
-	                                  query_indices,
-	                                  k,
-	                                  radius_search,
-	                                  radius,
-	                                  &num_ok_queries,
-	                                  dist_out_query_indices,
-	                                  out_nng->head)) {
-		free(internal_out_query_indices);
-		iscc_free_digraph(out_nng);
-		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
-	}
+	scc_PointIndex next_tail = 0;
+	out_nng->tail_ptr[0] = 0;
+
+	size_t len_round = 0;
+	for (size_t round_first_block = 0; round_first_block < block_search.num_blocks; round_first_block += len_round) {
+		if ((ec = iscc_search_nng_round(&block_search,
+		                                round_first_block,
+		                                &len_round)) != SCC_ER_OK) {
+			break;
+		}
 
-	iscc_ArcIndex* write_tail_ptr = out_nng->tail_ptr;
-	*write_tail_ptr = 0;
-	++write_tail_ptr;
-	const iscc_ArcIndex* const write_tail_ptr_stop = write_tail_ptr + num_data_points;
+		// Blocks are appended in order, so `out_query_indices` may alias `query_indices`
+		for (size_t b = 0; b < len_round; ++b) {
+			const size_t num_ok_block = block_search.block_num_ok[b];
+			const scc_PointIndex* const ok_q = iscc_nng_block_ok_queries(&block_search, b);
 
-	if (radius_search || query_indices != NULL) {
-		const scc_PointIndex* ok_q;
-		if (radius_search) {
-			assert(dist_out_query_indices != NULL);
-			ok_q = dist_out_query_indices;
-		} else {
-			assert(len_query_indices == num_ok_queries);
-			assert(query_indices != NULL);
-			ok_q = query_indices;
-		}
+			if ((ec = iscc_reserve_nng_arcs(out_nng,
+			                                num_ok_queries * k,
+			                                (num_ok_queries + num_ok_block) * k,
+			                                len_query_indices * k)) != SCC_ER_OK) {
+				break;
+			}
 
-		scc_PointIndex i = 0;
-		const scc_PointIndex* const ok_q_stop = ok_q + num_ok_queries;
-		for (; ok_q < ok_q_stop; ++ok_q) {
-			for (; i < *ok_q; ++i) {
-				*write_tail_ptr = *(write_tail_ptr - 1);
-				++write_tail_ptr;
+			memcpy(out_nng->head + num_ok_queries * k,
+			       iscc_nng_block_nn_indices(&block_search, b),
+			       sizeof(scc_PointIndex[num_ok_block * k]));
+			if (radius_search && (out_query_indices != NULL)) {
+				memcpy(out_query_indices + num_ok_queries, ok_q, sizeof(scc_PointIndex[num_ok_block]));
+			}
+
+			for (size_t q = 0; q < num_ok_block; ++q) {
+				for (; next_tail < ok_q[q]; ++next_tail) {
+					out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_ok_queries * k);
+				}
+				++num_ok_queries;
+				out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_ok_queries * k);
+				++next_tail;
 			}
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
-			++i;
-		}
-	} else {
-		assert(!radius_search && query_indices == NULL);
-		assert(len_query_indices == num_ok_queries);
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
 		}
+
+		if (ec != SCC_ER_OK) break;
 	}
 
-	for (; write_tail_ptr < write_tail_ptr_stop; ++write_tail_ptr) {
-		*write_tail_ptr = *(write_tail_ptr - 1);
+	iscc_free_nng_block_search(&block_search);
+
+	if (ec != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		return ec;
 	}
 
-	if (internal_out_query_indices != NULL) {
-		assert(radius_search);
-		assert(out_query_indices == NULL);
-		free(internal_out_query_indices);
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed.
+	for (; next_tail < num_data_points_pi; ++next_tail) {
+		out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_ok_queries * k);
 	}
 
-	if (len_query_indices > num_ok_queries) {
-		assert(radius_search);
-		if ((ec = iscc_change_arc_storage(out_nng, num_ok_queries * k)) != SCC_ER_OK) {
-			iscc_free_digraph(out_nng);
-			return ec;
-		}
+	if ((ec = iscc_change_arc_storage(out_nng, num_ok_queries * k)) != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		return ec;
 	}
 
 	if (out_len_query_indices != NULL) {
@@ -806,47 +1151,886 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 }
 
 
-static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
-                                          const size_t len_search_indices,
-                                          const scc_PointIndex search_indices[const])
+static scc_ErrorCode iscc_estimate_radius_ok_queries(iscc_NNSearchObject* const nn_search_object,
+                                                     const size_t len_query_indices,
+                                                     const scc_PointIndex query_indices[const],
+                                                     const uint32_t k,
+                                                     const double radius,
+                                                     size_t* const out_estimate)
 {
-	assert(iscc_digraph_is_valid(nng));
-	assert(!iscc_digraph_is_empty(nng));
-	assert(len_search_indices > 0);
+	assert(nn_search_object != NULL);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(radius > 0.0);
+	assert(out_estimate != NULL);
 
-	/* When there's identical data points, `iscc_nearest_neighbor_search_digraph` may not
-	 * return a self-loop when a query is a search point. The NNG clustering functions
-	 * require this. However, if all data points are unique, or the query and search sets
-	 * are disjoint, it's safe to call `iscc_make_nng` without `iscc_ensure_self_match`. */
+	// Not worth probing small query sets
+	if (len_query_indices <= 2 * ISCC_RADIUS_PROBE_SAMPLE) {
+		*out_estimate = len_query_indices;
+		return iscc_no_error();
+	}
 
-	if (search_indices == NULL) {
-		assert(len_search_indices <= ISCC_POINTINDEX_MAX);
-		const scc_PointIndex len_search_indices_pi = (scc_PointIndex) len_search_indices; // If `scc_PointIndex` is signed.
-		for (scc_PointIndex search_point = 0; search_point < len_search_indices_pi; ++search_point) {
-			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
-			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
-				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
-				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
-			}
-		}
+	scc_PointIndex* const sample_queries = malloc(sizeof(scc_PointIndex[ISCC_RADIUS_PROBE_SAMPLE]));
+	scc_PointIndex* const sample_ok_queries = malloc(sizeof(scc_PointIndex[ISCC_RADIUS_PROBE_SAMPLE]));
+	scc_PointIndex* const sample_nn_indices = malloc(sizeof(scc_PointIndex[ISCC_RADIUS_PROBE_SAMPLE * k]));
+	if ((sample_queries == NULL) || (sample_ok_queries == NULL) || (sample_nn_indices == NULL)) {
+		free(sample_queries);
+		free(sample_ok_queries);
+		free(sample_nn_indices);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
 
-	} else if (search_indices != NULL) {
-		for (size_t s = 0; s < len_search_indices; ++s) {
-			const scc_PointIndex search_point = search_indices[s];
-			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
-			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
-				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
-				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
-			}
+	const size_t step = len_query_indices / ISCC_RADIUS_PROBE_SAMPLE;
+	for (size_t i = 0; i < ISCC_RADIUS_PROBE_SAMPLE; ++i) {
+		if (query_indices == NULL) {
+			sample_queries[i] = (scc_PointIndex) (i * step);
+		} else {
+			sample_queries[i] = query_indices[i * step];
 		}
 	}
-}
 
+	size_t num_ok_sample = 0;
+	const bool search_ok = iscc_nearest_neighbor_search(nn_search_object,
+	                                                    ISCC_RADIUS_PROBE_SAMPLE,
+	                                                    sample_queries,
+	                                                    k,
+	                                                    true,
+	                                                    radius,
+	                                                    &num_ok_sample,
+	                                                    sample_ok_queries,
+	                                                    sample_nn_indices);
 
-static scc_ErrorCode iscc_type_count(const size_t num_data_points,
-                                     const uint32_t size_constraint,
+	free(sample_queries);
+	free(sample_ok_queries);
+	free(sample_nn_indices);
+
+	if (!search_ok) return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+
+	assert(num_ok_sample <= ISCC_RADIUS_PROBE_SAMPLE);
+	*out_estimate = num_ok_sample * (step + 1);
+	if (*out_estimate > len_query_indices) *out_estimate = len_query_indices;
+
+	return iscc_no_error();
+}
+
+
+static inline scc_ErrorCode iscc_reserve_nng_arcs(iscc_Digraph* const nng,
+                                                  const size_t arcs_written,
+                                                  const size_t min_arcs,
+                                                  const size_t max_arcs)
+{
+	assert(iscc_digraph_is_initialized(nng));
+	assert(arcs_written <= nng->max_arcs);
+	assert(arcs_written <= min_arcs);
+	assert(min_arcs <= max_arcs);
+
+	if (nng->max_arcs >= min_arcs) return iscc_no_error();
+
+	size_t new_max_arcs = nng->max_arcs + (nng->max_arcs >> 1);
+	if (new_max_arcs < min_arcs) new_max_arcs = min_arcs;
+	if (new_max_arcs > max_arcs) new_max_arcs = max_arcs;
+
+	// `tail_ptr` is incomplete during construction, let the last entry reflect what's written
+	nng->tail_ptr[nng->vertices] = (iscc_ArcIndex) arcs_written;
+
+	return iscc_change_arc_storage(nng, new_max_arcs);
+}
+
+
+static scc_ErrorCode iscc_init_nng_block_search(iscc_NNSearchObject* const nn_search_object,
+                                                const size_t len_query_indices,
+                                                const scc_PointIndex query_indices[const],
+                                                const uint32_t k,
+                                                const bool radius_search,
+                                                const double radius,
+                                                const bool finalize_loopless,
+                                                iscc_NNGBlockSearch* const out_block_search)
+{
+	assert(nn_search_object != NULL);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(!finalize_loopless || (k >= 2));
+	assert(!radius_search || (radius > 0.0));
+	assert(out_block_search != NULL);
+
+	// The blocks may be searched in the bodies of a parallel loop, so the object is prepared for all queries now
+	if (!iscc_expect_nn_queries(nn_search_object, len_query_indices)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	const size_t block_size = (ISCC_NNG_BLOCK_ARCS > k) ? (ISCC_NNG_BLOCK_ARCS / k) : 1;
+	const size_t num_blocks = (len_query_indices + block_size - 1) / block_size;
+	const size_t len_block_store = (len_query_indices < block_size) ? len_query_indices : block_size;
+
+	// Without a parallel loop, one block at a time keeps the scratch in cache
+	size_t blocks_per_round = iscc_parallel_for_is_set() ? ISCC_NNG_PARALLEL_BLOCKS : 1;
+	if (blocks_per_round > num_blocks) blocks_per_round = num_blocks;
+
+	*out_block_search = (iscc_NNGBlockSearch) {
+		.nn_search_object = nn_search_object,
+		.len_query_indices = len_query_indices,
+		.query_indices = query_indices,
+		.k = k,
+		.radius_search = radius_search,
+		.radius = radius,
+		.finalize_loopless = finalize_loopless,
+		.block_size = block_size,
+		.num_blocks = num_blocks,
+		.blocks_per_round = blocks_per_round,
+		.round_first_block = 0,
+		.block_queries = NULL,
+		.block_ok_queries = NULL,
+		.block_nn_indices = malloc(sizeof(scc_PointIndex[blocks_per_round * len_block_store * k])),
+		.block_num_ok = malloc(sizeof(size_t[blocks_per_round])),
+		.block_search_ok = malloc(sizeof(bool[blocks_per_round])),
+	};
+
+	if (query_indices == NULL) {
+		out_block_search->block_queries = malloc(sizeof(scc_PointIndex[blocks_per_round * len_block_store]));
+	}
+	if (radius_search) {
+		out_block_search->block_ok_queries = malloc(sizeof(scc_PointIndex[blocks_per_round * len_block_store]));
+	}
+
+	if ((out_block_search->block_nn_indices == NULL) ||
+	        (out_block_search->block_num_ok == NULL) ||
+	        (out_block_search->block_search_ok == NULL) ||
+	        ((query_indices == NULL) && (out_block_search->block_queries == NULL)) ||
+	        (radius_search && (out_block_search->block_ok_queries == NULL))) {
+		iscc_free_nng_block_search(out_block_search);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	return iscc_no_error();
+}
+
+
+static void iscc_free_nng_block_search(iscc_NNGBlockSearch* const block_search)
+{
+	if (block_search != NULL) {
+		free(block_search->block_queries);
+		free(block_search->block_ok_queries);
+		free(block_search->block_nn_indices);
+		free(block_search->block_num_ok);
+		free(block_search->block_search_ok);
+		block_search->block_queries = NULL;
+		block_search->block_ok_queries = NULL;
+		block_search->block_nn_indices = NULL;
+		block_search->block_num_ok = NULL;
+		block_search->block_search_ok = NULL;
+	}
+}
+
+
+static scc_ErrorCode iscc_search_nng_round(iscc_NNGBlockSearch* const block_search,
+                                           const size_t round_first_block,
+                                           size_t* const out_len_round)
+{
+	assert(block_search != NULL);
+	assert(round_first_block < block_search->num_blocks);
+	assert(out_len_round != NULL);
+
+	size_t len_round = block_search->num_blocks - round_first_block;
+	if (len_round > block_search->blocks_per_round) len_round = block_search->blocks_per_round;
+
+	block_search->round_first_block = round_first_block;
+	const bool in_parallel_loop = iscc_parallel_for_dispatches(0, len_round, 1);
+	iscc_set_nn_search_in_parallel_loop(block_search->nn_search_object, in_parallel_loop);
+	iscc_parallel_for(0, len_round, 1, iscc_search_nng_blocks, block_search);
+	iscc_set_nn_search_in_parallel_loop(block_search->nn_search_object, false);
+
+	for (size_t b = 0; b < len_round; ++b) {
+		if (!block_search->block_search_ok[b]) return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	*out_len_round = len_round;
+
+	return iscc_no_error();
+}
+
+
+static void iscc_search_nng_blocks(const size_t begin,
+                                   const size_t end,
+                                   void* const context)
+{
+	iscc_NNGBlockSearch* const block_search = context;
+	assert(block_search != NULL);
+	assert(begin <= end);
+	assert(end <= block_search->blocks_per_round);
+
+	const uint32_t k = block_search->k;
+	for (size_t b = begin; b < end; ++b) {
+		const size_t len_block = iscc_nng_block_len(block_search, b);
+		const size_t block_start = (block_search->round_first_block + b) * block_search->block_size;
+
+		const scc_PointIndex* block_query_indices;
+		if (block_search->query_indices == NULL) {
+			scc_PointIndex* const block_queries = block_search->block_queries + b * block_search->block_size;
+			for (size_t q = 0; q < len_block; ++q) {
+				block_queries[q] = (scc_PointIndex) (block_start + q);
+			}
+			block_query_indices = block_queries;
+		} else {
+			block_query_indices = block_search->query_indices + block_start;
+		}
+
+		scc_PointIndex* block_ok_queries = NULL;
+		if (block_search->radius_search) {
+			block_ok_queries = block_search->block_ok_queries + b * block_search->block_size;
+		}
+		scc_PointIndex* const block_nn_indices = block_search->block_nn_indices + b * block_search->block_size * k;
+
+		size_t num_ok_block = 0;
+		block_search->block_search_ok[b] = iscc_nearest_neighbor_search(block_search->nn_search_object,
+		                                                                len_block,
+		                                                                block_query_indices,
+		                                                                k,
+		                                                                block_search->radius_search,
+		                                                                block_search->radius,
+		                                                                &num_ok_block,
+		                                                                block_ok_queries,
+		                                                                block_nn_indices);
+		block_search->block_num_ok[b] = num_ok_block;
+		if (!block_search->block_search_ok[b]) continue;
+		assert(block_search->radius_search || (num_ok_block == len_block));
+
+		if (block_search->finalize_loopless) {
+			iscc_finalize_loopless_rows(num_ok_block,
+			                            block_search->radius_search ? block_ok_queries : block_query_indices,
+			                            k,
+			                            block_nn_indices);
+		}
+	}
+}
+
+
+static inline size_t iscc_nng_block_len(const iscc_NNGBlockSearch* const block_search,
+                                        const size_t round_block)
+{
+	assert(block_search != NULL);
+	const size_t block_start = (block_search->round_first_block + round_block) * block_search->block_size;
+	assert(block_start < block_search->len_query_indices);
+	const size_t remaining = block_search->len_query_indices - block_start;
+	return (remaining < block_search->block_size) ? remaining : block_search->block_size;
+}
+
+
+static inline const scc_PointIndex* iscc_nng_block_ok_queries(const iscc_NNGBlockSearch* const block_search,
+                                                              const size_t round_block)
+{
+	assert(block_search != NULL);
+	assert(round_block < block_search->blocks_per_round);
+	if (block_search->radius_search) {
+		return block_search->block_ok_queries + round_block * block_search->block_size;
+	} else if (block_search->query_indices == NULL) {
+		return block_search->block_queries + round_block * block_search->block_size;
+	} else {
+		return block_search->query_indices + (block_search->round_first_block + round_block) * block_search->block_size;
+	}
+}
+
+
+static inline const scc_PointIndex* iscc_nng_block_nn_indices(const iscc_NNGBlockSearch* const block_search,
+                                                              const size_t round_block)
+{
+	assert(block_search != NULL);
+	assert(round_block < block_search->blocks_per_round);
+	return block_search->block_nn_indices + round_block * block_search->block_size * block_search->k;
+}
+
+
+static scc_ErrorCode iscc_make_loopless_nng(void* const data_set,
+                                            const size_t num_data_points,
+                                            const size_t len_query_indices,
+                                            const scc_PointIndex query_indices[const],
+                                            const uint32_t k,
+                                            const bool radius_search,
+                                            const double radius,
+                                            iscc_SeedResult* const out_lexical_seeds,
+                                            const bool seed_rows_only,
+                                            iscc_Digraph* const out_nng)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(num_data_points >= k);
+	assert(len_query_indices > 0);
+	assert(k >= 2);
+	assert(!radius_search || (radius > 0.0));
+	assert((out_lexical_seeds == NULL) || (out_lexical_seeds->capacity > 0));
+	assert((out_lexical_seeds == NULL) || (out_lexical_seeds->count == 0));
+	assert((out_lexical_seeds == NULL) || (out_lexical_seeds->seeds == NULL));
+	assert(!seed_rows_only || (out_lexical_seeds != NULL));
+	assert(out_nng != NULL);
+
+	// Same result as `iscc_make_nng` with all points as search set followed by
+	// `iscc_ensure_self_match`, `iscc_delete_loops` and `iscc_sort_nng`, but each
+	// block of queries is finalized directly after its search while still in cache.
+	// If `out_lexical_seeds` is given, the finalized rows are also scanned for lexical
+	// seeds block by block, and, if `seed_rows_only`, rows of non-seeds are dropped.
+
+	iscc_NNSearchObject* nn_search_object;
+	if (!iscc_init_nn_search_object(data_set,
+	                                num_data_points,
+	                                NULL,
+	                                &nn_search_object)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	scc_ErrorCode ec;
+	iscc_NNGBlockSearch block_search;
+	if ((ec = iscc_init_nng_block_search(nn_search_object,
+	                                     len_query_indices,
+	                                     query_indices,
+	                                     k,
+	                                     radius_search,
+	                                     radius,
+	                                     true,
+	                                     &block_search)) != SCC_ER_OK) {
+		iscc_close_nn_search_object(&nn_search_object);
+		return ec;
+	}
+
+	// Each seed marks itself and its `k - 1` neighbors, so there are at most
+	// `num_data_points / k` seed rows plus one unscanned block at any time.
+	// This is also the upper bound when growing the arc storage.
+	size_t max_rows_stored = len_query_indices;
+	if (seed_rows_only && (num_data_points / k + block_search.block_size < max_rows_stored)) {
+		max_rows_stored = num_data_points / k + block_search.block_size;
+	}
+
+	bool* marks = NULL;
+	if (out_lexical_seeds != NULL) {
+		marks = calloc(num_data_points, sizeof(bool));
+		out_lexical_seeds->seeds = malloc(sizeof(scc_PointIndex[out_lexical_seeds->capacity]));
+		if ((marks == NULL) || (out_lexical_seeds->seeds == NULL)) {
+			free(marks);
+			free(out_lexical_seeds->seeds);
+			out_lexical_seeds->seeds = NULL;
+			iscc_free_nng_block_search(&block_search);
+			iscc_close_nn_search_object(&nn_search_object);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+	}
+
+	// With a radius constraint, start from a sampled estimate of the number of ok queries
+	size_t max_rows_initial = max_rows_stored;
+	if (radius_search) {
+		size_t estimated_ok_queries = 0;
+		ec = iscc_estimate_radius_ok_queries(nn_search_object,
+		                                     len_query_indices,
+		                                     query_indices,
+		                                     k,
+		                                     radius,
+		                                     &estimated_ok_queries);
+		estimated_ok_queries += (estimated_ok_queries >> 3) + block_search.block_size;
+		if (estimated_ok_queries < max_rows_initial) max_rows_initial = estimated_ok_queries;
+	}
+
+	if ((ec != SCC_ER_OK) ||
+	        ((ec = iscc_init_digraph(num_data_points,
+	                                 max_rows_initial * k,
+	                                 out_nng)) != SCC_ER_OK)) {
+		free(marks);
+		if (out_lexical_seeds != NULL) {
+			free(out_lexical_seeds->seeds);
+			out_lexical_seeds->seeds = NULL;
+		}
+		iscc_free_nng_block_search(&block_search);
+		iscc_close_nn_search_object(&nn_search_object);
+		return ec;
+	}
+
+	size_t arcs_written = 0;
+	scc_PointIndex next_tail = 0;
+	out_nng->tail_ptr[0] = 0;
+
+	size_t len_round = 0;
+	for (size_t round_first_block = 0; round_first_block < block_search.num_blocks; round_first_block += len_round) {
+		if ((ec = iscc_search_nng_round(&block_search,
+		                                round_first_block,
+		                                &len_round)) != SCC_ER_OK) {
+			break;
+		}
+
+		for (size_t b = 0; b < len_round; ++b) {
+			const size_t num_ok_queries = block_search.block_num_ok[b];
+			const scc_PointIndex* const ok_queries = iscc_nng_block_ok_queries(&block_search, b);
+
+			if ((ec = iscc_reserve_nng_arcs(out_nng,
+			                                arcs_written,
+			                                arcs_written + num_ok_queries * (k - 1),
+			                                max_rows_stored * k)) != SCC_ER_OK) {
+				break;
+			}
+
+			memcpy(out_nng->head + arcs_written,
+			       iscc_nng_block_nn_indices(&block_search, b),
+			       sizeof(scc_PointIndex[num_ok_queries * (k - 1)]));
+
+			const scc_PointIndex block_first_tail = next_tail;
+			for (size_t q = 0; q < num_ok_queries; ++q) {
+				for (; next_tail < ok_queries[q]; ++next_tail) {
+					out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) arcs_written;
+				}
+				arcs_written += k - 1;
+				out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) arcs_written;
+				++next_tail;
+			}
+
+			if (out_lexical_seeds != NULL) {
+				// All rows before `next_tail` are final, so they can be scanned now
+				const size_t num_seeds_before = out_lexical_seeds->count;
+				if ((ec = iscc_find_seeds_lexical_rows(out_nng,
+				                                       block_first_tail,
+				                                       next_tail,
+				                                       marks,
+				                                       out_lexical_seeds)) != SCC_ER_OK) {
+					break;
+				}
+
+				if (seed_rows_only) {
+					const scc_PointIndex* block_seed = out_lexical_seeds->seeds + num_seeds_before;
+					const scc_PointIndex* const block_seed_stop = out_lexical_seeds->seeds + out_lexical_seeds->count;
+					iscc_ArcIndex write_arc = out_nng->tail_ptr[block_first_tail];
+					iscc_ArcIndex read_arc = write_arc;
+					for (scc_PointIndex v = block_first_tail; v < next_tail; ++v) {
+						const iscc_ArcIndex read_arc_stop = out_nng->tail_ptr[v + 1];
+						if ((block_seed != block_seed_stop) && (*block_seed == v)) {
+							memmove(out_nng->head + write_arc,
+							        out_nng->head + read_arc,
+							        sizeof(scc_PointIndex[read_arc_stop - read_arc]));
+							write_arc += read_arc_stop - read_arc;
+							++block_seed;
+						}
+						out_nng->tail_ptr[v + 1] = write_arc;
+						read_arc = read_arc_stop;
+					}
+					assert(block_seed == block_seed_stop);
+					arcs_written = write_arc;
+				}
+			}
+		}
+
+		if (ec != SCC_ER_OK) break;
+	}
+
+	free(marks);
+	iscc_free_nng_block_search(&block_search);
+
+	if (ec != SCC_ER_OK) {
+		if (out_lexical_seeds != NULL) {
+			free(out_lexical_seeds->seeds);
+			out_lexical_seeds->seeds = NULL;
+		}
+		iscc_free_digraph(out_nng);
+		iscc_close_nn_search_object(&nn_search_object);
+		return ec;
+	}
+
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed.
+	for (; next_tail < num_data_points_pi; ++next_tail) {
+		out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) arcs_written;
+	}
+
+	if (!iscc_close_nn_search_object(&nn_search_object)) {
+		if (out_lexical_seeds != NULL) {
+			free(out_lexical_seeds->seeds);
+			out_lexical_seeds->seeds = NULL;
+		}
+		iscc_free_digraph(out_nng);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	if ((ec = iscc_change_arc_storage(out_nng, arcs_written)) != SCC_ER_OK) {
+		if (out_lexical_seeds != NULL) {
+			free(out_lexical_seeds->seeds);
+			out_lexical_seeds->seeds = NULL;
+		}
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_search_nearest_neighbors(iscc_NNSearchObject* const nn_search_object,
+                                                   const size_t len_query_indices,
+                                                   const scc_PointIndex query_indices[const],
+                                                   const bool loopless,
+                                                   const bool radius_search,
+                                                   const double radius,
+                                                   scc_PointIndex out_nn[const])
+{
+	assert(nn_search_object != NULL);
+	assert(len_query_indices > 0);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_nn != NULL);
+
+	// A loopless search looks for two neighbors and drops the query itself,
+	// as in `iscc_make_loopless_nng`. Either way, a single neighbor remains per row.
+	scc_ErrorCode ec;
+	iscc_NNGBlockSearch block_search;
+	if ((ec = iscc_init_nng_block_search(nn_search_object,
+	                                     len_query_indices,
+	                                     query_indices,
+	                                     loopless ? 2 : 1,
+	                                     radius_search,
+	                                     radius,
+	                                     loopless,
+	                                     &block_search)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	size_t len_round = 0;
+	for (size_t round_first_block = 0; round_first_block < block_search.num_blocks; round_first_block += len_round) {
+		if ((ec = iscc_search_nng_round(&block_search,
+		                                round_first_block,
+		                                &len_round)) != SCC_ER_OK) {
+			break;
+		}
+
+		for (size_t b = 0; b < len_round; ++b) {
+			const scc_PointIndex* const ok_queries = iscc_nng_block_ok_queries(&block_search, b);
+			const scc_PointIndex* const nn_indices = iscc_nng_block_nn_indices(&block_search, b);
+			for (size_t q = 0; q < block_search.block_num_ok[b]; ++q) {
+				assert(!loopless || (nn_indices[q] != ok_queries[q]));
+				out_nn[ok_queries[q]] = nn_indices[q];
+			}
+		}
+	}
+
+	iscc_free_nng_block_search(&block_search);
+
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_make_bipartite_nng(void* const data_set,
+                                             const size_t num_data_points,
+                                             const uint32_t size_constraint,
+                                             const scc_TypeLabel type_labels[const],
+                                             const size_t len_query_indices,
+                                             const scc_PointIndex query_indices[const],
+                                             const bool radius_constraint,
+                                             const double radius,
+                                             iscc_Digraph* const out_nng)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(num_data_points >= 2);
+	assert(size_constraint <= num_data_points);
+	assert(size_constraint >= 2);
+	assert(type_labels != NULL);
+	assert(len_query_indices > 0);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(out_nng != NULL);
+
+	/* With two types and unit type constraints, a query's own type is always
+	 * satisfied by the query itself, so only the other type must be searched.
+	 * The NNG is then, in order, the nearest point of the other type followed by
+	 * the `size_constraint - 2` nearest points among the remaining points. This
+	 * is the same graph as the general type constrained NNG, without building
+	 * per-type NNGs and their unions. */
+
+	const uint32_t type_constraints[2] = { 1, 1 };
+	scc_ErrorCode ec;
+	iscc_TypeCount tc;
+	if ((ec = iscc_type_count(num_data_points,
+	                          size_constraint,
+	                          2,
+	                          type_constraints,
+	                          type_labels,
+	                          &tc)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	scc_PointIndex* const cross_nn = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const type_queries = malloc(sizeof(scc_PointIndex[len_query_indices]));
+	if ((cross_nn == NULL) || (type_queries == NULL)) {
+		free(tc.type_group_size);
+		free(tc.point_store);
+		free(tc.type_groups);
+		free(cross_nn);
+		free(type_queries);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Points that are not queries, or lack a neighbor of the other type within the radius, point to themselves
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed.
+	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+		cross_nn[i] = i;
+	}
+
+	for (uint_fast16_t t = 0; t < 2; ++t) {
+		size_t len_type_queries = 0;
+		if (query_indices == NULL) {
+			for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+				type_queries[len_type_queries] = i;
+				len_type_queries += (type_labels[i] == (scc_TypeLabel) t);
+			}
+		} else {
+			for (size_t i = 0; i < len_query_indices; ++i) {
+				type_queries[len_type_queries] = query_indices[i];
+				len_type_queries += (type_labels[query_indices[i]] == (scc_TypeLabel) t);
+			}
+		}
+		if (len_type_queries == 0) continue;
+
+		iscc_NNSearchObject* nn_search_object;
+		if (!iscc_init_nn_search_object(data_set,
+		                                tc.type_group_size[1 - t],
+		                                tc.type_groups[1 - t],
+		                                &nn_search_object)) {
+			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			break;
+		}
+
+		ec = iscc_search_nearest_neighbors(nn_search_object,
+		                                   len_type_queries,
+		                                   type_queries,
+		                                   false,
+		                                   radius_constraint,
+		                                   radius,
+		                                   cross_nn);
+
+		if (!iscc_close_nn_search_object(&nn_search_object) && (ec == SCC_ER_OK)) {
+			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+		if (ec != SCC_ER_OK) break;
+	}
+
+	free(tc.type_group_size);
+	free(tc.point_store);
+	free(tc.type_groups);
+
+	if (ec != SCC_ER_OK) {
+		free(cross_nn);
+		free(type_queries);
+		return ec;
+	}
+
+	// Queries with a neighbor of the other type, in order
+	scc_PointIndex* const ok_queries = type_queries;
+	size_t num_ok_queries = 0;
+	if (query_indices == NULL) {
+		for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+			ok_queries[num_ok_queries] = i;
+			num_ok_queries += (cross_nn[i] != i);
+		}
+	} else {
+		for (size_t i = 0; i < len_query_indices; ++i) {
+			ok_queries[num_ok_queries] = query_indices[i];
+			num_ok_queries += (cross_nn[query_indices[i]] != query_indices[i]);
+		}
+	}
+
+	if (num_ok_queries == 0) {
+		free(cross_nn);
+		free(type_queries);
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	const uint32_t row_len = size_constraint - 1;
+	if ((ec = iscc_init_digraph(num_data_points,
+	                            num_ok_queries * row_len,
+	                            out_nng)) != SCC_ER_OK) {
+		free(cross_nn);
+		free(type_queries);
+		return ec;
+	}
+
+	size_t num_rows = 0;
+	scc_PointIndex next_tail = 0;
+	out_nng->tail_ptr[0] = 0;
+
+	if (size_constraint == 2) {
+		for (size_t q = 0; q < num_ok_queries; ++q) {
+			for (; next_tail < ok_queries[q]; ++next_tail) {
+				out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) num_rows;
+			}
+			out_nng->head[num_rows] = cross_nn[ok_queries[q]];
+			++num_rows;
+			out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) num_rows;
+			++next_tail;
+		}
+
+	} else {
+		// Fill the rows with the nearest points of any type, skipping the query and its cross-type neighbor
+		iscc_NNSearchObject* nn_search_object;
+		if (!iscc_init_nn_search_object(data_set,
+		                                num_data_points,
+		                                NULL,
+		                                &nn_search_object)) {
+			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+
+		iscc_NNGBlockSearch block_search;
+		if ((ec == SCC_ER_OK) &&
+		        ((ec = iscc_init_nng_block_search(nn_search_object,
+		                                          num_ok_queries,
+		                                          ok_queries,
+		                                          size_constraint,
+		                                          radius_constraint,
+		                                          radius,
+		                                          false,
+		                                          &block_search)) != SCC_ER_OK)) {
+			iscc_close_nn_search_object(&nn_search_object);
+		}
+
+		if (ec == SCC_ER_OK) {
+			size_t len_round = 0;
+			for (size_t round_first_block = 0; round_first_block < block_search.num_blocks; round_first_block += len_round) {
+				if ((ec = iscc_search_nng_round(&block_search,
+				                                round_first_block,
+				                                &len_round)) != SCC_ER_OK) {
+					break;
+				}
+
+				for (size_t b = 0; b < len_round; ++b) {
+					const scc_PointIndex* const ok_q = iscc_nng_block_ok_queries(&block_search, b);
+					const scc_PointIndex* nn_row = iscc_nng_block_nn_indices(&block_search, b);
+					for (size_t q = 0; q < block_search.block_num_ok[b]; ++q, nn_row += size_constraint) {
+						for (; next_tail < ok_q[q]; ++next_tail) {
+							out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_rows * row_len);
+						}
+
+						scc_PointIndex* row_write = out_nng->head + num_rows * row_len;
+						const scc_PointIndex* const row_write_stop = row_write + row_len;
+						*row_write = cross_nn[ok_q[q]];
+						++row_write;
+						for (const scc_PointIndex* nn = nn_row; row_write != row_write_stop; ++nn) {
+							assert(nn != nn_row + size_constraint);
+							if ((*nn != ok_q[q]) && (*nn != cross_nn[ok_q[q]])) {
+								*row_write = *nn;
+								++row_write;
+							}
+						}
+
+						++num_rows;
+						out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_rows * row_len);
+						++next_tail;
+					}
+				}
+			}
+
+			iscc_free_nng_block_search(&block_search);
+
+			if (!iscc_close_nn_search_object(&nn_search_object) && (ec == SCC_ER_OK)) {
+				ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+		}
+	}
+
+	free(cross_nn);
+	free(type_queries);
+
+	for (; (ec == SCC_ER_OK) && (next_tail < num_data_points_pi); ++next_tail) {
+		out_nng->tail_ptr[next_tail + 1] = (iscc_ArcIndex) (num_rows * row_len);
+	}
+
+	if ((ec == SCC_ER_OK) && (num_rows == 0)) {
+		ec = iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	if (ec == SCC_ER_OK) {
+		ec = iscc_change_arc_storage(out_nng, num_rows * row_len);
+	}
+
+	if (ec != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	return iscc_no_error();
+}
+
+
+static inline void iscc_finalize_loopless_rows(const size_t num_rows,
+                                               const scc_PointIndex row_queries[const],
+                                               const uint32_t k,
+                                               scc_PointIndex* const in_out_head)
+{
+	assert(row_queries != NULL || num_rows == 0);
+	assert(k >= 2);
+	assert(in_out_head != NULL);
+
+	// Each row of `k` arcs is compacted to `k - 1` arcs. The self-loop is dropped if
+	// it exists, otherwise the farthest neighbor (which `iscc_ensure_self_match` would
+	// have replaced with a self-loop). Writes never overtake reads.
+
+	const scc_PointIndex* read = in_out_head;
+	scc_PointIndex* write = in_out_head;
+	for (size_t r = 0; r < num_rows; ++r) {
+		const scc_PointIndex query = row_queries[r];
+		const scc_PointIndex* const read_stop = read + k;
+		scc_PointIndex* const write_row = write;
+		const scc_PointIndex* const write_stop = write + k - 1;
+		for (; (read != read_stop) && (*read != query); ++read, ++write) {
+			if (write == write_stop) break;
+			*write = *read;
+		}
+		if (write != write_stop) {
+			// Self-loop found at `read`, skip it and copy the remainder
+			assert(*read == query);
+			for (++read; read != read_stop; ++read, ++write) {
+				*write = *read;
+			}
+		}
+		read = read_stop;
+		assert(write == write_stop);
+
+		#ifdef SCC_STABLE_NNG
+			qsort(write_row, k - 1, sizeof(scc_PointIndex), iscc_compare_PointIndex);
+		#else
+			(void) write_row;
+		#endif // ifdef SCC_STABLE_NNG
+	}
+}
+
+
+static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
+                                          const size_t len_search_indices,
+                                          const scc_PointIndex search_indices[const])
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(len_search_indices > 0);
+
+	/* When there's identical data points, `iscc_nearest_neighbor_search_digraph` may not
+	 * return a self-loop when a query is a search point. The NNG clustering functions
+	 * require this. However, if all data points are unique, or the query and search sets
+	 * are disjoint, it's safe to call `iscc_make_nng` without `iscc_ensure_self_match`. */
+
+	if (search_indices == NULL) {
+		assert(len_search_indices <= ISCC_POINTINDEX_MAX);
+		const scc_PointIndex len_search_indices_pi = (scc_PointIndex) len_search_indices; // If `scc_PointIndex` is signed.
+		for (scc_PointIndex search_point = 0; search_point < len_search_indices_pi; ++search_point) {
+			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
+			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
+			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
+				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
+				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
+			}
+		}
+
+	} else if (search_indices != NULL) {
+		for (size_t s = 0; s < len_search_indices; ++s) {
+			const scc_PointIndex search_point = search_indices[s];
+			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
+			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
+			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
+				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
+				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
+			}
+		}
+	}
+}
+
+
+static scc_ErrorCode iscc_type_count(const size_t num_data_points,
+                                     const uint32_t size_constraint,
                                      const uint_fast16_t num_types,
                                      const uint32_t type_constraints[const static num_types],
                                      const scc_TypeLabel type_labels[const static num_data_points],
@@ -994,7 +2178,7 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
                                               iscc_NNSearchObject* const nn_search_object,
                                               const size_t num_to_assign,
-                                              scc_PointIndex to_assign[restrict const static num_to_assign],
+                                              const scc_PointIndex to_assign[restrict const static num_to_assign],
                                               const bool radius_constraint,
                                               const double radius)
 {
@@ -1004,43 +2188,108 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 	assert(to_assign != NULL);
 	assert(!radius_constraint || (radius > 0.0));
 
-	size_t num_ok_queries = 0;
-	scc_PointIndex* out_ok_query = NULL;
+	// With a radius constraint, each block writes its ok queries to the start of its own range of
+	// `ok_queries`, which is separate from `to_assign` as the search function may not alias them
+	const size_t num_blocks = (num_to_assign + ISCC_ASSIGN_BLOCK_QUERIES - 1) / ISCC_ASSIGN_BLOCK_QUERIES;
+	iscc_AssignSearch assign_search = {
+		.nn_search_object = nn_search_object,
+		.num_to_assign = num_to_assign,
+		.to_assign = to_assign,
+		.radius_constraint = radius_constraint,
+		.radius = radius,
+		.ok_queries = NULL,
+		.nn_indices = malloc(sizeof(scc_PointIndex[num_to_assign])),
+		.block_num_ok = malloc(sizeof(size_t[num_blocks])),
+		.block_search_ok = malloc(sizeof(bool[num_blocks])),
+	};
 	if (radius_constraint) {
-		out_ok_query = to_assign;
-	}
-	scc_PointIndex* const out_nn_indices = malloc(sizeof(scc_PointIndex[num_to_assign]));
-
-	if (!iscc_nearest_neighbor_search(nn_search_object,
-	                                  num_to_assign,
-	                                  to_assign,
-	                                  1,
-	                                  radius_constraint,
-	                                  radius,
-	                                  &num_ok_queries,
-	                                  out_ok_query,
-	                                  out_nn_indices)) {
-		free(out_nn_indices);
+		assign_search.ok_queries = malloc(sizeof(scc_PointIndex[num_to_assign]));
+	}
+	if ((assign_search.nn_indices == NULL) ||
+	        (assign_search.block_num_ok == NULL) ||
+	        (assign_search.block_search_ok == NULL) ||
+	        (radius_constraint && (assign_search.ok_queries == NULL))) {
+		free(assign_search.ok_queries);
+		free(assign_search.nn_indices);
+		free(assign_search.block_num_ok);
+		free(assign_search.block_search_ok);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (!iscc_expect_nn_queries(nn_search_object, num_to_assign)) {
+		free(assign_search.ok_queries);
+		free(assign_search.nn_indices);
+		free(assign_search.block_num_ok);
+		free(assign_search.block_search_ok);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	if (!radius_constraint) {
-		assert(num_ok_queries == num_to_assign);
-		out_ok_query = to_assign;
+	const bool in_parallel_loop = iscc_parallel_for_dispatches(0, num_blocks, 1);
+	iscc_set_nn_search_in_parallel_loop(nn_search_object, in_parallel_loop);
+	iscc_parallel_for(0, num_blocks, 1, iscc_assign_search_blocks, &assign_search);
+	iscc_set_nn_search_in_parallel_loop(nn_search_object, false);
+
+	for (size_t b = 0; b < num_blocks; ++b) {
+		if (!assign_search.block_search_ok[b]) {
+			free(assign_search.ok_queries);
+			free(assign_search.nn_indices);
+			free(assign_search.block_num_ok);
+			free(assign_search.block_search_ok);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
 	}
 
-	for (size_t i = 0; i < num_ok_queries; ++i) {
-		assert(clustering->cluster_label[out_ok_query[i]] == SCC_CLABEL_NA);
-		assert(clustering->cluster_label[out_nn_indices[i]] != SCC_CLABEL_NA);
-		clustering->cluster_label[out_ok_query[i]] = clustering->cluster_label[out_nn_indices[i]];
+	const scc_PointIndex* const ok_queries = radius_constraint ? assign_search.ok_queries : to_assign;
+	for (size_t b = 0; b < num_blocks; ++b) {
+		const scc_PointIndex* const ok_query = ok_queries + b * ISCC_ASSIGN_BLOCK_QUERIES;
+		const scc_PointIndex* const nn_indices = assign_search.nn_indices + b * ISCC_ASSIGN_BLOCK_QUERIES;
+		for (size_t i = 0; i < assign_search.block_num_ok[b]; ++i) {
+			assert(clustering->cluster_label[ok_query[i]] == SCC_CLABEL_NA);
+			assert(clustering->cluster_label[nn_indices[i]] != SCC_CLABEL_NA);
+			clustering->cluster_label[ok_query[i]] = clustering->cluster_label[nn_indices[i]];
+		}
 	}
 
-	free(out_nn_indices);
+	free(assign_search.ok_queries);
+	free(assign_search.nn_indices);
+	free(assign_search.block_num_ok);
+	free(assign_search.block_search_ok);
 
 	return iscc_no_error();
 }
 
 
+static void iscc_assign_search_blocks(const size_t begin,
+                                      const size_t end,
+                                      void* const context)
+{
+	iscc_AssignSearch* const assign_search = context;
+	assert(assign_search != NULL);
+	assert(begin <= end);
+
+	for (size_t b = begin; b < end; ++b) {
+		const size_t block_start = b * ISCC_ASSIGN_BLOCK_QUERIES;
+		assert(block_start < assign_search->num_to_assign);
+		const size_t remaining = assign_search->num_to_assign - block_start;
+		const size_t len_block = (remaining < ISCC_ASSIGN_BLOCK_QUERIES) ? remaining : ISCC_ASSIGN_BLOCK_QUERIES;
+		const scc_PointIndex* const block_to_assign = assign_search->to_assign + block_start;
+
+		size_t num_ok_block = 0;
+		assign_search->block_search_ok[b] = iscc_nearest_neighbor_search(assign_search->nn_search_object,
+		                                                                 len_block,
+		                                                                 block_to_assign,
+		                                                                 1,
+		                                                                 assign_search->radius_constraint,
+		                                                                 assign_search->radius,
+		                                                                 &num_ok_block,
+		                                                                 assign_search->radius_constraint ? (assign_search->ok_queries + block_start) : NULL,
+		                                                                 assign_search->nn_indices + block_start);
+		assert(!assign_search->block_search_ok[b] || assign_search->radius_constraint || (num_ok_block == len_block));
+		assign_search->block_num_ok[b] = num_ok_block;
+	}
+}
+
+
 #ifdef SCC_STABLE_NNG
 
 static int iscc_compare_PointIndex(const void* const a, const void* const b)
@@ -26,9 +26,23 @@
 #include <stdint.h>
 #include "../include/scclust.h"
 #include "digraph_core.h"
+#include "dist_search.h"
 #include "nng_findseeds.h"
 
 
+// =============================================================================
+// Structs
+// =============================================================================
+
+// State passed from the primary to the secondary assignment of unassigned points.
+typedef struct iscc_NNGAssignState {
+	size_t num_seed_or_neighbor;
+	scc_PointIndex* seed_or_neighbor;
+	iscc_NNSearchObject* nn_assigned_search_object;
+	iscc_NNSearchObject* nn_seed_search_object;
+} iscc_NNGAssignState;
+
+
 // =============================================================================
 // Function prototypes
 // =============================================================================
@@ -43,6 +57,27 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* data_set,
                                                 iscc_Digraph* out_nng);
 
 
+scc_ErrorCode iscc_get_nng_with_lexical_seeds(void* data_set,
+                                              size_t num_data_points,
+                                              uint32_t size_constraint,
+                                              size_t len_primary_data_points,
+                                              const scc_PointIndex primary_data_points[],
+                                              bool radius_constraint,
+                                              double radius,
+                                              bool seed_rows_only,
+                                              iscc_SeedResult* out_seeds,
+                                              iscc_Digraph* out_nng);
+
+
+scc_ErrorCode iscc_get_nearest_neighbors(void* data_set,
+                                         size_t num_data_points,
+                                         size_t len_query_indices,
+                                         const scc_PointIndex query_indices[],
+                                         bool radius_constraint,
+                                         double radius,
+                                         scc_PointIndex out_nn[]);
+
+
 scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 size_t num_data_points,
                                                 uint32_t size_constraint,
@@ -78,4 +113,32 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* clustering,
                                                 double secondary_radius);
 
 
+// The two steps of `iscc_make_nng_clusters_from_seeds`. `out_assign_state` must be
+// freed with `iscc_free_nng_assign_state` after the secondary step.
+scc_ErrorCode iscc_assign_primary_from_seeds(scc_Clustering* clustering,
+                                             void* data_set,
+                                             const iscc_SeedResult* seed_result,
+                                             iscc_Digraph* nng,
+                                             bool nng_is_ordered,
+                                             scc_UnassignedMethod unassigned_method,
+                                             bool radius_constraint,
+                                             double radius,
+                                             size_t len_primary_data_points,
+                                             const scc_PointIndex primary_data_points[],
+                                             scc_UnassignedMethod secondary_unassigned_method,
+                                             iscc_NNGAssignState* out_assign_state);
+
+
+scc_ErrorCode iscc_assign_secondary_from_seeds(scc_Clustering* clustering,
+                                               void* data_set,
+                                               const iscc_SeedResult* seed_result,
+                                               scc_UnassignedMethod secondary_unassigned_method,
+                                               bool secondary_radius_constraint,
+                                               double secondary_radius,
+                                               iscc_NNGAssignState* assign_state);
+
+
+void iscc_free_nng_assign_state(iscc_NNGAssignState* assign_state);
+
+
 #endif // ifndef SCC_NNG_CORE_HG
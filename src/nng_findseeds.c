@@ -160,17 +160,58 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 	}
 
 	if (ec == SCC_ER_OK) {
-		assert(out_seeds->seeds != NULL);
-		if ((out_seeds->count < out_seeds->capacity) && (out_seeds->count > 0)) {
-			scc_PointIndex* const tmp_seed_ptr = realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
-			if (tmp_seed_ptr != NULL) {
-				out_seeds->seeds = tmp_seed_ptr;
-				out_seeds->capacity = out_seeds->count;
+		iscc_shrink_seed_result(out_seeds);
+	}
+
+	return ec;
+}
+
+
+scc_ErrorCode iscc_find_seeds_lexical_rows(const iscc_Digraph* const nng,
+                                           const scc_PointIndex rows_begin,
+                                           const scc_PointIndex rows_end,
+                                           bool marks[const],
+                                           iscc_SeedResult* const in_out_seeds)
+{
+	assert(iscc_digraph_is_initialized(nng));
+	assert(rows_begin <= rows_end);
+	assert(((size_t) rows_end) <= nng->vertices);
+	assert(marks != NULL);
+	assert(in_out_seeds != NULL);
+	assert(in_out_seeds->capacity > 0);
+	assert(in_out_seeds->seeds != NULL);
+
+	// Only rows before `rows_end` are accessed, so the remaining
+	// rows of `nng` need not be constructed yet.
+	scc_ErrorCode ec;
+	for (scc_PointIndex v = rows_begin; v < rows_end; ++v) {
+		if (iscc_fs_check_neighbors_marks(v, nng, marks)) {
+			assert(nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
+
+			if ((ec = iscc_fs_add_seed(v, in_out_seeds)) != SCC_ER_OK) {
+				return ec;
 			}
+
+			iscc_fs_mark_seed_neighbors(v, nng, marks);
 		}
 	}
 
-	return ec;
+	return iscc_no_error();
+}
+
+
+void iscc_shrink_seed_result(iscc_SeedResult* const seed_result)
+{
+	assert(seed_result != NULL);
+	assert(seed_result->seeds != NULL);
+
+	if ((seed_result->count < seed_result->capacity) && (seed_result->count > 0)) {
+		scc_PointIndex* const tmp_seed_ptr = realloc(seed_result->seeds, sizeof(scc_PointIndex[seed_result->count]));
+		if (tmp_seed_ptr != NULL) {
+			seed_result->seeds = tmp_seed_ptr;
+			seed_result->capacity = seed_result->count;
+		}
+	}
 }
 
 
@@ -197,26 +238,17 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* const nng,
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	scc_ErrorCode ec;
 	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
-	for (scc_PointIndex v = 0; v < vertices; ++v) {
-		if (iscc_fs_check_neighbors_marks(v, nng, marks)) {
-			assert(nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
-
-			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
-				free(marks);
-				free(out_seeds->seeds);
-				return ec;
-			}
-
-			iscc_fs_mark_seed_neighbors(v, nng, marks);
-		}
-	}
+	const scc_ErrorCode ec = iscc_find_seeds_lexical_rows(nng, 0, vertices, marks, out_seeds);
 
 	free(marks);
+	if (ec != SCC_ER_OK) {
+		free(out_seeds->seeds);
+		out_seeds->seeds = NULL;
+	}
 
-	return iscc_no_error();
+	return ec;
 }
 
 
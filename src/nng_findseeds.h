@@ -21,6 +21,7 @@
 #ifndef SCC_NNG_FINDSEEDS_HG
 #define SCC_NNG_FINDSEEDS_HG
 
+#include <stdbool.h>
 #include <stddef.h>
 #include "../include/scclust.h"
 #include "digraph_core.h"
@@ -47,4 +48,14 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* nng,
                               iscc_SeedResult* out_seeds);
 
 
+scc_ErrorCode iscc_find_seeds_lexical_rows(const iscc_Digraph* nng,
+                                           scc_PointIndex rows_begin,
+                                           scc_PointIndex rows_end,
+                                           bool marks[],
+                                           iscc_SeedResult* in_out_seeds);
+
+
+void iscc_shrink_seed_result(iscc_SeedResult* seed_result);
+
+
 #endif // ifndef SCC_NNG_FINDSEEDS_HG
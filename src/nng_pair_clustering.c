@@ -0,0 +1,157 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "nng_pair_clustering.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "clustering_struct.h"
+#include "dist_search.h"
+#include "error.h"
+#include "nng_core.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_use_pair_clustering(const scc_ClusterOptions* const options)
+{
+	assert(options != NULL);
+
+	// The engine reproduces `SCC_SM_LEXICAL` seeds with a size constraint of two. Unassigned
+	// points are handled when the nearest neighbor alone decides their cluster.
+	if ((options->size_constraint != 2) ||
+	        (options->num_types >= 2) ||
+	        (options->seed_method != SCC_SM_LEXICAL) ||
+	        (options->secondary_unassigned_method != SCC_UM_IGNORE)) {
+		return false;
+	}
+
+	switch (options->primary_unassigned_method) {
+	case SCC_UM_IGNORE:
+		return true;
+	case SCC_UM_ANY_NEIGHBOR:
+		// An estimated radius is never used here, but its estimation may fail
+		return (options->primary_radius != SCC_RM_USE_ESTIMATED);
+	case SCC_UM_CLOSEST_ASSIGNED:
+		// Without seed radius, all primary points have a nearest neighbor that is assigned
+		return (options->seed_radius == SCC_RM_NO_RADIUS) &&
+		       (options->primary_radius != SCC_RM_USE_ESTIMATED);
+	default:
+		return false;
+	}
+}
+
+
+scc_ErrorCode iscc_nng_clustering_pairs(scc_Clustering* const clustering,
+                                        void* const data_set,
+                                        const scc_UnassignedMethod unassigned_method,
+                                        const bool radius_constraint,
+                                        const double radius,
+                                        const size_t len_primary_data_points,
+                                        const scc_PointIndex primary_data_points[const])
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters == 0);
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(clustering->num_data_points >= 2);
+	assert((unassigned_method == SCC_UM_IGNORE) ||
+	       (unassigned_method == SCC_UM_ANY_NEIGHBOR) ||
+	       (unassigned_method == SCC_UM_CLOSEST_ASSIGNED));
+	assert(!radius_constraint || (radius > 0.0));
+	assert((primary_data_points == NULL) || (len_primary_data_points > 0));
+
+	// With a size constraint of two, the NNG has a single arc per row, so it is
+	// stored as a flat array and the cluster labels double as seed marks.
+	scc_PointIndex* const nn = malloc(sizeof(scc_PointIndex[clustering->num_data_points]));
+	if (nn == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_get_nearest_neighbors(data_set,
+	                                     clustering->num_data_points,
+	                                     (primary_data_points == NULL) ? clustering->num_data_points : len_primary_data_points,
+	                                     primary_data_points,
+	                                     radius_constraint,
+	                                     radius,
+	                                     nn)) != SCC_ER_OK) {
+		free(nn);
+		return ec;
+	}
+
+	// Initialize cluster labels
+	if (clustering->cluster_label == NULL) {
+		clustering->external_labels = false;
+		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		if (clustering->cluster_label == NULL) {
+			free(nn);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+	}
+
+	for (size_t i = 0; i < clustering->num_data_points; ++i) {
+		clustering->cluster_label[i] = SCC_CLABEL_NA;
+	}
+
+	// Lexical seeds: a point is a seed if neither it nor its nearest neighbor is assigned
+	scc_Clabel next_cluster_label = 0;
+	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
+	for (scc_PointIndex i = 0; i < num_data_points; ++i) {
+		if ((nn[i] != i) &&
+		        (clustering->cluster_label[i] == SCC_CLABEL_NA) &&
+		        (clustering->cluster_label[nn[i]] == SCC_CLABEL_NA)) {
+			if (next_cluster_label == SCC_CLABEL_MAX) {
+				free(nn);
+				return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+			}
+			clustering->cluster_label[i] = next_cluster_label;
+			clustering->cluster_label[nn[i]] = next_cluster_label;
+			++next_cluster_label;
+		}
+	}
+
+	if (next_cluster_label == 0) {
+		free(nn);
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	// Points with a nearest neighbor that were not seeds have an assigned nearest neighbor
+	if (unassigned_method != SCC_UM_IGNORE) {
+		for (scc_PointIndex i = 0; i < num_data_points; ++i) {
+			if ((nn[i] != i) && (clustering->cluster_label[i] == SCC_CLABEL_NA)) {
+				assert(clustering->cluster_label[nn[i]] != SCC_CLABEL_NA);
+				clustering->cluster_label[i] = clustering->cluster_label[nn[i]];
+			}
+		}
+	}
+
+	free(nn);
+
+	clustering->num_clusters = (size_t) next_cluster_label;
+
+	return iscc_no_error();
+}
@@ -0,0 +1,76 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_PARALLEL_FOR_HG
+#define SCC_PARALLEL_FOR_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust_spi.h"
+
+
+// =============================================================================
+// Variables
+// =============================================================================
+
+extern scc_parallel_for iscc_parallel_for_function;
+
+
+// =============================================================================
+// Parallel loop functions
+// =============================================================================
+
+static inline bool iscc_parallel_for_is_set(void)
+{
+	return (iscc_parallel_for_function != NULL);
+}
+
+
+// True when `iscc_parallel_for` hands the loop to the registered loop function. Callers
+// use it to tell the objects used by the body that they are called from worker threads.
+static inline bool iscc_parallel_for_dispatches(const size_t begin,
+                                                const size_t end,
+                                                const size_t grain)
+{
+	const size_t use_grain = (grain > 0) ? grain : 1;
+	return (iscc_parallel_for_function != NULL) && (begin < end) && (end - begin > use_grain);
+}
+
+
+// Loops must not be started from within a body. The library guarantees this per call,
+// see `iscc_set_nn_search_in_parallel_loop`, as the host may run several clusterings
+// concurrently.
+static inline void iscc_parallel_for(const size_t begin,
+                                     const size_t end,
+                                     const size_t grain,
+                                     const scc_parallel_for_body body,
+                                     void* const context)
+{
+	if (begin >= end) return;
+	// Loops that fit in one grain are run directly
+	if (iscc_parallel_for_dispatches(begin, end, grain)) {
+		iscc_parallel_for_function(begin, end, (grain > 0) ? grain : 1, body, context);
+	} else {
+		body(begin, end, context);
+	}
+}
+
+
+#endif // ifndef SCC_PARALLEL_FOR_HG
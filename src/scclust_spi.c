@@ -23,6 +23,8 @@
 #include <stddef.h>
 #include "dist_search.h"
 #include "dist_search_imp.h"
+#include "parallel_for.h"
+#include "wall_clock.h"
 
 
 // =============================================================================
@@ -35,8 +37,10 @@ iscc_dist_functions_struct iscc_dist_functions = {
 	.num_data_points = iscc_imp_num_data_points,
 	.get_dist_matrix = iscc_imp_get_dist_matrix,
 	.get_dist_rows = iscc_imp_get_dist_rows,
+	.get_sq_dist_rows = iscc_imp_get_sq_dist_rows,
 	.init_max_dist_object = iscc_imp_init_max_dist_object,
 	.get_max_dist = iscc_imp_get_max_dist,
+	.get_sq_max_dist = iscc_imp_get_sq_max_dist,
 	.close_max_dist_object = iscc_imp_close_max_dist_object,
 	.init_nn_search_object = iscc_imp_init_nn_search_object,
 	.nearest_neighbor_search = iscc_imp_nearest_neighbor_search,
@@ -44,6 +48,12 @@ iscc_dist_functions_struct iscc_dist_functions = {
 };
 
 
+// See "parallel_for.h" for definition. Loops run serially when NULL.
+scc_parallel_for iscc_parallel_for_function = NULL;
+
+// See "wall_clock.h" for definition. Time budgets give only a first clustering when NULL.
+scc_clock iscc_clock_function = NULL;
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -55,8 +65,10 @@ bool scc_reset_dist_functions(void)
 		.num_data_points = iscc_imp_num_data_points,
 		.get_dist_matrix = iscc_imp_get_dist_matrix,
 		.get_dist_rows = iscc_imp_get_dist_rows,
+		.get_sq_dist_rows = iscc_imp_get_sq_dist_rows,
 		.init_max_dist_object = iscc_imp_init_max_dist_object,
 		.get_max_dist = iscc_imp_get_max_dist,
+		.get_sq_max_dist = iscc_imp_get_sq_max_dist,
 		.close_max_dist_object = iscc_imp_close_max_dist_object,
 		.init_nn_search_object = iscc_imp_init_nn_search_object,
 		.nearest_neighbor_search = iscc_imp_nearest_neighbor_search,
@@ -92,6 +104,7 @@ bool scc_set_dist_functions(scc_check_data_set check_data_set,
 
 	if (get_dist_rows != NULL) {
 		iscc_dist_functions.get_dist_rows = get_dist_rows;
+		iscc_dist_functions.get_sq_dist_rows = NULL;
 	}
 
 	if (init_max_dist_object != NULL &&
@@ -99,6 +112,7 @@ bool scc_set_dist_functions(scc_check_data_set check_data_set,
 			close_max_dist_object != NULL) {
 		iscc_dist_functions.init_max_dist_object = init_max_dist_object;
 		iscc_dist_functions.get_max_dist = get_max_dist;
+		iscc_dist_functions.get_sq_max_dist = NULL;
 		iscc_dist_functions.close_max_dist_object = close_max_dist_object;
 	} else if (init_max_dist_object != NULL ||
 			get_max_dist != NULL ||
@@ -120,3 +134,48 @@ bool scc_set_dist_functions(scc_check_data_set check_data_set,
 
 	return true;
 }
+
+
+bool scc_set_sq_dist_functions(scc_get_dist_rows get_sq_dist_rows,
+                               scc_get_max_dist get_sq_max_dist)
+{
+	if (get_sq_dist_rows != NULL) {
+		iscc_dist_functions.get_sq_dist_rows = get_sq_dist_rows;
+	}
+
+	if (get_sq_max_dist != NULL) {
+		iscc_dist_functions.get_sq_max_dist = get_sq_max_dist;
+	}
+
+	return true;
+}
+
+
+bool scc_reset_parallel_for(void)
+{
+	iscc_parallel_for_function = NULL;
+	return true;
+}
+
+
+bool scc_set_parallel_for(scc_parallel_for parallel_for)
+{
+	if (parallel_for == NULL) return false;
+	iscc_parallel_for_function = parallel_for;
+	return true;
+}
+
+
+bool scc_reset_clock(void)
+{
+	iscc_clock_function = NULL;
+	return true;
+}
+
+
+bool scc_set_clock(scc_clock clock)
+{
+	if (clock == NULL) return false;
+	iscc_clock_function = clock;
+	return true;
+}
@@ -0,0 +1,561 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "../include/scclust.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clustering_struct.h"
+#include "digraph_core.h"
+#include "dist_search.h"
+#include "error.h"
+#include "nng_core.h"
+#include "nng_findseeds.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs
+// =============================================================================
+
+// Each point in the window keeps a candidate list of up to `num_candidates` of its nearest
+// other points in the window, sorted by distance and then by slot. The list is always exactly
+// the nearest points, but may be shorter than `num_candidates` after expirations. Its first
+// `size_constraint - 1` entries are the row the point would have in the nearest neighbor
+// graph made by `scc_sc_clustering` on the points in the window. A list shorter than that
+// holds all other points in the window.
+struct scc_SlidingWindow {
+	uint32_t num_dimensions;
+	size_t capacity;
+	uint32_t size_constraint;
+	uint32_t num_candidates;
+	scc_SeedMethod seed_method;
+	scc_UnassignedMethod unassigned_method;
+	double* coordinates;
+	scc_DataSet* data_set;
+	size_t num_points;
+	scc_PointIndex* members;
+	size_t* member_position;
+	size_t num_free_slots;
+	scc_PointIndex* free_slots;
+	uint32_t* num_neighbors;
+	scc_PointIndex* neighbors;
+	double* neighbor_dists;
+	double* row_dists;
+	scc_PointIndex* affected;
+};
+
+
+// Marks slots that are not in the window in `member_position`.
+static const size_t ISCC_SW_NOT_MEMBER = SIZE_MAX;
+
+// Candidates kept per point, as a multiple of the `size_constraint - 1` neighbors needed.
+static const uint32_t ISCC_SW_CANDIDATE_FACTOR = 2;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_sw_find_neighbors(scc_SlidingWindow* window,
+                                            scc_PointIndex slot);
+
+
+static inline bool iscc_sw_offer_neighbor(scc_SlidingWindow* window,
+                                          scc_PointIndex slot,
+                                          scc_PointIndex neighbor,
+                                          double dist,
+                                          bool list_complete);
+
+
+static inline bool iscc_sw_remove_neighbor(scc_SlidingWindow* window,
+                                           scc_PointIndex slot,
+                                           scc_PointIndex neighbor);
+
+
+static inline bool iscc_sw_precedes(double dist1,
+                                    scc_PointIndex slot1,
+                                    double dist2,
+                                    scc_PointIndex slot2);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+scc_ErrorCode scc_init_sliding_window(const uint32_t num_dimensions,
+                                      const uint64_t capacity,
+                                      const uint32_t size_constraint,
+                                      const scc_SeedMethod seed_method,
+                                      const scc_UnassignedMethod unassigned_method,
+                                      scc_SlidingWindow** const out_window)
+{
+	if (out_window == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	// Initialize to null, so subsequent calls to `scc_free_sliding_window` are safe
+	*out_window = NULL;
+	if (num_dimensions == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data sets must have at least one dimension.");
+	}
+	if (size_constraint < 2) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be 2 or greater.");
+	}
+	if (capacity < size_constraint) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Window capacity must be at least the size constraint.");
+	}
+	if ((capacity > ISCC_POINTINDEX_MAX) || (capacity > SIZE_MAX / num_dimensions) ||
+	        (capacity > SIZE_MAX / ISCC_SW_CANDIDATE_FACTOR / size_constraint)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points (adjust the `scc_PointIndex` type).");
+	}
+	if ((seed_method != SCC_SM_LEXICAL) &&
+	        (seed_method != SCC_SM_INWARDS_ORDER) &&
+	        (seed_method != SCC_SM_INWARDS_UPDATING) &&
+	        (seed_method != SCC_SM_EXCLUSION_ORDER) &&
+	        (seed_method != SCC_SM_EXCLUSION_UPDATING)) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Unknown or unsupported seed method.");
+	}
+	if ((unassigned_method != SCC_UM_IGNORE) &&
+	        (unassigned_method != SCC_UM_ANY_NEIGHBOR) &&
+	        (unassigned_method != SCC_UM_CLOSEST_ASSIGNED) &&
+	        (unassigned_method != SCC_UM_CLOSEST_SEED)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown unassigned method.");
+	}
+
+	const size_t cap = (size_t) capacity;
+	// More candidates than other points are never needed
+	uint64_t num_candidates = ((uint64_t) ISCC_SW_CANDIDATE_FACTOR) * (size_constraint - 1);
+	if (num_candidates > capacity - 1) num_candidates = capacity - 1;
+	if (num_candidates > UINT32_MAX) num_candidates = UINT32_MAX;
+	const size_t len_neighbors = cap * num_candidates;
+
+	scc_SlidingWindow* tmp_window = malloc(sizeof(scc_SlidingWindow));
+	if (tmp_window == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	*tmp_window = (scc_SlidingWindow) {
+		.num_dimensions = num_dimensions,
+		.capacity = cap,
+		.size_constraint = size_constraint,
+		.num_candidates = (uint32_t) num_candidates,
+		.seed_method = seed_method,
+		.unassigned_method = unassigned_method,
+		.coordinates = calloc(cap * num_dimensions, sizeof(double)),
+		.data_set = NULL,
+		.num_points = 0,
+		.members = malloc(sizeof(scc_PointIndex[cap])),
+		.member_position = malloc(sizeof(size_t[cap])),
+		.num_free_slots = cap,
+		.free_slots = malloc(sizeof(scc_PointIndex[cap])),
+		.num_neighbors = calloc(cap, sizeof(uint32_t)),
+		.neighbors = malloc(sizeof(scc_PointIndex[len_neighbors])),
+		.neighbor_dists = malloc(sizeof(double[len_neighbors])),
+		.row_dists = malloc(sizeof(double[cap])),
+		.affected = malloc(sizeof(scc_PointIndex[cap])),
+	};
+
+	if ((tmp_window->coordinates == NULL) || (tmp_window->members == NULL) ||
+	        (tmp_window->member_position == NULL) || (tmp_window->free_slots == NULL) ||
+	        (tmp_window->num_neighbors == NULL) || (tmp_window->neighbors == NULL) ||
+	        (tmp_window->neighbor_dists == NULL) || (tmp_window->row_dists == NULL) ||
+	        (tmp_window->affected == NULL)) {
+		scc_free_sliding_window(&tmp_window);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// The data set covers all slots, so slots are point indices in distance queries
+	scc_ErrorCode ec;
+	if ((ec = scc_init_data_set(capacity,
+	                            num_dimensions,
+	                            cap * num_dimensions,
+	                            tmp_window->coordinates,
+	                            &tmp_window->data_set)) != SCC_ER_OK) {
+		scc_free_sliding_window(&tmp_window);
+		return ec;
+	}
+
+	// Slots are handed out in ascending order
+	for (size_t i = 0; i < cap; ++i) {
+		tmp_window->member_position[i] = ISCC_SW_NOT_MEMBER;
+		tmp_window->free_slots[i] = (scc_PointIndex) (cap - 1 - i);
+	}
+
+	*out_window = tmp_window;
+
+	return iscc_no_error();
+}
+
+
+void scc_free_sliding_window(scc_SlidingWindow** const window)
+{
+	if ((window != NULL) && (*window != NULL)) {
+		scc_free_data_set(&(*window)->data_set);
+		free((*window)->coordinates);
+		free((*window)->members);
+		free((*window)->member_position);
+		free((*window)->free_slots);
+		free((*window)->num_neighbors);
+		free((*window)->neighbors);
+		free((*window)->neighbor_dists);
+		free((*window)->row_dists);
+		free((*window)->affected);
+		free(*window);
+		*window = NULL;
+	}
+}
+
+
+scc_ErrorCode scc_window_insert(scc_SlidingWindow* const window,
+                                const double coordinates[const],
+                                uint64_t* const out_slot)
+{
+	if (window == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid sliding window object.");
+	}
+	if (coordinates == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid coordinates.");
+	}
+	if (window->num_free_slots == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Sliding window is full.");
+	}
+
+	const scc_PointIndex slot = window->free_slots[window->num_free_slots - 1];
+	memcpy(window->coordinates + ((size_t) slot) * window->num_dimensions,
+	       coordinates,
+	       sizeof(double[window->num_dimensions]));
+
+	// One row of distances gives both the candidates of the new point and
+	// the points that get the new point as candidate
+	const size_t num_points = window->num_points;
+	if ((num_points > 0) &&
+	        !iscc_get_dist_rows(window->data_set,
+	                            1,
+	                            &slot,
+	                            num_points,
+	                            window->members,
+	                            window->row_dists)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	window->num_neighbors[slot] = 0;
+	for (size_t i = 0; i < num_points; ++i) {
+		const scc_PointIndex p = window->members[i];
+		iscc_sw_offer_neighbor(window, slot, p, window->row_dists[i], true);
+		iscc_sw_offer_neighbor(window, p, slot, window->row_dists[i], (window->num_neighbors[p] == num_points - 1));
+	}
+
+	--(window->num_free_slots);
+	window->member_position[slot] = num_points;
+	window->members[num_points] = slot;
+	++(window->num_points);
+
+	if (out_slot != NULL) *out_slot = (uint64_t) slot;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_window_expire(scc_SlidingWindow* const window,
+                                const uint64_t slot)
+{
+	if (window == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid sliding window object.");
+	}
+	if ((slot >= window->capacity) || (window->member_position[slot] == ISCC_SW_NOT_MEMBER)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Slot is not in the window.");
+	}
+
+	const scc_PointIndex expired = (scc_PointIndex) slot;
+
+	// Remove from the member list by moving the last member into its position
+	const size_t position = window->member_position[expired];
+	const scc_PointIndex last_member = window->members[window->num_points - 1];
+	window->members[position] = last_member;
+	window->member_position[last_member] = position;
+	window->member_position[expired] = ISCC_SW_NOT_MEMBER;
+	--(window->num_points);
+	window->free_slots[window->num_free_slots] = expired;
+	++(window->num_free_slots);
+	window->num_neighbors[expired] = 0;
+
+	// Only points that had the expired point as candidate, and are left with fewer
+	// candidates than neighbors needed, must search again. Lists that hold all other
+	// points are still complete. Finding the points needs no distance calculations.
+	const uint32_t num_needed = window->size_constraint - 1;
+	size_t num_affected = 0;
+	for (size_t i = 0; i < window->num_points; ++i) {
+		const scc_PointIndex p = window->members[i];
+		if (iscc_sw_remove_neighbor(window, p, expired) &&
+		        (window->num_neighbors[p] < num_needed) &&
+		        (window->num_neighbors[p] < window->num_points - 1)) {
+			window->affected[num_affected] = p;
+			++num_affected;
+		}
+	}
+
+	scc_ErrorCode ec;
+	for (size_t a = 0; a < num_affected; ++a) {
+		if ((ec = iscc_sw_find_neighbors(window, window->affected[a])) != SCC_ER_OK) {
+			return ec;
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_window_clustering(scc_SlidingWindow* const window,
+                                    scc_Clustering* const out_clustering)
+{
+	if (window == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid sliding window object.");
+	}
+	if (!iscc_check_input_clustering(out_clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	if (out_clustering->num_data_points != window->capacity) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in clustering object does not match window capacity.");
+	}
+	if (out_clustering->num_clusters != 0) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+	}
+	if (window->num_points < window->size_constraint) {
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points in window than size constraint.");
+	}
+
+	if (out_clustering->cluster_label == NULL) {
+		out_clustering->external_labels = false;
+		out_clustering->cluster_label = malloc(sizeof(scc_Clabel[out_clustering->num_data_points]));
+		if (out_clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// The points in the window are clustered as a data set of their own, ordered by slot.
+	// The graph is read off the neighbor lists, so no distances are calculated for it.
+	const size_t num_points = window->num_points;
+	const uint32_t num_dimensions = window->num_dimensions;
+	const uint32_t num_neighbors = window->size_constraint - 1;
+	scc_PointIndex* const compact_index = malloc(sizeof(scc_PointIndex[window->capacity]));
+	double* const compact_coordinates = malloc(sizeof(double[num_points * num_dimensions]));
+	scc_Clabel* const compact_labels = malloc(sizeof(scc_Clabel[num_points]));
+	if ((compact_index == NULL) || (compact_coordinates == NULL) || (compact_labels == NULL)) {
+		free(compact_index);
+		free(compact_coordinates);
+		free(compact_labels);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_PointIndex next_index = 0;
+	for (size_t slot = 0; slot < window->capacity; ++slot) {
+		if (window->member_position[slot] != ISCC_SW_NOT_MEMBER) {
+			memcpy(compact_coordinates + ((size_t) next_index) * num_dimensions,
+			       window->coordinates + slot * num_dimensions,
+			       sizeof(double[num_dimensions]));
+			compact_index[slot] = next_index;
+			++next_index;
+		}
+	}
+	assert(((size_t) next_index) == num_points);
+
+	scc_ErrorCode ec;
+	iscc_Digraph nng;
+	if ((ec = iscc_init_digraph(num_points, num_points * num_neighbors, &nng)) != SCC_ER_OK) {
+		free(compact_index);
+		free(compact_coordinates);
+		free(compact_labels);
+		return ec;
+	}
+
+	nng.tail_ptr[0] = 0;
+	for (size_t slot = 0; slot < window->capacity; ++slot) {
+		if (window->member_position[slot] != ISCC_SW_NOT_MEMBER) {
+			const size_t v = (size_t) compact_index[slot];
+			assert(window->num_neighbors[slot] >= num_neighbors);
+			const scc_PointIndex* const slot_neighbors = window->neighbors + slot * window->num_candidates;
+			for (uint32_t j = 0; j < num_neighbors; ++j) {
+				nng.head[v * num_neighbors + j] = compact_index[slot_neighbors[j]];
+			}
+			nng.tail_ptr[v + 1] = (iscc_ArcIndex) ((v + 1) * num_neighbors);
+		}
+	}
+	free(compact_index);
+
+	scc_DataSet* compact_data_set = NULL;
+	scc_Clustering* compact_clustering = NULL;
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (num_points / window->size_constraint),
+		.count = 0,
+		.seeds = NULL,
+	};
+
+	if ((ec = scc_init_data_set(num_points,
+	                            num_dimensions,
+	                            num_points * num_dimensions,
+	                            compact_coordinates,
+	                            &compact_data_set)) == SCC_ER_OK &&
+	        (ec = scc_init_empty_clustering(num_points,
+	                                        compact_labels,
+	                                        &compact_clustering)) == SCC_ER_OK &&
+	        (ec = iscc_find_seeds(&nng,
+	                              window->seed_method,
+	                              &seed_result)) == SCC_ER_OK) {
+		ec = iscc_make_nng_clusters_from_seeds(compact_clustering,
+		                                       compact_data_set,
+		                                       &seed_result,
+		                                       &nng,
+		                                       true,
+		                                       window->unassigned_method,
+		                                       false,
+		                                       0.0,
+		                                       0,
+		                                       NULL,
+		                                       SCC_UM_IGNORE,
+		                                       false,
+		                                       0.0);
+		free(seed_result.seeds);
+	}
+
+	if (ec == SCC_ER_OK) {
+		size_t v = 0;
+		for (size_t slot = 0; slot < window->capacity; ++slot) {
+			if (window->member_position[slot] != ISCC_SW_NOT_MEMBER) {
+				out_clustering->cluster_label[slot] = compact_labels[v];
+				++v;
+			} else {
+				out_clustering->cluster_label[slot] = SCC_CLABEL_NA;
+			}
+		}
+		out_clustering->num_clusters = compact_clustering->num_clusters;
+	}
+
+	iscc_free_digraph(&nng);
+	scc_free_clustering(&compact_clustering);
+	scc_free_data_set(&compact_data_set);
+	free(compact_coordinates);
+	free(compact_labels);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+// Replaces the candidates of `slot` with its nearest other points in the window
+static scc_ErrorCode iscc_sw_find_neighbors(scc_SlidingWindow* const window,
+                                            const scc_PointIndex slot)
+{
+	assert(window != NULL);
+	assert(window->member_position[slot] != ISCC_SW_NOT_MEMBER);
+
+	if (!iscc_get_dist_rows(window->data_set,
+	                        1,
+	                        &slot,
+	                        window->num_points,
+	                        window->members,
+	                        window->row_dists)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	window->num_neighbors[slot] = 0;
+	for (size_t i = 0; i < window->num_points; ++i) {
+		if (window->members[i] != slot) {
+			iscc_sw_offer_neighbor(window, slot, window->members[i], window->row_dists[i], true);
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+// Adds `neighbor` to the candidates of `slot` if it is among the nearest, and returns whether it was added.
+// A point farther than all candidates is only appended to a list that holds all other points offered so far,
+// as indicated by `list_complete`; otherwise closer points may have been dropped from the list.
+static inline bool iscc_sw_offer_neighbor(scc_SlidingWindow* const window,
+                                          const scc_PointIndex slot,
+                                          const scc_PointIndex neighbor,
+                                          const double dist,
+                                          const bool list_complete)
+{
+	assert(window != NULL);
+	assert(slot != neighbor);
+
+	const uint32_t max_neighbors = window->num_candidates;
+	uint32_t count = window->num_neighbors[slot];
+	scc_PointIndex* const slot_neighbors = window->neighbors + ((size_t) slot) * max_neighbors;
+	double* const slot_dists = window->neighbor_dists + ((size_t) slot) * max_neighbors;
+
+	const bool precedes_last = (count > 0) &&
+	                           iscc_sw_precedes(dist, neighbor, slot_dists[count - 1], slot_neighbors[count - 1]);
+	if (!precedes_last && (!list_complete || (count == max_neighbors))) {
+		return false;
+	}
+	if (count < max_neighbors) ++count;
+
+	// Shift farther neighbors one step, dropping the farthest if the list is full
+	uint32_t pos = count - 1;
+	for (; (pos > 0) && iscc_sw_precedes(dist, neighbor, slot_dists[pos - 1], slot_neighbors[pos - 1]); --pos) {
+		slot_neighbors[pos] = slot_neighbors[pos - 1];
+		slot_dists[pos] = slot_dists[pos - 1];
+	}
+	slot_neighbors[pos] = neighbor;
+	slot_dists[pos] = dist;
+	window->num_neighbors[slot] = count;
+
+	return true;
+}
+
+
+static inline bool iscc_sw_remove_neighbor(scc_SlidingWindow* const window,
+                                           const scc_PointIndex slot,
+                                           const scc_PointIndex neighbor)
+{
+	assert(window != NULL);
+
+	const uint32_t max_neighbors = window->num_candidates;
+	const uint32_t count = window->num_neighbors[slot];
+	scc_PointIndex* const slot_neighbors = window->neighbors + ((size_t) slot) * max_neighbors;
+	double* const slot_dists = window->neighbor_dists + ((size_t) slot) * max_neighbors;
+
+	uint32_t pos = 0;
+	for (; (pos < count) && (slot_neighbors[pos] != neighbor); ++pos);
+	if (pos == count) return false;
+
+	for (; pos + 1 < count; ++pos) {
+		slot_neighbors[pos] = slot_neighbors[pos + 1];
+		slot_dists[pos] = slot_dists[pos + 1];
+	}
+	window->num_neighbors[slot] = count - 1;
+
+	return true;
+}
+
+
+// Neighbors are ordered by distance, and ties by slot as in the built-in search
+static inline bool iscc_sw_precedes(const double dist1,
+                                    const scc_PointIndex slot1,
+                                    const double dist2,
+                                    const scc_PointIndex slot2)
+{
+	return (dist1 < dist2) || (!(dist1 > dist2) && (slot1 < slot2));
+}
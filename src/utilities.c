@@ -30,13 +30,31 @@
 #include "clustering_struct.h"
 #include "dist_search.h"
 #include "error.h"
+#include "parallel_for.h"
 #include "scclust_types.h"
 
 
 // =============================================================================
-// Internal variables
+// Internal structs & variables
 // =============================================================================
 
+typedef struct iscc_ClusterDistStats {
+	scc_ErrorCode ec;
+	double sum_dists;
+	double min_dist;
+	double max_dist;
+} iscc_ClusterDistStats;
+
+
+typedef struct iscc_StatsDistSearch {
+	void* data_set;
+	const size_t* cluster_size;
+	scc_PointIndex* const* cl_members;
+	size_t largest_dist_matrix;
+	iscc_ClusterDistStats* cluster_dist_stats;
+} iscc_StatsDistSearch;
+
+
 /** The null clustering statistics struct.
  *
  *  This is an easily detectable invalid struct used as return value on errors.
@@ -45,6 +63,18 @@ static const scc_ClusteringStats ISCC_NULL_CLUSTERING_STATS = { 0, 0, 0, 0, 0, 0
 
 static const int32_t ISCC_OPTIONS_STRUCT_VERSION = 722678001;
 
+// Number of clusters in each call to `iscc_get_cluster_dist_stats`.
+static const size_t ISCC_STATS_CLUSTER_GRAIN = 16;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static void iscc_get_cluster_dist_stats(size_t begin,
+                                        size_t end,
+                                        void* context);
+
 
 // =============================================================================
 // Public function implementations
@@ -239,12 +269,12 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 	const size_t largest_dist_matrix = (tmp_stats.max_cluster_size * (tmp_stats.max_cluster_size - 1)) / 2;
 	scc_PointIndex* const id_store = malloc(sizeof(scc_PointIndex[tmp_stats.num_assigned]));
 	scc_PointIndex** const cl_members = malloc(sizeof(scc_PointIndex*[clustering->num_clusters]));
-	double* const dist_scratch = malloc(sizeof(double[largest_dist_matrix]));
-	if ((id_store == NULL) || (cl_members == NULL) || (dist_scratch == NULL)) {
+	iscc_ClusterDistStats* const cluster_dist_stats = malloc(sizeof(iscc_ClusterDistStats[clustering->num_clusters]));
+	if ((id_store == NULL) || (cl_members == NULL) || (cluster_dist_stats == NULL)) {
 		free(cluster_size);
 		free(id_store);
 		free(cl_members);
-		free(dist_scratch);
+		free(cluster_dist_stats);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -262,35 +292,36 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 		}
 	}
 
-	for (size_t c = 0; c < clustering->num_clusters; ++c) {
-		if (cluster_size[c] < 2) {
-			if (cluster_size[c] == 1) tmp_stats.min_dist = 0.0;
-			continue;
-		}
+	// Distances within clusters are independent, collect them first and sum in cluster order
+	iscc_StatsDistSearch stats_search = {
+		.data_set = data_set,
+		.cluster_size = cluster_size,
+		.cl_members = cl_members,
+		.largest_dist_matrix = largest_dist_matrix,
+		.cluster_dist_stats = cluster_dist_stats,
+	};
+	iscc_parallel_for(0, clustering->num_clusters, ISCC_STATS_CLUSTER_GRAIN, iscc_get_cluster_dist_stats, &stats_search);
 
-		const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
-		if (!iscc_get_dist_matrix(data_set, cluster_size[c], cl_members[c], dist_scratch)) {
+	for (size_t c = 0; c < clustering->num_clusters; ++c) {
+		if (cluster_dist_stats[c].ec != SCC_ER_OK) {
+			const scc_ErrorCode cluster_ec = cluster_dist_stats[c].ec;
 			free(cluster_size);
 			free(id_store);
 			free(cl_members);
-			free(dist_scratch);
-			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			free(cluster_dist_stats);
+			return iscc_make_error(cluster_ec);
 		}
 
-		double cluster_sum_dists = dist_scratch[0];
-		double cluster_min = dist_scratch[0];
-		double cluster_max = dist_scratch[0];
-
-		for (size_t d = 1; d < size_dist_matrix; ++d) {
-			cluster_sum_dists += dist_scratch[d];
-			if (cluster_min > dist_scratch[d]) {
-				cluster_min = dist_scratch[d];
-			}
-			if (cluster_max < dist_scratch[d]) {
-				cluster_max = dist_scratch[d];
-			}
+		if (cluster_size[c] < 2) {
+			if (cluster_size[c] == 1) tmp_stats.min_dist = 0.0;
+			continue;
 		}
 
+		const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
+		const double cluster_sum_dists = cluster_dist_stats[c].sum_dists;
+		const double cluster_min = cluster_dist_stats[c].min_dist;
+		const double cluster_max = cluster_dist_stats[c].max_dist;
+
 		tmp_stats.sum_dists += cluster_sum_dists;
 
 		if (tmp_stats.min_dist > cluster_min) {
@@ -315,7 +346,7 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 	free(cluster_size);
 	free(id_store);
 	free(cl_members);
-	free(dist_scratch);
+	free(cluster_dist_stats);
 
 	*out_stats = tmp_stats;
 
@@ -444,3 +475,61 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 
 	return iscc_no_error();
 }
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static void iscc_get_cluster_dist_stats(const size_t begin,
+                                        const size_t end,
+                                        void* const context)
+{
+	const iscc_StatsDistSearch* const stats_search = context;
+	assert(stats_search != NULL);
+	assert(begin <= end);
+
+	double* dist_scratch = NULL;
+	if (stats_search->largest_dist_matrix > 0) {
+		dist_scratch = malloc(sizeof(double[stats_search->largest_dist_matrix]));
+	}
+
+	for (size_t c = begin; c < end; ++c) {
+		iscc_ClusterDistStats* const cl_stats = &stats_search->cluster_dist_stats[c];
+		*cl_stats = (iscc_ClusterDistStats) { SCC_ER_OK, 0.0, 0.0, 0.0 };
+
+		const size_t cl_size = stats_search->cluster_size[c];
+		if (cl_size < 2) continue;
+
+		if (dist_scratch == NULL) {
+			cl_stats->ec = SCC_ER_NO_MEMORY;
+			continue;
+		}
+
+		const size_t size_dist_matrix = (cl_size * (cl_size - 1)) / 2;
+		if (!iscc_get_dist_matrix(stats_search->data_set, cl_size, stats_search->cl_members[c], dist_scratch)) {
+			cl_stats->ec = SCC_ER_DIST_SEARCH_ERROR;
+			continue;
+		}
+
+		double cluster_sum_dists = dist_scratch[0];
+		double cluster_min = dist_scratch[0];
+		double cluster_max = dist_scratch[0];
+
+		for (size_t d = 1; d < size_dist_matrix; ++d) {
+			cluster_sum_dists += dist_scratch[d];
+			if (cluster_min > dist_scratch[d]) {
+				cluster_min = dist_scratch[d];
+			}
+			if (cluster_max < dist_scratch[d]) {
+				cluster_max = dist_scratch[d];
+			}
+		}
+
+		cl_stats->sum_dists = cluster_sum_dists;
+		cl_stats->min_dist = cluster_min;
+		cl_stats->max_dist = cluster_max;
+	}
+
+	free(dist_scratch);
+}
@@ -0,0 +1,48 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_WALL_CLOCK_HG
+#define SCC_WALL_CLOCK_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust_spi.h"
+
+
+// =============================================================================
+// Variables
+// =============================================================================
+
+extern scc_clock iscc_clock_function;
+
+
+// =============================================================================
+// Clock functions
+// =============================================================================
+
+// Writes the host's wall-clock time in seconds to `out_now`. Returns false when no
+// clock is registered or the clock fails.
+static inline bool iscc_wall_clock_now(double* const out_now)
+{
+	return (iscc_clock_function != NULL) && iscc_clock_function(out_now);
+}
+
+
+#endif // ifndef SCC_WALL_CLOCK_HG
@@ -90,7 +90,10 @@ typedef enum scc_ErrorCode {
 	SCC_ER_DIST_SEARCH_ERROR,
 
 	/// Functionality not yet implemented.
-	SCC_ER_NOT_IMPLEMENTED
+	SCC_ER_NOT_IMPLEMENTED,
+
+	/// Failed to read or write a file.
+	SCC_ER_IO_ERROR
 
 } scc_ErrorCode;
 
@@ -189,9 +192,284 @@ scc_ErrorCode scc_init_data_set(uint64_t num_data_points,
                                 scc_DataSet** out_data_set);
 
 
+/** Construct new data set from a subset of columns.
+ *
+ *  Creates a #scc_DataSet that uses some of the columns of a wider data matrix. The
+ *  data matrix is not copied; the distance functions read the used columns in place.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of used columns, i.e., the number of dimensions
+ *                            for each data point.
+ *  \param[in] row_stride the number of elements in #data_matrix between the first elements
+ *                        of two consecutive data points (the leading dimension).
+ *  \param[in] columns the indices of the used columns, of length #num_dimensions. All
+ *                     indices must be less than #row_stride. If \c NULL, the first
+ *                     #num_dimensions columns are used.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the raw data, ordered first by point, then by column. With
+ *                         three units (A, B, C) and a row stride of three, #data_matrix
+ *                         should be `[A_1, A_2, A_3, B_1, B_2, B_3, C_1, C_2, C_3]`.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note #data_matrix must outlive the data set object. #columns is copied.
+ */
+scc_ErrorCode scc_init_data_set_columns(uint64_t num_data_points,
+                                        uint32_t num_dimensions,
+                                        size_t row_stride,
+                                        const uint32_t columns[],
+                                        size_t len_data_matrix,
+                                        const double data_matrix[],
+                                        scc_DataSet** out_data_set);
+
+
+/** Construct new data set from column-major data.
+ *
+ *  Creates a #scc_DataSet from a column-major data matrix, as used in R and Fortran,
+ *  without transposing or copying it.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of used columns, i.e., the number of dimensions
+ *                            for each data point.
+ *  \param[in] column_stride the number of elements in #data_matrix between the first elements
+ *                           of two consecutive columns (the leading dimension). Must be at
+ *                           least #num_data_points.
+ *  \param[in] columns the indices of the used columns, of length #num_dimensions. If \c NULL,
+ *                     the first #num_dimensions columns are used.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the raw data, ordered first by column, then by point. With three
+ *                         units (A, B, C) in two dimensions, #data_matrix should be
+ *                         `[A_1, B_1, C_1, A_2, B_2, C_2]`.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note #data_matrix must outlive the data set object. #columns is copied.
+ */
+scc_ErrorCode scc_init_data_set_column_major(uint64_t num_data_points,
+                                             uint32_t num_dimensions,
+                                             size_t column_stride,
+                                             const uint32_t columns[],
+                                             size_t len_data_matrix,
+                                             const double data_matrix[],
+                                             scc_DataSet** out_data_set);
+
+
+/** Construct new data set from separate column arrays.
+ *
+ *  Creates a #scc_DataSet where the values of each dimension are stored in an array of
+ *  their own, as in the column buffers of Apache Arrow or a data frame. The arrays are
+ *  not copied; the distance functions read them in place.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of columns, i.e., the number of dimensions for each
+ *                            data point.
+ *  \param[in] column_arrays the columns, of length #num_dimensions. Each column is an array
+ *                           of length #num_data_points. With three units (A, B, C) in two
+ *                           dimensions, the columns should be `[A_1, B_1, C_1]` and
+ *                           `[A_2, B_2, C_2]`.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The columns must outlive the data set object. #column_arrays is copied.
+ */
+scc_ErrorCode scc_init_data_set_column_arrays(uint64_t num_data_points,
+                                              uint32_t num_dimensions,
+                                              const double* const column_arrays[],
+                                              scc_DataSet** out_data_set);
+
+
+/** Construct new data set with mixed numeric and categorical data.
+ *
+ *  Creates a #scc_DataSet where distances are Gower distances. The distance between two
+ *  data points is the weighted mean over the columns of the absolute difference divided
+ *  by the column's range (for numeric columns) and of an indicator of different categories
+ *  (for categorical columns). All distances are between zero and one.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_numeric the number of numeric columns. May be zero.
+ *  \param[in] len_numeric_matrix the length of #numeric_matrix.
+ *  \param[in] numeric_matrix the numeric data, ordered first by data point, then by column
+ *                            (as in #scc_init_data_set). May be \c NULL if #num_numeric is zero.
+ *  \param[in] numeric_ranges the ranges of the numeric columns, of length #num_numeric. All
+ *                            ranges must be positive. If \c NULL, the ranges are derived from
+ *                            the data, and constant columns do not affect the distances.
+ *  \param[in] numeric_weights the weights of the numeric columns, of length #num_numeric.
+ *                             If \c NULL, all numeric columns have weight one.
+ *  \param[in] num_categorical the number of categorical columns. May be zero.
+ *  \param[in] len_categorical_matrix the length of #categorical_matrix.
+ *  \param[in] categorical_matrix the integer-coded categories, ordered first by data point,
+ *                                then by column. May be \c NULL if #num_categorical is zero.
+ *  \param[in] categorical_weights the weights of the categorical columns, of length
+ *                                 #num_categorical. If \c NULL, all categorical columns have
+ *                                 weight one.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The weights must be non-negative with a positive sum. #numeric_matrix and #categorical_matrix
+ *        must outlive the data set object. The ranges and weights are not needed after the call.
+ */
+scc_ErrorCode scc_init_mixed_data_set(uint64_t num_data_points,
+                                      uint32_t num_numeric,
+                                      size_t len_numeric_matrix,
+                                      const double numeric_matrix[],
+                                      const double numeric_ranges[],
+                                      const double numeric_weights[],
+                                      uint32_t num_categorical,
+                                      size_t len_categorical_matrix,
+                                      const int32_t categorical_matrix[],
+                                      const double categorical_weights[],
+                                      scc_DataSet** out_data_set);
+
+
+/// Enum to specify distance metric for binary data sets.
+typedef enum scc_BinaryDistance {
+	/// The number of features that differ between two data points.
+	SCC_BD_HAMMING,
+
+	/// One minus the number of features present in both data points divided by the number present
+	/// in either. The distance between two data points without any features is zero.
+	SCC_BD_JACCARD
+
+} scc_BinaryDistance;
+
+
+/** Construct new data set with binary features.
+ *
+ *  Creates a #scc_DataSet from bit-packed binary features, using Hamming or Jaccard distances.
+ *  Each data point is stored in `(num_features + 63) / 64` consecutive 64-bit words, where
+ *  feature `f` is bit `f % 64` of word `f / 64`.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_features the number of binary features of each data point.
+ *  \param[in] distance the distance metric to use.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the packed features, ordered first by data point, then by word.
+ *                         Bits beyond the last feature in each data point's last word must be zero.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note #data_matrix must outlive the data set object.
+ */
+scc_ErrorCode scc_init_binary_data_set(uint64_t num_data_points,
+                                       uint32_t num_features,
+                                       scc_BinaryDistance distance,
+                                       size_t len_data_matrix,
+                                       const uint64_t data_matrix[],
+                                       scc_DataSet** out_data_set);
+
+
+/** Construct new data set with geographic coordinates.
+ *
+ *  Creates a #scc_DataSet from latitudes and longitudes where distances are great-circle
+ *  distances. The points are embedded once on the unit sphere in three dimensions. The
+ *  chord distance between the embedded points is monotone in the great-circle distance, so
+ *  the Euclidean nearest neighbor searches are used unchanged. Radii and distances are
+ *  converted between the two when passed to or from the searches.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] len_coordinates the length of #coordinates.
+ *  \param[in] coordinates the latitude and longitude, in degrees, of each data point. With three
+ *                         units (A, B, C), #coordinates should be
+ *                         `[lat_A, lon_A, lat_B, lon_B, lat_C, lon_C]`. Latitudes must be in
+ *                         [-90, 90] and longitudes in [-360, 360].
+ *  \param[in] sphere_radius the radius of the sphere, which sets the unit of the distances
+ *                           (e.g., 6371.0 for kilometers on Earth, or 1.0 for radians).
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note #coordinates are not needed after the call.
+ */
+scc_ErrorCode scc_init_geo_data_set(uint64_t num_data_points,
+                                    size_t len_coordinates,
+                                    const double coordinates[],
+                                    double sphere_radius,
+                                    scc_DataSet** out_data_set);
+
+
+/** Add a principal component projection to a data set.
+ *
+ *  Projects the data points onto the top #num_components principal components of the data. The
+ *  distance between two projected points is a lower bound of the distance between the points, so
+ *  the built-in nearest neighbor search can skip most full-dimensional distance calculations in
+ *  high-dimensional data. The search results are unchanged.
+ *
+ *  The principal components are estimated from at most a few thousand data points. Any previous
+ *  projection of the data set is replaced.
+ *
+ *  \param[in,out] data_set the data set to project. Must be a Euclidean data set, i.e., one
+ *                          made by #scc_init_data_set, #scc_init_data_set_columns,
+ *                          #scc_init_data_set_column_major or #scc_init_geo_data_set.
+ *  \param[in] num_components the number of components. Must be positive and less than the
+ *                            number of dimensions.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_add_pca_projection(scc_DataSet* data_set,
+                                     uint32_t num_components);
+
+
+/** Build a search index for a data set.
+ *
+ *  Builds a kd-tree over all data points and attaches it to the data set. The built-in nearest
+ *  neighbor search then uses the index, instead of building a tree of its own, whenever all data
+ *  points are searched. The search results are unchanged. Any previous index of the data set is
+ *  replaced. The index can be written to a file with #scc_save_search_index.
+ *
+ *  \param[in,out] data_set the data set to index. Must be a Euclidean data set, i.e., one
+ *                          made by #scc_init_data_set, #scc_init_data_set_columns,
+ *                          #scc_init_data_set_column_major or #scc_init_geo_data_set.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The index refers to the data matrix of the data set, which must not change while the
+ *        index is in use.
+ */
+scc_ErrorCode scc_build_search_index(scc_DataSet* data_set);
+
+
+/** Save the search index of a data set.
+ *
+ *  Writes the index built by #scc_build_search_index, or loaded by #scc_load_search_index, to a
+ *  file. The file holds the tree structure and a fingerprint of the data set, but not the data
+ *  itself. It is written in the native byte order.
+ *
+ *  \param[in] data_set the data set whose index should be saved.
+ *  \param[in] path the file to write.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_save_search_index(const scc_DataSet* data_set,
+                                    const char* path);
+
+
+/** Load a search index for a data set.
+ *
+ *  Reads an index written by #scc_save_search_index and attaches it to the data set, as if it
+ *  was built by #scc_build_search_index. The file is rejected with #SCC_ER_INVALID_INPUT if it
+ *  was made for another data set: the size and fingerprint of the data set must match, and
+ *  every data point must lie within the bounds stored for it. Any previous index of the data
+ *  set is replaced.
+ *
+ *  \param[in,out] data_set the data set the index was built for.
+ *  \param[in] path the file to read.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_load_search_index(scc_DataSet* data_set,
+                                    const char* path);
+
+
 /** Free data set.
  *
- *  Frees a #scc_DataSet previously allocated by #scc_init_data_set.
+ *  Frees a #scc_DataSet previously allocated by #scc_init_data_set, #scc_init_data_set_columns,
+ *  #scc_init_data_set_column_major, #scc_init_mixed_data_set, #scc_init_binary_data_set or
+ *  #scc_init_geo_data_set.
  *
  *  \param[in,out] data_set double pointer to a #scc_DataSet objec to free.
  */
@@ -366,12 +644,193 @@ scc_ErrorCode scc_sc_clustering(void* data_set,
                                 scc_Clustering* out_clustering);
 
 
+/** Size-constrained clustering with checkpoints
+ *
+ *  Same as #scc_sc_clustering, but the nearest neighbor graph, the seeds and the
+ *  labels after the primary assignment are saved to files in `checkpoint_dir`
+ *  when each phase is done. Calling the function again with the same directory,
+ *  the same options and unchanged data resumes from the latest saved phase, and
+ *  gives the same clustering as an uninterrupted call.
+ *
+ *  Checkpoints made with other options, another number of data points or other
+ *  data are rejected with #SCC_ER_INVALID_INPUT. The data is identified by a hash
+ *  of the distances between a few fixed points and, for data sets made by
+ *  #scc_init_data_set and its variants, of the coordinates of up to 4096 evenly
+ *  spaced points. Changes to points outside these samples are not detected.
+ *  The batch seed method and clusterings of pairs are not checkpointed.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_sc_clustering_with_checkpoints(void* data_set,
+                                                 const scc_ClusterOptions* options,
+                                                 const char* checkpoint_dir,
+                                                 scc_Clustering* out_clustering);
+
+
+/** Size-constrained clustering within a time budget
+ *
+ *  Makes a clustering with the cheapest seed method that `options` allow (#SCC_SM_BATCHES when
+ *  possible, otherwise #SCC_SM_LEXICAL), and then tries to improve it while time remains. The
+ *  improvements are, in order: the other seed methods, assignment of leftover points to the
+ *  closest assigned point when `primary_unassigned_method` is #SCC_UM_ANY_NEIGHBOR, and hierarchical
+ *  refinement (as in #scc_hierarchical_clustering) of the best clustering found so far. The refinement
+ *  is skipped with type constraints. All other options are used as given, and `seed_method` is ignored.
+ *
+ *  The clustering that assigns the most data points, with the smallest average distance within clusters
+ *  as tie-breaker (`avg_dist_weighted` in #scc_ClusteringStats), is returned.
+ *
+ *  The first clustering is always made, even when it takes longer than the budget. Each later step is
+ *  started only if it is expected to finish within the budget, judged by the duration of the previous step.
+ *  Steps are not interrupted, so the budget may be exceeded by a step that takes longer than expected.
+ *  With a budget of zero, only the first clustering is made.
+ *
+ *  Time is measured with the monotonic wall clock registered by the host with `scc_set_clock`
+ *  (see `include/scclust_spi.h`), so the budget is a deadline in wall-clock time, whatever the work
+ *  of other threads. If no clock is registered, or the clock fails, only the first clustering is made.
+ *
+ *  \param[in] data_set the data set to cluster.
+ *  \param[in] options the clustering options.
+ *  \param[in] time_budget the time budget in seconds.
+ *  \param[in,out] out_clustering an empty clustering object.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_anytime_clustering(void* data_set,
+                                     const scc_ClusterOptions* options,
+                                     double time_budget,
+                                     scc_Clustering* out_clustering);
+
+
 scc_ErrorCode scc_hierarchical_clustering(void* data_set,
                                           uint32_t size_constraint,
                                           bool batch_assign,
                                           scc_Clustering* out_clustering);
 
 
+/// Type used for split trees
+typedef struct scc_SplitTree scc_SplitTree;
+
+
+/** Records the splits of hierarchical clustering.
+ *
+ *  Runs the same splitting as #scc_hierarchical_clustering on all points, and records each
+ *  split so that clusterings for larger size constraints can be derived with #scc_cut_split_tree.
+ *
+ *  \param[in] data_set the data set to cluster.
+ *  \param[in] size_constraint the smallest size constraint the tree can be cut at.
+ *  \param[in] batch_assign the assignment method, as in #scc_hierarchical_clustering.
+ *  \param[out] out_split_tree double pointer to where to write the split tree reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_build_split_tree(void* data_set,
+                                   uint32_t size_constraint,
+                                   bool batch_assign,
+                                   scc_SplitTree** out_split_tree);
+
+
+/** Derives a hierarchical clustering from a split tree.
+ *
+ *  Walks the tree from the root, and stops at nodes smaller than twice #size_constraint, which become
+ *  clusters. Where a recorded split made a cluster smaller than #size_constraint, only that subtree
+ *  is split again. Cutting at the size constraint the tree was built with gives the same clustering as
+ *  #scc_hierarchical_clustering.
+ *
+ *  \param[in] split_tree a tree made by #scc_build_split_tree for #data_set.
+ *  \param[in] data_set the data set the tree was made for.
+ *  \param[in] size_constraint the size constraint, at least the one the tree was built with.
+ *  \param[in,out] out_clustering an empty clustering object.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_cut_split_tree(const scc_SplitTree* split_tree,
+                                 void* data_set,
+                                 uint32_t size_constraint,
+                                 scc_Clustering* out_clustering);
+
+
+void scc_free_split_tree(scc_SplitTree** split_tree);
+
+
+// =============================================================================
+// Sliding window
+// =============================================================================
+
+/// Type used for sliding windows
+typedef struct scc_SlidingWindow scc_SlidingWindow;
+
+
+/** Makes an empty sliding window for streaming clustering.
+ *
+ *  The window holds at most #capacity points. Points are inserted with #scc_window_insert and
+ *  removed with #scc_window_expire. For each point, the window keeps a list of its nearest other
+ *  points, with twice as many candidates as the `size_constraint - 1` neighbors a clustering needs.
+ *
+ *  Costs, with `n` points in the window and `k = size_constraint - 1`:
+ *  - An insertion calculates the distances from the new point to all `n` points in the window,
+ *    i.e., one full distance row, and updates the lists in `O(n k)` time.
+ *  - An expiration scans all lists in `O(n k)` time, and calculates a full distance row only for
+ *    the points left with fewer than `k` candidates, which happens after about `k` of a point's
+ *    candidates have expired.
+ *  - #scc_window_clustering reads the nearest neighbor graph off the lists without calculating
+ *    distances, but copies the points and finds seeds and assigns points from scratch on every
+ *    call, as #scc_sc_clustering does after its neighbor search.
+ *
+ *  \param[in] num_dimensions the number of dimensions of the points.
+ *  \param[in] capacity the maximum number of points in the window.
+ *  \param[in] size_constraint the size constraint of the clusterings.
+ *  \param[in] seed_method the seed method, as in #scc_ClusterOptions. #SCC_SM_BATCHES is not supported.
+ *  \param[in] unassigned_method how to assign points that are not seeds or neighbors of seeds.
+ *  \param[out] out_window double pointer to where to write the window reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The window uses the distance functions with a data set made by #scc_init_data_set, so
+ *        registered distance functions must accept such data sets.
+ */
+scc_ErrorCode scc_init_sliding_window(uint32_t num_dimensions,
+                                      uint64_t capacity,
+                                      uint32_t size_constraint,
+                                      scc_SeedMethod seed_method,
+                                      scc_UnassignedMethod unassigned_method,
+                                      scc_SlidingWindow** out_window);
+
+
+void scc_free_sliding_window(scc_SlidingWindow** window);
+
+
+/** Inserts a point into a sliding window.
+ *
+ *  \param[in,out] window the window.
+ *  \param[in] coordinates the coordinates of the point, of length `num_dimensions`. They are copied.
+ *  \param[out] out_slot the slot of the point, used to expire it. May be \c NULL.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_window_insert(scc_SlidingWindow* window,
+                                const double coordinates[],
+                                uint64_t* out_slot);
+
+
+scc_ErrorCode scc_window_expire(scc_SlidingWindow* window,
+                                uint64_t slot);
+
+
+/** Clusters the points in a sliding window.
+ *
+ *  Gives the same clustering as #scc_sc_clustering with the window's size constraint, seed method and
+ *  unassigned method on a data set of the points in the window ordered by slot.
+ *
+ *  \param[in] window the window.
+ *  \param[in,out] out_clustering an empty clustering object with one data point per slot, i.e., `capacity`
+ *                                data points. Slots not in the window are labeled #SCC_CLABEL_NA.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_window_clustering(scc_SlidingWindow* window,
+                                    scc_Clustering* out_clustering);
+
+
 // =============================================================================
 // Utility functions
 // =============================================================================
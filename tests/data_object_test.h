@@ -143,15 +143,19 @@ double coord2[15] = { -1.40865056, -0.83518405,  0.28314478,
 scc_DataSet scc_ut_test_data_large_struct = {
 	.num_data_points = 100,
 	.num_dimensions = 3,
+	.row_stride = 3,
+	.column_stride = 1,
 	.data_matrix = coord1,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722328007, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_small_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 1,
+	.row_stride = 1,
+	.column_stride = 1,
 	.data_matrix = coord2,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722328007, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet* const scc_ut_test_data_large = &scc_ut_test_data_large_struct;
@@ -166,20 +170,26 @@ scc_DataSet* const scc_ut_test_data_small = &scc_ut_test_data_small_struct;
 scc_DataSet scc_ut_test_data_invalid1_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 0,
+	.row_stride = 1,
+	.column_stride = 1,
 	.data_matrix = coord2,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722328007, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_invalid2_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 1,
+	.row_stride = 1,
+	.column_stride = 1,
 	.data_matrix = NULL,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722328007, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_invalid3_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 1,
+	.row_stride = 1,
+	.column_stride = 1,
 	.data_matrix = coord2,
 	.data_set_version = 0,
 };
@@ -42,6 +42,7 @@ if [ "$KEEP_SCC_BUILD" = "false" ]; then
 fi
 make all ANN_SEARCH=$ANN
 
+run_test test_anytime_clustering
 run_test test_data_set
 run_test test_digraph_core
 run_test test_digraph_debug
@@ -61,7 +62,9 @@ run_test test_nng_core
 run_test test_nng_findseeds_internal
 run_test test_nng_findseeds_stable
 run_test test_nng_findseeds
+run_test test_parallel_for
 run_test test_scclust
+run_test test_sliding_window
 
 if [ "$STRESS" = "true" ]; then
 	run_test stress_hierarchical_clustering
@@ -0,0 +1,311 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/clustering_struct.h>
+#include <src/scclust_types.h>
+#include "rand.h"
+
+#define SCC_UT_NUM_DATA_POINTS 200
+#define SCC_UT_NUM_DIMENSIONS 2
+
+
+static double scc_ut_coordinates[SCC_UT_NUM_DATA_POINTS * SCC_UT_NUM_DIMENSIONS];
+static double scc_ut_clock_time;
+static double scc_ut_clock_step;
+static size_t scc_ut_clock_calls;
+
+
+// Fake wall clock that advances `scc_ut_clock_step` seconds per call
+static bool scc_ut_fake_clock(double* const out_now)
+{
+	*out_now = scc_ut_clock_time;
+	scc_ut_clock_time += scc_ut_clock_step;
+	++scc_ut_clock_calls;
+	return true;
+}
+
+
+static bool scc_ut_failing_clock(double* const out_now)
+{
+	(void) out_now;
+	++scc_ut_clock_calls;
+	return false;
+}
+
+
+static void scc_ut_set_fake_clock(const double step)
+{
+	scc_ut_clock_time = 0.0;
+	scc_ut_clock_step = step;
+	scc_ut_clock_calls = 0;
+	assert_true(scc_set_clock(scc_ut_fake_clock));
+}
+
+
+static scc_DataSet* scc_ut_make_data_set(void)
+{
+	srand(4321);
+	for (size_t i = 0; i < SCC_UT_NUM_DATA_POINTS * SCC_UT_NUM_DIMENSIONS; ++i) {
+		scc_ut_coordinates[i] = scc_rand_double(0.0, 100.0);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SCC_UT_NUM_DATA_POINTS, SCC_UT_NUM_DIMENSIONS, SCC_UT_NUM_DATA_POINTS * SCC_UT_NUM_DIMENSIONS, scc_ut_coordinates, &data_set), SCC_ER_OK);
+	return data_set;
+}
+
+
+// Checks that the anytime clustering with `time_budget` is the first clustering, made with batches
+static void scc_ut_check_first_clustering(scc_DataSet* const data_set,
+                                          const double time_budget)
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, time_budget, cl), SCC_ER_OK);
+
+	options.seed_method = SCC_SM_BATCHES;
+	scc_Clustering* ref_cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &ref_cl), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, ref_cl), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, ref_cl->num_clusters);
+	assert_memory_equal(cl->cluster_label, ref_cl->cluster_label, SCC_UT_NUM_DATA_POINTS * sizeof(scc_Clabel));
+	scc_free_clustering(&cl);
+	scc_free_clustering(&ref_cl);
+}
+
+
+static scc_ClusteringStats scc_ut_get_stats(scc_DataSet* const data_set,
+                                            const scc_Clustering* const cl)
+{
+	scc_ClusteringStats stats;
+	assert_int_equal(scc_get_clustering_stats(data_set, cl, &stats), SCC_ER_OK);
+	return stats;
+}
+
+
+// With no time, the first clustering is returned
+void scc_ut_anytime_clustering_no_time(void** state)
+{
+	(void) state;
+
+	scc_DataSet* data_set = scc_ut_make_data_set();
+	scc_ut_set_fake_clock(0.0);
+	scc_ut_check_first_clustering(data_set, 0.0);
+
+	// Later steps find a different clustering, so the budget of zero did stop after the first
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	options.seed_method = SCC_SM_BATCHES;
+	scc_Clustering* ref_cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &ref_cl), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, ref_cl), SCC_ER_OK);
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1000.0, cl), SCC_ER_OK);
+	assert_true(memcmp(cl->cluster_label, ref_cl->cluster_label, SCC_UT_NUM_DATA_POINTS * sizeof(scc_Clabel)) != 0);
+	scc_free_clustering(&cl);
+	scc_free_clustering(&ref_cl);
+
+	// Batches cannot assign leftovers to the closest seed
+	scc_Clabel external_labels[SCC_UT_NUM_DATA_POINTS];
+	options.seed_method = SCC_SM_EXCLUSION_UPDATING;
+	options.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, external_labels, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 0.0, cl), SCC_ER_OK);
+	assert_ptr_equal(cl->cluster_label, external_labels);
+
+	options.seed_method = SCC_SM_LEXICAL;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &ref_cl), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, ref_cl), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, ref_cl->num_clusters);
+	assert_memory_equal(cl->cluster_label, ref_cl->cluster_label, SCC_UT_NUM_DATA_POINTS * sizeof(scc_Clabel));
+	scc_free_clustering(&cl);
+	scc_free_clustering(&ref_cl);
+
+	assert_true(scc_reset_clock());
+	scc_free_data_set(&data_set);
+}
+
+
+// The budget is measured with the registered wall clock, and without a working clock only the
+// first clustering is made
+void scc_ut_anytime_clustering_clock(void** state)
+{
+	(void) state;
+
+	scc_DataSet* data_set = scc_ut_make_data_set();
+
+	assert_false(scc_set_clock(NULL));
+
+	assert_true(scc_reset_clock());
+	scc_ut_check_first_clustering(data_set, 1000.0);
+
+	scc_ut_clock_calls = 0;
+	assert_true(scc_set_clock(scc_ut_failing_clock));
+	scc_ut_check_first_clustering(data_set, 1000.0);
+	assert_int_equal(scc_ut_clock_calls, 1);
+
+	// The whole budget has passed on the wall clock when the first step is considered
+	scc_ut_set_fake_clock(1000.0);
+	scc_ut_check_first_clustering(data_set, 1000.0);
+	assert_true(scc_ut_clock_calls >= 2);
+
+	// Each step is timed, and steps stop once the budget is used up
+	scc_ut_set_fake_clock(1.0);
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 6.0, cl), SCC_ER_OK);
+	assert_true(scc_ut_clock_calls > 2);
+	assert_true(scc_ut_clock_calls <= 8);
+	scc_free_clustering(&cl);
+
+	assert_true(scc_reset_clock());
+	scc_free_data_set(&data_set);
+}
+
+
+// With ample time, the result is at least as good as every seed method and cannot be refined further
+void scc_ut_anytime_clustering_ample_time(void** state)
+{
+	(void) state;
+
+	scc_DataSet* data_set = scc_ut_make_data_set();
+	scc_ut_set_fake_clock(0.0);
+
+	const scc_SeedMethod seed_methods[] = {
+		SCC_SM_BATCHES,
+		SCC_SM_LEXICAL,
+		SCC_SM_INWARDS_ORDER,
+		SCC_SM_INWARDS_UPDATING,
+		SCC_SM_EXCLUSION_ORDER,
+		SCC_SM_EXCLUSION_UPDATING,
+	};
+
+	for (uint32_t size_constraint = 2; size_constraint <= 4; ++size_constraint) {
+		scc_ClusterOptions options = scc_get_default_options();
+		options.size_constraint = size_constraint;
+		scc_Clustering* cl;
+		assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+		assert_int_equal(scc_anytime_clustering(data_set, &options, 1000.0, cl), SCC_ER_OK);
+		bool is_OK;
+		assert_int_equal(scc_check_clustering(cl, &options, &is_OK), SCC_ER_OK);
+		assert_true(is_OK);
+		const scc_ClusteringStats stats = scc_ut_get_stats(data_set, cl);
+		assert_int_equal(stats.num_assigned, SCC_UT_NUM_DATA_POINTS);
+		assert_int_equal(scc_hierarchical_clustering(data_set, size_constraint, false, cl), SCC_ER_OK);
+		assert_true(stats.avg_dist_weighted <= scc_ut_get_stats(data_set, cl).avg_dist_weighted + 1e-9);
+		scc_free_clustering(&cl);
+
+		for (size_t m = 0; m < sizeof(seed_methods) / sizeof(seed_methods[0]); ++m) {
+			for (size_t closer = 0; closer < 2; ++closer) {
+				if ((closer == 1) && (seed_methods[m] == SCC_SM_BATCHES)) continue;
+				scc_ClusterOptions ref_options = options;
+				ref_options.seed_method = seed_methods[m];
+				ref_options.primary_unassigned_method = (closer == 1) ? SCC_UM_CLOSEST_ASSIGNED : SCC_UM_ANY_NEIGHBOR;
+				scc_Clustering* ref_cl;
+				assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &ref_cl), SCC_ER_OK);
+				assert_int_equal(scc_sc_clustering(data_set, &ref_options, ref_cl), SCC_ER_OK);
+				assert_true(stats.avg_dist_weighted <= scc_ut_get_stats(data_set, ref_cl).avg_dist_weighted + 1e-9);
+				scc_free_clustering(&ref_cl);
+			}
+		}
+	}
+
+	// Type constraints are respected
+	scc_TypeLabel type_labels[SCC_UT_NUM_DATA_POINTS];
+	for (size_t i = 0; i < SCC_UT_NUM_DATA_POINTS; ++i) {
+		type_labels[i] = (scc_TypeLabel) (i % 3);
+	}
+	const uint32_t type_constraints[3] = { 1, 1, 0 };
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	options.num_types = 3;
+	options.type_constraints = type_constraints;
+	options.len_type_labels = SCC_UT_NUM_DATA_POINTS;
+	options.type_labels = type_labels;
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1000.0, cl), SCC_ER_OK);
+	bool is_OK;
+	assert_int_equal(scc_check_clustering(cl, &options, &is_OK), SCC_ER_OK);
+	assert_true(is_OK);
+	scc_free_clustering(&cl);
+
+	assert_true(scc_reset_clock());
+	scc_free_data_set(&data_set);
+}
+
+
+void scc_ut_anytime_clustering_nonval(void** state)
+{
+	(void) state;
+
+	scc_DataSet* data_set = scc_ut_make_data_set();
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+
+	assert_int_equal(scc_anytime_clustering(NULL, &options, 1.0, cl), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1.0, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, -1.0, cl), SCC_ER_INVALID_INPUT);
+	options.size_constraint = 1;
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1.0, cl), SCC_ER_INVALID_INPUT);
+	options.size_constraint = SCC_UT_NUM_DATA_POINTS + 1;
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1.0, cl), SCC_ER_NO_SOLUTION);
+	options.size_constraint = 3;
+	scc_free_clustering(&cl);
+
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS - 1, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1.0, cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_DATA_POINTS, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 0.0, cl), SCC_ER_OK);
+	assert_int_equal(scc_anytime_clustering(data_set, &options, 1.0, cl), SCC_ER_NOT_IMPLEMENTED);
+	scc_free_clustering(&cl);
+
+	scc_free_data_set(&data_set);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_anytime_clustering_no_time),
+		cmocka_unit_test(scc_ut_anytime_clustering_clock),
+		cmocka_unit_test(scc_ut_anytime_clustering_ample_time),
+		cmocka_unit_test(scc_ut_anytime_clustering_nonval),
+	};
+
+	return cmocka_run_group_tests_name("anytime_clustering.c", test_cases, NULL, NULL);
+}
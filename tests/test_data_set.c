@@ -27,6 +27,7 @@
 #include <src/data_set_struct.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
+#include "double_assert.h"
 
 
 void scc_ut_free_data_set(void** state)
@@ -125,6 +126,9 @@ void scc_ut_get_data_set(void** state)
 	assert_non_null(dso9);
 	assert_int_equal(dso9->num_data_points, 5);
 	assert_int_equal(dso9->num_dimensions, 2);
+	assert_int_equal(dso9->row_stride, 2);
+	assert_int_equal(dso9->column_stride, 1);
+	assert_null(dso9->columns);
 	assert_non_null(dso9->data_matrix);
 	assert_ptr_equal(dso9->data_matrix, coord);
 	assert_memory_equal(dso9->data_matrix, ref_coord, 10 * sizeof(double));
@@ -147,6 +151,396 @@ void scc_ut_get_data_set(void** state)
 }
 
 
+void scc_ut_get_data_set_columns(void** state)
+{
+	(void) state;
+
+	// Three points with four columns, padded to a row stride of five
+	double coord[15] = { 1.0,  2.0,  3.0,  4.0, -1.0,
+	                     5.0,  6.0,  7.0,  8.0, -1.0,
+	                     9.0, 10.0, 11.0, 12.0, -1.0 };
+	uint32_t columns[2] = { 3, 1 };
+	const uint32_t ref_columns[2] = { 3, 1 };
+	const uint32_t leading_columns[2] = { 0, 1 };
+	const uint32_t out_of_stride_columns[2] = { 1, 5 };
+
+	scc_ErrorCode ec1 = scc_init_data_set_columns(3, 2, 5, columns, 15, coord, NULL);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_data_set_columns(3, 2, 5, out_of_stride_columns, 15, coord, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_data_set_columns(3, 2, 1, NULL, 15, coord, &dso3);
+	assert_null(dso3);
+	assert_int_equal(ec3, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_data_set_columns(3, 2, 5, columns, 13, coord, &dso4);
+	assert_null(dso4);
+	assert_int_equal(ec4, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso5;
+	scc_ErrorCode ec5 = scc_init_data_set_columns(3, 2, 5, columns, 14, coord, &dso5);
+	assert_non_null(dso5);
+	assert_int_equal(dso5->num_data_points, 3);
+	assert_int_equal(dso5->num_dimensions, 2);
+	assert_int_equal(dso5->row_stride, 5);
+	assert_non_null(dso5->columns);
+	assert_ptr_not_equal(dso5->columns, columns);
+	columns[0] = 0;
+	assert_memory_equal(dso5->columns, ref_columns, 2 * sizeof(uint32_t));
+	assert_ptr_equal(dso5->data_matrix, coord);
+	assert_int_equal(dso5->data_set_version, ISCC_DATASET_STRUCT_VERSION);
+	assert_int_equal(ec5, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso5));
+
+	scc_DataSet* dso6;
+	scc_ErrorCode ec6 = scc_init_data_set_columns(3, 2, 5, leading_columns, 12, coord, &dso6);
+	assert_non_null(dso6);
+	assert_int_equal(dso6->row_stride, 5);
+	assert_null(dso6->columns);
+	assert_int_equal(ec6, SCC_ER_OK);
+
+	scc_DataSet* dso7;
+	scc_ErrorCode ec7 = scc_init_data_set_columns(3, 3, 5, NULL, 13, coord, &dso7);
+	assert_non_null(dso7);
+	assert_int_equal(dso7->row_stride, 5);
+	assert_null(dso7->columns);
+	assert_int_equal(ec7, SCC_ER_OK);
+
+	scc_free_data_set(&dso5);
+	scc_free_data_set(&dso6);
+	scc_free_data_set(&dso7);
+	assert_null(dso5);
+}
+
+
+void scc_ut_get_data_set_column_major(void** state)
+{
+	(void) state;
+
+	// Three points with three columns, padded to a column stride of four
+	double coord[12] = { 1.0, 2.0, 3.0, -1.0,
+	                     4.0, 5.0, 6.0, -1.0,
+	                     7.0, 8.0, 9.0, -1.0 };
+	const uint32_t columns[2] = { 2, 0 };
+
+	scc_DataSet* dso1;
+	scc_ErrorCode ec1 = scc_init_data_set_column_major(3, 2, 2, NULL, 12, coord, &dso1);
+	assert_null(dso1);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_data_set_column_major(3, 2, 4, columns, 10, coord, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_data_set_column_major(3, 2, 4, columns, 11, coord, &dso3);
+	assert_non_null(dso3);
+	assert_int_equal(dso3->num_data_points, 3);
+	assert_int_equal(dso3->num_dimensions, 2);
+	assert_int_equal(dso3->row_stride, 1);
+	assert_int_equal(dso3->column_stride, 4);
+	assert_non_null(dso3->columns);
+	assert_memory_equal(dso3->columns, columns, 2 * sizeof(uint32_t));
+	assert_ptr_equal(dso3->data_matrix, coord);
+	assert_int_equal(ec3, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso3));
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_data_set_column_major(3, 3, 3, NULL, 9, coord, &dso4);
+	assert_non_null(dso4);
+	assert_int_equal(dso4->row_stride, 1);
+	assert_int_equal(dso4->column_stride, 3);
+	assert_null(dso4->columns);
+	assert_int_equal(ec4, SCC_ER_OK);
+
+	scc_free_data_set(&dso3);
+	scc_free_data_set(&dso4);
+}
+
+
+void scc_ut_get_data_set_column_arrays(void** state)
+{
+	(void) state;
+
+	const double column1[3] = { 1.0, 2.0, 3.0 };
+	const double column2[3] = { 4.0, 5.0, 6.0 };
+	const double* const column_arrays[2] = { column1, column2 };
+	const double* const missing_column[2] = { column1, NULL };
+
+	scc_DataSet* dso1;
+	scc_ErrorCode ec1 = scc_init_data_set_column_arrays(3, 2, NULL, &dso1);
+	assert_null(dso1);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_data_set_column_arrays(3, 2, missing_column, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_data_set_column_arrays(3, 0, column_arrays, &dso3);
+	assert_null(dso3);
+	assert_int_equal(ec3, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_data_set_column_arrays(3, 2, column_arrays, &dso4);
+	assert_non_null(dso4);
+	assert_int_equal(dso4->num_data_points, 3);
+	assert_int_equal(dso4->num_dimensions, 2);
+	assert_int_equal(dso4->row_stride, 1);
+	assert_null(dso4->columns);
+	assert_non_null(dso4->column_arrays);
+	assert_ptr_equal(dso4->column_arrays[0], column1);
+	assert_ptr_equal(dso4->column_arrays[1], column2);
+	assert_int_equal(ec4, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso4));
+
+	scc_free_data_set(&dso4);
+	assert_null(dso4);
+}
+
+
+void scc_ut_get_mixed_data_set(void** state)
+{
+	(void) state;
+
+	// Three points with two numeric and two categorical columns
+	double numeric[6] = { 1.0, 5.0,
+	                      3.0, 5.0,
+	                      2.0, 5.0 };
+	int32_t categorical[6] = { 1, 0,
+	                           2, 0,
+	                           1, 1 };
+	const double ranges[2] = { 4.0, 1.0 };
+	const double bad_ranges[2] = { 4.0, 0.0 };
+	const double weights[2] = { 2.0, 1.0 };
+	const double zero_weights[2] = { 0.0, 0.0 };
+
+	scc_DataSet* dso1;
+	scc_ErrorCode ec1 = scc_init_mixed_data_set(3, 0, 0, NULL, NULL, NULL, 0, 0, NULL, NULL, &dso1);
+	assert_null(dso1);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_mixed_data_set(3, 2, 6, numeric, NULL, NULL, 2, 5, categorical, NULL, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_mixed_data_set(3, 2, 6, numeric, bad_ranges, NULL, 2, 6, categorical, NULL, &dso3);
+	assert_null(dso3);
+	assert_int_equal(ec3, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_mixed_data_set(3, 2, 6, numeric, NULL, zero_weights, 2, 6, categorical, zero_weights, &dso4);
+	assert_null(dso4);
+	assert_int_equal(ec4, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso5;
+	scc_ErrorCode ec5 = scc_init_mixed_data_set(0, 2, 6, numeric, NULL, NULL, 2, 6, categorical, NULL, &dso5);
+	assert_null(dso5);
+	assert_int_equal(ec5, SCC_ER_INVALID_INPUT);
+
+	// Derived ranges: the second numeric column is constant
+	scc_DataSet* dso6;
+	scc_ErrorCode ec6 = scc_init_mixed_data_set(3, 2, 6, numeric, NULL, NULL, 2, 6, categorical, weights, &dso6);
+	assert_non_null(dso6);
+	assert_int_equal(dso6->num_data_points, 3);
+	assert_int_equal(dso6->num_dimensions, 2);
+	assert_int_equal(dso6->num_categorical, 2);
+	assert_ptr_equal(dso6->data_matrix, numeric);
+	assert_ptr_equal(dso6->categorical_matrix, categorical);
+	assert_non_null(dso6->gower_weights);
+	assert_double_equal(dso6->gower_weights[0], 1.0 / (2.0 * 5.0));
+	assert_double_equal(dso6->gower_weights[1], 0.0);
+	assert_double_equal(dso6->gower_weights[2], 2.0 / 5.0);
+	assert_double_equal(dso6->gower_weights[3], 1.0 / 5.0);
+	assert_int_equal(ec6, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso6));
+
+	scc_DataSet* dso7;
+	scc_ErrorCode ec7 = scc_init_mixed_data_set(3, 2, 6, numeric, ranges, weights, 0, 0, NULL, NULL, &dso7);
+	assert_non_null(dso7);
+	assert_int_equal(dso7->num_categorical, 0);
+	assert_null(dso7->categorical_matrix);
+	assert_double_equal(dso7->gower_weights[0], 2.0 / (4.0 * 3.0));
+	assert_double_equal(dso7->gower_weights[1], 1.0 / (1.0 * 3.0));
+	assert_int_equal(ec7, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso7));
+
+	scc_DataSet* dso8;
+	scc_ErrorCode ec8 = scc_init_mixed_data_set(3, 0, 0, NULL, NULL, NULL, 2, 6, categorical, NULL, &dso8);
+	assert_non_null(dso8);
+	assert_int_equal(dso8->num_dimensions, 0);
+	assert_null(dso8->data_matrix);
+	assert_double_equal(dso8->gower_weights[0], 0.5);
+	assert_double_equal(dso8->gower_weights[1], 0.5);
+	assert_int_equal(ec8, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso8));
+
+	scc_free_data_set(&dso6);
+	scc_free_data_set(&dso7);
+	scc_free_data_set(&dso8);
+	assert_null(dso6);
+}
+
+
+void scc_ut_get_binary_data_set(void** state)
+{
+	(void) state;
+
+	// Three points with 70 features in two words each
+	uint64_t bits[6] = { 0x1, 0x3F,
+	                     0xF0, 0x0,
+	                     0xFFFFFFFFFFFFFFFF, 0x1 };
+	uint64_t bad_bits[6] = { 0x1, 0x40,
+	                         0xF0, 0x0,
+	                         0x0, 0x0 };
+
+	scc_DataSet* dso1;
+	scc_ErrorCode ec1 = scc_init_binary_data_set(3, 0, SCC_BD_HAMMING, 6, bits, &dso1);
+	assert_null(dso1);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_binary_data_set(3, 70, SCC_BD_HAMMING, 5, bits, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_binary_data_set(3, 70, SCC_BD_JACCARD, 6, bad_bits, &dso3);
+	assert_null(dso3);
+	assert_int_equal(ec3, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_binary_data_set(3, 70, (scc_BinaryDistance) 99, 6, bits, &dso4);
+	assert_null(dso4);
+	assert_int_equal(ec4, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso5;
+	scc_ErrorCode ec5 = scc_init_binary_data_set(3, 70, SCC_BD_JACCARD, 6, bits, &dso5);
+	assert_non_null(dso5);
+	assert_int_equal(dso5->num_data_points, 3);
+	assert_int_equal(dso5->num_dimensions, 70);
+	assert_int_equal(dso5->row_stride, 2);
+	assert_null(dso5->data_matrix);
+	assert_ptr_equal(dso5->binary_matrix, bits);
+	assert_int_equal(dso5->binary_distance, SCC_BD_JACCARD);
+	assert_int_equal(ec5, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso5));
+
+	scc_DataSet* dso6;
+	scc_ErrorCode ec6 = scc_init_binary_data_set(3, 128, SCC_BD_HAMMING, 6, bad_bits, &dso6);
+	assert_non_null(dso6);
+	assert_int_equal(dso6->row_stride, 2);
+	assert_int_equal(ec6, SCC_ER_OK);
+
+	scc_free_data_set(&dso5);
+	scc_free_data_set(&dso6);
+	assert_null(dso5);
+}
+
+
+void scc_ut_get_geo_data_set(void** state)
+{
+	(void) state;
+
+	double coordinates[6] = { 0.0, 0.0,
+	                          90.0, 45.0,
+	                          0.0, -90.0 };
+	double bad_coordinates[6] = { 0.0, 0.0,
+	                              91.0, 45.0,
+	                              0.0, -90.0 };
+
+	scc_DataSet* dso1;
+	scc_ErrorCode ec1 = scc_init_geo_data_set(3, 5, coordinates, 1.0, &dso1);
+	assert_null(dso1);
+	assert_int_equal(ec1, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso2;
+	scc_ErrorCode ec2 = scc_init_geo_data_set(3, 6, bad_coordinates, 1.0, &dso2);
+	assert_null(dso2);
+	assert_int_equal(ec2, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso3;
+	scc_ErrorCode ec3 = scc_init_geo_data_set(3, 6, coordinates, 0.0, &dso3);
+	assert_null(dso3);
+	assert_int_equal(ec3, SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso4;
+	scc_ErrorCode ec4 = scc_init_geo_data_set(3, 6, coordinates, 6371.0, &dso4);
+	assert_non_null(dso4);
+	assert_int_equal(dso4->num_data_points, 3);
+	assert_int_equal(dso4->num_dimensions, 3);
+	assert_int_equal(dso4->row_stride, 3);
+	assert_non_null(dso4->geo_matrix);
+	assert_ptr_equal(dso4->data_matrix, dso4->geo_matrix);
+	assert_double_equal(dso4->geo_radius, 6371.0);
+	const double ref_embedding[9] = { 1.0, 0.0, 0.0,
+	                                  0.0, 0.0, 1.0,
+	                                  0.0, -1.0, 0.0 };
+	for (size_t i = 0; i < 9; ++i) {
+		assert_double_equal(dso4->geo_matrix[i], ref_embedding[i]);
+	}
+	assert_int_equal(ec4, SCC_ER_OK);
+	assert_true(scc_is_initialized_data_set(dso4));
+
+	scc_free_data_set(&dso4);
+	assert_null(dso4);
+}
+
+
+void scc_ut_add_pca_projection(void** state)
+{
+	(void) state;
+
+	// Points on a line in three dimensions
+	double coord[12] = { 0.0, 0.0, 1.0,
+	                     1.0, 2.0, 1.0,
+	                     2.0, 4.0, 1.0,
+	                     3.0, 6.0, 1.0 };
+	double numeric[4] = { 0.0, 1.0, 2.0, 3.0 };
+	int32_t categorical[4] = { 0, 1, 0, 1 };
+
+	assert_int_equal(scc_add_pca_projection(NULL, 1), SCC_ER_INVALID_INPUT);
+
+	scc_DataSet* dso1;
+	assert_int_equal(scc_init_mixed_data_set(4, 1, 4, numeric, NULL, NULL, 1, 4, categorical, NULL, &dso1), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(dso1, 1), SCC_ER_INVALID_INPUT);
+	assert_null(dso1->projection_matrix);
+	scc_free_data_set(&dso1);
+
+	scc_DataSet* dso2;
+	assert_int_equal(scc_init_data_set(4, 3, 12, coord, &dso2), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(dso2, 0), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_add_pca_projection(dso2, 3), SCC_ER_INVALID_INPUT);
+	assert_null(dso2->projection_matrix);
+
+	// The first component is along the line, so projected distances equal the distances
+	assert_int_equal(scc_add_pca_projection(dso2, 1), SCC_ER_OK);
+	assert_int_equal(dso2->num_components, 1);
+	assert_non_null(dso2->projection_matrix);
+	for (size_t i = 1; i < 4; ++i) {
+		const double proj_dist = fabs(dso2->projection_matrix[i] - dso2->projection_matrix[0]);
+		assert_double_equal(proj_dist, sqrt(5.0) * (double) i);
+	}
+
+	assert_int_equal(scc_add_pca_projection(dso2, 2), SCC_ER_OK);
+	assert_int_equal(dso2->num_components, 2);
+	assert_non_null(dso2->projection_matrix);
+	assert_true(scc_is_initialized_data_set(dso2));
+
+	scc_free_data_set(&dso2);
+	assert_null(dso2);
+}
+
+
 void scc_ut_is_initialized_data_set(void** state)
 {
 	(void) state;
@@ -168,6 +562,13 @@ int main(void)
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_free_data_set),
 		cmocka_unit_test(scc_ut_get_data_set),
+		cmocka_unit_test(scc_ut_get_data_set_columns),
+		cmocka_unit_test(scc_ut_get_data_set_column_major),
+		cmocka_unit_test(scc_ut_get_data_set_column_arrays),
+		cmocka_unit_test(scc_ut_get_mixed_data_set),
+		cmocka_unit_test(scc_ut_get_binary_data_set),
+		cmocka_unit_test(scc_ut_get_geo_data_set),
+		cmocka_unit_test(scc_ut_add_pca_projection),
 		cmocka_unit_test(scc_ut_is_initialized_data_set),
 	};
 
@@ -21,10 +21,15 @@
 #include "init_test.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <src/data_set_struct.h>
 #include <src/dist_search.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
 #include "double_assert.h"
+#include "rand.h"
 
 
 void scc_ut_check_data_set(void** state)
@@ -121,6 +126,879 @@ void scc_ut_get_dist_matrix(void** state)
 }
 
 
+void scc_ut_get_dist_matrix_columns(void** state)
+{
+	(void) state;
+
+	// Points from `scc_ut_test_data_large`, with the columns reversed and
+	// interleaved with unused columns
+	double wide_coord[100 * 7];
+	const double* const coord = ((const scc_DataSet*) scc_ut_test_data_large)->data_matrix;
+	for (size_t i = 0; i < 100; ++i) {
+		for (size_t d = 0; d < 7; ++d) {
+			wide_coord[i * 7 + d] = -1000.0;
+		}
+		wide_coord[i * 7 + 5] = coord[i * 3];
+		wide_coord[i * 7 + 3] = coord[i * 3 + 1];
+		wide_coord[i * 7 + 0] = coord[i * 3 + 2];
+	}
+	const uint32_t columns[3] = { 5, 3, 0 };
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set_columns(100, 3, 7, columns, 100 * 7, wide_coord, &data_set), SCC_ER_OK);
+	assert_true(iscc_check_data_set(data_set));
+
+	double output_ref[4950];
+	double output[4950];
+	assert_true(iscc_get_dist_matrix(scc_ut_test_data_large, 100, NULL, output_ref));
+	assert_true(iscc_get_dist_matrix(data_set, 100, NULL, output));
+	assert_memory_equal(output, output_ref, 4950 * sizeof(double));
+
+	scc_free_data_set(&data_set);
+
+	// Leading columns with padded rows
+	for (size_t i = 0; i < 100; ++i) {
+		wide_coord[i * 7 + 0] = coord[i * 3];
+		wide_coord[i * 7 + 1] = coord[i * 3 + 1];
+		wide_coord[i * 7 + 2] = coord[i * 3 + 2];
+	}
+	assert_int_equal(scc_init_data_set_columns(100, 3, 7, NULL, 100 * 7, wide_coord, &data_set), SCC_ER_OK);
+	assert_true(iscc_get_dist_matrix(data_set, 100, NULL, output));
+	assert_memory_equal(output, output_ref, 4950 * sizeof(double));
+
+	scc_free_data_set(&data_set);
+}
+
+
+// Runs the distance functions on two data sets that should give identical results
+static void scc_ut_check_same_dists(void* const data_set1,
+                                    void* const data_set2,
+                                    const size_t num_data_points)
+{
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_data_points]));
+	double* const dists1 = malloc(sizeof(double[num_data_points * num_data_points]));
+	double* const dists2 = malloc(sizeof(double[num_data_points * num_data_points]));
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_data_points * 5]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_data_points * 5]));
+	scc_PointIndex* const ok1 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok2 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	assert_non_null(indices);
+	assert_non_null(dists1);
+	assert_non_null(dists2);
+	assert_non_null(nn1);
+	assert_non_null(nn2);
+	assert_non_null(ok1);
+	assert_non_null(ok2);
+
+	const size_t num_indices = (num_data_points + 1) / 2;
+	for (size_t i = 0; i < num_indices; ++i) {
+		indices[i] = (scc_PointIndex) (num_data_points - 1 - 2 * i);
+	}
+	const size_t len_dist_matrix = (num_data_points * (num_data_points - 1)) / 2;
+
+	assert_true(iscc_get_dist_matrix(data_set1, num_data_points, NULL, dists1));
+	assert_true(iscc_get_dist_matrix(data_set2, num_data_points, NULL, dists2));
+	assert_memory_equal(dists1, dists2, len_dist_matrix * sizeof(double));
+
+	assert_true(iscc_get_dist_rows(data_set1, 7, indices, num_data_points, NULL, dists1));
+	assert_true(iscc_get_dist_rows(data_set2, 7, indices, num_data_points, NULL, dists2));
+	assert_memory_equal(dists1, dists2, 7 * num_data_points * sizeof(double));
+
+	assert_true(iscc_get_sq_dist_rows(data_set1, 7, NULL, num_indices, indices, dists1));
+	assert_true(iscc_get_sq_dist_rows(data_set2, 7, NULL, num_indices, indices, dists2));
+	assert_memory_equal(dists1, dists2, 7 * num_indices * sizeof(double));
+
+	for (size_t with_indices = 0; with_indices < 2; ++with_indices) {
+		const size_t len_search = (with_indices == 1) ? num_indices : num_data_points;
+		const scc_PointIndex* const search = (with_indices == 1) ? indices : NULL;
+
+		iscc_MaxDistObject* max_dist_object1;
+		iscc_MaxDistObject* max_dist_object2;
+		assert_true(iscc_init_max_dist_object(data_set1, len_search, search, &max_dist_object1));
+		assert_true(iscc_init_max_dist_object(data_set2, len_search, search, &max_dist_object2));
+		assert_true(iscc_get_max_dist(max_dist_object1, 20, NULL, ok1, dists1));
+		assert_true(iscc_get_max_dist(max_dist_object2, 20, NULL, ok2, dists2));
+		assert_memory_equal(ok1, ok2, 20 * sizeof(scc_PointIndex));
+		assert_memory_equal(dists1, dists2, 20 * sizeof(double));
+		assert_true(iscc_close_max_dist_object(&max_dist_object1));
+		assert_true(iscc_close_max_dist_object(&max_dist_object2));
+
+		iscc_NNSearchObject* nn_search_object1;
+		iscc_NNSearchObject* nn_search_object2;
+		assert_true(iscc_init_nn_search_object(data_set1, len_search, search, &nn_search_object1));
+		assert_true(iscc_init_nn_search_object(data_set2, len_search, search, &nn_search_object2));
+		for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+			size_t num_ok1;
+			size_t num_ok2;
+			assert_true(iscc_nearest_neighbor_search(nn_search_object1, num_indices, indices, 5, (radius_search == 1), 8.0, &num_ok1, ok1, nn1));
+			assert_true(iscc_nearest_neighbor_search(nn_search_object2, num_indices, indices, 5, (radius_search == 1), 8.0, &num_ok2, ok2, nn2));
+			assert_int_equal(num_ok1, num_ok2);
+			assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+			assert_memory_equal(nn1, nn2, 5 * num_ok1 * sizeof(scc_PointIndex));
+		}
+		assert_true(iscc_close_nn_search_object(&nn_search_object1));
+		assert_true(iscc_close_nn_search_object(&nn_search_object2));
+	}
+
+	free(indices);
+	free(dists1);
+	free(dists2);
+	free(nn1);
+	free(nn2);
+	free(ok1);
+	free(ok2);
+}
+
+
+void scc_ut_column_major_data_set(void** state)
+{
+	(void) state;
+
+	// More points than fit in one block of distances
+	const size_t num_data_points = 700;
+	const size_t num_columns = 4;
+	const size_t column_stride = 703;
+	double* const row_major = malloc(sizeof(double[num_data_points * num_columns]));
+	double* const column_major = malloc(sizeof(double[column_stride * num_columns]));
+	assert_non_null(row_major);
+	assert_non_null(column_major);
+	srand(20170614);
+	for (size_t i = 0; i < column_stride * num_columns; ++i) {
+		column_major[i] = -1000.0;
+	}
+	for (size_t i = 0; i < num_data_points; ++i) {
+		for (size_t d = 0; d < num_columns; ++d) {
+			row_major[i * num_columns + d] = scc_rand_double(0.0, 100.0);
+			column_major[d * column_stride + i] = row_major[i * num_columns + d];
+		}
+	}
+
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_columns, num_data_points * num_columns, row_major, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set_column_major(num_data_points, (uint32_t) num_columns, column_stride, NULL, column_stride * num_columns, column_major, &data_set2), SCC_ER_OK);
+	scc_ut_check_same_dists(data_set1, data_set2, num_data_points);
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+
+	const uint32_t columns[2] = { 3, 1 };
+	assert_int_equal(scc_init_data_set_columns(num_data_points, 2, num_columns, columns, num_data_points * num_columns, row_major, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set_column_major(num_data_points, 2, column_stride, columns, column_stride * num_columns, column_major, &data_set2), SCC_ER_OK);
+	scc_ut_check_same_dists(data_set1, data_set2, num_data_points);
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+
+	// Columns in separate arrays, read with and without a search index
+	const double* column_arrays[2];
+	for (size_t d = 0; d < 2; ++d) {
+		double* const column = malloc(sizeof(double[num_data_points]));
+		assert_non_null(column);
+		memcpy(column, column_major + columns[d] * column_stride, sizeof(double[num_data_points]));
+		column_arrays[d] = column;
+	}
+	assert_int_equal(scc_init_data_set_columns(num_data_points, 2, num_columns, columns, num_data_points * num_columns, row_major, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set_column_arrays(num_data_points, 2, column_arrays, &data_set2), SCC_ER_OK);
+	scc_ut_check_same_dists(data_set1, data_set2, num_data_points);
+	assert_int_equal(scc_build_search_index(data_set1), SCC_ER_OK);
+	assert_int_equal(scc_build_search_index(data_set2), SCC_ER_OK);
+	scc_ut_check_same_dists(data_set1, data_set2, num_data_points);
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	free((void*) column_arrays[0]);
+	free((void*) column_arrays[1]);
+
+	free(row_major);
+	free(column_major);
+}
+
+
+// Reference Gower distance with unit weights and derived ranges
+static double scc_ut_gower_dist(const double numeric[const],
+                                const double ranges[const],
+                                const int32_t categorical[const],
+                                const size_t index1,
+                                const size_t index2)
+{
+	double dist = 0.0;
+	for (size_t d = 0; d < 2; ++d) {
+		dist += fabs(numeric[index1 * 2 + d] - numeric[index2 * 2 + d]) / ranges[d];
+	}
+	for (size_t c = 0; c < 3; ++c) {
+		dist += (categorical[index1 * 3 + c] == categorical[index2 * 3 + c]) ? 0.0 : 1.0;
+	}
+	return dist / 5.0;
+}
+
+
+static int scc_ut_cmp_doubles(const void* const a,
+                              const void* const b)
+{
+	const double da = *((const double*) a);
+	const double db = *((const double*) b);
+	return (da > db) - (da < db);
+}
+
+
+void scc_ut_gower_data_set(void** state)
+{
+	(void) state;
+
+	const size_t num_data_points = 600;
+	double* const numeric = malloc(sizeof(double[num_data_points * 2]));
+	int32_t* const categorical = malloc(sizeof(int32_t[num_data_points * 3]));
+	double* const ref_dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	double* const dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	scc_PointIndex* const ok_queries = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn_indices = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	assert_non_null(numeric);
+	assert_non_null(categorical);
+	assert_non_null(ref_dists);
+	assert_non_null(dists);
+	assert_non_null(ok_queries);
+	assert_non_null(nn_indices);
+
+	srand(20170701);
+	double ranges[2] = { 0.0, 0.0 };
+	for (size_t i = 0; i < num_data_points; ++i) {
+		numeric[i * 2] = scc_rand_double(0.0, 10.0);
+		numeric[i * 2 + 1] = scc_rand_double(-50.0, 50.0);
+		for (size_t c = 0; c < 3; ++c) {
+			categorical[i * 3 + c] = (int32_t) (rand() % (int) (c + 2));
+		}
+	}
+	for (size_t d = 0; d < 2; ++d) {
+		double min_value = numeric[d];
+		double max_value = numeric[d];
+		for (size_t i = 1; i < num_data_points; ++i) {
+			if (numeric[i * 2 + d] < min_value) min_value = numeric[i * 2 + d];
+			if (numeric[i * 2 + d] > max_value) max_value = numeric[i * 2 + d];
+		}
+		ranges[d] = max_value - min_value;
+	}
+	for (size_t i = 0; i < num_data_points; ++i) {
+		for (size_t j = 0; j < num_data_points; ++j) {
+			ref_dists[i * num_data_points + j] = scc_ut_gower_dist(numeric, ranges, categorical, i, j);
+		}
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_mixed_data_set(num_data_points, 2, num_data_points * 2, numeric, NULL, NULL,
+	                                         3, num_data_points * 3, categorical, NULL, &data_set), SCC_ER_OK);
+
+	assert_true(iscc_get_dist_matrix(data_set, num_data_points, NULL, dists));
+	const double* dist_read = dists;
+	for (size_t i = 0; i < num_data_points; ++i) {
+		for (size_t j = i + 1; j < num_data_points; ++j) {
+			assert_double_equal(*dist_read, ref_dists[i * num_data_points + j]);
+			++dist_read;
+		}
+	}
+
+	assert_true(iscc_get_sq_dist_rows(data_set, num_data_points, NULL, num_data_points, NULL, dists));
+	for (size_t i = 0; i < num_data_points * num_data_points; ++i) {
+		assert_double_equal(dists[i], ref_dists[i] * ref_dists[i]);
+	}
+
+	iscc_MaxDistObject* max_dist_object;
+	assert_true(iscc_init_max_dist_object(data_set, num_data_points, NULL, &max_dist_object));
+	assert_true(iscc_get_max_dist(max_dist_object, num_data_points, NULL, ok_queries, dists));
+	for (size_t i = 0; i < num_data_points; ++i) {
+		assert_double_equal(dists[i], ref_dists[i * num_data_points + ok_queries[i]]);
+		for (size_t j = 0; j < num_data_points; ++j) {
+			assert_true(ref_dists[i * num_data_points + j] <= dists[i] + SCC_DOUBLE_EPSILON);
+		}
+	}
+	assert_true(iscc_close_max_dist_object(&max_dist_object));
+
+	// Gower distances have many ties, so compare the distances of the neighbors rather than the indices
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, num_data_points, NULL, &nn_search_object));
+	for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+		const double radius = 0.15;
+		size_t num_ok_queries;
+		assert_true(iscc_nearest_neighbor_search(nn_search_object, num_data_points, NULL, 4, (radius_search == 1), radius, &num_ok_queries, ok_queries, nn_indices));
+		size_t ok_read = 0;
+		for (size_t i = 0; i < num_data_points; ++i) {
+			double* const row = ref_dists + i * num_data_points;
+			qsort(row, num_data_points, sizeof(double), scc_ut_cmp_doubles);
+			if ((radius_search == 1) && (row[3] > radius)) continue;
+			assert_true(ok_read < num_ok_queries);
+			assert_int_equal(ok_queries[ok_read], i);
+			for (size_t k = 0; k < 4; ++k) {
+				const double nn_dist = scc_ut_gower_dist(numeric, ranges, categorical, i, nn_indices[ok_read * 4 + k]);
+				assert_double_equal(nn_dist, row[k]);
+			}
+			++ok_read;
+		}
+		assert_int_equal(ok_read, num_ok_queries);
+	}
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+
+	scc_free_data_set(&data_set);
+	free(numeric);
+	free(categorical);
+	free(ref_dists);
+	free(dists);
+	free(ok_queries);
+	free(nn_indices);
+}
+
+
+// Reference binary distance computed bit by bit
+static double scc_ut_binary_dist(const uint64_t bits[const],
+                                 const size_t num_features,
+                                 const scc_BinaryDistance distance,
+                                 const size_t index1,
+                                 const size_t index2)
+{
+	const size_t num_words = (num_features + 63) / 64;
+	size_t num_differ = 0;
+	size_t num_either = 0;
+	for (size_t f = 0; f < num_features; ++f) {
+		const bool bit1 = (bits[index1 * num_words + f / 64] >> (f % 64)) & 1;
+		const bool bit2 = (bits[index2 * num_words + f / 64] >> (f % 64)) & 1;
+		num_differ += (bit1 != bit2);
+		num_either += (bit1 || bit2);
+	}
+	if (distance == SCC_BD_HAMMING) return (double) num_differ;
+	return (num_either == 0) ? 0.0 : ((double) num_differ) / ((double) num_either);
+}
+
+
+void scc_ut_binary_data_set(void** state)
+{
+	(void) state;
+
+	const size_t num_data_points = 400;
+	const size_t num_features = 100;
+	const size_t num_words = 2;
+	uint64_t* const bits = malloc(sizeof(uint64_t[num_data_points * num_words]));
+	double* const ref_dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	double* const dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	scc_PointIndex* const ok_queries = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn_indices = malloc(sizeof(scc_PointIndex[num_data_points * 3]));
+	assert_non_null(bits);
+	assert_non_null(ref_dists);
+	assert_non_null(dists);
+	assert_non_null(ok_queries);
+	assert_non_null(nn_indices);
+
+	// Sparse features, and some points without any features
+	srand(20170702);
+	for (size_t i = 0; i < num_data_points * num_words; ++i) {
+		bits[i] = 0;
+	}
+	for (size_t i = 10; i < num_data_points; ++i) {
+		for (size_t f = 0; f < num_features; ++f) {
+			if (rand() % 8 == 0) bits[i * num_words + f / 64] |= ((uint64_t) 1) << (f % 64);
+		}
+	}
+
+	const scc_BinaryDistance distances[2] = { SCC_BD_HAMMING, SCC_BD_JACCARD };
+	for (size_t m = 0; m < 2; ++m) {
+		for (size_t i = 0; i < num_data_points; ++i) {
+			for (size_t j = 0; j < num_data_points; ++j) {
+				ref_dists[i * num_data_points + j] = scc_ut_binary_dist(bits, num_features, distances[m], i, j);
+			}
+		}
+
+		scc_DataSet* data_set;
+		assert_int_equal(scc_init_binary_data_set(num_data_points, (uint32_t) num_features, distances[m],
+		                                          num_data_points * num_words, bits, &data_set), SCC_ER_OK);
+
+		assert_true(iscc_get_dist_rows(data_set, num_data_points, NULL, num_data_points, NULL, dists));
+		for (size_t i = 0; i < num_data_points * num_data_points; ++i) {
+			assert_double_equal(dists[i], ref_dists[i]);
+		}
+
+		assert_true(iscc_get_sq_dist_rows(data_set, 20, NULL, num_data_points, NULL, dists));
+		for (size_t i = 0; i < 20 * num_data_points; ++i) {
+			assert_double_equal(dists[i], ref_dists[i] * ref_dists[i]);
+		}
+
+		iscc_MaxDistObject* max_dist_object;
+		assert_true(iscc_init_max_dist_object(data_set, num_data_points, NULL, &max_dist_object));
+		assert_true(iscc_get_max_dist(max_dist_object, num_data_points, NULL, ok_queries, dists));
+		for (size_t i = 0; i < num_data_points; ++i) {
+			assert_double_equal(dists[i], ref_dists[i * num_data_points + ok_queries[i]]);
+			for (size_t j = 0; j < num_data_points; ++j) {
+				assert_true(ref_dists[i * num_data_points + j] <= dists[i] + SCC_DOUBLE_EPSILON);
+			}
+		}
+		assert_true(iscc_close_max_dist_object(&max_dist_object));
+
+		// Many ties, so compare the distances of the neighbors rather than the indices
+		const double radius = (distances[m] == SCC_BD_HAMMING) ? 18.0 : 0.9;
+		iscc_NNSearchObject* nn_search_object;
+		assert_true(iscc_init_nn_search_object(data_set, num_data_points, NULL, &nn_search_object));
+		for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+			size_t num_ok_queries;
+			assert_true(iscc_nearest_neighbor_search(nn_search_object, num_data_points, NULL, 3, (radius_search == 1), radius, &num_ok_queries, ok_queries, nn_indices));
+			size_t ok_read = 0;
+			for (size_t i = 0; i < num_data_points; ++i) {
+				double* const row = ref_dists + i * num_data_points;
+				qsort(row, num_data_points, sizeof(double), scc_ut_cmp_doubles);
+				if ((radius_search == 1) && (row[2] > radius)) continue;
+				assert_true(ok_read < num_ok_queries);
+				assert_int_equal(ok_queries[ok_read], i);
+				for (size_t k = 0; k < 3; ++k) {
+					const double nn_dist = scc_ut_binary_dist(bits, num_features, distances[m], i, nn_indices[ok_read * 3 + k]);
+					assert_double_equal(nn_dist, row[k]);
+				}
+				++ok_read;
+			}
+			assert_int_equal(ok_read, num_ok_queries);
+		}
+		assert_true(iscc_close_nn_search_object(&nn_search_object));
+
+		scc_free_data_set(&data_set);
+	}
+
+	free(bits);
+	free(ref_dists);
+	free(dists);
+	free(ok_queries);
+	free(nn_indices);
+}
+
+
+// Reference great-circle distance with the haversine formula, on a sphere with radius 100
+static double scc_ut_geo_dist(const double coordinates[const],
+                              const size_t index1,
+                              const size_t index2)
+{
+	const double to_radians = 3.14159265358979323846 / 180.0;
+	const double lat1 = coordinates[2 * index1] * to_radians;
+	const double lat2 = coordinates[2 * index2] * to_radians;
+	const double sin_dlat = sin((lat2 - lat1) / 2.0);
+	const double sin_dlon = sin((coordinates[2 * index2 + 1] - coordinates[2 * index1 + 1]) * to_radians / 2.0);
+	const double a = sin_dlat * sin_dlat + cos(lat1) * cos(lat2) * sin_dlon * sin_dlon;
+	return 100.0 * 2.0 * asin(sqrt((a < 1.0) ? a : 1.0));
+}
+
+
+void scc_ut_geo_data_set(void** state)
+{
+	(void) state;
+
+	const size_t num_data_points = 500;
+	double* const coordinates = malloc(sizeof(double[num_data_points * 2]));
+	double* const ref_dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	double* const dists = malloc(sizeof(double[num_data_points * num_data_points]));
+	scc_PointIndex* const ok_queries = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn_indices = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	assert_non_null(coordinates);
+	assert_non_null(ref_dists);
+	assert_non_null(dists);
+	assert_non_null(ok_queries);
+	assert_non_null(nn_indices);
+
+	// Includes points near the poles and on both sides of the antimeridian
+	srand(20170703);
+	for (size_t i = 0; i < num_data_points; ++i) {
+		coordinates[2 * i] = scc_rand_double(-90.0, 90.0);
+		coordinates[2 * i + 1] = scc_rand_double(-180.0, 180.0);
+	}
+	for (size_t i = 0; i < num_data_points; ++i) {
+		for (size_t j = 0; j < num_data_points; ++j) {
+			ref_dists[i * num_data_points + j] = scc_ut_geo_dist(coordinates, i, j);
+		}
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_geo_data_set(num_data_points, num_data_points * 2, coordinates, 100.0, &data_set), SCC_ER_OK);
+
+	assert_true(iscc_get_dist_rows(data_set, num_data_points, NULL, num_data_points, NULL, dists));
+	for (size_t i = 0; i < num_data_points * num_data_points; ++i) {
+		assert_true(fabs(dists[i] - ref_dists[i]) < 0.0001);
+	}
+
+	iscc_MaxDistObject* max_dist_object;
+	assert_true(iscc_init_max_dist_object(data_set, num_data_points, NULL, &max_dist_object));
+	assert_true(iscc_get_max_dist(max_dist_object, num_data_points, NULL, ok_queries, dists));
+	for (size_t i = 0; i < num_data_points; ++i) {
+		assert_true(fabs(dists[i] - ref_dists[i * num_data_points + ok_queries[i]]) < 0.0001);
+		for (size_t j = 0; j < num_data_points; ++j) {
+			assert_true(ref_dists[i * num_data_points + j] <= dists[i] + 0.0001);
+		}
+	}
+	assert_true(iscc_close_max_dist_object(&max_dist_object));
+
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, num_data_points, NULL, &nn_search_object));
+	for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+		const double radius = 15.0;
+		size_t num_ok_queries;
+		assert_true(iscc_nearest_neighbor_search(nn_search_object, num_data_points, NULL, 4, (radius_search == 1), radius, &num_ok_queries, ok_queries, nn_indices));
+		size_t ok_read = 0;
+		for (size_t i = 0; i < num_data_points; ++i) {
+			double* const row = ref_dists + i * num_data_points;
+			qsort(row, num_data_points, sizeof(double), scc_ut_cmp_doubles);
+			if ((radius_search == 1) && (row[3] > radius)) continue;
+			assert_true(ok_read < num_ok_queries);
+			assert_int_equal(ok_queries[ok_read], i);
+			for (size_t k = 0; k < 4; ++k) {
+				const double nn_dist = scc_ut_geo_dist(coordinates, i, nn_indices[ok_read * 4 + k]);
+				assert_true(fabs(nn_dist - row[k]) < 0.0001);
+			}
+			++ok_read;
+		}
+		assert_int_equal(ok_read, num_ok_queries);
+	}
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+
+	scc_free_data_set(&data_set);
+	free(coordinates);
+	free(ref_dists);
+	free(dists);
+	free(ok_queries);
+	free(nn_indices);
+}
+
+
+void scc_ut_pca_projection_search(void** state)
+{
+	(void) state;
+
+	// Data near a five-dimensional subspace of a 120-dimensional space
+	const size_t num_data_points = 700;
+	const size_t num_dimensions = 120;
+	double* const data_matrix = malloc(sizeof(double[num_data_points * num_dimensions]));
+	double* const loadings = malloc(sizeof(double[5 * num_dimensions]));
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok1 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok2 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_data_points * 6]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_data_points * 6]));
+	assert_non_null(data_matrix);
+	assert_non_null(loadings);
+	assert_non_null(indices);
+	assert_non_null(ok1);
+	assert_non_null(ok2);
+	assert_non_null(nn1);
+	assert_non_null(nn2);
+
+	srand(20170704);
+	for (size_t i = 0; i < 5 * num_dimensions; ++i) {
+		loadings[i] = scc_rand_double(-1.0, 1.0);
+	}
+	for (size_t i = 0; i < num_data_points; ++i) {
+		double factors[5];
+		for (size_t f = 0; f < 5; ++f) {
+			factors[f] = scc_rand_double(-10.0, 10.0);
+		}
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			double value = scc_rand_double(-0.5, 0.5);
+			for (size_t f = 0; f < 5; ++f) {
+				value += factors[f] * loadings[f * num_dimensions + d];
+			}
+			data_matrix[i * num_dimensions + d] = value;
+		}
+	}
+	for (size_t i = 0; i < num_data_points / 2; ++i) {
+		indices[i] = (scc_PointIndex) (2 * i + 1);
+	}
+
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set2), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(data_set2, 6), SCC_ER_OK);
+
+	// Projected distances are lower bounds
+	for (size_t i = 0; i < 50; ++i) {
+		for (size_t j = 0; j < num_data_points; ++j) {
+			double sq_dist = 0.0;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				const double diff = data_matrix[i * num_dimensions + d] - data_matrix[j * num_dimensions + d];
+				sq_dist += diff * diff;
+			}
+			double proj_sq_dist = 0.0;
+			for (size_t c = 0; c < 6; ++c) {
+				const double diff = data_set2->projection_matrix[i * 6 + c] - data_set2->projection_matrix[j * 6 + c];
+				proj_sq_dist += diff * diff;
+			}
+			assert_true(proj_sq_dist <= sq_dist * (1.0 + 1e-12) + 1e-12);
+		}
+	}
+
+	// The search results are identical with and without the projection
+	for (size_t with_indices = 0; with_indices < 2; ++with_indices) {
+		const size_t len_search = (with_indices == 1) ? (num_data_points / 2) : num_data_points;
+		const scc_PointIndex* const search = (with_indices == 1) ? indices : NULL;
+		iscc_NNSearchObject* nn_search_object1;
+		iscc_NNSearchObject* nn_search_object2;
+		assert_true(iscc_init_nn_search_object(data_set1, len_search, search, &nn_search_object1));
+		assert_true(iscc_init_nn_search_object(data_set2, len_search, search, &nn_search_object2));
+		for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+			size_t num_ok1;
+			size_t num_ok2;
+			assert_true(iscc_nearest_neighbor_search(nn_search_object1, num_data_points, NULL, 6, (radius_search == 1), 45.0, &num_ok1, ok1, nn1));
+			assert_true(iscc_nearest_neighbor_search(nn_search_object2, num_data_points, NULL, 6, (radius_search == 1), 45.0, &num_ok2, ok2, nn2));
+			assert_int_equal(num_ok1, num_ok2);
+			assert_true(num_ok1 > 0);
+			assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+			assert_memory_equal(nn1, nn2, 6 * num_ok1 * sizeof(scc_PointIndex));
+		}
+		assert_true(iscc_close_nn_search_object(&nn_search_object1));
+		assert_true(iscc_close_nn_search_object(&nn_search_object2));
+	}
+
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	free(data_matrix);
+	free(loadings);
+	free(indices);
+	free(ok1);
+	free(ok2);
+	free(nn1);
+	free(nn2);
+}
+
+
+void scc_ut_kd_tree_search(void** state)
+{
+	(void) state;
+
+	// Points on a small integer grid, so many distances are tied
+	const size_t num_data_points = 3000;
+	const size_t num_dimensions = 3;
+	double* const data_matrix = malloc(sizeof(double[num_data_points * num_dimensions]));
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok1 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok2 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_data_points * 7]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_data_points * 7]));
+	assert_non_null(data_matrix);
+	assert_non_null(indices);
+	assert_non_null(ok1);
+	assert_non_null(ok2);
+	assert_non_null(nn1);
+	assert_non_null(nn2);
+
+	srand(20170705);
+	for (size_t i = 0; i < num_data_points * num_dimensions; ++i) {
+		data_matrix[i] = (double) (rand() % 12);
+	}
+	for (size_t i = 0; i < num_data_points / 3; ++i) {
+		indices[i] = (scc_PointIndex) (3 * i + 2);
+	}
+
+	// The data set with a projection is searched with a linear scan, the other with kd-trees
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set2), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(data_set1, 2), SCC_ER_OK);
+
+	for (size_t with_indices = 0; with_indices < 2; ++with_indices) {
+		const size_t len_search = (with_indices == 1) ? (num_data_points / 3) : num_data_points;
+		const scc_PointIndex* const search = (with_indices == 1) ? indices : NULL;
+		iscc_NNSearchObject* nn_search_object1;
+		iscc_NNSearchObject* nn_search_object2;
+		assert_true(iscc_init_nn_search_object(data_set1, len_search, search, &nn_search_object1));
+		assert_true(iscc_init_nn_search_object(data_set2, len_search, search, &nn_search_object2));
+		for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+			for (uint32_t k = 1; k <= 7; k += 3) {
+				size_t num_ok1;
+				size_t num_ok2;
+				assert_true(iscc_nearest_neighbor_search(nn_search_object1, num_data_points, NULL, k, (radius_search == 1), 1.5, &num_ok1, ok1, nn1));
+				assert_true(iscc_nearest_neighbor_search(nn_search_object2, num_data_points, NULL, k, (radius_search == 1), 1.5, &num_ok2, ok2, nn2));
+				assert_int_equal(num_ok1, num_ok2);
+				assert_true(num_ok1 > 0);
+				assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+				assert_memory_equal(nn1, nn2, k * num_ok1 * sizeof(scc_PointIndex));
+
+				assert_true(iscc_nearest_neighbor_search(nn_search_object1, num_data_points / 3, indices, k, (radius_search == 1), 1.5, &num_ok1, ok1, nn1));
+				assert_true(iscc_nearest_neighbor_search(nn_search_object2, num_data_points / 3, indices, k, (radius_search == 1), 1.5, &num_ok2, ok2, nn2));
+				assert_int_equal(num_ok1, num_ok2);
+				assert_true(num_ok1 > 0);
+				assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+				assert_memory_equal(nn1, nn2, k * num_ok1 * sizeof(scc_PointIndex));
+			}
+		}
+		assert_true(iscc_close_nn_search_object(&nn_search_object1));
+		assert_true(iscc_close_nn_search_object(&nn_search_object2));
+	}
+
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	free(data_matrix);
+	free(indices);
+	free(ok1);
+	free(ok2);
+	free(nn1);
+	free(nn2);
+}
+
+
+// The kd-tree is built only once enough queries are made, and the results do not change when it is
+void scc_ut_kd_tree_deferred(void** state)
+{
+	(void) state;
+
+	const size_t num_data_points = 3000;
+	const size_t num_dimensions = 2;
+	const size_t batch_size = 5;
+	double* const data_matrix = malloc(sizeof(double[num_data_points * num_dimensions]));
+	scc_PointIndex* const ok1 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok2 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	assert_non_null(data_matrix);
+	assert_non_null(ok1);
+	assert_non_null(ok2);
+	assert_non_null(nn1);
+	assert_non_null(nn2);
+
+	srand(20170707);
+	for (size_t i = 0; i < num_data_points * num_dimensions; ++i) {
+		data_matrix[i] = (double) (rand() % 20);
+	}
+
+	// The data set with a projection is always scanned
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set2), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(data_set1, 1), SCC_ER_OK);
+
+	// Small batches are scanned until their total justifies a tree
+	iscc_NNSearchObject* nn_search_object1;
+	iscc_NNSearchObject* nn_search_object2;
+	assert_true(iscc_init_nn_search_object(data_set1, num_data_points, NULL, &nn_search_object1));
+	assert_true(iscc_init_nn_search_object(data_set2, num_data_points, NULL, &nn_search_object2));
+	for (size_t batch_start = 0; batch_start < num_data_points; batch_start += 20 * batch_size) {
+		scc_PointIndex queries[5];
+		for (size_t q = 0; q < batch_size; ++q) {
+			queries[q] = (scc_PointIndex) (batch_start + q);
+		}
+		size_t num_ok1;
+		size_t num_ok2;
+		assert_true(iscc_nearest_neighbor_search(nn_search_object1, batch_size, queries, 4, true, 2.5, &num_ok1, ok1, nn1));
+		assert_true(iscc_nearest_neighbor_search(nn_search_object2, batch_size, queries, 4, true, 2.5, &num_ok2, ok2, nn2));
+		assert_int_equal(num_ok1, num_ok2);
+		assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+		assert_memory_equal(nn1, nn2, 4 * num_ok1 * sizeof(scc_PointIndex));
+	}
+	assert_true(iscc_close_nn_search_object(&nn_search_object1));
+	assert_true(iscc_close_nn_search_object(&nn_search_object2));
+
+	// Queries announced before a loop build the tree before the loop bodies search
+	assert_true(iscc_init_nn_search_object(data_set1, num_data_points, NULL, &nn_search_object1));
+	assert_true(iscc_init_nn_search_object(data_set2, num_data_points, NULL, &nn_search_object2));
+	assert_true(iscc_expect_nn_queries(nn_search_object1, num_data_points));
+	assert_true(iscc_expect_nn_queries(nn_search_object2, num_data_points));
+	iscc_set_nn_search_in_parallel_loop(nn_search_object1, true);
+	iscc_set_nn_search_in_parallel_loop(nn_search_object2, true);
+	for (size_t batch_start = 0; batch_start < num_data_points; batch_start += 500) {
+		size_t num_ok1;
+		size_t num_ok2;
+		scc_PointIndex batch[500];
+		for (size_t q = 0; q < 500; ++q) {
+			batch[q] = (scc_PointIndex) (batch_start + q);
+		}
+		assert_true(iscc_nearest_neighbor_search(nn_search_object1, 500, batch, 3, false, 0.0, &num_ok1, NULL, nn1));
+		assert_true(iscc_nearest_neighbor_search(nn_search_object2, 500, batch, 3, false, 0.0, &num_ok2, NULL, nn2));
+		assert_int_equal(num_ok1, 500);
+		assert_int_equal(num_ok2, 500);
+		assert_memory_equal(nn1, nn2, 3 * 500 * sizeof(scc_PointIndex));
+	}
+	iscc_set_nn_search_in_parallel_loop(nn_search_object1, false);
+	iscc_set_nn_search_in_parallel_loop(nn_search_object2, false);
+	assert_true(iscc_close_nn_search_object(&nn_search_object1));
+	assert_true(iscc_close_nn_search_object(&nn_search_object2));
+
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	free(data_matrix);
+	free(ok1);
+	free(ok2);
+	free(nn1);
+	free(nn2);
+}
+
+
+void scc_ut_search_index(void** state)
+{
+	(void) state;
+
+	const char* const index_path = "scc_ut_search_index.tmp";
+	const size_t num_data_points = 2000;
+	const size_t num_dimensions = 3;
+	double* const data_matrix = malloc(sizeof(double[num_data_points * num_dimensions]));
+	double* const other_matrix = malloc(sizeof(double[num_data_points * num_dimensions]));
+	scc_PointIndex* const ok1 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const ok2 = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_data_points * 4]));
+	assert_non_null(data_matrix);
+	assert_non_null(other_matrix);
+	assert_non_null(ok1);
+	assert_non_null(ok2);
+	assert_non_null(nn1);
+	assert_non_null(nn2);
+
+	srand(20170706);
+	for (size_t i = 0; i < num_data_points * num_dimensions; ++i) {
+		data_matrix[i] = other_matrix[i] = (double) (rand() % 12);
+	}
+	other_matrix[7] = 100.0;
+
+	// The data set with a projection is searched with a linear scan
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	scc_DataSet* data_set3;
+	scc_DataSet* other_data_set;
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set2), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, data_matrix, &data_set3), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_data_points, (uint32_t) num_dimensions, num_data_points * num_dimensions, other_matrix, &other_data_set), SCC_ER_OK);
+	assert_int_equal(scc_add_pca_projection(data_set1, 2), SCC_ER_OK);
+
+	assert_int_equal(scc_save_search_index(data_set2, index_path), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_load_search_index(data_set3, "scc_ut_no_such_file.tmp"), SCC_ER_IO_ERROR);
+	assert_int_equal(scc_build_search_index(data_set2), SCC_ER_OK);
+	assert_int_equal(scc_save_search_index(data_set2, index_path), SCC_ER_OK);
+	assert_int_equal(scc_load_search_index(data_set3, index_path), SCC_ER_OK);
+	assert_non_null(data_set3->search_index);
+	assert_int_equal(scc_load_search_index(other_data_set, index_path), SCC_ER_INVALID_INPUT);
+	assert_null(other_data_set->search_index);
+	remove(index_path);
+
+	scc_DataSet* const indexed_data_sets[2] = { data_set2, data_set3 };
+	for (size_t i = 0; i < 2; ++i) {
+		iscc_NNSearchObject* nn_search_object1;
+		iscc_NNSearchObject* nn_search_object2;
+		assert_true(iscc_init_nn_search_object(data_set1, num_data_points, NULL, &nn_search_object1));
+		assert_true(iscc_init_nn_search_object(indexed_data_sets[i], num_data_points, NULL, &nn_search_object2));
+		for (size_t radius_search = 0; radius_search < 2; ++radius_search) {
+			size_t num_ok1;
+			size_t num_ok2;
+			assert_true(iscc_nearest_neighbor_search(nn_search_object1, num_data_points, NULL, 4, (radius_search == 1), 1.5, &num_ok1, ok1, nn1));
+			assert_true(iscc_nearest_neighbor_search(nn_search_object2, num_data_points, NULL, 4, (radius_search == 1), 1.5, &num_ok2, ok2, nn2));
+			assert_int_equal(num_ok1, num_ok2);
+			assert_true(num_ok1 > 0);
+			assert_memory_equal(ok1, ok2, num_ok1 * sizeof(scc_PointIndex));
+			assert_memory_equal(nn1, nn2, 4 * num_ok1 * sizeof(scc_PointIndex));
+		}
+		assert_true(iscc_close_nn_search_object(&nn_search_object1));
+		assert_true(iscc_close_nn_search_object(&nn_search_object2));
+	}
+
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	scc_free_data_set(&data_set3);
+	scc_free_data_set(&other_data_set);
+	free(data_matrix);
+	free(other_matrix);
+	free(ok1);
+	free(ok2);
+	free(nn1);
+	free(nn2);
+}
+
+
 void scc_ut_get_dist_rows(void** state)
 {
 	(void) state;
@@ -698,6 +1576,67 @@ void scc_ut_get_max_dist(void** state)
 }
 
 
+void scc_ut_get_sq_dists(void** state)
+{
+	(void) state;
+
+	scc_PointIndex query[3] = { 0, 7, 33 };
+	scc_PointIndex column[5] = { 2, 4, 76, 89, 99 };
+	double dists[15];
+	double sq_dists[15];
+	scc_PointIndex max_ids[3];
+	scc_PointIndex sq_max_ids[3];
+	double max_dists[3];
+	double sq_max_dists[3];
+
+	assert_true(iscc_get_dist_rows(scc_ut_test_data_large, 3, query, 5, column, dists));
+	assert_true(iscc_get_sq_dist_rows(scc_ut_test_data_large, 3, query, 5, column, sq_dists));
+	for (size_t i = 0; i < 15; ++i) {
+		assert_double_equal(sqrt(sq_dists[i]), dists[i]);
+	}
+
+	iscc_MaxDistObject* max_dist_object;
+	assert_true(iscc_init_max_dist_object(scc_ut_test_data_large, 5, column, &max_dist_object));
+	assert_true(iscc_get_max_dist(max_dist_object, 3, query, max_ids, max_dists));
+	assert_true(iscc_get_sq_max_dist(max_dist_object, 3, query, sq_max_ids, sq_max_dists));
+	for (size_t i = 0; i < 3; ++i) {
+		assert_int_equal(sq_max_ids[i], max_ids[i]);
+		assert_double_equal(sqrt(sq_max_dists[i]), max_dists[i]);
+	}
+
+	// Replacing the regular functions clears the variants, regular outputs are then squared
+	const iscc_dist_functions_struct saved_dist_functions = iscc_dist_functions;
+	assert_true(scc_set_dist_functions(NULL, NULL, NULL,
+	                                   iscc_dist_functions.get_dist_rows,
+	                                   iscc_dist_functions.init_max_dist_object,
+	                                   iscc_dist_functions.get_max_dist,
+	                                   iscc_dist_functions.close_max_dist_object,
+	                                   NULL, NULL, NULL));
+	assert_null(iscc_dist_functions.get_sq_dist_rows);
+	assert_null(iscc_dist_functions.get_sq_max_dist);
+
+	double fallback_sq_dists[15];
+	double fallback_sq_max_dists[3];
+	assert_true(iscc_get_sq_dist_rows(scc_ut_test_data_large, 3, query, 5, column, fallback_sq_dists));
+	assert_true(iscc_get_sq_max_dist(max_dist_object, 3, query, sq_max_ids, fallback_sq_max_dists));
+	for (size_t i = 0; i < 15; ++i) {
+		assert_double_equal(fallback_sq_dists[i], dists[i] * dists[i]);
+	}
+	for (size_t i = 0; i < 3; ++i) {
+		assert_int_equal(sq_max_ids[i], max_ids[i]);
+		assert_double_equal(fallback_sq_max_dists[i], max_dists[i] * max_dists[i]);
+	}
+
+	assert_true(scc_set_sq_dist_functions(saved_dist_functions.get_sq_dist_rows,
+	                                      saved_dist_functions.get_sq_max_dist));
+	assert_ptr_equal(iscc_dist_functions.get_sq_dist_rows, saved_dist_functions.get_sq_dist_rows);
+	assert_ptr_equal(iscc_dist_functions.get_sq_max_dist, saved_dist_functions.get_sq_max_dist);
+	iscc_dist_functions = saved_dist_functions;
+
+	assert_true(iscc_close_max_dist_object(&max_dist_object));
+}
+
+
 void scc_ut_init_close_nn_search_object(void** state)
 {
 	(void) state;
@@ -1263,9 +2202,19 @@ int main(void)
 		cmocka_unit_test(scc_ut_check_data_set),
 		cmocka_unit_test(scc_ut_num_data_points),
 		cmocka_unit_test(scc_ut_get_dist_matrix),
+		cmocka_unit_test(scc_ut_get_dist_matrix_columns),
+		cmocka_unit_test(scc_ut_column_major_data_set),
+		cmocka_unit_test(scc_ut_gower_data_set),
+		cmocka_unit_test(scc_ut_binary_data_set),
+		cmocka_unit_test(scc_ut_geo_data_set),
+		cmocka_unit_test(scc_ut_pca_projection_search),
+		cmocka_unit_test(scc_ut_kd_tree_search),
+		cmocka_unit_test(scc_ut_kd_tree_deferred),
+		cmocka_unit_test(scc_ut_search_index),
 		cmocka_unit_test(scc_ut_get_dist_rows),
 		cmocka_unit_test(scc_ut_init_close_max_dist_object),
 		cmocka_unit_test(scc_ut_get_max_dist),
+		cmocka_unit_test(scc_ut_get_sq_dists),
 		cmocka_unit_test(scc_ut_init_close_nn_search_object),
 		cmocka_unit_test(scc_ut_nearest_neighbor_search),
 		cmocka_unit_test(scc_ut_nearest_neighbor_search_radius),
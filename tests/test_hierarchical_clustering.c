@@ -208,12 +208,80 @@ void scc_ut_hierarchical_clustering(void** state)
 }
 
 
+void scc_ut_split_tree(void** state)
+{
+	(void) state;
+
+	scc_ClusterOptions options = scc_get_default_options();
+	scc_SplitTree* tree;
+	scc_Clustering* cl;
+	scc_Clustering* ref_cl;
+	bool cl_is_OK;
+
+	for (int batch = 0; batch < 2; ++batch) {
+		const bool batch_assign = (batch == 1);
+		assert_int_equal(scc_build_split_tree(scc_ut_test_data_large, 2, batch_assign, &tree), SCC_ER_OK);
+
+		// Cutting at the size constraint of the tree gives the same clustering as a direct run
+		scc_init_empty_clustering(100, NULL, &ref_cl);
+		assert_int_equal(scc_hierarchical_clustering(scc_ut_test_data_large, 2, batch_assign, ref_cl), SCC_ER_OK);
+		scc_init_empty_clustering(100, NULL, &cl);
+		assert_int_equal(scc_cut_split_tree(tree, scc_ut_test_data_large, 2, cl), SCC_ER_OK);
+		assert_int_equal(cl->num_clusters, ref_cl->num_clusters);
+		assert_memory_equal(cl->cluster_label, ref_cl->cluster_label, 100 * sizeof(scc_Clabel));
+		scc_free_clustering(&cl);
+		scc_free_clustering(&ref_cl);
+
+		// Larger size constraints give valid clusterings with no cluster that could be split
+		const uint32_t size_constraints[7] = { 3, 5, 7, 10, 20, 33, 100 };
+		for (size_t s = 0; s < 7; ++s) {
+			scc_init_empty_clustering(100, NULL, &cl);
+			assert_int_equal(scc_cut_split_tree(tree, scc_ut_test_data_large, size_constraints[s], cl), SCC_ER_OK);
+			options.size_constraint = size_constraints[s];
+			assert_int_equal(scc_check_clustering(cl, &options, &cl_is_OK), SCC_ER_OK);
+			assert_true(cl_is_OK);
+			size_t cluster_size[100] = { 0 };
+			for (size_t i = 0; i < 100; ++i) {
+				assert_true(cl->cluster_label[i] < (scc_Clabel) cl->num_clusters);
+				++cluster_size[cl->cluster_label[i]];
+			}
+			for (size_t c = 0; c < cl->num_clusters; ++c) {
+				assert_true(cluster_size[c] < 2 * size_constraints[s]);
+			}
+			scc_free_clustering(&cl);
+		}
+
+		scc_init_empty_clustering(100, NULL, &cl);
+		assert_int_equal(scc_cut_split_tree(tree, scc_ut_test_data_large, 101, cl), SCC_ER_NO_SOLUTION);
+		scc_free_clustering(&cl);
+
+		scc_free_split_tree(&tree);
+		assert_null(tree);
+	}
+
+	assert_int_equal(scc_build_split_tree(scc_ut_test_data_large, 20, true, &tree), SCC_ER_OK);
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_cut_split_tree(tree, scc_ut_test_data_large, 10, cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_cut_split_tree(tree, scc_ut_test_data_small, 20, cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+	scc_free_split_tree(&tree);
+
+	assert_int_equal(scc_build_split_tree(scc_ut_test_data_large, 1, true, &tree), SCC_ER_INVALID_INPUT);
+	assert_null(tree);
+	assert_int_equal(scc_build_split_tree(scc_ut_test_data_large, 101, true, &tree), SCC_ER_NO_SOLUTION);
+	assert_null(tree);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
 
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_hierarchical_clustering),
+		cmocka_unit_test(scc_ut_split_tree),
 	};
 
 	return cmocka_run_group_tests_name("hierarchical_clustering.c", test_cases, NULL, NULL);
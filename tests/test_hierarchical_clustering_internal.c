@@ -197,7 +197,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	};
 	iscc_hi_ClusterStack cl_stack1;
 	iscc_hi_empty_cl_stack(100, &cl_stack1);
-	scc_ErrorCode ec1 = iscc_hi_run_hierarchical_clustering(&cl_stack1, &cl1, scc_ut_test_data_large, &wa, 20, true);
+	scc_ErrorCode ec1 = iscc_hi_run_hierarchical_clustering(&cl_stack1, &cl1, scc_ut_test_data_large, &wa, 20, true, NULL);
 	assert_int_equal(ec1, SCC_ER_OK);
 	scc_Clabel ref_label1[100] = { 2, 3, 3, 2, 2, 3, 0, 0, 4, 3, 2, 1, 1, 0, 4, 3, 0, 2, 0, 4, 3, 1, 3,
 	                               0, 0, 0, 4, 0, 4, 0, 3, 4, 3, 1, 0, 0, 3, 4, 1, 0, 3, 2, 1, 2, 2, 2,
@@ -225,7 +225,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	};
 	iscc_hi_ClusterStack cl_stack2;
 	iscc_hi_empty_cl_stack(100, &cl_stack2);
-	scc_ErrorCode ec2 = iscc_hi_run_hierarchical_clustering(&cl_stack2, &cl2, scc_ut_test_data_large, &wa, 20, false);
+	scc_ErrorCode ec2 = iscc_hi_run_hierarchical_clustering(&cl_stack2, &cl2, scc_ut_test_data_large, &wa, 20, false, NULL);
 	assert_int_equal(ec2, SCC_ER_OK);
 	scc_Clabel ref_label2[100] = { 3, 0, 2, 3, 3, 2, 1, 1, 3, 2, 3, 0, 1, 0, 2, 2, 1, 3, 0, 2, 2, 0, 1, 1, 0, 1, 2, 1, 2, 0,
 	                               2, 2, 2, 0, 1, 1, 2, 2, 0, 0, 3, 3, 0, 3, 3, 0, 1, 3, 0, 2, 0, 2, 2, 2, 0, 0, 2, 0, 2, 1,
@@ -261,7 +261,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	iscc_hi_ClusterStack cl_stack3;
 	iscc_hi_init_cl_stack(&cl3, &cl_stack3, &size_largest_cluster3);
 	assert_int_equal(size_largest_cluster3, 50);
-	scc_ErrorCode ec3 = iscc_hi_run_hierarchical_clustering(&cl_stack3, &cl3, scc_ut_test_data_large, &wa, 20, true);
+	scc_ErrorCode ec3 = iscc_hi_run_hierarchical_clustering(&cl_stack3, &cl3, scc_ut_test_data_large, &wa, 20, true, NULL);
 	assert_int_equal(ec3, SCC_ER_OK);
 	scc_Clabel ref_label3[100] = { 1, 1, 3, 3, 3, 0, 0, 2, 0, 0, 3, 1, 2, 2, 3, 1, 0, 3, 1, 0, 0, 2, 1, 1, 1,
 	                               0, 1, 2, 0, 2, 3, 0, 0, 1, 2, 0, 3, 2, 1, 1, 1, 3, 2, 3, 1, 2, 2, 2, 1, 0,
@@ -296,7 +296,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	iscc_hi_ClusterStack cl_stack4;
 	iscc_hi_init_cl_stack(&cl4, &cl_stack4, &size_largest_cluster4);
 	assert_int_equal(size_largest_cluster4, 50);
-	scc_ErrorCode ec4 = iscc_hi_run_hierarchical_clustering(&cl_stack4, &cl4, scc_ut_test_data_large, &wa, 20, false);
+	scc_ErrorCode ec4 = iscc_hi_run_hierarchical_clustering(&cl_stack4, &cl4, scc_ut_test_data_large, &wa, 20, false, NULL);
 	assert_int_equal(ec4, SCC_ER_OK);
 	scc_Clabel ref_label4[100] = { 1, 0, 3, 3, 3, 0, 0, 2, 0, 0, 3, 0, 2, 2, 3, 1, 0, 3, 1, 0, 0, 2, 1, 1, 1,
 	                               0, 0, 2, 0, 2, 3, 0, 0, 1, 2, 0, 3, 3, 0, 0, 1, 3, 2, 3, 1, 2, 2, 2, 0, 0,
@@ -637,7 +637,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist0 = iscc_hi_get_next_k_nn(wa.edge_store1, 4, wa.vertex_markers, 1, out_dist_array0);
 	assert_memory_equal(out_dist_array0, ref_dist_array0, 4 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist0->head, 4);
-	assert_double_equal(prev_dist0->distance, 72.125847);
+	assert_double_equal(sqrt(prev_dist0->distance), 72.125847);
 	assert_ptr_equal(prev_dist0->next_dist, prev_dist0 + 1);
 
 	scc_PointIndex out_dist_array1[4];
@@ -645,7 +645,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist1 = iscc_hi_get_next_k_nn(&wa.edge_store1[2], 4, wa.vertex_markers, 1, out_dist_array1);
 	assert_memory_equal(out_dist_array1, ref_dist_array1, 4 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist1->head, 14);
-	assert_double_equal(prev_dist1->distance, 80.566800);
+	assert_double_equal(sqrt(prev_dist1->distance), 80.566800);
 	assert_ptr_equal(prev_dist1->next_dist, prev_dist1 + 1);
 
 	wa.vertex_markers[18] = 1;
@@ -657,7 +657,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_distY = iscc_hi_get_next_k_nn(wa.edge_store1, 4, wa.vertex_markers, 1, out_dist_arrayY);
 	assert_memory_equal(out_dist_arrayY, ref_dist_arrayY, 4 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_distY->head, 14);
-	assert_double_equal(prev_distY->distance, 80.566800);
+	assert_double_equal(sqrt(prev_distY->distance), 80.566800);
 	assert_ptr_equal(prev_distY->next_dist, prev_distY + 1);
 
 	scc_PointIndex out_dist_arrayX[2];
@@ -665,7 +665,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_distX = iscc_hi_get_next_k_nn(wa.edge_store1, 2, wa.vertex_markers, 1, out_dist_arrayX);
 	assert_memory_equal(out_dist_arrayX, ref_dist_arrayX, 2 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_distX->head, 16);
-	assert_double_equal(prev_distX->distance, 43.918798);
+	assert_double_equal(sqrt(prev_distX->distance), 43.918798);
 	assert_ptr_equal(prev_distX->next_dist, prev_distX + 3);
 
 	scc_PointIndex out_dist_array2[4];
@@ -673,7 +673,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist2 = iscc_hi_get_next_k_nn(&wa.edge_store1[2], 4, wa.vertex_markers, 1, out_dist_array2);
 	assert_memory_equal(out_dist_array2, ref_dist_array2, 4 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist2->head, 2);
-	assert_double_equal(prev_dist2->distance, 103.030113);
+	assert_double_equal(sqrt(prev_dist2->distance), 103.030113);
 	assert_null(prev_dist2->next_dist);
 
 	wa.vertex_markers[20] = 1;
@@ -683,7 +683,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist3 = iscc_hi_get_next_k_nn(&wa.edge_store1[1], 4, wa.vertex_markers, 1, out_dist_array3);
 	assert_memory_equal(out_dist_array3, ref_dist_array3, 4 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist3->head, 2);
-	assert_double_equal(prev_dist3->distance, 103.030113);
+	assert_double_equal(sqrt(prev_dist3->distance), 103.030113);
 	assert_null(prev_dist3->next_dist);
 
 
@@ -692,7 +692,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist4 = iscc_hi_get_next_k_nn(&wa.edge_store2[4], 1, wa.vertex_markers, 2, out_dist_array4);
 	assert_memory_equal(out_dist_array4, ref_dist_array4, 1 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist4->head, 8);
-	assert_double_equal(prev_dist4->distance, 62.616031);
+	assert_double_equal(sqrt(prev_dist4->distance), 62.616031);
 	assert_ptr_equal(prev_dist4->next_dist, prev_dist4 + 1);
 
 	wa.vertex_markers[4] = 2;
@@ -704,7 +704,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 	iscc_hi_DistanceEdge* prev_dist5 = iscc_hi_get_next_k_nn(&wa.edge_store2[2], 3, wa.vertex_markers, 2, out_dist_array5);
 	assert_memory_equal(out_dist_array5, ref_dist_array5, 3 * sizeof(scc_PointIndex));
 	assert_int_equal(prev_dist5->head, 2);
-	assert_double_equal(prev_dist5->distance, 83.120587);
+	assert_double_equal(sqrt(prev_dist5->distance), 83.120587);
 	assert_ptr_equal(prev_dist5->next_dist, prev_dist5 + 1);
 
 	free(wa.dist_array);
@@ -737,26 +737,26 @@ void scc_ut_hi_get_next_dist(void** state)
 	assert_int_equal(iscc_hi_populate_edge_lists(&cl, scc_ut_test_data_large, 6, 4, &wa), SCC_ER_OK);
 
 	assert_int_equal(wa.edge_store1[1].head, 4);
-	assert_double_equal(wa.edge_store1[1].distance, 72.125847);
+	assert_double_equal(sqrt(wa.edge_store1[1].distance), 72.125847);
 	assert_int_equal(wa.edge_store1[2].head, 10);
-	assert_double_equal(wa.edge_store1[2].distance, 76.285875);
+	assert_double_equal(sqrt(wa.edge_store1[2].distance), 76.285875);
 	assert_int_equal(wa.edge_store1[3].head, 8);
-	assert_double_equal(wa.edge_store1[3].distance, 82.249050);
+	assert_double_equal(sqrt(wa.edge_store1[3].distance), 82.249050);
 	assert_int_equal(wa.edge_store1[4].head, 2);
-	assert_double_equal(wa.edge_store1[4].distance, 103.030113);
+	assert_double_equal(sqrt(wa.edge_store1[4].distance), 103.030113);
 	for (size_t i = 0; i < 4; ++i) {
 		assert_ptr_equal(wa.edge_store1[i].next_dist, &wa.edge_store1[i + 1]);
     }
     assert_null(wa.edge_store1[4].next_dist);
 
 	assert_int_equal(wa.edge_store2[1].head, 2);
-	assert_double_equal(wa.edge_store2[1].distance, 63.103580);
+	assert_double_equal(sqrt(wa.edge_store2[1].distance), 63.103580);
 	assert_int_equal(wa.edge_store2[2].head, 10);
-	assert_double_equal(wa.edge_store2[2].distance, 67.606177);
+	assert_double_equal(sqrt(wa.edge_store2[2].distance), 67.606177);
 	assert_int_equal(wa.edge_store2[3].head, 6);
-	assert_double_equal(wa.edge_store2[3].distance, 72.125847);
+	assert_double_equal(sqrt(wa.edge_store2[3].distance), 72.125847);
 	assert_int_equal(wa.edge_store2[4].head, 8);
-	assert_double_equal(wa.edge_store2[4].distance, 89.098152);
+	assert_double_equal(sqrt(wa.edge_store2[4].distance), 89.098152);
 	for (size_t i = 0; i < 4; ++i) {
 		assert_ptr_equal(wa.edge_store2[i].next_dist, &wa.edge_store2[i + 1]);
     }
@@ -765,39 +765,39 @@ void scc_ut_hi_get_next_dist(void** state)
 
     iscc_hi_DistanceEdge* next0 = iscc_hi_get_next_dist(wa.edge_store1, wa.vertex_markers, 1);
 	assert_int_equal(next0->head, 4);
-	assert_double_equal(next0->distance, 72.125847);
+	assert_double_equal(sqrt(next0->distance), 72.125847);
 	assert_ptr_equal(next0->next_dist, &wa.edge_store1[2]);
 
 	iscc_hi_DistanceEdge* next1 = iscc_hi_get_next_dist(&wa.edge_store1[2], wa.vertex_markers, 1);
 	assert_int_equal(next1->head, 8);
-	assert_double_equal(next1->distance, 82.249050);
+	assert_double_equal(sqrt(next1->distance), 82.249050);
 	assert_ptr_equal(next1->next_dist, &wa.edge_store1[4]);
 
 	iscc_hi_DistanceEdge* next2 = iscc_hi_get_next_dist(&wa.edge_store1[3], wa.vertex_markers, 1);
 	assert_int_equal(next2->head, 2);
-	assert_double_equal(next2->distance, 103.030113);
+	assert_double_equal(sqrt(next2->distance), 103.030113);
 	assert_null(next2->next_dist);
 
 	wa.vertex_markers[8] = 1;
 
 	iscc_hi_DistanceEdge* next3 = iscc_hi_get_next_dist(&wa.edge_store1[2], wa.vertex_markers, 1);
 	assert_int_equal(next3->head, 2);
-	assert_double_equal(next3->distance, 103.030113);
+	assert_double_equal(sqrt(next3->distance), 103.030113);
 	assert_null(next3->next_dist);
 
 	iscc_hi_DistanceEdge* next4 = iscc_hi_get_next_dist(&wa.edge_store1[2], wa.vertex_markers, 1);
 	assert_int_equal(next4->head, 2);
-	assert_double_equal(next4->distance, 103.030113);
+	assert_double_equal(sqrt(next4->distance), 103.030113);
 	assert_null(next4->next_dist);
 
 	assert_int_equal(wa.edge_store1[1].head, 4);
-	assert_double_equal(wa.edge_store1[1].distance, 72.125847);
+	assert_double_equal(sqrt(wa.edge_store1[1].distance), 72.125847);
 	assert_int_equal(wa.edge_store1[2].head, 10);
-	assert_double_equal(wa.edge_store1[2].distance, 76.285875);
+	assert_double_equal(sqrt(wa.edge_store1[2].distance), 76.285875);
 	assert_int_equal(wa.edge_store1[3].head, 8);
-	assert_double_equal(wa.edge_store1[3].distance, 82.249050);
+	assert_double_equal(sqrt(wa.edge_store1[3].distance), 82.249050);
 	assert_int_equal(wa.edge_store1[4].head, 2);
-	assert_double_equal(wa.edge_store1[4].distance, 103.030113);
+	assert_double_equal(sqrt(wa.edge_store1[4].distance), 103.030113);
 
 	assert_ptr_equal(wa.edge_store1[0].next_dist, &wa.edge_store1[1]);
 	assert_ptr_equal(wa.edge_store1[1].next_dist, &wa.edge_store1[2]);
@@ -810,22 +810,22 @@ void scc_ut_hi_get_next_dist(void** state)
 
 	iscc_hi_DistanceEdge* next5 = iscc_hi_get_next_dist(wa.edge_store2, wa.vertex_markers, 1);
 	assert_int_equal(next5->head, 6);
-	assert_double_equal(next5->distance, 72.125847);
+	assert_double_equal(sqrt(next5->distance), 72.125847);
 	assert_ptr_equal(next5->next_dist, &wa.edge_store2[4]);
 
 	iscc_hi_DistanceEdge* next6 = iscc_hi_get_next_dist(wa.edge_store2, wa.vertex_markers, 1);
 	assert_int_equal(next6->head, 6);
-	assert_double_equal(next6->distance, 72.125847);
+	assert_double_equal(sqrt(next6->distance), 72.125847);
 	assert_ptr_equal(next6->next_dist, &wa.edge_store2[4]);
 
 	assert_int_equal(wa.edge_store2[1].head, 2);
-	assert_double_equal(wa.edge_store2[1].distance, 63.103580);
+	assert_double_equal(sqrt(wa.edge_store2[1].distance), 63.103580);
 	assert_int_equal(wa.edge_store2[2].head, 10);
-	assert_double_equal(wa.edge_store2[2].distance, 67.606177);
+	assert_double_equal(sqrt(wa.edge_store2[2].distance), 67.606177);
 	assert_int_equal(wa.edge_store2[3].head, 6);
-	assert_double_equal(wa.edge_store2[3].distance, 72.125847);
+	assert_double_equal(sqrt(wa.edge_store2[3].distance), 72.125847);
 	assert_int_equal(wa.edge_store2[4].head, 8);
-	assert_double_equal(wa.edge_store2[4].distance, 89.098152);
+	assert_double_equal(sqrt(wa.edge_store2[4].distance), 89.098152);
 
 	assert_ptr_equal(wa.edge_store2[0].next_dist, &wa.edge_store2[3]);
 	assert_ptr_equal(wa.edge_store2[1].next_dist, &wa.edge_store2[2]);
@@ -1333,22 +1333,22 @@ void scc_ut_hi_populate_edge_lists(void** state)
 	assert_int_equal(ec, SCC_ER_OK);
 
 	assert_int_equal(wa.edge_store1[1].head, 3);
-	assert_double_equal(wa.edge_store1[1].distance, 65.042314);
+	assert_double_equal(sqrt(wa.edge_store1[1].distance), 65.042314);
 	assert_int_equal(wa.edge_store1[2].head, 5);
-	assert_double_equal(wa.edge_store1[2].distance, 82.967209);
+	assert_double_equal(sqrt(wa.edge_store1[2].distance), 82.967209);
 	assert_int_equal(wa.edge_store1[3].head, 2);
-	assert_double_equal(wa.edge_store1[3].distance, 102.986773);
+	assert_double_equal(sqrt(wa.edge_store1[3].distance), 102.986773);
 	for (size_t i = 0; i < 3; ++i) {
 		assert_ptr_equal(wa.edge_store1[i].next_dist, &wa.edge_store1[i + 1]);
     }
     assert_null(wa.edge_store1[3].next_dist);
 
 	assert_int_equal(wa.edge_store2[1].head, 2);
-	assert_double_equal(wa.edge_store2[1].distance, 21.423179);
+	assert_double_equal(sqrt(wa.edge_store2[1].distance), 21.423179);
 	assert_int_equal(wa.edge_store2[2].head, 3);
-	assert_double_equal(wa.edge_store2[2].distance, 52.901061);
+	assert_double_equal(sqrt(wa.edge_store2[2].distance), 52.901061);
 	assert_int_equal(wa.edge_store2[3].head, 10);
-	assert_double_equal(wa.edge_store2[3].distance, 82.967209);
+	assert_double_equal(sqrt(wa.edge_store2[3].distance), 82.967209);
 	for (size_t i = 0; i < 3; ++i) {
 		assert_ptr_equal(wa.edge_store2[i].next_dist, &wa.edge_store2[i + 1]);
     }
@@ -19,8 +19,11 @@
  * ========================================================================== */
 
 #include "init_test.h"
+#include <stdio.h>
 #include <include/scclust.h>
+#include <include/scclust_spi.h>
 #include <src/clustering_struct.h>
+#include <src/dist_search_imp.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
 
@@ -6690,6 +6693,258 @@ void scc_ut_nng_clustering_with_types_nonval(void** state)
 }
 
 
+static void iscc_remove_checkpoints(void)
+{
+	remove("./nng.scc");
+	remove("./seeds.scc");
+	remove("./assign.scc");
+}
+
+
+static size_t iscc_num_searched_queries = 0;
+
+
+static bool iscc_counting_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                                  const size_t len_query_indices,
+                                                  const scc_PointIndex query_indices[const],
+                                                  const uint32_t k,
+                                                  const bool radius_search,
+                                                  const double radius,
+                                                  size_t* const out_num_ok_queries,
+                                                  scc_PointIndex out_query_indices[const],
+                                                  scc_PointIndex out_nn_indices[const])
+{
+	iscc_num_searched_queries += len_query_indices;
+	return iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                        radius_search, radius, out_num_ok_queries,
+	                                        out_query_indices, out_nn_indices);
+}
+
+
+// Drops the last seed in the seeds checkpoint, after its 40-byte header
+static void iscc_drop_checkpoint_seed(void)
+{
+	FILE* const file = fopen("./seeds.scc", "r+b");
+	assert_non_null(file);
+	uint64_t count;
+	assert_int_equal(fseek(file, 40, SEEK_SET), 0);
+	assert_int_equal(fread(&count, sizeof(uint64_t), 1, file), 1);
+	assert_true(count > 1);
+	--count;
+	assert_int_equal(fseek(file, 40, SEEK_SET), 0);
+	assert_int_equal(fwrite(&count, sizeof(uint64_t), 1, file), 1);
+	assert_int_equal(fclose(file), 0);
+}
+
+
+static void iscc_check_checkpoint_run(const scc_ClusterOptions* const options)
+{
+	scc_Clabel plain_labels[100];
+	scc_Clabel checkpoint_labels[100];
+	scc_Clustering* cl;
+
+	iscc_remove_checkpoints();
+
+	scc_init_empty_clustering(100, plain_labels, &cl);
+	assert_int_equal(scc_sc_clustering(scc_ut_test_data_large, options, cl), SCC_ER_OK);
+	const size_t plain_num_clusters = cl->num_clusters;
+	scc_free_clustering(&cl);
+
+	// Fresh run, resume after primary assignment, and resume from the NNG and seeds.
+	// Counting the searched queries shows that the saved phases are not redone.
+	size_t num_searched[3];
+	assert_true(scc_set_dist_functions(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	                                   iscc_imp_init_nn_search_object,
+	                                   iscc_counting_nearest_neighbor_search,
+	                                   iscc_imp_close_nn_search_object));
+	for (int run = 0; run < 3; ++run) {
+		if (run == 2) remove("./assign.scc");
+		iscc_num_searched_queries = 0;
+		scc_init_empty_clustering(100, checkpoint_labels, &cl);
+		assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, options, ".", cl), SCC_ER_OK);
+		scc_free_clustering(&cl);
+		assert_memory_equal(checkpoint_labels, plain_labels, sizeof(plain_labels));
+		num_searched[run] = iscc_num_searched_queries;
+	}
+	assert_true(scc_reset_dist_functions());
+	assert_true(num_searched[0] > 0);
+	assert_true(num_searched[1] <= num_searched[2]);
+	assert_true(num_searched[2] < num_searched[0]);
+
+	// Seeds are found from the NNG without distances, so one is dropped from the checkpoint
+	// instead, and the resumed clustering has one cluster less
+	remove("./assign.scc");
+	iscc_drop_checkpoint_seed();
+	scc_init_empty_clustering(100, checkpoint_labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, options, ".", cl), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, plain_num_clusters - 1);
+	scc_free_clustering(&cl);
+
+	// Checkpoints from another clustering problem are rejected
+	scc_ClusterOptions other_options = *options;
+	other_options.size_constraint = 4;
+	scc_init_empty_clustering(100, checkpoint_labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, &other_options, ".", cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	iscc_remove_checkpoints();
+}
+
+
+static size_t iscc_num_radius_searches = 0;
+
+
+// Fails if the ok-query output overlaps the query indices
+static bool iscc_unaliased_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                                   const size_t len_query_indices,
+                                                   const scc_PointIndex query_indices[const],
+                                                   const uint32_t k,
+                                                   const bool radius_search,
+                                                   const double radius,
+                                                   size_t* const out_num_ok_queries,
+                                                   scc_PointIndex out_query_indices[const],
+                                                   scc_PointIndex out_nn_indices[const])
+{
+	if ((query_indices != NULL) && (out_query_indices != NULL)) {
+		++iscc_num_radius_searches;
+		const uintptr_t query_begin = (uintptr_t) query_indices;
+		const uintptr_t query_end = (uintptr_t) (query_indices + len_query_indices);
+		const uintptr_t out_begin = (uintptr_t) out_query_indices;
+		const uintptr_t out_end = (uintptr_t) (out_query_indices + len_query_indices);
+		assert_true((query_end <= out_begin) || (out_end <= query_begin));
+	}
+	return iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                        radius_search, radius, out_num_ok_queries,
+	                                        out_query_indices, out_nn_indices);
+}
+
+
+void scc_ut_nng_clustering_unaliased_search(void** state)
+{
+	(void) state;
+
+	const scc_PointIndex primary_data_points[50] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 40,
+	                                        41, 42, 43, 44, 45, 46, 47, 48, 49, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69,
+	                                        80, 81, 82, 83, 84, 85, 86, 87, 88, 89 };
+	const scc_ClusterOptions options = iscc_translate_options(3,
+	                                                          0, NULL, 0, NULL,
+	                                                          SCC_SM_EXCLUSION_ORDER, SCC_UM_CLOSEST_ASSIGNED, true, 30.0,
+	                                                          50, primary_data_points, SCC_UM_CLOSEST_ASSIGNED, true, 20.0, 0);
+	scc_Clabel plain_labels[100];
+	scc_Clabel checked_labels[100];
+	scc_Clustering* cl;
+
+	scc_init_empty_clustering(100, plain_labels, &cl);
+	assert_int_equal(scc_sc_clustering(scc_ut_test_data_large, &options, cl), SCC_ER_OK);
+	scc_free_clustering(&cl);
+
+	iscc_num_radius_searches = 0;
+	assert_true(scc_set_dist_functions(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+	                                   iscc_imp_init_nn_search_object,
+	                                   iscc_unaliased_nearest_neighbor_search,
+	                                   iscc_imp_close_nn_search_object));
+	scc_init_empty_clustering(100, checked_labels, &cl);
+	assert_int_equal(scc_sc_clustering(scc_ut_test_data_large, &options, cl), SCC_ER_OK);
+	scc_free_clustering(&cl);
+	assert_true(scc_reset_dist_functions());
+
+	assert_true(iscc_num_radius_searches > 0);
+	assert_memory_equal(checked_labels, plain_labels, sizeof(plain_labels));
+}
+
+
+static bool iscc_wrapped_check_data_set(void* const data_set)
+{
+	return iscc_imp_check_data_set(data_set);
+}
+
+
+// Resumes with data that differs only in one point, which must be detected
+static void iscc_check_checkpoint_other_data(const scc_ClusterOptions* const options)
+{
+	double changed_coord[300];
+	memcpy(changed_coord, scc_ut_test_data_large->data_matrix, sizeof(changed_coord));
+	changed_coord[0] += 1000.0;
+	scc_DataSet* changed_data;
+	assert_int_equal(scc_init_data_set(100, 3, 300, changed_coord, &changed_data), SCC_ER_OK);
+
+	scc_Clabel labels[100];
+	scc_Clustering* cl;
+	iscc_remove_checkpoints();
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, options, ".", cl), SCC_ER_OK);
+	scc_free_clustering(&cl);
+
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(changed_data, options, ".", cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	// Data sets behind the SPI are identified by distances only
+	assert_true(scc_set_dist_functions(iscc_wrapped_check_data_set, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL));
+	iscc_remove_checkpoints();
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, options, ".", cl), SCC_ER_OK);
+	scc_free_clustering(&cl);
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(changed_data, options, ".", cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, options, ".", cl), SCC_ER_OK);
+	scc_free_clustering(&cl);
+	assert_true(scc_reset_dist_functions());
+
+	iscc_remove_checkpoints();
+	scc_free_data_set(&changed_data);
+}
+
+
+void scc_ut_nng_clustering_checkpoints(void** state)
+{
+	(void) state;
+
+	const scc_PointIndex primary_data_points[50] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 40,
+	                                        41, 42, 43, 44, 45, 46, 47, 48, 49, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69,
+	                                        80, 81, 82, 83, 84, 85, 86, 87, 88, 89 };
+	const uint32_t type_constraints[3] = { 1, 1, 0 };
+	scc_TypeLabel type_labels[100];
+	for (size_t i = 0; i < 100; ++i) type_labels[i] = (scc_TypeLabel) (i % 3);
+
+	scc_ClusterOptions options;
+	scc_Clustering* cl;
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_LEXICAL, SCC_UM_ANY_NEIGHBOR, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	iscc_check_checkpoint_run(&options);
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_INWARDS_UPDATING, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 50, primary_data_points, SCC_UM_CLOSEST_SEED + 100, true, 0.0, 0);
+	iscc_check_checkpoint_run(&options);
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_EXCLUSION_ORDER, SCC_UM_CLOSEST_ASSIGNED, true, 30.0,
+	                                 50, primary_data_points, SCC_UM_CLOSEST_ASSIGNED, false, 0.0, 0);
+	iscc_check_checkpoint_run(&options);
+
+	options = iscc_translate_options(3,
+	                                 3, type_constraints, 100, type_labels,
+	                                 SCC_SM_INWARDS_ORDER, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 50, primary_data_points, SCC_UM_CLOSEST_ASSIGNED, false, 0.0, 0);
+	iscc_check_checkpoint_run(&options);
+
+	iscc_check_checkpoint_other_data(&options);
+
+	scc_Clabel labels[100];
+	scc_init_empty_clustering(100, labels, &cl);
+	assert_int_equal(scc_sc_clustering_with_checkpoints(scc_ut_test_data_large, &options, NULL, cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
@@ -6699,6 +6954,8 @@ int main(void)
 		cmocka_unit_test(scc_ut_nng_clustering_nonval),
 		cmocka_unit_test(scc_ut_nng_clustering_with_types),
 		cmocka_unit_test(scc_ut_nng_clustering_with_types_nonval),
+		cmocka_unit_test(scc_ut_nng_clustering_checkpoints),
+		cmocka_unit_test(scc_ut_nng_clustering_unaliased_search),
 	};
 
 	return cmocka_run_group_tests_name("nng_clustering.c", test_cases, NULL, NULL);
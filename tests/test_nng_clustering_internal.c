@@ -22,6 +22,7 @@
 #include <src/nng_clustering.c>
 #include "assert_digraph.h"
 #include "data_object_test.h"
+#include "rand.h"
 
 
 #define ISCC_UT_OPTIONS_STRUCT_VERSION 722678001
@@ -259,12 +260,125 @@ void scc_ut_make_clustering_from_nng(void** state)
 }
 
 
+static void scc_ut_check_pair_clustering(void* const data_set,
+                                         const size_t num_data_points,
+                                         const scc_ClusterOptions* const options)
+{
+	assert_true(iscc_use_pair_clustering(options));
+
+	scc_Clustering* cl_pair;
+	assert_int_equal(scc_init_empty_clustering(num_data_points, NULL, &cl_pair), SCC_ER_OK);
+	const scc_ErrorCode ec_pair = scc_sc_clustering(data_set, options, cl_pair);
+
+	iscc_Digraph nng;
+	scc_Clustering* cl_ref;
+	assert_int_equal(scc_init_empty_clustering(num_data_points, NULL, &cl_ref), SCC_ER_OK);
+	scc_ErrorCode ec_ref = iscc_get_nng_with_size_constraint(data_set,
+	                                                         num_data_points,
+	                                                         2,
+	                                                         options->len_primary_data_points,
+	                                                         options->primary_data_points,
+	                                                         (options->seed_radius == SCC_RM_USE_SUPPLIED),
+	                                                         options->seed_supplied_radius,
+	                                                         &nng);
+	if (ec_ref == SCC_ER_OK) {
+		ec_ref = iscc_make_clustering_from_nng(cl_ref, data_set, &nng, options);
+		iscc_free_digraph(&nng);
+	}
+
+	assert_int_equal(ec_pair, ec_ref);
+	if (ec_ref == SCC_ER_OK) {
+		assert_int_equal(cl_pair->num_clusters, cl_ref->num_clusters);
+		assert_memory_equal(cl_pair->cluster_label, cl_ref->cluster_label, num_data_points * sizeof(scc_Clabel));
+	}
+
+	scc_free_clustering(&cl_pair);
+	scc_free_clustering(&cl_ref);
+}
+
+
+void scc_ut_pair_clustering(void** state)
+{
+	(void) state;
+
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 2;
+	assert_true(iscc_use_pair_clustering(&options));
+	options.seed_method = SCC_SM_INWARDS_ORDER;
+	assert_false(iscc_use_pair_clustering(&options));
+	options.seed_method = SCC_SM_LEXICAL;
+	options.size_constraint = 3;
+	assert_false(iscc_use_pair_clustering(&options));
+	options.size_constraint = 2;
+	options.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+	assert_false(iscc_use_pair_clustering(&options));
+	options.primary_unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+	options.seed_radius = SCC_RM_USE_SUPPLIED;
+	options.seed_supplied_radius = 1.0;
+	assert_false(iscc_use_pair_clustering(&options));
+
+	const size_t num_data_points = 3000;
+	double* const raw_data = malloc(sizeof(double[2 * num_data_points]));
+	assert_non_null(raw_data);
+	srand(20170602);
+	for (size_t i = 0; i < 2 * num_data_points; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_data_points, 2, 2 * num_data_points, raw_data, &data_set), SCC_ER_OK);
+
+	scc_PointIndex primary_data_points[1000];
+	for (size_t i = 0; i < 1000; ++i) {
+		primary_data_points[i] = (scc_PointIndex) (3 * i + (i % 3));
+	}
+	scc_PointIndex large_primary_data_points[40];
+	for (size_t i = 0; i < 40; ++i) {
+		large_primary_data_points[i] = (scc_PointIndex) (2 * i + 10);
+	}
+
+	const scc_UnassignedMethod unassigned_methods[3] = { SCC_UM_IGNORE, SCC_UM_ANY_NEIGHBOR, SCC_UM_CLOSEST_ASSIGNED };
+	for (size_t um = 0; um < 3; ++um) {
+		for (size_t radius = 0; radius < 3; ++radius) {
+			if ((unassigned_methods[um] == SCC_UM_CLOSEST_ASSIGNED) && (radius > 0)) continue;
+			for (size_t primary = 0; primary < 2; ++primary) {
+				options = scc_get_default_options();
+				options.size_constraint = 2;
+				options.primary_unassigned_method = unassigned_methods[um];
+				if (radius > 0) {
+					options.seed_radius = SCC_RM_USE_SUPPLIED;
+					options.seed_supplied_radius = (radius == 1) ? 1.0 : 0.01;
+				}
+
+				if (primary == 1) {
+					options.len_primary_data_points = 1000;
+					options.primary_data_points = primary_data_points;
+				}
+				scc_ut_check_pair_clustering(data_set, num_data_points, &options);
+
+				if (primary == 1) {
+					options.len_primary_data_points = 40;
+					options.primary_data_points = large_primary_data_points;
+				}
+				if (radius > 0) {
+					options.seed_supplied_radius = (radius == 1) ? 20.0 : 1.0;
+				}
+				scc_ut_check_pair_clustering(scc_ut_test_data_large, 100, &options);
+			}
+		}
+	}
+
+	scc_free_data_set(&data_set);
+	free(raw_data);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
 
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_make_clustering_from_nng),
+		cmocka_unit_test(scc_ut_pair_clustering),
 	};
 
 	return cmocka_run_group_tests_name("internal nng_clustering.c", test_cases, NULL, NULL);
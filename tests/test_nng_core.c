@@ -258,6 +258,84 @@ void scc_ut_get_nng_with_size_constraint(void** state)
 }
 
 
+static void scc_ut_check_nng_with_lexical_seeds(const size_t len_primary_data_points,
+                                                const scc_PointIndex primary_data_points[const],
+                                                const uint32_t size_constraint,
+                                                const bool radius_constraint,
+                                                const double radius)
+{
+	iscc_Digraph ref_nng;
+	scc_ErrorCode ref_ec = iscc_get_nng_with_size_constraint(scc_ut_test_data_large, 100, size_constraint,
+	                                                         len_primary_data_points, primary_data_points,
+	                                                         radius_constraint, radius, &ref_nng);
+	assert_int_equal(ref_ec, SCC_ER_OK);
+	iscc_SeedResult ref_seeds = { .capacity = 1 + 100 / size_constraint, .count = 0, .seeds = NULL };
+	assert_int_equal(iscc_find_seeds(&ref_nng, SCC_SM_LEXICAL, &ref_seeds), SCC_ER_OK);
+
+	for (int seed_rows_only = 0; seed_rows_only < 2; ++seed_rows_only) {
+		iscc_Digraph out_nng;
+		iscc_SeedResult out_seeds = { .capacity = 1 + 100 / size_constraint, .count = 0, .seeds = NULL };
+		scc_ErrorCode ec = iscc_get_nng_with_lexical_seeds(scc_ut_test_data_large, 100, size_constraint,
+		                                                   len_primary_data_points, primary_data_points,
+		                                                   radius_constraint, radius, (seed_rows_only == 1),
+		                                                   &out_seeds, &out_nng);
+		assert_int_equal(ec, SCC_ER_OK);
+		assert_valid_digraph(&out_nng, 100);
+		assert_int_equal(out_seeds.count, ref_seeds.count);
+		assert_memory_equal(out_seeds.seeds, ref_seeds.seeds, ref_seeds.count * sizeof(scc_PointIndex));
+
+		if (seed_rows_only == 0) {
+			assert_identical_digraph(&out_nng, &ref_nng);
+		} else {
+			size_t s = 0;
+			for (scc_PointIndex v = 0; v < 100; ++v) {
+				const size_t out_count = out_nng.tail_ptr[v + 1] - out_nng.tail_ptr[v];
+				if ((s < ref_seeds.count) && (ref_seeds.seeds[s] == v)) {
+					assert_int_equal(out_count, ref_nng.tail_ptr[v + 1] - ref_nng.tail_ptr[v]);
+					assert_memory_equal(out_nng.head + out_nng.tail_ptr[v],
+					                    ref_nng.head + ref_nng.tail_ptr[v],
+					                    out_count * sizeof(scc_PointIndex));
+					++s;
+				} else {
+					assert_int_equal(out_count, 0);
+				}
+			}
+			assert_int_equal(out_nng.max_arcs, ref_seeds.count * (size_constraint - 1));
+		}
+
+		free(out_seeds.seeds);
+		iscc_free_digraph(&out_nng);
+	}
+
+	free(ref_seeds.seeds);
+	iscc_free_digraph(&ref_nng);
+}
+
+
+void scc_ut_get_nng_with_lexical_seeds(void** state)
+{
+	(void) state;
+
+	scc_ut_check_nng_with_lexical_seeds(0, NULL, 2, false, 0.0);
+	scc_ut_check_nng_with_lexical_seeds(0, NULL, 3, false, 0.0);
+	scc_ut_check_nng_with_lexical_seeds(0, NULL, 50, false, 0.0);
+	scc_ut_check_nng_with_lexical_seeds(0, NULL, 100, false, 0.0);
+	scc_ut_check_nng_with_lexical_seeds(0, NULL, 3, true, 20.0);
+
+	const scc_PointIndex primary_data_points[10] = { 3, 6, 9, 15, 19, 20, 23, 33, 88, 90 };
+	scc_ut_check_nng_with_lexical_seeds(10, primary_data_points, 2, false, 0.0);
+	scc_ut_check_nng_with_lexical_seeds(10, primary_data_points, 4, true, 20.0);
+
+	iscc_Digraph out_nng;
+	iscc_SeedResult out_seeds = { .capacity = 34, .count = 0, .seeds = NULL };
+	scc_ErrorCode ec = iscc_get_nng_with_lexical_seeds(scc_ut_test_data_large, 100, 3,
+	                                                   0, NULL, true, 0.1, true,
+	                                                   &out_seeds, &out_nng);
+	assert_int_equal(ec, SCC_ER_NO_SOLUTION);
+	assert_null(out_seeds.seeds);
+}
+
+
 void scc_ut_get_nng_with_type_constraint(void** state)
 {
 	(void) state;
@@ -2811,6 +2889,7 @@ int main(void)
 
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_get_nng_with_size_constraint),
+		cmocka_unit_test(scc_ut_get_nng_with_lexical_seeds),
 		cmocka_unit_test(scc_ut_get_nng_with_type_constraint),
 		cmocka_unit_test(scc_ut_estimate_avg_seed_dist),
 		cmocka_unit_test(scc_ut_make_nng_clusters_from_seeds),
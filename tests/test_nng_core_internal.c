@@ -24,6 +24,7 @@
 #include <src/scclust_types.h>
 #include "assert_digraph.h"
 #include "data_object_test.h"
+#include "rand.h"
 
 
 void scc_ut_make_nng(void** state)
@@ -880,6 +881,68 @@ void scc_ut_make_nng_from_search_object_radius(void** state)
 }
 
 
+void scc_ut_make_nng_radius_estimate(void** state)
+{
+	(void) state;
+
+	// Points not on the probe's sampling grid form a dense line, points on the
+	// grid are isolated. The probe thus estimates zero ok queries, and the arc
+	// storage must grow during the search.
+	double data_matrix[1000];
+	for (size_t i = 0; i < 1000; ++i) {
+		data_matrix[i] = ((i % 15) == 0) ? (1000000.0 + 1000.0 * ((double) i)) : (0.01 * ((double) i));
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(1000, 1, 1000, data_matrix, &data_set), SCC_ER_OK);
+
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, 1000, NULL, &nn_search_object));
+
+	size_t estimate1 = 1;
+	assert_int_equal(iscc_estimate_radius_ok_queries(nn_search_object, 1000, NULL, 64, 1.0, &estimate1), SCC_ER_OK);
+	assert_int_equal(estimate1, 0);
+
+	size_t estimate2 = 0;
+	assert_int_equal(iscc_estimate_radius_ok_queries(nn_search_object, 1000, NULL, 2, 1.0e10, &estimate2), SCC_ER_OK);
+	assert_int_equal(estimate2, 1000);
+
+	size_t estimate3 = 0;
+	assert_int_equal(iscc_estimate_radius_ok_queries(nn_search_object, 100, NULL, 64, 1.0, &estimate3), SCC_ER_OK);
+	assert_int_equal(estimate3, 100);
+
+	scc_PointIndex* const ref_query_indices = malloc(sizeof(scc_PointIndex[1000]));
+	scc_PointIndex* const ref_nn_indices = malloc(sizeof(scc_PointIndex[1000 * 64]));
+	size_t ref_num_ok = 0;
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, 1000, NULL, 64, true, 1.0,
+	                                         &ref_num_ok, ref_query_indices, ref_nn_indices));
+	assert_int_equal(ref_num_ok, 933);
+
+	size_t out_num_ok = 0;
+	scc_PointIndex* const out_query_indices = malloc(sizeof(scc_PointIndex[1000]));
+	iscc_Digraph out_nng;
+	scc_ErrorCode ec = iscc_make_nng_from_search_object(nn_search_object, 1000, 1000, NULL,
+	                                                    64, true, 1.0,
+	                                                    &out_num_ok, out_query_indices, &out_nng);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_valid_digraph(&out_nng, 1000);
+	assert_int_equal(out_num_ok, ref_num_ok);
+	assert_memory_equal(out_query_indices, ref_query_indices, ref_num_ok * sizeof(scc_PointIndex));
+	assert_int_equal(out_nng.max_arcs, ref_num_ok * 64);
+	assert_memory_equal(out_nng.head, ref_nn_indices, ref_num_ok * 64 * sizeof(scc_PointIndex));
+	for (size_t q = 0; q < ref_num_ok; ++q) {
+		assert_int_equal(out_nng.tail_ptr[ref_query_indices[q]], q * 64);
+		assert_int_equal(out_nng.tail_ptr[ref_query_indices[q] + 1], (q + 1) * 64);
+	}
+	iscc_free_digraph(&out_nng);
+
+	free(ref_query_indices);
+	free(ref_nn_indices);
+	free(out_query_indices);
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+	scc_free_data_set(&data_set);
+}
+
+
 void scc_ut_ensure_self_match(void** state)
 {
 	(void) state;
@@ -959,6 +1022,64 @@ void scc_ut_ensure_self_match(void** state)
 }
 
 
+static void scc_ut_check_loopless_nng(const size_t len_query_indices,
+                                      const scc_PointIndex query_indices[const],
+                                      const uint32_t k,
+                                      const bool radius_search,
+                                      const double radius)
+{
+	iscc_Digraph ref_nng;
+	scc_ErrorCode ref_ec = iscc_make_nng(scc_ut_test_data_large, 100, 100, NULL,
+	                                     len_query_indices, query_indices,
+	                                     k, radius_search, radius,
+	                                     NULL, NULL, &ref_nng);
+	assert_int_equal(ref_ec, SCC_ER_OK);
+	iscc_ensure_self_match(&ref_nng, 100, NULL);
+	assert_int_equal(iscc_delete_loops(&ref_nng), SCC_ER_OK);
+
+	iscc_Digraph out_nng;
+	scc_ErrorCode ec = iscc_make_loopless_nng(scc_ut_test_data_large, 100,
+	                                          len_query_indices, query_indices,
+	                                          k, radius_search, radius,
+	                                          NULL, false, &out_nng);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_valid_digraph(&out_nng, 100);
+	assert_int_equal(out_nng.max_arcs, out_nng.tail_ptr[100]);
+	assert_identical_digraph(&out_nng, &ref_nng);
+
+	iscc_free_digraph(&out_nng);
+	iscc_free_digraph(&ref_nng);
+}
+
+
+void scc_ut_make_loopless_nng(void** state)
+{
+	(void) state;
+
+	scc_ut_check_loopless_nng(100, NULL, 2, false, 0.0);
+	scc_ut_check_loopless_nng(100, NULL, 3, false, 0.0);
+	scc_ut_check_loopless_nng(100, NULL, 7, false, 0.0);
+	scc_ut_check_loopless_nng(100, NULL, 100, false, 0.0);
+
+	const scc_PointIndex query1[10] = { 3, 6, 9, 15, 19, 20, 23, 33, 88, 90 };
+	scc_ut_check_loopless_nng(10, query1, 2, false, 0.0);
+	scc_ut_check_loopless_nng(10, query1, 4, false, 0.0);
+
+	scc_ut_check_loopless_nng(100, NULL, 3, true, 20.0);
+	scc_ut_check_loopless_nng(100, NULL, 5, true, 30.0);
+	scc_ut_check_loopless_nng(10, query1, 3, true, 20.0);
+
+	iscc_Digraph out_nng_empty;
+	scc_ErrorCode ec_empty = iscc_make_loopless_nng(scc_ut_test_data_large, 100,
+	                                                100, NULL,
+	                                                3, true, 0.1,
+	                                                NULL, false, &out_nng_empty);
+	assert_int_equal(ec_empty, SCC_ER_OK);
+	assert_empty_digraph(&out_nng_empty, 100);
+	iscc_free_digraph(&out_nng_empty);
+}
+
+
 void scc_ut_type_count(void** state)
 {
 	(void) state;
@@ -1032,6 +1153,81 @@ void scc_ut_type_count(void** state)
 }
 
 
+void scc_ut_make_bipartite_nng(void** state)
+{
+	(void) state;
+
+	const size_t num_data_points = 2000;
+	double* const raw_data = malloc(sizeof(double[2 * num_data_points]));
+	scc_TypeLabel* const type_labels = malloc(sizeof(scc_TypeLabel[num_data_points]));
+	assert_non_null(raw_data);
+	assert_non_null(type_labels);
+	srand(20170607);
+	for (size_t i = 0; i < 2 * num_data_points; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+	for (size_t i = 0; i < num_data_points; ++i) {
+		// Unbalanced types, as in treatment/control designs
+		type_labels[i] = (scc_TypeLabel) ((rand() % 4) == 0);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_data_points, 2, 2 * num_data_points, raw_data, &data_set), SCC_ER_OK);
+
+	scc_PointIndex primary_data_points[500];
+	for (size_t i = 0; i < 500; ++i) {
+		primary_data_points[i] = (scc_PointIndex) (4 * i + (i % 4));
+	}
+
+	// An unused third type makes `iscc_get_nng_with_type_constraint` take the general path
+	const uint32_t type_constraints_fast[2] = { 1, 1 };
+	const uint32_t type_constraints_general[3] = { 1, 1, 0 };
+	const uint32_t size_constraints[3] = { 2, 3, 6 };
+	const double radii[3] = { 0.0, 4.0, 0.05 };
+
+	for (size_t sc = 0; sc < 3; ++sc) {
+		for (size_t r = 0; r < 3; ++r) {
+			for (size_t primary = 0; primary < 2; ++primary) {
+				iscc_Digraph nng_fast;
+				iscc_Digraph nng_general;
+				const scc_ErrorCode ec_fast = iscc_get_nng_with_type_constraint(data_set,
+				                                                                num_data_points,
+				                                                                size_constraints[sc],
+				                                                                2,
+				                                                                type_constraints_fast,
+				                                                                type_labels,
+				                                                                (primary == 1) ? 500 : 0,
+				                                                                (primary == 1) ? primary_data_points : NULL,
+				                                                                (r > 0),
+				                                                                radii[r],
+				                                                                &nng_fast);
+				const scc_ErrorCode ec_general = iscc_get_nng_with_type_constraint(data_set,
+				                                                                   num_data_points,
+				                                                                   size_constraints[sc],
+				                                                                   3,
+				                                                                   type_constraints_general,
+				                                                                   type_labels,
+				                                                                   (primary == 1) ? 500 : 0,
+				                                                                   (primary == 1) ? primary_data_points : NULL,
+				                                                                   (r > 0),
+				                                                                   radii[r],
+				                                                                   &nng_general);
+				assert_int_equal(ec_fast, ec_general);
+				if (ec_fast == SCC_ER_OK) {
+					assert_valid_digraph(&nng_fast, num_data_points);
+					assert_identical_digraph(&nng_fast, &nng_general);
+					iscc_free_digraph(&nng_fast);
+					iscc_free_digraph(&nng_general);
+				}
+			}
+		}
+	}
+
+	scc_free_data_set(&data_set);
+	free(raw_data);
+	free(type_labels);
+}
+
+
 void scc_ut_assign_seeds_and_neighbors(void** state)
 {
 	(void) state;
@@ -1330,8 +1526,11 @@ int main(void)
 		cmocka_unit_test(scc_ut_make_nng_radius),
 		cmocka_unit_test(scc_ut_make_nng_from_search_object),
 		cmocka_unit_test(scc_ut_make_nng_from_search_object_radius),
+		cmocka_unit_test(scc_ut_make_nng_radius_estimate),
 		cmocka_unit_test(scc_ut_ensure_self_match),
+		cmocka_unit_test(scc_ut_make_loopless_nng),
 		cmocka_unit_test(scc_ut_type_count),
+		cmocka_unit_test(scc_ut_make_bipartite_nng),
 		cmocka_unit_test(scc_ut_assign_seeds_and_neighbors),
 		cmocka_unit_test(scc_ut_assign_by_nng),
 		cmocka_unit_test(scc_ut_assign_by_nn_search),
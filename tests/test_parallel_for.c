@@ -0,0 +1,385 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/clustering_struct.h>
+#include <src/dist_search.h>
+#include "rand.h"
+
+#define SCC_UT_NUM_POINTS 5000
+#define SCC_UT_SPLIT_NUM_POINTS 40000
+#define SCC_UT_SPLIT_NUM_DIMENSIONS 10
+#define SCC_UT_SPLIT_NUM_QUERIES 7
+#define SCC_UT_SPLIT_K 5
+#define SCC_UT_HI_NUM_POINTS 20000
+#define SCC_UT_NESTED_NUM_PRIMARY 200
+#define SCC_UT_NESTED_SIZE_CONSTRAINT 70
+
+
+static size_t scc_ut_num_loops = 0;
+static size_t scc_ut_num_bodies = 0;
+static size_t scc_ut_loop_depth = 0;
+
+
+// Splits the range into chunks of `grain` and runs them last to first,
+// so the results must not depend on the order in which chunks are run.
+// Fails if a loop is started from within one of its bodies.
+static void scc_ut_reverse_parallel_for(const size_t begin,
+                                        const size_t end,
+                                        const size_t grain,
+                                        const scc_parallel_for_body body,
+                                        void* const context)
+{
+	assert_true(begin < end);
+	assert_true(grain > 0);
+	assert_int_equal(scc_ut_loop_depth, 0);
+	++scc_ut_loop_depth;
+	++scc_ut_num_loops;
+	const size_t num_chunks = (end - begin + grain - 1) / grain;
+	for (size_t c = num_chunks; c > 0; --c) {
+		const size_t chunk_begin = begin + (c - 1) * grain;
+		const size_t chunk_end = (chunk_begin + grain < end) ? (chunk_begin + grain) : end;
+		++scc_ut_num_bodies;
+		body(chunk_begin, chunk_end, context);
+	}
+	--scc_ut_loop_depth;
+}
+
+
+static void scc_ut_check_parallel_clustering(scc_DataSet* const data_set,
+                                             const scc_ClusterOptions* const options)
+{
+	static scc_Clabel serial_labels[SCC_UT_NUM_POINTS];
+	static scc_Clabel parallel_labels[SCC_UT_NUM_POINTS];
+	scc_Clustering* clustering;
+	scc_ClusteringStats serial_stats;
+	scc_ClusteringStats parallel_stats;
+
+	assert_true(scc_reset_parallel_for());
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_POINTS, serial_labels, &clustering), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, options, clustering), SCC_ER_OK);
+	assert_int_equal(scc_get_clustering_stats(data_set, clustering, &serial_stats), SCC_ER_OK);
+	bool is_OK = false;
+	assert_int_equal(scc_check_clustering(clustering, options, &is_OK), SCC_ER_OK);
+	assert_true(is_OK);
+	scc_free_clustering(&clustering);
+
+	scc_ut_num_loops = 0;
+	scc_ut_num_bodies = 0;
+	assert_true(scc_set_parallel_for(scc_ut_reverse_parallel_for));
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_NUM_POINTS, parallel_labels, &clustering), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, options, clustering), SCC_ER_OK);
+	assert_int_equal(scc_get_clustering_stats(data_set, clustering, &parallel_stats), SCC_ER_OK);
+	scc_free_clustering(&clustering);
+	assert_true(scc_reset_parallel_for());
+
+	assert_true(scc_ut_num_loops > 0);
+	assert_true(scc_ut_num_bodies > scc_ut_num_loops);
+	assert_memory_equal(serial_labels, parallel_labels, sizeof(serial_labels));
+	assert_memory_equal(&serial_stats, &parallel_stats, sizeof(scc_ClusteringStats));
+}
+
+
+void scc_ut_set_parallel_for(void** state)
+{
+	(void) state;
+
+	assert_false(scc_set_parallel_for(NULL));
+	assert_true(scc_set_parallel_for(scc_ut_reverse_parallel_for));
+	assert_true(scc_reset_parallel_for());
+	assert_true(scc_reset_parallel_for());
+}
+
+
+void scc_ut_parallel_for_clustering(void** state)
+{
+	(void) state;
+
+	static double raw_data[2 * SCC_UT_NUM_POINTS];
+	static scc_TypeLabel type_labels[SCC_UT_NUM_POINTS];
+	srand(20170518);
+	for (size_t i = 0; i < 2 * SCC_UT_NUM_POINTS; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+	for (size_t i = 0; i < SCC_UT_NUM_POINTS; ++i) {
+		type_labels[i] = (scc_TypeLabel) (i % 3 == 0);
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SCC_UT_NUM_POINTS, 2, 2 * SCC_UT_NUM_POINTS, raw_data, &data_set), SCC_ER_OK);
+
+	scc_ClusterOptions options1 = scc_get_default_options();
+	options1.size_constraint = 3;
+	scc_ut_check_parallel_clustering(data_set, &options1);
+
+	scc_ClusterOptions options2 = scc_get_default_options();
+	options2.size_constraint = 4;
+	options2.seed_method = SCC_SM_INWARDS_UPDATING;
+	options2.seed_radius = SCC_RM_USE_SUPPLIED;
+	options2.seed_supplied_radius = 3.0;
+	options2.primary_unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+	scc_ut_check_parallel_clustering(data_set, &options2);
+
+	const uint32_t type_constraints[2] = { 1, 1 };
+	scc_ClusterOptions options3 = scc_get_default_options();
+	options3.size_constraint = 3;
+	options3.num_types = 2;
+	options3.type_constraints = type_constraints;
+	options3.len_type_labels = SCC_UT_NUM_POINTS;
+	options3.type_labels = type_labels;
+	options3.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+	scc_ut_check_parallel_clustering(data_set, &options3);
+
+	scc_free_data_set(&data_set);
+}
+
+
+// Searches once serially and once with the loop, and checks that the results are the same
+static void scc_ut_check_split_search(scc_DataSet* const data_set,
+                                      const size_t len_search_indices,
+                                      const scc_PointIndex search_indices[const],
+                                      const scc_PointIndex query_indices[const],
+                                      const bool radius_search,
+                                      const double radius,
+                                      const size_t expected_num_ok)
+{
+	size_t num_ok[2];
+	scc_PointIndex ok_queries[2][SCC_UT_SPLIT_NUM_QUERIES];
+	scc_PointIndex nn_indices[2][SCC_UT_SPLIT_NUM_QUERIES * SCC_UT_SPLIT_K];
+
+	for (size_t run = 0; run < 2; ++run) {
+		if (run == 0) {
+			assert_true(scc_reset_parallel_for());
+		} else {
+			scc_ut_num_loops = 0;
+			scc_ut_num_bodies = 0;
+			assert_true(scc_set_parallel_for(scc_ut_reverse_parallel_for));
+		}
+		iscc_NNSearchObject* nn_search_object;
+		assert_true(iscc_init_nn_search_object(data_set, len_search_indices, search_indices, &nn_search_object));
+		assert_true(iscc_nearest_neighbor_search(nn_search_object,
+		                                         SCC_UT_SPLIT_NUM_QUERIES,
+		                                         query_indices,
+		                                         SCC_UT_SPLIT_K,
+		                                         radius_search,
+		                                         radius,
+		                                         &num_ok[run],
+		                                         radius_search ? ok_queries[run] : NULL,
+		                                         nn_indices[run]));
+		assert_true(iscc_close_nn_search_object(&nn_search_object));
+	}
+	assert_true(scc_reset_parallel_for());
+
+	// The search set was split between several bodies of one loop
+	assert_int_equal(scc_ut_num_loops, 1);
+	assert_true(scc_ut_num_bodies > 1);
+
+	assert_int_equal(num_ok[0], expected_num_ok);
+	assert_int_equal(num_ok[1], expected_num_ok);
+	if (radius_search) {
+		assert_memory_equal(ok_queries[0], ok_queries[1], expected_num_ok * sizeof(scc_PointIndex));
+	}
+	assert_memory_equal(nn_indices[0], nn_indices[1], expected_num_ok * SCC_UT_SPLIT_K * sizeof(scc_PointIndex));
+}
+
+
+void scc_ut_parallel_for_split_search(void** state)
+{
+	(void) state;
+
+	static double raw_data[SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS];
+	static scc_PointIndex search_indices[SCC_UT_SPLIT_NUM_POINTS / 2];
+	srand(20170519);
+	for (size_t i = 0; i < SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+	for (size_t i = 0; i < SCC_UT_SPLIT_NUM_POINTS / 2; ++i) {
+		search_indices[i] = (scc_PointIndex) (2 * i + 1);
+	}
+	const scc_PointIndex query_indices[SCC_UT_SPLIT_NUM_QUERIES] = { 0, 2, 4, 101, 5000, 20001, 39998 };
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SCC_UT_SPLIT_NUM_POINTS, SCC_UT_SPLIT_NUM_DIMENSIONS, SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS, raw_data, &data_set), SCC_ER_OK);
+
+	scc_ut_check_split_search(data_set, SCC_UT_SPLIT_NUM_POINTS, NULL, query_indices, false, 0.0, SCC_UT_SPLIT_NUM_QUERIES);
+	scc_ut_check_split_search(data_set, SCC_UT_SPLIT_NUM_POINTS / 2, search_indices, query_indices, false, 0.0, SCC_UT_SPLIT_NUM_QUERIES);
+
+	// A radius between the smallest and largest distance to the k-th neighbor excludes some queries
+	scc_PointIndex nn_indices[SCC_UT_SPLIT_NUM_QUERIES * SCC_UT_SPLIT_K];
+	size_t num_ok;
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, SCC_UT_SPLIT_NUM_POINTS, NULL, &nn_search_object));
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, SCC_UT_SPLIT_NUM_QUERIES, query_indices, SCC_UT_SPLIT_K,
+	                                         false, 0.0, &num_ok, NULL, nn_indices));
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+	double kth_dists[SCC_UT_SPLIT_NUM_QUERIES];
+	for (size_t q = 0; q < SCC_UT_SPLIT_NUM_QUERIES; ++q) {
+		assert_true(iscc_get_dist_rows(data_set, 1, &query_indices[q], 1, &nn_indices[q * SCC_UT_SPLIT_K + SCC_UT_SPLIT_K - 1], &kth_dists[q]));
+	}
+	double radius = kth_dists[0];
+	size_t expected_num_ok = 0;
+	for (size_t q = 0; q < SCC_UT_SPLIT_NUM_QUERIES; ++q) {
+		if (kth_dists[q] > radius) radius = kth_dists[q];
+	}
+	radius = (radius + kth_dists[0]) / 2.0;
+	for (size_t q = 0; q < SCC_UT_SPLIT_NUM_QUERIES; ++q) {
+		expected_num_ok += (kth_dists[q] <= radius);
+	}
+	assert_true(expected_num_ok > 0);
+	assert_true(expected_num_ok < SCC_UT_SPLIT_NUM_QUERIES);
+	scc_ut_check_split_search(data_set, SCC_UT_SPLIT_NUM_POINTS, NULL, query_indices, true, radius, expected_num_ok);
+
+	scc_free_data_set(&data_set);
+}
+
+
+void scc_ut_parallel_for_hierarchical(void** state)
+{
+	(void) state;
+
+	static double raw_data[2 * SCC_UT_HI_NUM_POINTS];
+	static scc_Clabel serial_labels[SCC_UT_HI_NUM_POINTS];
+	static scc_Clabel parallel_labels[SCC_UT_HI_NUM_POINTS];
+	srand(20170520);
+	for (size_t i = 0; i < 2 * SCC_UT_HI_NUM_POINTS; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SCC_UT_HI_NUM_POINTS, 2, 2 * SCC_UT_HI_NUM_POINTS, raw_data, &data_set), SCC_ER_OK);
+
+	// The first splits are of clusters large enough to be split in parallel
+	for (size_t batch_assign = 0; batch_assign < 2; ++batch_assign) {
+		scc_Clustering* clustering;
+		assert_true(scc_reset_parallel_for());
+		assert_int_equal(scc_init_empty_clustering(SCC_UT_HI_NUM_POINTS, serial_labels, &clustering), SCC_ER_OK);
+		assert_int_equal(scc_hierarchical_clustering(data_set, 5, (batch_assign == 1), clustering), SCC_ER_OK);
+		const size_t serial_num_clusters = clustering->num_clusters;
+		scc_free_clustering(&clustering);
+
+		scc_ut_num_loops = 0;
+		scc_ut_num_bodies = 0;
+		assert_true(scc_set_parallel_for(scc_ut_reverse_parallel_for));
+		assert_int_equal(scc_init_empty_clustering(SCC_UT_HI_NUM_POINTS, parallel_labels, &clustering), SCC_ER_OK);
+		assert_int_equal(scc_hierarchical_clustering(data_set, 5, (batch_assign == 1), clustering), SCC_ER_OK);
+		const size_t parallel_num_clusters = clustering->num_clusters;
+		scc_free_clustering(&clustering);
+		assert_true(scc_reset_parallel_for());
+
+		assert_true(scc_ut_num_loops > 0);
+		assert_true(scc_ut_num_bodies > scc_ut_num_loops);
+		assert_int_equal(serial_num_clusters, parallel_num_clusters);
+		assert_memory_equal(serial_labels, parallel_labels, sizeof(serial_labels));
+	}
+
+	scc_free_data_set(&data_set);
+}
+
+
+// Each block of the NNG search has enough work for the search itself to be split, so the
+// searches in the loop bodies would nest loops if they were not marked
+void scc_ut_parallel_for_nested_search(void** state)
+{
+	(void) state;
+
+	static double raw_data[SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS];
+	static scc_PointIndex primary_data_points[SCC_UT_NESTED_NUM_PRIMARY];
+	static scc_Clabel serial_labels[SCC_UT_SPLIT_NUM_POINTS];
+	static scc_Clabel parallel_labels[SCC_UT_SPLIT_NUM_POINTS];
+	srand(20170521);
+	for (size_t i = 0; i < SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS; ++i) {
+		raw_data[i] = scc_rand_double(0.0, 100.0);
+	}
+	for (size_t i = 0; i < SCC_UT_NESTED_NUM_PRIMARY; ++i) {
+		primary_data_points[i] = (scc_PointIndex) (i * (SCC_UT_SPLIT_NUM_POINTS / SCC_UT_NESTED_NUM_PRIMARY));
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SCC_UT_SPLIT_NUM_POINTS, SCC_UT_SPLIT_NUM_DIMENSIONS, SCC_UT_SPLIT_NUM_DIMENSIONS * SCC_UT_SPLIT_NUM_POINTS, raw_data, &data_set), SCC_ER_OK);
+
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = SCC_UT_NESTED_SIZE_CONSTRAINT;
+	options.len_primary_data_points = SCC_UT_NESTED_NUM_PRIMARY;
+	options.primary_data_points = primary_data_points;
+
+	scc_Clustering* clustering;
+	assert_true(scc_reset_parallel_for());
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_SPLIT_NUM_POINTS, serial_labels, &clustering), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, clustering), SCC_ER_OK);
+	scc_free_clustering(&clustering);
+
+	scc_ut_num_loops = 0;
+	scc_ut_num_bodies = 0;
+	scc_ut_loop_depth = 0;
+	assert_true(scc_set_parallel_for(scc_ut_reverse_parallel_for));
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_SPLIT_NUM_POINTS, parallel_labels, &clustering), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, clustering), SCC_ER_OK);
+	scc_free_clustering(&clustering);
+
+	// Only searches on objects marked as used in a loop body skip the split
+	scc_PointIndex nn_indices[SCC_UT_SPLIT_NUM_QUERIES * SCC_UT_SPLIT_K];
+	size_t num_ok;
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, SCC_UT_SPLIT_NUM_POINTS, NULL, &nn_search_object));
+	const size_t num_loops_before = scc_ut_num_loops;
+	iscc_set_nn_search_in_parallel_loop(nn_search_object, true);
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, SCC_UT_SPLIT_NUM_QUERIES, primary_data_points, SCC_UT_SPLIT_K,
+	                                         false, 0.0, &num_ok, NULL, nn_indices));
+	assert_int_equal(scc_ut_num_loops, num_loops_before);
+	iscc_set_nn_search_in_parallel_loop(nn_search_object, false);
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, SCC_UT_SPLIT_NUM_QUERIES, primary_data_points, SCC_UT_SPLIT_K,
+	                                         false, 0.0, &num_ok, NULL, nn_indices));
+	assert_int_equal(scc_ut_num_loops, num_loops_before + 1);
+
+	// A single query is too little work for two slices of the search set
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, 1, primary_data_points, SCC_UT_SPLIT_K,
+	                                         false, 0.0, &num_ok, NULL, nn_indices));
+	assert_int_equal(scc_ut_num_loops, num_loops_before + 1);
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+	assert_true(scc_reset_parallel_for());
+
+	assert_true(scc_ut_num_loops > 0);
+	assert_int_equal(scc_ut_loop_depth, 0);
+	assert_memory_equal(serial_labels, parallel_labels, sizeof(serial_labels));
+
+	scc_free_data_set(&data_set);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_set_parallel_for),
+		cmocka_unit_test(scc_ut_parallel_for_clustering),
+		cmocka_unit_test(scc_ut_parallel_for_split_search),
+		cmocka_unit_test(scc_ut_parallel_for_hierarchical),
+		cmocka_unit_test(scc_ut_parallel_for_nested_search),
+	};
+
+	return cmocka_run_group_tests_name("parallel_for", test_cases, NULL, NULL);
+}
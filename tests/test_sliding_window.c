@@ -0,0 +1,258 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/clustering_struct.h>
+#include <src/dist_search_imp.h>
+#include <src/scclust_types.h>
+#include "rand.h"
+
+#define SCC_UT_CAPACITY 120
+#define SCC_UT_NUM_DIMENSIONS 2
+
+
+static double scc_ut_coordinates[SCC_UT_CAPACITY * SCC_UT_NUM_DIMENSIONS];
+static bool scc_ut_in_window[SCC_UT_CAPACITY];
+static size_t scc_ut_num_dist_rows = 0;
+
+
+static bool scc_ut_counting_get_dist_rows(void* const data_set,
+                                          const size_t len_query_indices,
+                                          const scc_PointIndex query_indices[const],
+                                          const size_t len_column_indices,
+                                          const scc_PointIndex column_indices[const],
+                                          double output_dists[const])
+{
+	scc_ut_num_dist_rows += len_query_indices;
+	return iscc_imp_get_dist_rows(data_set, len_query_indices, query_indices,
+	                              len_column_indices, column_indices, output_dists);
+}
+
+
+// Clusters the points in the window from scratch, ordered by slot, and compares with the window
+static void scc_ut_check_window(scc_SlidingWindow* const window,
+                                const uint32_t size_constraint,
+                                const scc_SeedMethod seed_method,
+                                const scc_UnassignedMethod unassigned_method)
+{
+	double compact_coordinates[SCC_UT_CAPACITY * SCC_UT_NUM_DIMENSIONS];
+	size_t num_points = 0;
+	for (size_t slot = 0; slot < SCC_UT_CAPACITY; ++slot) {
+		if (scc_ut_in_window[slot]) {
+			compact_coordinates[SCC_UT_NUM_DIMENSIONS * num_points] = scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * slot];
+			compact_coordinates[SCC_UT_NUM_DIMENSIONS * num_points + 1] = scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * slot + 1];
+			++num_points;
+		}
+	}
+
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, SCC_UT_NUM_DIMENSIONS, SCC_UT_NUM_DIMENSIONS * num_points, compact_coordinates, &data_set), SCC_ER_OK);
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = size_constraint;
+	options.seed_method = seed_method;
+	options.primary_unassigned_method = unassigned_method;
+	scc_Clustering* ref_cl;
+	assert_int_equal(scc_init_empty_clustering(num_points, NULL, &ref_cl), SCC_ER_OK);
+	assert_int_equal(scc_sc_clustering(data_set, &options, ref_cl), SCC_ER_OK);
+
+	scc_Clustering* cl;
+	assert_int_equal(scc_init_empty_clustering(SCC_UT_CAPACITY, NULL, &cl), SCC_ER_OK);
+	assert_int_equal(scc_window_clustering(window, cl), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, ref_cl->num_clusters);
+
+	size_t i = 0;
+	for (size_t slot = 0; slot < SCC_UT_CAPACITY; ++slot) {
+		if (scc_ut_in_window[slot]) {
+			assert_int_equal(cl->cluster_label[slot], ref_cl->cluster_label[i]);
+			++i;
+		} else {
+			assert_int_equal(cl->cluster_label[slot], SCC_CLABEL_NA);
+		}
+	}
+
+	scc_free_clustering(&cl);
+	scc_free_clustering(&ref_cl);
+	scc_free_data_set(&data_set);
+}
+
+
+static void scc_ut_run_window(const uint32_t size_constraint,
+                              const scc_SeedMethod seed_method,
+                              const scc_UnassignedMethod unassigned_method)
+{
+	scc_SlidingWindow* window;
+	assert_int_equal(scc_init_sliding_window(SCC_UT_NUM_DIMENSIONS, SCC_UT_CAPACITY, size_constraint, seed_method, unassigned_method, &window), SCC_ER_OK);
+	for (size_t slot = 0; slot < SCC_UT_CAPACITY; ++slot) scc_ut_in_window[slot] = false;
+
+	// Points arrive in order and expire when the window is full, so slots are reused out of order
+	srand(1234);
+	uint64_t expire_order[SCC_UT_CAPACITY];
+	size_t next_expire = 0;
+	size_t num_expire = 0;
+	for (size_t step = 0; step < 3 * SCC_UT_CAPACITY; ++step) {
+		if ((num_expire - next_expire == SCC_UT_CAPACITY) || ((step > SCC_UT_CAPACITY) && (rand() % 3 == 0))) {
+			const uint64_t slot = expire_order[next_expire % SCC_UT_CAPACITY];
+			++next_expire;
+			assert_int_equal(scc_window_expire(window, slot), SCC_ER_OK);
+			scc_ut_in_window[slot] = false;
+		}
+
+		double point[SCC_UT_NUM_DIMENSIONS];
+		point[0] = scc_rand_double(0.0, 100.0);
+		point[1] = scc_rand_double(0.0, 100.0);
+		uint64_t slot;
+		assert_int_equal(scc_window_insert(window, point, &slot), SCC_ER_OK);
+		assert_true(slot < SCC_UT_CAPACITY);
+		assert_false(scc_ut_in_window[slot]);
+		scc_ut_in_window[slot] = true;
+		scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * slot] = point[0];
+		scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * slot + 1] = point[1];
+		expire_order[num_expire % SCC_UT_CAPACITY] = slot;
+		++num_expire;
+
+		if ((step % 37 == 36) && (num_expire - next_expire >= size_constraint)) {
+			scc_ut_check_window(window, size_constraint, seed_method, unassigned_method);
+		}
+	}
+
+	scc_free_sliding_window(&window);
+	assert_null(window);
+}
+
+
+void scc_ut_sliding_window(void** state)
+{
+	(void) state;
+
+	scc_ut_run_window(2, SCC_SM_LEXICAL, SCC_UM_ANY_NEIGHBOR);
+	scc_ut_run_window(3, SCC_SM_LEXICAL, SCC_UM_CLOSEST_ASSIGNED);
+	scc_ut_run_window(3, SCC_SM_INWARDS_UPDATING, SCC_UM_CLOSEST_SEED);
+	scc_ut_run_window(4, SCC_SM_EXCLUSION_ORDER, SCC_UM_ANY_NEIGHBOR);
+	scc_ut_run_window(5, SCC_SM_INWARDS_ORDER, SCC_UM_IGNORE);
+}
+
+
+// Points on a line, so the candidates of each point are known. With size constraint 3, each
+// point keeps four candidates and searches again only when fewer than two are left.
+void scc_ut_sliding_window_candidates(void** state)
+{
+	(void) state;
+
+	scc_SlidingWindow* window;
+	assert_int_equal(scc_init_sliding_window(SCC_UT_NUM_DIMENSIONS, SCC_UT_CAPACITY, 3, SCC_SM_LEXICAL, SCC_UM_ANY_NEIGHBOR, &window), SCC_ER_OK);
+	assert_true(scc_set_dist_functions(NULL, NULL, NULL, scc_ut_counting_get_dist_rows, NULL, NULL, NULL, NULL, NULL, NULL));
+
+	scc_ut_num_dist_rows = 0;
+	for (size_t i = 0; i < SCC_UT_CAPACITY; ++i) {
+		const double point[SCC_UT_NUM_DIMENSIONS] = { (double) i, 0.0 };
+		uint64_t slot;
+		assert_int_equal(scc_window_insert(window, point, &slot), SCC_ER_OK);
+		assert_int_equal(slot, i);
+		scc_ut_in_window[i] = true;
+		scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * i] = point[0];
+		scc_ut_coordinates[SCC_UT_NUM_DIMENSIONS * i + 1] = point[1];
+	}
+	// One row per insertion, except into the empty window
+	assert_int_equal(scc_ut_num_dist_rows, SCC_UT_CAPACITY - 1);
+
+	// Points 48 and 52 keep at least two candidates, so no distances are needed
+	const uint64_t expire_order[3] = { 50, 49, 51 };
+	scc_ut_num_dist_rows = 0;
+	for (size_t e = 0; e < 3; ++e) {
+		assert_int_equal(scc_window_expire(window, expire_order[e]), SCC_ER_OK);
+		scc_ut_in_window[expire_order[e]] = false;
+	}
+	assert_int_equal(scc_ut_num_dist_rows, 0);
+	scc_ut_check_window(window, 3, SCC_SM_LEXICAL, SCC_UM_ANY_NEIGHBOR);
+
+	// Point 48 is left with only point 46, and searches again
+	scc_ut_num_dist_rows = 0;
+	assert_int_equal(scc_window_expire(window, 47), SCC_ER_OK);
+	scc_ut_in_window[47] = false;
+	assert_int_equal(scc_ut_num_dist_rows, 1);
+	scc_ut_check_window(window, 3, SCC_SM_LEXICAL, SCC_UM_ANY_NEIGHBOR);
+
+	assert_true(scc_reset_dist_functions());
+	scc_free_sliding_window(&window);
+}
+
+
+void scc_ut_sliding_window_nonval(void** state)
+{
+	(void) state;
+
+	scc_SlidingWindow* window;
+	assert_int_equal(scc_init_sliding_window(2, 10, 1, SCC_SM_LEXICAL, SCC_UM_IGNORE, &window), SCC_ER_INVALID_INPUT);
+	assert_null(window);
+	assert_int_equal(scc_init_sliding_window(2, 2, 3, SCC_SM_LEXICAL, SCC_UM_IGNORE, &window), SCC_ER_INVALID_INPUT);
+	assert_null(window);
+	assert_int_equal(scc_init_sliding_window(0, 10, 2, SCC_SM_LEXICAL, SCC_UM_IGNORE, &window), SCC_ER_INVALID_INPUT);
+	assert_null(window);
+	assert_int_equal(scc_init_sliding_window(2, 10, 2, SCC_SM_BATCHES, SCC_UM_IGNORE, &window), SCC_ER_NOT_IMPLEMENTED);
+	assert_null(window);
+
+	assert_int_equal(scc_init_sliding_window(2, 3, 2, SCC_SM_LEXICAL, SCC_UM_IGNORE, &window), SCC_ER_OK);
+	scc_Clustering* cl;
+	scc_init_empty_clustering(3, NULL, &cl);
+	const double point[2] = { 0.0, 1.0 };
+	uint64_t slot;
+	assert_int_equal(scc_window_insert(window, point, &slot), SCC_ER_OK);
+	assert_int_equal(slot, 0);
+	assert_int_equal(scc_window_clustering(window, cl), SCC_ER_NO_SOLUTION);
+	assert_int_equal(scc_window_expire(window, 1), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_window_expire(window, 3), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_window_insert(window, point, NULL), SCC_ER_OK);
+	assert_int_equal(scc_window_insert(window, point, NULL), SCC_ER_OK);
+	assert_int_equal(scc_window_insert(window, point, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_window_expire(window, 0), SCC_ER_OK);
+	assert_int_equal(scc_window_expire(window, 0), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_window_clustering(window, cl), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, 1);
+	assert_int_equal(cl->cluster_label[0], SCC_CLABEL_NA);
+	assert_int_equal(cl->cluster_label[1], 0);
+	assert_int_equal(cl->cluster_label[2], 0);
+	scc_free_clustering(&cl);
+
+	scc_init_empty_clustering(4, NULL, &cl);
+	assert_int_equal(scc_window_clustering(window, cl), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	scc_free_sliding_window(&window);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_sliding_window),
+		cmocka_unit_test(scc_ut_sliding_window_candidates),
+		cmocka_unit_test(scc_ut_sliding_window_nonval),
+	};
+
+	return cmocka_run_group_tests_name("sliding_window.c", test_cases, NULL, NULL);
+}